@@ -0,0 +1,126 @@
+#include "assets.h"
+
+#include <Refresh_Image.h>
+
+static void Asset_Job(void *userdata)
+{
+	Asset *asset = (Asset*) userdata;
+
+	asset->startTicks = SDL_GetPerformanceCounter();
+
+	if (asset->type == ASSET_TYPE_TEXTURE)
+	{
+		if (TextureFile_Open(&asset->textureFile, asset->path))
+		{
+			asset->data = (uint8_t*) asset->textureFile.mapping;
+			asset->size = asset->textureFile.mappingSize;
+			asset->width = asset->textureFile.width;
+			asset->height = asset->textureFile.height;
+			asset->endTicks = SDL_GetPerformanceCounter();
+			return;
+		}
+
+		asset->path = asset->fallbackPath;
+		asset->type = ASSET_TYPE_IMAGE;
+	}
+
+	if (asset->type == ASSET_TYPE_IMAGE)
+	{
+		/* Always decoded to 4 channels regardless of numChannels */
+		int32_t numChannels;
+		asset->data = Refresh_Image_Load(
+			asset->path,
+			&asset->width,
+			&asset->height,
+			&numChannels
+		);
+		if (asset->data != NULL)
+		{
+			asset->size = (size_t) asset->width * asset->height * 4;
+		}
+	}
+	else
+	{
+		asset->data = (uint8_t*) SDL_LoadFile(asset->path, &asset->size);
+	}
+
+	asset->endTicks = SDL_GetPerformanceCounter();
+}
+
+void Asset_Load(JobSystem *jobs, Asset *asset, const char *path, AssetType type)
+{
+	SDL_memset(asset, 0, sizeof(Asset));
+	asset->path = path;
+	asset->type = type;
+	asset->submitTicks = SDL_GetPerformanceCounter();
+
+	JobSystem_Submit(jobs, &asset->job, Asset_Job, asset);
+}
+
+void Asset_LoadTexture(
+	JobSystem *jobs,
+	Asset *asset,
+	const char *path,
+	const char *fallbackPath
+) {
+	SDL_memset(asset, 0, sizeof(Asset));
+	asset->path = path;
+	asset->fallbackPath = fallbackPath;
+	asset->type = ASSET_TYPE_TEXTURE;
+	asset->submitTicks = SDL_GetPerformanceCounter();
+
+	JobSystem_Submit(jobs, &asset->job, Asset_Job, asset);
+}
+
+uint8_t Asset_Wait(JobSystem *jobs, Asset *asset)
+{
+	JobSystem_Wait(jobs, &asset->job);
+
+	if (asset->data == NULL)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to load %s", asset->path);
+		return 0;
+	}
+	return 1;
+}
+
+void Asset_Free(Asset *asset)
+{
+	if (asset->data == NULL)
+	{
+		return;
+	}
+
+	if (asset->type == ASSET_TYPE_TEXTURE)
+	{
+		TextureFile_Close(&asset->textureFile);
+	}
+	else if (asset->type == ASSET_TYPE_IMAGE)
+	{
+		Refresh_Image_Free(asset->data);
+	}
+	else
+	{
+		SDL_free(asset->data);
+	}
+	asset->data = NULL;
+}
+
+void Asset_Report(Asset *assets, uint32_t assetCount, uint64_t startupTicks, FILE *output)
+{
+	double toMilliseconds = 1000.0 / SDL_GetPerformanceFrequency();
+
+	fprintf(output, "asset                   queued    load      ready at  upload\n");
+	for (uint32_t i = 0; i < assetCount; i++)
+	{
+		fprintf(
+			output,
+			"%-22s %6.2f ms %6.2f ms %6.2f ms %6.2f ms\n",
+			assets[i].path,
+			(assets[i].startTicks - assets[i].submitTicks) * toMilliseconds,
+			(assets[i].endTicks - assets[i].startTicks) * toMilliseconds,
+			(assets[i].endTicks - startupTicks) * toMilliseconds,
+			assets[i].uploadTicks * toMilliseconds
+		);
+	}
+}
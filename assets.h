@@ -0,0 +1,61 @@
+#ifndef ASSETS_H
+#define ASSETS_H
+
+/* Startup assets read and decoded on the job system.
+ *
+ * The CPU side of loading (file I/O, PNG decode) happens on workers while
+ * the main thread creates the window and devices; the GPU upload stays on
+ * the main thread and is timed separately.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "jobs.h"
+#include "texture_file.h"
+
+typedef enum AssetType
+{
+	ASSET_TYPE_FILE,	/* raw bytes, e.g. SPIR-V or an effect binary */
+	ASSET_TYPE_IMAGE,	/* decoded to RGBA8 */
+	ASSET_TYPE_TEXTURE	/* mapped texture container, or an image if that is missing */
+} AssetType;
+
+typedef struct Asset
+{
+	Job job;
+
+	const char *path;		/* replaced by fallbackPath if that was loaded instead */
+	const char *fallbackPath;
+	AssetType type;
+	TextureFile textureFile;	/* mapping is NULL unless the container was loaded */
+
+	uint8_t *data;
+	size_t size;
+	int32_t width;
+	int32_t height;
+
+	uint64_t submitTicks;
+	uint64_t startTicks;
+	uint64_t endTicks;
+	uint64_t uploadTicks;	/* filled in by the caller */
+} Asset;
+
+void Asset_Load(JobSystem *jobs, Asset *asset, const char *path, AssetType type);
+
+/* Maps a texture container, decoding fallbackPath as an image if it is missing */
+void Asset_LoadTexture(
+	JobSystem *jobs,
+	Asset *asset,
+	const char *path,
+	const char *fallbackPath
+);
+
+/* Blocks until loaded; returns 0 and logs if the load failed */
+uint8_t Asset_Wait(JobSystem *jobs, Asset *asset);
+
+void Asset_Free(Asset *asset);
+
+void Asset_Report(Asset *assets, uint32_t assetCount, uint64_t startupTicks, FILE *output);
+
+#endif /* ASSETS_H */
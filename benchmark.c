@@ -0,0 +1,163 @@
+#include "benchmark.h"
+
+#include <SDL.h>
+
+static double Benchmark_TicksToMilliseconds(uint64_t ticks)
+{
+	return (ticks * 1000.0) / (double) SDL_GetPerformanceFrequency();
+}
+
+static int Benchmark_CompareDoubles(const void *a, const void *b)
+{
+	double x = *(const double*) a;
+	double y = *(const double*) b;
+	return (x > y) - (x < y);
+}
+
+void Benchmark_Init(Benchmark *benchmark, uint32_t expectedFrameCount)
+{
+	SDL_memset(benchmark, 0, sizeof(Benchmark));
+	benchmark->frameCapacity = expectedFrameCount > 0 ? expectedFrameCount : 64;
+	benchmark->frameTimes = SDL_malloc(sizeof(double) * benchmark->frameCapacity);
+}
+
+void Benchmark_Quit(Benchmark *benchmark)
+{
+	SDL_free(benchmark->frameTimes);
+	SDL_memset(benchmark, 0, sizeof(Benchmark));
+}
+
+void Benchmark_BeginFrame(Benchmark *benchmark)
+{
+	benchmark->frameStart = SDL_GetPerformanceCounter();
+
+	if (benchmark->frameCount == 0)
+	{
+		benchmark->firstFrameStart = benchmark->frameStart;
+	}
+}
+
+void Benchmark_EndFrame(Benchmark *benchmark)
+{
+	benchmark->lastFrameEnd = SDL_GetPerformanceCounter();
+
+	if (benchmark->frameCount == benchmark->frameCapacity)
+	{
+		benchmark->frameCapacity *= 2;
+		benchmark->frameTimes = SDL_realloc(
+			benchmark->frameTimes,
+			sizeof(double) * benchmark->frameCapacity
+		);
+	}
+
+	benchmark->frameTimes[benchmark->frameCount] = Benchmark_TicksToMilliseconds(
+		benchmark->lastFrameEnd - benchmark->frameStart
+	);
+	benchmark->frameCount += 1;
+}
+
+void Benchmark_Summarize(
+	const double *samples,
+	uint32_t sampleCount,
+	BenchmarkSummary *summary
+) {
+	SDL_memset(summary, 0, sizeof(BenchmarkSummary));
+	summary->count = sampleCount;
+
+	if (sampleCount == 0)
+	{
+		return;
+	}
+
+	double *sorted = SDL_malloc(sizeof(double) * sampleCount);
+	SDL_memcpy(sorted, samples, sizeof(double) * sampleCount);
+	SDL_qsort(sorted, sampleCount, sizeof(double), Benchmark_CompareDoubles);
+
+	double sum = 0.0;
+	for (uint32_t i = 0; i < sampleCount; i++)
+	{
+		sum += sorted[i];
+	}
+
+	uint32_t p99Index = (uint32_t) SDL_ceil(sampleCount * 0.99) - 1;
+
+	summary->min = sorted[0];
+	summary->median = sorted[sampleCount / 2];
+	summary->p99 = sorted[p99Index];
+	summary->max = sorted[sampleCount - 1];
+	summary->mean = sum / sampleCount;
+
+	SDL_free(sorted);
+}
+
+void Benchmark_Report(Benchmark *benchmark, const char *name, FILE *output)
+{
+	BenchmarkSummary summary;
+	Benchmark_Summarize(benchmark->frameTimes, benchmark->frameCount, &summary);
+
+	if (summary.count == 0)
+	{
+		fprintf(output, "%s: no frames recorded\n", name);
+		return;
+	}
+
+	double totalSeconds = Benchmark_TicksToMilliseconds(
+		benchmark->lastFrameEnd - benchmark->firstFrameStart
+	) / 1000.0;
+
+	fprintf(output, "%s: %u frames in %.3f s\n", name, summary.count, totalSeconds);
+	fprintf(output, "  cpu frame time (ms)  min %8.3f  median %8.3f  p99 %8.3f  max %8.3f\n",
+		summary.min,
+		summary.median,
+		summary.p99,
+		summary.max
+	);
+	fprintf(output, "  throughput           %.2f frames/s\n", summary.count / totalSeconds);
+	fflush(output);
+}
+
+void Benchmark_ReportSplit(
+	Benchmark *benchmark,
+	const char *firstName,
+	const char *secondName,
+	uint32_t splitFrame,
+	FILE *output
+) {
+	BenchmarkSummary summaries[2];
+	const char *names[2] = { firstName, secondName };
+
+	splitFrame = SDL_min(splitFrame, benchmark->frameCount);
+	Benchmark_Summarize(benchmark->frameTimes, splitFrame, &summaries[0]);
+	Benchmark_Summarize(
+		benchmark->frameTimes + splitFrame,
+		benchmark->frameCount - splitFrame,
+		&summaries[1]
+	);
+
+	fprintf(output, "cpu frame time (ms)   frames       min    median       p99      mean\n");
+	for (uint32_t i = 0; i < 2; i++)
+	{
+		fprintf(
+			output,
+			"  %-18s %7u  %8.3f  %8.3f  %8.3f  %8.3f\n",
+			names[i],
+			summaries[i].count,
+			summaries[i].min,
+			summaries[i].median,
+			summaries[i].p99,
+			summaries[i].mean
+		);
+	}
+
+	if (summaries[0].count > 0 && summaries[1].count > 0)
+	{
+		fprintf(
+			output,
+			"  %s / %s median: %.2fx\n",
+			secondName,
+			firstName,
+			summaries[1].median / summaries[0].median
+		);
+	}
+	fflush(output);
+}
@@ -0,0 +1,54 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+typedef struct BenchmarkSummary
+{
+	uint32_t count;
+	double min;
+	double median;
+	double p99;
+	double max;
+	double mean;
+} BenchmarkSummary;
+
+typedef struct Benchmark
+{
+	double *frameTimes; /* milliseconds */
+	uint32_t frameCount;
+	uint32_t frameCapacity;
+
+	uint64_t firstFrameStart;
+	uint64_t frameStart;
+	uint64_t lastFrameEnd;
+} Benchmark;
+
+void Benchmark_Init(Benchmark *benchmark, uint32_t expectedFrameCount);
+void Benchmark_Quit(Benchmark *benchmark);
+
+void Benchmark_BeginFrame(Benchmark *benchmark);
+void Benchmark_EndFrame(Benchmark *benchmark);
+
+/* Sorts a copy of the samples, percentiles use nearest-rank */
+void Benchmark_Summarize(
+	const double *samples,
+	uint32_t sampleCount,
+	BenchmarkSummary *summary
+);
+
+void Benchmark_Report(Benchmark *benchmark, const char *name, FILE *output);
+
+/* Side by side statistics for the frames before and from splitFrame on,
+ * for runs that change one thing halfway through
+ */
+void Benchmark_ReportSplit(
+	Benchmark *benchmark,
+	const char *firstName,
+	const char *secondName,
+	uint32_t splitFrame,
+	FILE *output
+);
+
+#endif /* BENCHMARK_H */
@@ -0,0 +1,168 @@
+#include "capture_stream.h"
+
+#include <SDL.h>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <signal.h>
+#endif
+
+CaptureStream* CaptureStream_Open(
+	const char *path,
+	CaptureStreamFormat format,
+	uint32_t width,
+	uint32_t height,
+	uint32_t framesPerSecond
+) {
+	FILE *file;
+	uint8_t closeFile;
+
+	if (SDL_strcmp(path, "-") == 0)
+	{
+		file = stdout;
+		closeFile = 0;
+#ifdef _WIN32
+		_setmode(_fileno(stdout), _O_BINARY);
+#else
+		/* A closed pipe should fail the write, not kill the process */
+		signal(SIGPIPE, SIG_IGN);
+#endif
+	}
+	else
+	{
+		file = fopen(path, "wb");
+		closeFile = 1;
+	}
+
+	if (file == NULL)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open capture stream %s", path);
+		return NULL;
+	}
+
+	/* Frames are written in a few large chunks, a big buffer keeps the syscall count down */
+	setvbuf(file, NULL, _IOFBF, 1 << 20);
+
+	CaptureStream *stream = SDL_malloc(sizeof(CaptureStream));
+	SDL_memset(stream, 0, sizeof(CaptureStream));
+
+	stream->file = file;
+	stream->closeFile = closeFile;
+	stream->format = format;
+	stream->width = width;
+	stream->height = height;
+
+	if (format == CAPTURE_STREAM_FORMAT_Y4M)
+	{
+		stream->planes = SDL_malloc(width * height * 3);
+
+		fprintf(
+			file,
+			"YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C444 XYSCSS=444\n",
+			width,
+			height,
+			framesPerSecond
+		);
+	}
+
+	return stream;
+}
+
+void CaptureStream_Close(CaptureStream *stream)
+{
+	fflush(stream->file);
+
+	if (stream->closeFile)
+	{
+		fclose(stream->file);
+	}
+
+	double writeSeconds = stream->writeTicks / (double) SDL_GetPerformanceFrequency();
+
+	SDL_LogInfo(
+		SDL_LOG_CATEGORY_APPLICATION,
+		"capture stream: %u frames, %.1f MB, %.1f ms/frame writing%s",
+		stream->framesWritten,
+		stream->bytesWritten / (1024.0 * 1024.0),
+		stream->framesWritten > 0 ? (writeSeconds * 1000.0) / stream->framesWritten : 0.0,
+		stream->failed ? ", WRITE FAILED" : ""
+	);
+
+	SDL_free(stream->planes);
+	SDL_free(stream);
+}
+
+/* BT.601 limited range in 8.8 fixed point */
+static void CaptureStream_ConvertToYUV444(
+	const uint8_t *pixels,
+	uint32_t pixelCount,
+	uint8_t *y,
+	uint8_t *cb,
+	uint8_t *cr
+) {
+	for (uint32_t i = 0; i < pixelCount; i++)
+	{
+		int32_t r = pixels[0];
+		int32_t g = pixels[1];
+		int32_t b = pixels[2];
+		pixels += 4;
+
+		y[i] = (uint8_t) (((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+		cb[i] = (uint8_t) (((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+		cr[i] = (uint8_t) (((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+	}
+}
+
+void CaptureStream_Consume(
+	void *userdata,
+	uint32_t captureIndex,
+	uint8_t *pixels,
+	uint32_t width,
+	uint32_t height
+) {
+	CaptureStream *stream = (CaptureStream*) userdata;
+
+	if (stream->failed)
+	{
+		return;
+	}
+
+	uint64_t writeStart = SDL_GetPerformanceCounter();
+	uint32_t pixelCount = width * height;
+	size_t written, expected;
+
+	if (stream->format == CAPTURE_STREAM_FORMAT_Y4M)
+	{
+		CaptureStream_ConvertToYUV444(
+			pixels,
+			pixelCount,
+			stream->planes,
+			stream->planes + pixelCount,
+			stream->planes + pixelCount * 2
+		);
+
+		fputs("FRAME\n", stream->file);
+		expected = pixelCount * 3;
+		written = fwrite(stream->planes, 1, expected, stream->file);
+		stream->bytesWritten += 6;
+	}
+	else
+	{
+		expected = pixelCount * 4;
+		written = fwrite(pixels, 1, expected, stream->file);
+	}
+
+	if (written != expected)
+	{
+		/* Usually the reading end of the pipe went away, stop rather than spam */
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "capture stream write failed at frame %u", captureIndex);
+		stream->failed = 1;
+		return;
+	}
+
+	stream->bytesWritten += written;
+	stream->framesWritten += 1;
+	stream->writeTicks += SDL_GetPerformanceCounter() - writeStart;
+}
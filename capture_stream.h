@@ -0,0 +1,59 @@
+#ifndef CAPTURE_STREAM_H
+#define CAPTURE_STREAM_H
+
+/* Writes every rendered frame to a file or stdout, either as raw RGBA or as
+ * a YUV4MPEG2 (Y4M) stream, for example:
+ *
+ *	RefreshTest --headless --frames 600 --capture-stream - --capture-format y4m | ffmpeg -i - out.mp4
+ *
+ * Frames arrive from a blocking ReadbackRing, whose slots are the frame pool:
+ * CaptureStream_Consume runs on the ring's worker thread and all conversion
+ * memory is allocated once up front.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+typedef enum CaptureStreamFormat
+{
+	CAPTURE_STREAM_FORMAT_RAW,	/* R8G8B8A8, one frame after another */
+	CAPTURE_STREAM_FORMAT_Y4M	/* YUV4MPEG2, 4:4:4 planar, BT.601 limited range */
+} CaptureStreamFormat;
+
+typedef struct CaptureStream
+{
+	FILE *file;
+	uint8_t closeFile;
+	CaptureStreamFormat format;
+	uint32_t width;
+	uint32_t height;
+
+	uint8_t *planes; /* Y4M conversion target, Y then Cb then Cr */
+
+	uint32_t framesWritten;
+	uint64_t bytesWritten;
+	uint64_t writeTicks;
+	uint8_t failed;
+} CaptureStream;
+
+/* A path of "-" writes to stdout */
+CaptureStream* CaptureStream_Open(
+	const char *path,
+	CaptureStreamFormat format,
+	uint32_t width,
+	uint32_t height,
+	uint32_t framesPerSecond
+);
+
+void CaptureStream_Close(CaptureStream *stream);
+
+/* ReadbackConsumeFunc, userdata is the CaptureStream */
+void CaptureStream_Consume(
+	void *userdata,
+	uint32_t captureIndex,
+	uint8_t *pixels,
+	uint32_t width,
+	uint32_t height
+);
+
+#endif /* CAPTURE_STREAM_H */
@@ -0,0 +1,292 @@
+#include "checkerboard.h"
+
+#include <SDL.h>
+
+#include "command_capture.h"
+#include "gpu_memory.h"
+
+static void Checkerboard_CreateLevel(
+	Checkerboard *checkerboard,
+	CheckerboardLevel *level,
+	uint32_t width,
+	uint32_t height,
+	Refresh_RenderPass *renderPass
+) {
+	Refresh_Device *device = checkerboard->device;
+	uint32_t shadedWidth = (width + 1) / 2;
+
+	level->width = width;
+	level->height = height;
+
+	level->shadedArea.x = 0;
+	level->shadedArea.y = 0;
+	level->shadedArea.w = shadedWidth;
+	level->shadedArea.h = height;
+
+	level->shadedViewport.x = 0;
+	level->shadedViewport.y = 0;
+	level->shadedViewport.w = (float) shadedWidth;
+	level->shadedViewport.h = (float) height;
+	level->shadedViewport.minDepth = 0;
+	level->shadedViewport.maxDepth = 1;
+
+	level->shadedTexture = CommandCapture_CreateTexture2D(
+		device,
+		REFRESH_COLORFORMAT_R8G8B8A8,
+		shadedWidth,
+		height,
+		1,
+		REFRESH_TEXTUREUSAGE_COLOR_TARGET_BIT | REFRESH_TEXTUREUSAGE_SAMPLER_BIT
+	);
+	GpuMemory_AddTexture(
+		level->shadedTexture,
+		REFRESH_COLORFORMAT_R8G8B8A8,
+		shadedWidth,
+		height,
+		1,
+		REFRESH_TEXTUREUSAGE_COLOR_TARGET_BIT | REFRESH_TEXTUREUSAGE_SAMPLER_BIT
+	);
+
+	Refresh_TextureSlice shadedSlice;
+	shadedSlice.texture = level->shadedTexture;
+	shadedSlice.rectangle = level->shadedArea;
+	shadedSlice.depth = 0;
+	shadedSlice.layer = 0;
+	shadedSlice.level = 0;
+
+	level->shadedColorTarget = CommandCapture_CreateColorTarget(
+		device,
+		REFRESH_SAMPLECOUNT_1,
+		&shadedSlice
+	);
+
+	Refresh_FramebufferCreateInfo framebufferCreateInfo;
+	framebufferCreateInfo.width = shadedWidth;
+	framebufferCreateInfo.height = height;
+	framebufferCreateInfo.colorTargetCount = 1;
+	framebufferCreateInfo.pColorTargets = &level->shadedColorTarget;
+	framebufferCreateInfo.pDepthStencilTarget = NULL;
+	framebufferCreateInfo.renderPass = renderPass;
+
+	level->shadedFramebuffer = CommandCapture_CreateFramebuffer(device, &framebufferCreateInfo);
+
+	level->historyTexture = CommandCapture_CreateTexture2D(
+		device,
+		REFRESH_COLORFORMAT_R8G8B8A8,
+		width,
+		height,
+		1,
+		REFRESH_TEXTUREUSAGE_SAMPLER_BIT
+	);
+	GpuMemory_AddTexture(level->historyTexture, REFRESH_COLORFORMAT_R8G8B8A8, width, height, 1, REFRESH_TEXTUREUSAGE_SAMPLER_BIT);
+
+	level->historySlice.texture = level->historyTexture;
+	level->historySlice.rectangle.x = 0;
+	level->historySlice.rectangle.y = 0;
+	level->historySlice.rectangle.w = width;
+	level->historySlice.rectangle.h = height;
+	level->historySlice.depth = 0;
+	level->historySlice.layer = 0;
+	level->historySlice.level = 0;
+}
+
+Checkerboard* Checkerboard_Create(
+	Refresh_Device *device,
+	DynamicResolution *resolution,
+	Refresh_RenderPass *renderPass,
+	Refresh_Sampler *sampler
+) {
+	Checkerboard *checkerboard = SDL_malloc(sizeof(Checkerboard));
+	SDL_memset(checkerboard, 0, sizeof(Checkerboard));
+
+	checkerboard->device = device;
+	checkerboard->renderPass = renderPass;
+	checkerboard->sampler = sampler;
+	checkerboard->historyLevel = -1;
+
+	checkerboard->levelCount = resolution->levelCount;
+	for (uint32_t i = 0; i < resolution->levelCount; i++)
+	{
+		Checkerboard_CreateLevel(
+			checkerboard,
+			&checkerboard->levels[i],
+			resolution->levels[i].width,
+			resolution->levels[i].height,
+			renderPass
+		);
+	}
+
+	return checkerboard;
+}
+
+void Checkerboard_CreatePipelines(
+	Checkerboard *checkerboard,
+	Refresh_GraphicsPipelineCreateInfo *createInfos,
+	uint32_t pipelineCount,
+	Refresh_GraphicsPipelineCreateInfo *resolveCreateInfo
+) {
+	pipelineCount = SDL_min(pipelineCount, DYNAMIC_RESOLUTION_PIPELINES_MAX);
+
+	for (uint32_t i = 0; i < checkerboard->levelCount; i++)
+	{
+		CheckerboardLevel *level = &checkerboard->levels[i];
+
+		for (uint32_t j = 0; j < pipelineCount; j++)
+		{
+			Refresh_GraphicsPipelineCreateInfo levelCreateInfo = createInfos[j];
+			levelCreateInfo.viewportState.viewports = &level->shadedViewport;
+			levelCreateInfo.viewportState.viewportCount = 1;
+			levelCreateInfo.viewportState.scissors = &level->shadedArea;
+			levelCreateInfo.viewportState.scissorCount = 1;
+
+			level->pipelines[j] = CommandCapture_CreateGraphicsPipeline(checkerboard->device, &levelCreateInfo);
+		}
+
+		Refresh_Viewport viewport;
+		viewport.x = 0;
+		viewport.y = 0;
+		viewport.w = (float) level->width;
+		viewport.h = (float) level->height;
+		viewport.minDepth = 0;
+		viewport.maxDepth = 1;
+
+		Refresh_GraphicsPipelineCreateInfo levelResolveCreateInfo = *resolveCreateInfo;
+		levelResolveCreateInfo.viewportState.viewports = &viewport;
+		levelResolveCreateInfo.viewportState.viewportCount = 1;
+		levelResolveCreateInfo.viewportState.scissors = &level->historySlice.rectangle;
+		levelResolveCreateInfo.viewportState.scissorCount = 1;
+
+		level->resolvePipeline = CommandCapture_CreateGraphicsPipeline(checkerboard->device, &levelResolveCreateInfo);
+	}
+}
+
+void Checkerboard_Destroy(Checkerboard *checkerboard)
+{
+	for (uint32_t i = 0; i < checkerboard->levelCount; i++)
+	{
+		CheckerboardLevel *level = &checkerboard->levels[i];
+
+		for (uint32_t j = 0; j < DYNAMIC_RESOLUTION_PIPELINES_MAX; j++)
+		{
+			if (level->pipelines[j] != NULL)
+			{
+				CommandCapture_QueueDestroyGraphicsPipeline(checkerboard->device, level->pipelines[j]);
+			}
+		}
+		if (level->resolvePipeline != NULL)
+		{
+			CommandCapture_QueueDestroyGraphicsPipeline(checkerboard->device, level->resolvePipeline);
+		}
+
+		CommandCapture_QueueDestroyFramebuffer(checkerboard->device, level->shadedFramebuffer);
+		CommandCapture_QueueDestroyColorTarget(checkerboard->device, level->shadedColorTarget);
+		GpuMemory_Remove(level->shadedTexture);
+		CommandCapture_QueueDestroyTexture(checkerboard->device, level->shadedTexture);
+		GpuMemory_Remove(level->historyTexture);
+		CommandCapture_QueueDestroyTexture(checkerboard->device, level->historyTexture);
+	}
+
+	SDL_free(checkerboard);
+}
+
+void Checkerboard_Invalidate(Checkerboard *checkerboard)
+{
+	checkerboard->historyLevel = -1;
+}
+
+void Checkerboard_Record(
+	Checkerboard *checkerboard,
+	Refresh_CommandBuffer *commandBuffer,
+	CheckerboardFrame *frame
+) {
+	Refresh_Device *device = checkerboard->device;
+	CheckerboardLevel *level = &checkerboard->levels[frame->level];
+	uint64_t offset = 0;
+
+	/* Half the pixels, at full cost each */
+	CommandCapture_BeginRenderPass(
+		device,
+		commandBuffer,
+		checkerboard->renderPass,
+		level->shadedFramebuffer,
+		level->shadedArea,
+		frame->clearColor,
+		1,
+		NULL
+	);
+
+	CommandCapture_BindGraphicsPipeline(device, commandBuffer, level->pipelines[frame->pipeline]);
+
+	uint32_t fragmentParamOffset = CommandCapture_PushFragmentShaderParams(device, commandBuffer, frame->fragmentUniforms, 1);
+	CommandCapture_BindVertexBuffers(device, commandBuffer, 0, 1, &frame->vertexBuffer, &offset);
+	CommandCapture_BindFragmentSamplers(device, commandBuffer, frame->textures, frame->samplers);
+	CommandCapture_DrawPrimitives(device, commandBuffer, 0, 1, 0, fragmentParamOffset);
+
+	CommandCapture_EndRenderPass(device, commandBuffer);
+
+	/* The resolve */
+	CheckerboardUniforms uniforms;
+	uniforms.phase = (float) checkerboard->phase;
+	uniforms.historyWeight = checkerboard->historyLevel == (int32_t) frame->level ? 1.0f : 0.0f;
+
+	if (uniforms.historyWeight == 0.0f)
+	{
+		checkerboard->historyMissCount += 1;
+	}
+
+	CommandCapture_BeginRenderPass(
+		device,
+		commandBuffer,
+		checkerboard->renderPass,
+		frame->framebuffer,
+		level->historySlice.rectangle,
+		frame->clearColor,
+		1,
+		NULL
+	);
+
+	CommandCapture_BindGraphicsPipeline(device, commandBuffer, level->resolvePipeline);
+
+	Refresh_Texture *resolveTextures[2];
+	resolveTextures[0] = level->shadedTexture;
+	resolveTextures[1] = level->historyTexture;
+
+	Refresh_Sampler *resolveSamplers[2];
+	resolveSamplers[0] = checkerboard->sampler;
+	resolveSamplers[1] = checkerboard->sampler;
+
+	fragmentParamOffset = CommandCapture_PushFragmentShaderParams(device, commandBuffer, &uniforms, 1);
+	CommandCapture_BindVertexBuffers(device, commandBuffer, 0, 1, &frame->vertexBuffer, &offset);
+	CommandCapture_BindFragmentSamplers(device, commandBuffer, resolveTextures, resolveSamplers);
+	CommandCapture_DrawPrimitives(device, commandBuffer, 0, 1, 0, fragmentParamOffset);
+
+	CommandCapture_EndRenderPass(device, commandBuffer);
+
+	/* Next frame's history; the interop target itself may be in FNA3D's hands by then */
+	CommandCapture_CopyTextureToTexture(
+		device,
+		commandBuffer,
+		frame->slice,
+		&level->historySlice,
+		REFRESH_FILTER_NEAREST
+	);
+
+	checkerboard->historyLevel = (int32_t) frame->level;
+	checkerboard->phase ^= 1;
+	checkerboard->frameCount += 1;
+}
+
+void Checkerboard_Report(Checkerboard *checkerboard, FILE *output)
+{
+	if (checkerboard->frameCount == 0)
+	{
+		return;
+	}
+
+	fprintf(
+		output,
+		"checkerboard: %u frames at half rate, %u resolved without history\n",
+		checkerboard->frameCount,
+		checkerboard->historyMissCount
+	);
+}
@@ -0,0 +1,126 @@
+#ifndef CHECKERBOARD_H
+#define CHECKERBOARD_H
+
+/* --checkerboard: the raymarch pass shades half the pixels each frame and
+ * a resolve pass fills in the other half from the previous frame.
+ *
+ * The shaded pixels form a checkerboard whose phase flips every frame.
+ * Refresh bakes the viewport into the pipeline and has no per-sample
+ * masks, so the raymarch shader is specialized with CHECKERBOARD and draws
+ * into a half-width target instead: column x of row y is full-resolution
+ * pixel 2x + ((y + phase) & 1), which keeps the fragment count at half.
+ *
+ * The resolve pass writes the full-resolution interop target. Pixels
+ * shaded this frame are copied; each of the others takes last frame's
+ * value, clamped to the range of its four shaded neighbours so that moving
+ * edges don't smear. The shaders are functions of time and pixel position
+ * with no motion vectors to reproject by, and the clamp is what keeps the
+ * reconstruction honest. Without history, on the first frame or after a
+ * resolution level change, the neighbours' average is used instead.
+ *
+ * Each level keeps its own history, a copy of the resolved target, since
+ * FNA3D may still be sampling the interop target when the next frame
+ * resolves.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <Refresh.h>
+
+#include "dynamic_resolution.h"
+
+typedef struct CheckerboardUniforms
+{
+	float phase, historyWeight;
+} CheckerboardUniforms;
+
+typedef struct CheckerboardLevel
+{
+	uint32_t width;
+	uint32_t height;
+
+	/* Half the columns, rounded up */
+	Refresh_Texture *shadedTexture;
+	Refresh_ColorTarget *shadedColorTarget;
+	Refresh_Framebuffer *shadedFramebuffer;
+	Refresh_Rect shadedArea;
+	Refresh_Viewport shadedViewport;
+
+	Refresh_Texture *historyTexture;
+	Refresh_TextureSlice historySlice;
+
+	Refresh_GraphicsPipeline *pipelines[DYNAMIC_RESOLUTION_PIPELINES_MAX];
+	Refresh_GraphicsPipeline *resolvePipeline;
+} CheckerboardLevel;
+
+/* What one frame draws with */
+typedef struct CheckerboardFrame
+{
+	uint32_t level;
+	uint32_t pipeline;
+	Refresh_Framebuffer *framebuffer;
+	Refresh_TextureSlice *slice;
+	Refresh_Buffer *vertexBuffer;
+	Refresh_Color *clearColor;
+	Refresh_Texture **textures;
+	Refresh_Sampler **samplers;
+
+	/* Raymarch uniforms at full resolution, with this frame's phase */
+	void *fragmentUniforms;
+} CheckerboardFrame;
+
+typedef struct Checkerboard
+{
+	Refresh_Device *device;
+	Refresh_RenderPass *renderPass;
+	Refresh_Sampler *sampler;
+
+	CheckerboardLevel levels[DYNAMIC_RESOLUTION_LEVELS_MAX];
+	uint32_t levelCount;
+
+	uint32_t phase; /* this frame's, 0 or 1 */
+	int32_t historyLevel; /* -1 when there is no history */
+
+	/* Statistics */
+	uint32_t frameCount;
+	uint32_t historyMissCount;
+} Checkerboard;
+
+/* Targets for every level of the resolution, with renderPass the one the
+ * raymarch pipelines were made for
+ */
+Checkerboard* Checkerboard_Create(
+	Refresh_Device *device,
+	DynamicResolution *resolution,
+	Refresh_RenderPass *renderPass,
+	Refresh_Sampler *sampler
+);
+
+/* pipelines[i] of each level from createInfos[i], which should use the
+ * CHECKERBOARD modules; the resolve pipeline from resolveCreateInfo
+ */
+void Checkerboard_CreatePipelines(
+	Checkerboard *checkerboard,
+	Refresh_GraphicsPipelineCreateInfo *createInfos,
+	uint32_t pipelineCount,
+	Refresh_GraphicsPipelineCreateInfo *resolveCreateInfo
+);
+
+void Checkerboard_Destroy(Checkerboard *checkerboard);
+
+/* Forgets the history, e.g. after drawing frames at full rate */
+void Checkerboard_Invalidate(Checkerboard *checkerboard);
+
+/* Records the half-rate raymarch pass, the resolve into frame->framebuffer
+ * and the copy into history, in that order
+ */
+void Checkerboard_Record(
+	Checkerboard *checkerboard,
+	Refresh_CommandBuffer *commandBuffer,
+	CheckerboardFrame *frame
+);
+
+void Checkerboard_Report(Checkerboard *checkerboard, FILE *output);
+
+#endif /* CHECKERBOARD_H */
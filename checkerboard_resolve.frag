@@ -0,0 +1,50 @@
+#version 450
+
+// Checkerboard resolve, see checkerboard.h. Pixels shaded this frame are
+// copied from the half-width target; the other half is last frame's pixel
+// clamped to the range of its four shaded neighbours, or their average
+// when there is no history.
+
+layout(set = 1, binding = 0) uniform sampler2D shaded;
+layout(set = 1, binding = 1) uniform sampler2D history;
+
+layout(set = 3, binding = 0) uniform UniformBlock
+{
+    float phase;
+    float historyWeight;
+} Uniforms;
+
+layout(location = 0) out vec4 fragColor;
+
+vec3 fetchShaded( ivec2 pixel )
+{
+    ivec2 size = textureSize(shaded, 0);
+    ivec2 texel = clamp(ivec2(pixel.x>>1, pixel.y), ivec2(0), size-1);
+    return texelFetch(shaded, texel, 0).rgb;
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    int phase = int(Uniforms.phase);
+
+    if( ((pixel.x + pixel.y + phase)&1) == 0 )
+    {
+        fragColor = vec4(fetchShaded(pixel), 1.0);
+        return;
+    }
+
+    // every horizontal and vertical neighbour was shaded this frame
+    vec3 l = fetchShaded(pixel + ivec2(-1, 0));
+    vec3 r = fetchShaded(pixel + ivec2( 1, 0));
+    vec3 u = fetchShaded(pixel + ivec2( 0,-1));
+    vec3 d = fetchShaded(pixel + ivec2( 0, 1));
+
+    vec3 lo = min(min(l,r),min(u,d));
+    vec3 hi = max(max(l,r),max(u,d));
+    vec3 spatial = 0.25*(l+r+u+d);
+
+    vec3 previous = clamp(texelFetch(history, pixel, 0).rgb, lo, hi);
+
+    fragColor = vec4(mix(spatial, previous, Uniforms.historyWeight), 1.0);
+}
@@ -3,14 +3,32 @@
 layout(set = 3, binding = 0) uniform UniformBlock
 {
     float time;
+    float checkerboardPhase;
+    vec2 resolution;
 } Uniforms;
 
-layout(location = 0) in vec2 fragCoord;
-
 layout(location = 0) out vec4 FragColor;
 
+// Shade half the pixels into a half-width target, see checkerboard.h
+layout(constant_id = 0) const bool CHECKERBOARD = false;
+
 void main()
 {
+    vec2 pixel = gl_FragCoord.xy;
+
+    // each half-width column is every other pixel of its row, starting
+    // on the left or the right one by row and frame
+    if( CHECKERBOARD )
+    {
+        int row = int(pixel.y);
+        int column = 2*int(pixel.x) + ((row + int(Uniforms.checkerboardPhase))&1);
+        pixel.x = float(column) + 0.5;
+    }
+
+    // the fullscreen triangle's texture coordinates, which span twice
+    // the screen, v up
+    vec2 fragCoord = vec2(pixel.x, 2.0*Uniforms.resolution.y - pixel.y) / (2.0*Uniforms.resolution);
+
     // Time varying pixel color
     vec3 col = 0.5 + 0.5 * cos(Uniforms.time + fragCoord.xyx + vec3(0, 2, 4));
 
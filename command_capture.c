@@ -0,0 +1,1996 @@
+#include "command_capture.h"
+
+#include <stdio.h>
+
+
+#include <SDL.h>
+
+/* The layout a bind or push needs the size of, as of the pipeline's creation */
+typedef struct CapturedGraphicsPipeline
+{
+	Refresh_GraphicsPipeline *pipeline;
+	uint32_t vertexSamplerCount;
+	uint32_t fragmentSamplerCount;
+	uint64_t vertexUniformSize;
+	uint64_t fragmentUniformSize;
+} CapturedGraphicsPipeline;
+
+typedef struct CapturedComputePipeline
+{
+	Refresh_ComputePipeline *pipeline;
+	uint32_t imageCount;
+	uint64_t uniformSize;
+} CapturedComputePipeline;
+
+/* An ApplyEffect record carries the parameters MOJOSHADER holds for it */
+typedef struct CapturedEffect
+{
+	FNA3D_Effect *effect;
+	MOJOSHADER_effect *effectData;
+} CapturedEffect;
+
+/* Acquired and not yet submitted, with copies of what is bound to it */
+typedef struct CapturedCommandBuffer
+{
+	Refresh_CommandBuffer *commandBuffer;
+	CapturedGraphicsPipeline graphicsPipeline;
+	CapturedComputePipeline computePipeline;
+} CapturedCommandBuffer;
+
+static uint8_t captureEnabled = 0;
+static SDL_mutex *captureLock;
+static FILE *captureFile;
+static const char *capturePath;
+static uint8_t captureFailed;
+
+/* The record being written, sent to the file whole by CommandCapture_End */
+static uint32_t recordOp;
+static uint8_t *recordData;
+static uint32_t recordSize;
+static uint32_t recordCapacity;
+
+static uint32_t capturedFrameCount;
+static uint64_t capturedRecordCount;
+static uint64_t capturedByteCount;
+
+static CapturedGraphicsPipeline *graphicsPipelines;
+static uint32_t graphicsPipelineCount;
+static uint32_t graphicsPipelineCapacity;
+
+static CapturedComputePipeline *computePipelines;
+static uint32_t computePipelineCount;
+static uint32_t computePipelineCapacity;
+
+static CapturedCommandBuffer *openCommandBuffers;
+static uint32_t openCommandBufferCount;
+static uint32_t openCommandBufferCapacity;
+
+static CapturedEffect *effects;
+static uint32_t effectCount;
+static uint32_t effectCapacity;
+
+static void* CommandCapture_Grow(void *array, uint32_t *capacity, uint32_t count, size_t elementSize)
+{
+	if (count < *capacity)
+	{
+		return array;
+	}
+
+	*capacity = *capacity > 0 ? *capacity * 2 : 16;
+	return SDL_realloc(array, *capacity * elementSize);
+}
+
+static void CommandCapture_Begin(CommandCaptureOp op)
+{
+	recordOp = op;
+	recordSize = 0;
+}
+
+static void CommandCapture_Put(const void *data, uint32_t size)
+{
+	if (recordSize + size > recordCapacity)
+	{
+		while (recordSize + size > recordCapacity)
+		{
+			recordCapacity = recordCapacity > 0 ? recordCapacity * 2 : 4096;
+		}
+		recordData = SDL_realloc(recordData, recordCapacity);
+	}
+
+	SDL_memcpy(recordData + recordSize, data, size);
+	recordSize += size;
+}
+
+static void CommandCapture_Put32(uint32_t value)
+{
+	CommandCapture_Put(&value, sizeof(value));
+}
+
+static void CommandCapture_Put64(uint64_t value)
+{
+	CommandCapture_Put(&value, sizeof(value));
+}
+
+static void CommandCapture_PutHandle(const void *handle)
+{
+	CommandCapture_Put64((uint64_t) (uintptr_t) handle);
+}
+
+/* NULL is written as an empty string */
+static void CommandCapture_PutString(const char *string)
+{
+	uint32_t length = string != NULL ? (uint32_t) SDL_strlen(string) : 0;
+	CommandCapture_Put32(length);
+	CommandCapture_Put(string, length);
+}
+
+static void CommandCapture_PutSlice(const Refresh_TextureSlice *slice)
+{
+	CommandCapture_PutHandle(slice->texture);
+	CommandCapture_Put(&slice->rectangle, sizeof(Refresh_Rect));
+	CommandCapture_Put32(slice->depth);
+	CommandCapture_Put32(slice->layer);
+	CommandCapture_Put32(slice->level);
+}
+
+static void CommandCapture_PutShaderStage(const Refresh_ShaderStageState *stage)
+{
+	CommandCapture_PutHandle(stage->shaderModule);
+	CommandCapture_PutString(stage->entryPointName);
+	CommandCapture_Put64(stage->uniformBufferSize);
+}
+
+static void CommandCapture_End(void)
+{
+	if (captureFailed)
+	{
+		return;
+	}
+
+	CommandCaptureRecord record;
+	record.op = recordOp;
+	record.size = recordSize;
+
+	if (	fwrite(&record, sizeof(record), 1, captureFile) != 1 ||
+		(recordSize > 0 && fwrite(recordData, recordSize, 1, captureFile) != 1)	)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write command capture %s", capturePath);
+		captureFailed = 1;
+		return;
+	}
+
+	capturedRecordCount += 1;
+	capturedByteCount += sizeof(record) + recordSize;
+}
+
+static CapturedGraphicsPipeline* CommandCapture_FindGraphicsPipeline(Refresh_GraphicsPipeline *pipeline)
+{
+	for (uint32_t i = 0; i < graphicsPipelineCount; i++)
+	{
+		if (graphicsPipelines[i].pipeline == pipeline)
+		{
+			return &graphicsPipelines[i];
+		}
+	}
+
+	return NULL;
+}
+
+static CapturedEffect* CommandCapture_FindEffect(FNA3D_Effect *effect)
+{
+	for (uint32_t i = 0; i < effectCount; i++)
+	{
+		if (effects[i].effect == effect)
+		{
+			return &effects[i];
+		}
+	}
+
+	return NULL;
+}
+
+static CapturedComputePipeline* CommandCapture_FindComputePipeline(Refresh_ComputePipeline *pipeline)
+{
+	for (uint32_t i = 0; i < computePipelineCount; i++)
+	{
+		if (computePipelines[i].pipeline == pipeline)
+		{
+			return &computePipelines[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* Command buffers we haven't seen acquired are added with nothing bound */
+static CapturedCommandBuffer* CommandCapture_FindCommandBuffer(Refresh_CommandBuffer *commandBuffer)
+{
+	for (uint32_t i = 0; i < openCommandBufferCount; i++)
+	{
+		if (openCommandBuffers[i].commandBuffer == commandBuffer)
+		{
+			return &openCommandBuffers[i];
+		}
+	}
+
+	openCommandBuffers = CommandCapture_Grow(
+		openCommandBuffers,
+		&openCommandBufferCapacity,
+		openCommandBufferCount,
+		sizeof(CapturedCommandBuffer)
+	);
+
+	CapturedCommandBuffer *captured = &openCommandBuffers[openCommandBufferCount++];
+	SDL_memset(captured, 0, sizeof(CapturedCommandBuffer));
+	captured->commandBuffer = commandBuffer;
+	return captured;
+}
+
+uint8_t CommandCapture_Open(const char *path)
+{
+	captureFile = fopen(path, "wb");
+	if (captureFile == NULL)
+	{
+		return 0;
+	}
+
+	CommandCaptureHeader header;
+	header.magic = COMMAND_CAPTURE_MAGIC;
+	header.version = COMMAND_CAPTURE_VERSION;
+	fwrite(&header, sizeof(header), 1, captureFile);
+
+	capturePath = path;
+	captureFailed = 0;
+	captureLock = SDL_CreateMutex();
+	captureEnabled = 1;
+	return 1;
+}
+
+void CommandCapture_Close(void)
+{
+	if (!captureEnabled)
+	{
+		return;
+	}
+
+	captureEnabled = 0;
+
+	if (fclose(captureFile) != 0)
+	{
+		captureFailed = 1;
+	}
+
+	if (!captureFailed)
+	{
+		SDL_LogInfo(
+			SDL_LOG_CATEGORY_APPLICATION,
+			"Captured %u frames, %llu calls, %.1f MB to %s",
+			capturedFrameCount,
+			(unsigned long long) capturedRecordCount,
+			capturedByteCount / (1024.0 * 1024.0),
+			capturePath
+		);
+	}
+
+	SDL_DestroyMutex(captureLock);
+	SDL_free(recordData);
+	SDL_free(graphicsPipelines);
+	SDL_free(computePipelines);
+	SDL_free(openCommandBuffers);
+	SDL_free(effects);
+
+	recordData = NULL;
+	recordCapacity = 0;
+	graphicsPipelines = NULL;
+	graphicsPipelineCount = graphicsPipelineCapacity = 0;
+	computePipelines = NULL;
+	computePipelineCount = computePipelineCapacity = 0;
+	openCommandBuffers = NULL;
+	openCommandBufferCount = openCommandBufferCapacity = 0;
+	effects = NULL;
+	effectCount = effectCapacity = 0;
+}
+
+void CommandCapture_EndFrame(void)
+{
+	if (!captureEnabled)
+	{
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_FRAME);
+	CommandCapture_End();
+	capturedFrameCount += 1;
+	SDL_UnlockMutex(captureLock);
+}
+
+/* Object creation */
+
+Refresh_Texture* CommandCapture_CreateTexture2D(
+	Refresh_Device *device,
+	Refresh_ColorFormat format,
+	uint32_t width,
+	uint32_t height,
+	uint32_t levelCount,
+	Refresh_TextureUsageFlags usageFlags
+) {
+	if (!captureEnabled)
+	{
+		return Refresh_CreateTexture2D(device, format, width, height, levelCount, usageFlags);
+	}
+
+	SDL_LockMutex(captureLock);
+	Refresh_Texture *texture = Refresh_CreateTexture2D(device, format, width, height, levelCount, usageFlags);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_CREATE_TEXTURE_2D);
+	CommandCapture_PutHandle(texture);
+	CommandCapture_Put32(format);
+	CommandCapture_Put32(width);
+	CommandCapture_Put32(height);
+	CommandCapture_Put32(levelCount);
+	CommandCapture_Put32(usageFlags);
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+	return texture;
+}
+
+Refresh_ColorTarget* CommandCapture_CreateColorTarget(
+	Refresh_Device *device,
+	Refresh_SampleCount multisampleCount,
+	Refresh_TextureSlice *textureSlice
+) {
+	if (!captureEnabled)
+	{
+		return Refresh_CreateColorTarget(device, multisampleCount, textureSlice);
+	}
+
+	SDL_LockMutex(captureLock);
+	Refresh_ColorTarget *colorTarget = Refresh_CreateColorTarget(device, multisampleCount, textureSlice);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_CREATE_COLOR_TARGET);
+	CommandCapture_PutHandle(colorTarget);
+	CommandCapture_Put32(multisampleCount);
+	CommandCapture_PutSlice(textureSlice);
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+	return colorTarget;
+}
+
+Refresh_DepthStencilTarget* CommandCapture_CreateDepthStencilTarget(
+	Refresh_Device *device,
+	uint32_t width,
+	uint32_t height,
+	Refresh_DepthFormat format
+) {
+	if (!captureEnabled)
+	{
+		return Refresh_CreateDepthStencilTarget(device, width, height, format);
+	}
+
+	SDL_LockMutex(captureLock);
+	Refresh_DepthStencilTarget *depthStencilTarget = Refresh_CreateDepthStencilTarget(device, width, height, format);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_CREATE_DEPTH_STENCIL_TARGET);
+	CommandCapture_PutHandle(depthStencilTarget);
+	CommandCapture_Put32(width);
+	CommandCapture_Put32(height);
+	CommandCapture_Put32(format);
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+	return depthStencilTarget;
+}
+
+Refresh_Framebuffer* CommandCapture_CreateFramebuffer(
+	Refresh_Device *device,
+	Refresh_FramebufferCreateInfo *framebufferCreateInfo
+) {
+	if (!captureEnabled)
+	{
+		return Refresh_CreateFramebuffer(device, framebufferCreateInfo);
+	}
+
+	SDL_LockMutex(captureLock);
+	Refresh_Framebuffer *framebuffer = Refresh_CreateFramebuffer(device, framebufferCreateInfo);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_CREATE_FRAMEBUFFER);
+	CommandCapture_PutHandle(framebuffer);
+	CommandCapture_PutHandle(framebufferCreateInfo->renderPass);
+	CommandCapture_Put32(framebufferCreateInfo->colorTargetCount);
+	for (uint32_t i = 0; i < framebufferCreateInfo->colorTargetCount; i++)
+	{
+		CommandCapture_PutHandle(framebufferCreateInfo->pColorTargets[i]);
+	}
+	CommandCapture_PutHandle(framebufferCreateInfo->pDepthStencilTarget);
+	CommandCapture_Put32(framebufferCreateInfo->width);
+	CommandCapture_Put32(framebufferCreateInfo->height);
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+	return framebuffer;
+}
+
+Refresh_RenderPass* CommandCapture_CreateRenderPass(
+	Refresh_Device *device,
+	Refresh_RenderPassCreateInfo *renderPassCreateInfo
+) {
+	if (!captureEnabled)
+	{
+		return Refresh_CreateRenderPass(device, renderPassCreateInfo);
+	}
+
+	SDL_LockMutex(captureLock);
+	Refresh_RenderPass *renderPass = Refresh_CreateRenderPass(device, renderPassCreateInfo);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_CREATE_RENDER_PASS);
+	CommandCapture_PutHandle(renderPass);
+	CommandCapture_Put32(renderPassCreateInfo->colorTargetCount);
+	CommandCapture_Put(
+		renderPassCreateInfo->colorTargetDescriptions,
+		sizeof(Refresh_ColorTargetDescription) * renderPassCreateInfo->colorTargetCount
+	);
+	CommandCapture_Put32(renderPassCreateInfo->depthTargetDescription != NULL);
+	if (renderPassCreateInfo->depthTargetDescription != NULL)
+	{
+		CommandCapture_Put(
+			renderPassCreateInfo->depthTargetDescription,
+			sizeof(Refresh_DepthStencilTargetDescription)
+		);
+	}
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+	return renderPass;
+}
+
+Refresh_ShaderModule* CommandCapture_CreateShaderModule(
+	Refresh_Device *device,
+	Refresh_ShaderModuleCreateInfo *shaderModuleCreateInfo
+) {
+	if (!captureEnabled)
+	{
+		return Refresh_CreateShaderModule(device, shaderModuleCreateInfo);
+	}
+
+	SDL_LockMutex(captureLock);
+	Refresh_ShaderModule *shaderModule = Refresh_CreateShaderModule(device, shaderModuleCreateInfo);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_CREATE_SHADER_MODULE);
+	CommandCapture_PutHandle(shaderModule);
+	CommandCapture_Put32((uint32_t) shaderModuleCreateInfo->codeSize);
+	CommandCapture_Put(shaderModuleCreateInfo->byteCode, (uint32_t) shaderModuleCreateInfo->codeSize);
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+	return shaderModule;
+}
+
+Refresh_Sampler* CommandCapture_CreateSampler(
+	Refresh_Device *device,
+	Refresh_SamplerStateCreateInfo *samplerStateCreateInfo
+) {
+	if (!captureEnabled)
+	{
+		return Refresh_CreateSampler(device, samplerStateCreateInfo);
+	}
+
+	SDL_LockMutex(captureLock);
+	Refresh_Sampler *sampler = Refresh_CreateSampler(device, samplerStateCreateInfo);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_CREATE_SAMPLER);
+	CommandCapture_PutHandle(sampler);
+	CommandCapture_Put(samplerStateCreateInfo, sizeof(Refresh_SamplerStateCreateInfo));
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+	return sampler;
+}
+
+Refresh_Buffer* CommandCapture_CreateBuffer(
+	Refresh_Device *device,
+	Refresh_BufferUsageFlags usageFlags,
+	uint32_t sizeInBytes
+) {
+	if (!captureEnabled)
+	{
+		return Refresh_CreateBuffer(device, usageFlags, sizeInBytes);
+	}
+
+	SDL_LockMutex(captureLock);
+	Refresh_Buffer *buffer = Refresh_CreateBuffer(device, usageFlags, sizeInBytes);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_CREATE_BUFFER);
+	CommandCapture_PutHandle(buffer);
+	CommandCapture_Put32(usageFlags);
+	CommandCapture_Put32(sizeInBytes);
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+	return buffer;
+}
+
+Refresh_ComputePipeline* CommandCapture_CreateComputePipeline(
+	Refresh_Device *device,
+	Refresh_ComputePipelineCreateInfo *pipelineCreateInfo
+) {
+	if (!captureEnabled)
+	{
+		return Refresh_CreateComputePipeline(device, pipelineCreateInfo);
+	}
+
+	SDL_LockMutex(captureLock);
+	Refresh_ComputePipeline *pipeline = Refresh_CreateComputePipeline(device, pipelineCreateInfo);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_CREATE_COMPUTE_PIPELINE);
+	CommandCapture_PutHandle(pipeline);
+	CommandCapture_PutShaderStage(&pipelineCreateInfo->computeShaderState);
+	CommandCapture_Put(
+		&pipelineCreateInfo->pipelineLayoutCreateInfo,
+		sizeof(Refresh_ComputePipelineLayoutCreateInfo)
+	);
+	CommandCapture_End();
+
+	computePipelines = CommandCapture_Grow(
+		computePipelines,
+		&computePipelineCapacity,
+		computePipelineCount,
+		sizeof(CapturedComputePipeline)
+	);
+
+	CapturedComputePipeline *captured = &computePipelines[computePipelineCount++];
+	captured->pipeline = pipeline;
+	captured->imageCount = pipelineCreateInfo->pipelineLayoutCreateInfo.imageBindingCount;
+	captured->uniformSize = pipelineCreateInfo->computeShaderState.uniformBufferSize;
+
+	SDL_UnlockMutex(captureLock);
+	return pipeline;
+}
+
+Refresh_GraphicsPipeline* CommandCapture_CreateGraphicsPipeline(
+	Refresh_Device *device,
+	Refresh_GraphicsPipelineCreateInfo *pipelineCreateInfo
+) {
+	if (!captureEnabled)
+	{
+		return Refresh_CreateGraphicsPipeline(device, pipelineCreateInfo);
+	}
+
+	SDL_LockMutex(captureLock);
+	Refresh_GraphicsPipeline *pipeline = Refresh_CreateGraphicsPipeline(device, pipelineCreateInfo);
+
+	const Refresh_VertexInputState *vertexInputState = &pipelineCreateInfo->vertexInputState;
+	const Refresh_ViewportState *viewportState = &pipelineCreateInfo->viewportState;
+	const Refresh_ColorBlendState *colorBlendState = &pipelineCreateInfo->colorBlendState;
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_CREATE_GRAPHICS_PIPELINE);
+	CommandCapture_PutHandle(pipeline);
+	CommandCapture_PutShaderStage(&pipelineCreateInfo->vertexShaderState);
+	CommandCapture_PutShaderStage(&pipelineCreateInfo->fragmentShaderState);
+
+	CommandCapture_Put32(vertexInputState->vertexBindingCount);
+	CommandCapture_Put(
+		vertexInputState->vertexBindings,
+		sizeof(Refresh_VertexBinding) * vertexInputState->vertexBindingCount
+	);
+	CommandCapture_Put32(vertexInputState->vertexAttributeCount);
+	CommandCapture_Put(
+		vertexInputState->vertexAttributes,
+		sizeof(Refresh_VertexAttribute) * vertexInputState->vertexAttributeCount
+	);
+
+	CommandCapture_Put32(pipelineCreateInfo->topologyState.topology);
+
+	CommandCapture_Put32(viewportState->viewportCount);
+	CommandCapture_Put(viewportState->viewports, sizeof(Refresh_Viewport) * viewportState->viewportCount);
+	CommandCapture_Put32(viewportState->scissorCount);
+	CommandCapture_Put(viewportState->scissors, sizeof(Refresh_Rect) * viewportState->scissorCount);
+
+	CommandCapture_Put(&pipelineCreateInfo->rasterizerState, sizeof(Refresh_RasterizerState));
+	CommandCapture_Put(&pipelineCreateInfo->multisampleState, sizeof(Refresh_MultisampleState));
+	CommandCapture_Put(&pipelineCreateInfo->depthStencilState, sizeof(Refresh_DepthStencilState));
+
+	CommandCapture_Put32(colorBlendState->logicOpEnable);
+	CommandCapture_Put32(colorBlendState->logicOp);
+	CommandCapture_Put32(colorBlendState->blendStateCount);
+	CommandCapture_Put(
+		colorBlendState->blendStates,
+		sizeof(Refresh_ColorTargetBlendState) * colorBlendState->blendStateCount
+	);
+	CommandCapture_Put(colorBlendState->blendConstants, sizeof(colorBlendState->blendConstants));
+
+	CommandCapture_Put(
+		&pipelineCreateInfo->pipelineLayoutCreateInfo,
+		sizeof(Refresh_GraphicsPipelineLayoutCreateInfo)
+	);
+	CommandCapture_PutHandle(pipelineCreateInfo->renderPass);
+	CommandCapture_End();
+
+	graphicsPipelines = CommandCapture_Grow(
+		graphicsPipelines,
+		&graphicsPipelineCapacity,
+		graphicsPipelineCount,
+		sizeof(CapturedGraphicsPipeline)
+	);
+
+	CapturedGraphicsPipeline *captured = &graphicsPipelines[graphicsPipelineCount++];
+	captured->pipeline = pipeline;
+	captured->vertexSamplerCount = pipelineCreateInfo->pipelineLayoutCreateInfo.vertexSamplerBindingCount;
+	captured->fragmentSamplerCount = pipelineCreateInfo->pipelineLayoutCreateInfo.fragmentSamplerBindingCount;
+	captured->vertexUniformSize = pipelineCreateInfo->vertexShaderState.uniformBufferSize;
+	captured->fragmentUniformSize = pipelineCreateInfo->fragmentShaderState.uniformBufferSize;
+
+	SDL_UnlockMutex(captureLock);
+	return pipeline;
+}
+
+/* Data transfer */
+
+void CommandCapture_SetTextureData(
+	Refresh_Device *device,
+	Refresh_TextureSlice *textureSlice,
+	void *data,
+	uint32_t dataLengthInBytes
+) {
+	if (!captureEnabled)
+	{
+		Refresh_SetTextureData(device, textureSlice, data, dataLengthInBytes);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	Refresh_SetTextureData(device, textureSlice, data, dataLengthInBytes);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_SET_TEXTURE_DATA);
+	CommandCapture_PutSlice(textureSlice);
+	CommandCapture_Put32(dataLengthInBytes);
+	CommandCapture_Put(data, dataLengthInBytes);
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+}
+
+void CommandCapture_SetBufferData(
+	Refresh_Device *device,
+	Refresh_Buffer *buffer,
+	uint32_t offsetInBytes,
+	void *data,
+	uint32_t dataLength
+) {
+	if (!captureEnabled)
+	{
+		Refresh_SetBufferData(device, buffer, offsetInBytes, data, dataLength);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	Refresh_SetBufferData(device, buffer, offsetInBytes, data, dataLength);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_SET_BUFFER_DATA);
+	CommandCapture_PutHandle(buffer);
+	CommandCapture_Put32(offsetInBytes);
+	CommandCapture_Put32(dataLength);
+	CommandCapture_Put(data, dataLength);
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+}
+
+/* Only the read itself is replayed, the data stays here */
+void CommandCapture_GetBufferData(
+	Refresh_Device *device,
+	Refresh_Buffer *buffer,
+	void *data,
+	uint32_t dataLengthInBytes
+) {
+	if (!captureEnabled)
+	{
+		Refresh_GetBufferData(device, buffer, data, dataLengthInBytes);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	Refresh_GetBufferData(device, buffer, data, dataLengthInBytes);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_GET_BUFFER_DATA);
+	CommandCapture_PutHandle(buffer);
+	CommandCapture_Put32(dataLengthInBytes);
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+}
+
+/* Destruction */
+
+#define COMMAND_CAPTURE_DESTROY(name, type, op) \
+	void CommandCapture_QueueDestroy##name(Refresh_Device *device, type *object) \
+	{ \
+		if (!captureEnabled) \
+		{ \
+			Refresh_QueueDestroy##name(device, object); \
+			return; \
+		} \
+	\
+		SDL_LockMutex(captureLock); \
+		Refresh_QueueDestroy##name(device, object); \
+	\
+		CommandCapture_Begin(op); \
+		CommandCapture_PutHandle(object); \
+		CommandCapture_End(); \
+	\
+		SDL_UnlockMutex(captureLock); \
+	}
+
+COMMAND_CAPTURE_DESTROY(Texture, Refresh_Texture, COMMAND_CAPTURE_OP_DESTROY_TEXTURE)
+COMMAND_CAPTURE_DESTROY(Sampler, Refresh_Sampler, COMMAND_CAPTURE_OP_DESTROY_SAMPLER)
+COMMAND_CAPTURE_DESTROY(Buffer, Refresh_Buffer, COMMAND_CAPTURE_OP_DESTROY_BUFFER)
+COMMAND_CAPTURE_DESTROY(ColorTarget, Refresh_ColorTarget, COMMAND_CAPTURE_OP_DESTROY_COLOR_TARGET)
+COMMAND_CAPTURE_DESTROY(DepthStencilTarget, Refresh_DepthStencilTarget, COMMAND_CAPTURE_OP_DESTROY_DEPTH_STENCIL_TARGET)
+COMMAND_CAPTURE_DESTROY(Framebuffer, Refresh_Framebuffer, COMMAND_CAPTURE_OP_DESTROY_FRAMEBUFFER)
+COMMAND_CAPTURE_DESTROY(ShaderModule, Refresh_ShaderModule, COMMAND_CAPTURE_OP_DESTROY_SHADER_MODULE)
+COMMAND_CAPTURE_DESTROY(RenderPass, Refresh_RenderPass, COMMAND_CAPTURE_OP_DESTROY_RENDER_PASS)
+
+/* The pipelines also leave the layout tables, so a reused pointer starts over */
+void CommandCapture_QueueDestroyComputePipeline(Refresh_Device *device, Refresh_ComputePipeline *computePipeline)
+{
+	if (!captureEnabled)
+	{
+		Refresh_QueueDestroyComputePipeline(device, computePipeline);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	Refresh_QueueDestroyComputePipeline(device, computePipeline);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_DESTROY_COMPUTE_PIPELINE);
+	CommandCapture_PutHandle(computePipeline);
+	CommandCapture_End();
+
+	CapturedComputePipeline *captured = CommandCapture_FindComputePipeline(computePipeline);
+	if (captured != NULL)
+	{
+		*captured = computePipelines[--computePipelineCount];
+	}
+
+	SDL_UnlockMutex(captureLock);
+}
+
+void CommandCapture_QueueDestroyGraphicsPipeline(Refresh_Device *device, Refresh_GraphicsPipeline *graphicsPipeline)
+{
+	if (!captureEnabled)
+	{
+		Refresh_QueueDestroyGraphicsPipeline(device, graphicsPipeline);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	Refresh_QueueDestroyGraphicsPipeline(device, graphicsPipeline);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_DESTROY_GRAPHICS_PIPELINE);
+	CommandCapture_PutHandle(graphicsPipeline);
+	CommandCapture_End();
+
+	CapturedGraphicsPipeline *captured = CommandCapture_FindGraphicsPipeline(graphicsPipeline);
+	if (captured != NULL)
+	{
+		*captured = graphicsPipelines[--graphicsPipelineCount];
+	}
+
+	SDL_UnlockMutex(captureLock);
+}
+
+/* Recording */
+
+Refresh_CommandBuffer* CommandCapture_AcquireCommandBuffer(Refresh_Device *device, uint8_t fixed)
+{
+	if (!captureEnabled)
+	{
+		return Refresh_AcquireCommandBuffer(device, fixed);
+	}
+
+	SDL_LockMutex(captureLock);
+	Refresh_CommandBuffer *commandBuffer = Refresh_AcquireCommandBuffer(device, fixed);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_ACQUIRE_COMMAND_BUFFER);
+	CommandCapture_PutHandle(commandBuffer);
+	CommandCapture_Put32(fixed);
+	CommandCapture_End();
+
+	CapturedCommandBuffer *captured = CommandCapture_FindCommandBuffer(commandBuffer);
+	SDL_memset(&captured->graphicsPipeline, 0, sizeof(CapturedGraphicsPipeline));
+	SDL_memset(&captured->computePipeline, 0, sizeof(CapturedComputePipeline));
+
+	SDL_UnlockMutex(captureLock);
+	return commandBuffer;
+}
+
+void CommandCapture_BeginRenderPass(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	Refresh_RenderPass *renderPass,
+	Refresh_Framebuffer *framebuffer,
+	Refresh_Rect renderArea,
+	Refresh_Color *pColorClearValues,
+	uint32_t colorClearCount,
+	Refresh_DepthStencilValue *depthStencilClearValue
+) {
+	if (!captureEnabled)
+	{
+		Refresh_BeginRenderPass(
+			device,
+			commandBuffer,
+			renderPass,
+			framebuffer,
+			renderArea,
+			pColorClearValues,
+			colorClearCount,
+			depthStencilClearValue
+		);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	Refresh_BeginRenderPass(
+		device,
+		commandBuffer,
+		renderPass,
+		framebuffer,
+		renderArea,
+		pColorClearValues,
+		colorClearCount,
+		depthStencilClearValue
+	);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_BEGIN_RENDER_PASS);
+	CommandCapture_PutHandle(commandBuffer);
+	CommandCapture_PutHandle(renderPass);
+	CommandCapture_PutHandle(framebuffer);
+	CommandCapture_Put(&renderArea, sizeof(Refresh_Rect));
+	CommandCapture_Put32(colorClearCount);
+	CommandCapture_Put(pColorClearValues, sizeof(Refresh_Color) * colorClearCount);
+	CommandCapture_Put32(depthStencilClearValue != NULL);
+	if (depthStencilClearValue != NULL)
+	{
+		CommandCapture_Put(depthStencilClearValue, sizeof(Refresh_DepthStencilValue));
+	}
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+}
+
+void CommandCapture_EndRenderPass(Refresh_Device *device, Refresh_CommandBuffer *commandBuffer)
+{
+	if (!captureEnabled)
+	{
+		Refresh_EndRenderPass(device, commandBuffer);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	Refresh_EndRenderPass(device, commandBuffer);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_END_RENDER_PASS);
+	CommandCapture_PutHandle(commandBuffer);
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+}
+
+void CommandCapture_BindGraphicsPipeline(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	Refresh_GraphicsPipeline *graphicsPipeline
+) {
+	if (!captureEnabled)
+	{
+		Refresh_BindGraphicsPipeline(device, commandBuffer, graphicsPipeline);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	Refresh_BindGraphicsPipeline(device, commandBuffer, graphicsPipeline);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_BIND_GRAPHICS_PIPELINE);
+	CommandCapture_PutHandle(commandBuffer);
+	CommandCapture_PutHandle(graphicsPipeline);
+	CommandCapture_End();
+
+	CapturedCommandBuffer *captured = CommandCapture_FindCommandBuffer(commandBuffer);
+	CapturedGraphicsPipeline *pipeline = CommandCapture_FindGraphicsPipeline(graphicsPipeline);
+	if (pipeline != NULL)
+	{
+		captured->graphicsPipeline = *pipeline;
+	}
+
+	SDL_UnlockMutex(captureLock);
+}
+
+void CommandCapture_BindVertexBuffers(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	uint32_t firstBinding,
+	uint32_t bindingCount,
+	Refresh_Buffer **pBuffers,
+	uint64_t *pOffsets
+) {
+	if (!captureEnabled)
+	{
+		Refresh_BindVertexBuffers(device, commandBuffer, firstBinding, bindingCount, pBuffers, pOffsets);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	Refresh_BindVertexBuffers(device, commandBuffer, firstBinding, bindingCount, pBuffers, pOffsets);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_BIND_VERTEX_BUFFERS);
+	CommandCapture_PutHandle(commandBuffer);
+	CommandCapture_Put32(firstBinding);
+	CommandCapture_Put32(bindingCount);
+	for (uint32_t i = 0; i < bindingCount; i++)
+	{
+		CommandCapture_PutHandle(pBuffers[i]);
+		CommandCapture_Put64(pOffsets[i]);
+	}
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+}
+
+static void CommandCapture_PutSamplers(
+	CommandCaptureOp op,
+	Refresh_CommandBuffer *commandBuffer,
+	uint32_t samplerCount,
+	Refresh_Texture **pTextures,
+	Refresh_Sampler **pSamplers
+) {
+	CommandCapture_Begin(op);
+	CommandCapture_PutHandle(commandBuffer);
+	CommandCapture_Put32(samplerCount);
+	for (uint32_t i = 0; i < samplerCount; i++)
+	{
+		CommandCapture_PutHandle(pTextures[i]);
+		CommandCapture_PutHandle(pSamplers[i]);
+	}
+	CommandCapture_End();
+}
+
+void CommandCapture_BindVertexSamplers(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	Refresh_Texture **pTextures,
+	Refresh_Sampler **pSamplers
+) {
+	if (!captureEnabled)
+	{
+		Refresh_BindVertexSamplers(device, commandBuffer, pTextures, pSamplers);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	Refresh_BindVertexSamplers(device, commandBuffer, pTextures, pSamplers);
+
+	CommandCapture_PutSamplers(
+		COMMAND_CAPTURE_OP_BIND_VERTEX_SAMPLERS,
+		commandBuffer,
+		CommandCapture_FindCommandBuffer(commandBuffer)->graphicsPipeline.vertexSamplerCount,
+		pTextures,
+		pSamplers
+	);
+
+	SDL_UnlockMutex(captureLock);
+}
+
+void CommandCapture_BindFragmentSamplers(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	Refresh_Texture **pTextures,
+	Refresh_Sampler **pSamplers
+) {
+	if (!captureEnabled)
+	{
+		Refresh_BindFragmentSamplers(device, commandBuffer, pTextures, pSamplers);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	Refresh_BindFragmentSamplers(device, commandBuffer, pTextures, pSamplers);
+
+	CommandCapture_PutSamplers(
+		COMMAND_CAPTURE_OP_BIND_FRAGMENT_SAMPLERS,
+		commandBuffer,
+		CommandCapture_FindCommandBuffer(commandBuffer)->graphicsPipeline.fragmentSamplerCount,
+		pTextures,
+		pSamplers
+	);
+
+	SDL_UnlockMutex(captureLock);
+}
+
+/* The offset Refresh returned goes with the data, for the replayer to map */
+static void CommandCapture_PutParams(
+	CommandCaptureOp op,
+	Refresh_CommandBuffer *commandBuffer,
+	uint32_t offset,
+	void *data,
+	uint32_t elementCount,
+	uint64_t elementSize
+) {
+	CommandCapture_Begin(op);
+	CommandCapture_PutHandle(commandBuffer);
+	CommandCapture_Put32(offset);
+	CommandCapture_Put32(elementCount);
+	CommandCapture_Put32((uint32_t) elementSize);
+	CommandCapture_Put(data, (uint32_t) (elementSize * elementCount));
+	CommandCapture_End();
+}
+
+uint32_t CommandCapture_PushVertexShaderParams(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	void *data,
+	uint32_t elementCount
+) {
+	if (!captureEnabled)
+	{
+		return Refresh_PushVertexShaderParams(device, commandBuffer, data, elementCount);
+	}
+
+	SDL_LockMutex(captureLock);
+	uint32_t offset = Refresh_PushVertexShaderParams(device, commandBuffer, data, elementCount);
+
+	CommandCapture_PutParams(
+		COMMAND_CAPTURE_OP_PUSH_VERTEX_SHADER_PARAMS,
+		commandBuffer,
+		offset,
+		data,
+		elementCount,
+		CommandCapture_FindCommandBuffer(commandBuffer)->graphicsPipeline.vertexUniformSize
+	);
+
+	SDL_UnlockMutex(captureLock);
+	return offset;
+}
+
+uint32_t CommandCapture_PushFragmentShaderParams(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	void *data,
+	uint32_t elementCount
+) {
+	if (!captureEnabled)
+	{
+		return Refresh_PushFragmentShaderParams(device, commandBuffer, data, elementCount);
+	}
+
+	SDL_LockMutex(captureLock);
+	uint32_t offset = Refresh_PushFragmentShaderParams(device, commandBuffer, data, elementCount);
+
+	CommandCapture_PutParams(
+		COMMAND_CAPTURE_OP_PUSH_FRAGMENT_SHADER_PARAMS,
+		commandBuffer,
+		offset,
+		data,
+		elementCount,
+		CommandCapture_FindCommandBuffer(commandBuffer)->graphicsPipeline.fragmentUniformSize
+	);
+
+	SDL_UnlockMutex(captureLock);
+	return offset;
+}
+
+void CommandCapture_DrawPrimitives(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	uint32_t vertexStart,
+	uint32_t primitiveCount,
+	uint32_t vertexParamOffset,
+	uint32_t fragmentParamOffset
+) {
+	if (!captureEnabled)
+	{
+		Refresh_DrawPrimitives(device, commandBuffer, vertexStart, primitiveCount, vertexParamOffset, fragmentParamOffset);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	Refresh_DrawPrimitives(device, commandBuffer, vertexStart, primitiveCount, vertexParamOffset, fragmentParamOffset);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_DRAW_PRIMITIVES);
+	CommandCapture_PutHandle(commandBuffer);
+	CommandCapture_Put32(vertexStart);
+	CommandCapture_Put32(primitiveCount);
+	CommandCapture_Put32(vertexParamOffset);
+	CommandCapture_Put32(fragmentParamOffset);
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+}
+
+void CommandCapture_Clear(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	Refresh_Rect *clearRect,
+	Refresh_ClearOptions options,
+	Refresh_Color *colors,
+	uint32_t colorCount,
+	float depth,
+	int32_t stencil
+) {
+	if (!captureEnabled)
+	{
+		Refresh_Clear(device, commandBuffer, clearRect, options, colors, colorCount, depth, stencil);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	Refresh_Clear(device, commandBuffer, clearRect, options, colors, colorCount, depth, stencil);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_CLEAR);
+	CommandCapture_PutHandle(commandBuffer);
+	CommandCapture_Put(clearRect, sizeof(Refresh_Rect));
+	CommandCapture_Put32(options);
+	CommandCapture_Put32(colorCount);
+	CommandCapture_Put(colors, sizeof(Refresh_Color) * colorCount);
+	CommandCapture_Put(&depth, sizeof(depth));
+	CommandCapture_Put32((uint32_t) stencil);
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+}
+
+void CommandCapture_BindComputePipeline(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	Refresh_ComputePipeline *computePipeline
+) {
+	if (!captureEnabled)
+	{
+		Refresh_BindComputePipeline(device, commandBuffer, computePipeline);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	Refresh_BindComputePipeline(device, commandBuffer, computePipeline);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_BIND_COMPUTE_PIPELINE);
+	CommandCapture_PutHandle(commandBuffer);
+	CommandCapture_PutHandle(computePipeline);
+	CommandCapture_End();
+
+	CapturedCommandBuffer *captured = CommandCapture_FindCommandBuffer(commandBuffer);
+	CapturedComputePipeline *pipeline = CommandCapture_FindComputePipeline(computePipeline);
+	if (pipeline != NULL)
+	{
+		captured->computePipeline = *pipeline;
+	}
+
+	SDL_UnlockMutex(captureLock);
+}
+
+void CommandCapture_BindComputeTextures(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	Refresh_Texture **pTextures
+) {
+	if (!captureEnabled)
+	{
+		Refresh_BindComputeTextures(device, commandBuffer, pTextures);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	Refresh_BindComputeTextures(device, commandBuffer, pTextures);
+
+	uint32_t imageCount = CommandCapture_FindCommandBuffer(commandBuffer)->computePipeline.imageCount;
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_BIND_COMPUTE_TEXTURES);
+	CommandCapture_PutHandle(commandBuffer);
+	CommandCapture_Put32(imageCount);
+	for (uint32_t i = 0; i < imageCount; i++)
+	{
+		CommandCapture_PutHandle(pTextures[i]);
+	}
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+}
+
+uint32_t CommandCapture_PushComputeShaderParams(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	void *data,
+	uint32_t elementCount
+) {
+	if (!captureEnabled)
+	{
+		return Refresh_PushComputeShaderParams(device, commandBuffer, data, elementCount);
+	}
+
+	SDL_LockMutex(captureLock);
+	uint32_t offset = Refresh_PushComputeShaderParams(device, commandBuffer, data, elementCount);
+
+	CommandCapture_PutParams(
+		COMMAND_CAPTURE_OP_PUSH_COMPUTE_SHADER_PARAMS,
+		commandBuffer,
+		offset,
+		data,
+		elementCount,
+		CommandCapture_FindCommandBuffer(commandBuffer)->computePipeline.uniformSize
+	);
+
+	SDL_UnlockMutex(captureLock);
+	return offset;
+}
+
+void CommandCapture_DispatchCompute(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	uint32_t groupCountX,
+	uint32_t groupCountY,
+	uint32_t groupCountZ,
+	uint32_t computeParamOffset
+) {
+	if (!captureEnabled)
+	{
+		Refresh_DispatchCompute(device, commandBuffer, groupCountX, groupCountY, groupCountZ, computeParamOffset);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	Refresh_DispatchCompute(device, commandBuffer, groupCountX, groupCountY, groupCountZ, computeParamOffset);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_DISPATCH_COMPUTE);
+	CommandCapture_PutHandle(commandBuffer);
+	CommandCapture_Put32(groupCountX);
+	CommandCapture_Put32(groupCountY);
+	CommandCapture_Put32(groupCountZ);
+	CommandCapture_Put32(computeParamOffset);
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+}
+
+void CommandCapture_CopyTextureToTexture(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	Refresh_TextureSlice *sourceTextureSlice,
+	Refresh_TextureSlice *destinationTextureSlice,
+	Refresh_Filter filter
+) {
+	if (!captureEnabled)
+	{
+		Refresh_CopyTextureToTexture(device, commandBuffer, sourceTextureSlice, destinationTextureSlice, filter);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	Refresh_CopyTextureToTexture(device, commandBuffer, sourceTextureSlice, destinationTextureSlice, filter);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_COPY_TEXTURE_TO_TEXTURE);
+	CommandCapture_PutHandle(commandBuffer);
+	CommandCapture_PutSlice(sourceTextureSlice);
+	CommandCapture_PutSlice(destinationTextureSlice);
+	CommandCapture_Put32(filter);
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+}
+
+void CommandCapture_CopyTextureToBuffer(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	Refresh_TextureSlice *textureSlice,
+	Refresh_Buffer *buffer
+) {
+	if (!captureEnabled)
+	{
+		Refresh_CopyTextureToBuffer(device, commandBuffer, textureSlice, buffer);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	Refresh_CopyTextureToBuffer(device, commandBuffer, textureSlice, buffer);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_COPY_TEXTURE_TO_BUFFER);
+	CommandCapture_PutHandle(commandBuffer);
+	CommandCapture_PutSlice(textureSlice);
+	CommandCapture_PutHandle(buffer);
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+}
+
+void CommandCapture_Submit(
+	Refresh_Device *device,
+	uint32_t commandBufferCount,
+	Refresh_CommandBuffer **pCommandBuffers
+) {
+	if (!captureEnabled)
+	{
+		Refresh_Submit(device, commandBufferCount, pCommandBuffers);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	Refresh_Submit(device, commandBufferCount, pCommandBuffers);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_SUBMIT);
+	CommandCapture_Put32(commandBufferCount);
+	for (uint32_t i = 0; i < commandBufferCount; i++)
+	{
+		CommandCapture_PutHandle(pCommandBuffers[i]);
+
+		/* Refresh hands submitted command buffers out again */
+		CapturedCommandBuffer *captured = CommandCapture_FindCommandBuffer(pCommandBuffers[i]);
+		*captured = openCommandBuffers[--openCommandBufferCount];
+	}
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+}
+
+void CommandCapture_Wait(Refresh_Device *device)
+{
+	if (!captureEnabled)
+	{
+		Refresh_Wait(device);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	Refresh_Wait(device);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_WAIT);
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+}
+
+/* FNA3D object creation */
+
+FNA3D_Texture* CommandCapture_FNA3D_CreateTexture2D(
+	FNA3D_Device *device,
+	FNA3D_SurfaceFormat format,
+	int32_t width,
+	int32_t height,
+	int32_t levelCount,
+	uint8_t isRenderTarget
+) {
+	if (!captureEnabled)
+	{
+		return FNA3D_CreateTexture2D(device, format, width, height, levelCount, isRenderTarget);
+	}
+
+	SDL_LockMutex(captureLock);
+	FNA3D_Texture *texture = FNA3D_CreateTexture2D(device, format, width, height, levelCount, isRenderTarget);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_FNA3D_CREATE_TEXTURE_2D);
+	CommandCapture_PutHandle(texture);
+	CommandCapture_Put32(format);
+	CommandCapture_Put32(width);
+	CommandCapture_Put32(height);
+	CommandCapture_Put32(levelCount);
+	CommandCapture_Put32(isRenderTarget);
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+	return texture;
+}
+
+/* The image and view are this run's, the replayer looks its own up from texture */
+FNA3D_Texture* CommandCapture_FNA3D_CreateSysTextureEXT(
+	FNA3D_Device *device,
+	FNA3D_SysTextureEXT *sysTexture,
+	Refresh_Texture *texture
+) {
+	if (!captureEnabled)
+	{
+		return FNA3D_CreateSysTextureEXT(device, sysTexture);
+	}
+
+	SDL_LockMutex(captureLock);
+	FNA3D_Texture *fnaTexture = FNA3D_CreateSysTextureEXT(device, sysTexture);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_FNA3D_CREATE_SYS_TEXTURE);
+	CommandCapture_PutHandle(fnaTexture);
+	CommandCapture_PutHandle(texture);
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+	return fnaTexture;
+}
+
+static FNA3D_Buffer* CommandCapture_FNA3D_GenBuffer(
+	FNA3D_Device *device,
+	uint8_t dynamic,
+	FNA3D_BufferUsage usage,
+	int32_t sizeInBytes,
+	CommandCaptureOp op
+) {
+	FNA3D_Buffer *buffer;
+	if (op == COMMAND_CAPTURE_OP_FNA3D_GEN_VERTEX_BUFFER)
+	{
+		buffer = FNA3D_GenVertexBuffer(device, dynamic, usage, sizeInBytes);
+	}
+	else
+	{
+		buffer = FNA3D_GenIndexBuffer(device, dynamic, usage, sizeInBytes);
+	}
+
+	CommandCapture_Begin(op);
+	CommandCapture_PutHandle(buffer);
+	CommandCapture_Put32(dynamic);
+	CommandCapture_Put32(usage);
+	CommandCapture_Put32(sizeInBytes);
+	CommandCapture_End();
+
+	return buffer;
+}
+
+FNA3D_Buffer* CommandCapture_FNA3D_GenVertexBuffer(
+	FNA3D_Device *device,
+	uint8_t dynamic,
+	FNA3D_BufferUsage usage,
+	int32_t sizeInBytes
+) {
+	if (!captureEnabled)
+	{
+		return FNA3D_GenVertexBuffer(device, dynamic, usage, sizeInBytes);
+	}
+
+	SDL_LockMutex(captureLock);
+	FNA3D_Buffer *buffer = CommandCapture_FNA3D_GenBuffer(
+		device,
+		dynamic,
+		usage,
+		sizeInBytes,
+		COMMAND_CAPTURE_OP_FNA3D_GEN_VERTEX_BUFFER
+	);
+	SDL_UnlockMutex(captureLock);
+	return buffer;
+}
+
+FNA3D_Buffer* CommandCapture_FNA3D_GenIndexBuffer(
+	FNA3D_Device *device,
+	uint8_t dynamic,
+	FNA3D_BufferUsage usage,
+	int32_t sizeInBytes
+) {
+	if (!captureEnabled)
+	{
+		return FNA3D_GenIndexBuffer(device, dynamic, usage, sizeInBytes);
+	}
+
+	SDL_LockMutex(captureLock);
+	FNA3D_Buffer *buffer = CommandCapture_FNA3D_GenBuffer(
+		device,
+		dynamic,
+		usage,
+		sizeInBytes,
+		COMMAND_CAPTURE_OP_FNA3D_GEN_INDEX_BUFFER
+	);
+	SDL_UnlockMutex(captureLock);
+	return buffer;
+}
+
+void CommandCapture_FNA3D_CreateEffect(
+	FNA3D_Device *device,
+	uint8_t *effectCode,
+	uint32_t effectCodeLength,
+	FNA3D_Effect **effect,
+	MOJOSHADER_effect **effectData
+) {
+	if (!captureEnabled)
+	{
+		FNA3D_CreateEffect(device, effectCode, effectCodeLength, effect, effectData);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	FNA3D_CreateEffect(device, effectCode, effectCodeLength, effect, effectData);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_FNA3D_CREATE_EFFECT);
+	CommandCapture_PutHandle(*effect);
+	CommandCapture_Put32(effectCodeLength);
+	CommandCapture_Put(effectCode, effectCodeLength);
+	CommandCapture_End();
+
+	effects = CommandCapture_Grow(effects, &effectCapacity, effectCount, sizeof(CapturedEffect));
+	effects[effectCount].effect = *effect;
+	effects[effectCount].effectData = *effectData;
+	effectCount += 1;
+
+	SDL_UnlockMutex(captureLock);
+}
+
+/* FNA3D data transfer */
+
+void CommandCapture_FNA3D_SetTextureData2D(
+	FNA3D_Device *device,
+	FNA3D_Texture *texture,
+	int32_t x,
+	int32_t y,
+	int32_t w,
+	int32_t h,
+	int32_t level,
+	void *data,
+	int32_t dataLength
+) {
+	if (!captureEnabled)
+	{
+		FNA3D_SetTextureData2D(device, texture, x, y, w, h, level, data, dataLength);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	FNA3D_SetTextureData2D(device, texture, x, y, w, h, level, data, dataLength);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_FNA3D_SET_TEXTURE_DATA_2D);
+	CommandCapture_PutHandle(texture);
+	CommandCapture_Put32(x);
+	CommandCapture_Put32(y);
+	CommandCapture_Put32(w);
+	CommandCapture_Put32(h);
+	CommandCapture_Put32(level);
+	CommandCapture_Put32(dataLength);
+	CommandCapture_Put(data, dataLength);
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+}
+
+/* Only the read itself is replayed, the data stays here */
+void CommandCapture_FNA3D_GetTextureData2D(
+	FNA3D_Device *device,
+	FNA3D_Texture *texture,
+	int32_t x,
+	int32_t y,
+	int32_t w,
+	int32_t h,
+	int32_t level,
+	void *data,
+	int32_t dataLength
+) {
+	if (!captureEnabled)
+	{
+		FNA3D_GetTextureData2D(device, texture, x, y, w, h, level, data, dataLength);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	FNA3D_GetTextureData2D(device, texture, x, y, w, h, level, data, dataLength);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_FNA3D_GET_TEXTURE_DATA_2D);
+	CommandCapture_PutHandle(texture);
+	CommandCapture_Put32(x);
+	CommandCapture_Put32(y);
+	CommandCapture_Put32(w);
+	CommandCapture_Put32(h);
+	CommandCapture_Put32(level);
+	CommandCapture_Put32(dataLength);
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+}
+
+void CommandCapture_FNA3D_SetVertexBufferData(
+	FNA3D_Device *device,
+	FNA3D_Buffer *buffer,
+	int32_t offsetInBytes,
+	void *data,
+	int32_t elementCount,
+	int32_t elementSizeInBytes,
+	int32_t vertexStride,
+	FNA3D_SetDataOptions options
+) {
+	if (!captureEnabled)
+	{
+		FNA3D_SetVertexBufferData(
+			device,
+			buffer,
+			offsetInBytes,
+			data,
+			elementCount,
+			elementSizeInBytes,
+			vertexStride,
+			options
+		);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	FNA3D_SetVertexBufferData(
+		device,
+		buffer,
+		offsetInBytes,
+		data,
+		elementCount,
+		elementSizeInBytes,
+		vertexStride,
+		options
+	);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_FNA3D_SET_VERTEX_BUFFER_DATA);
+	CommandCapture_PutHandle(buffer);
+	CommandCapture_Put32(offsetInBytes);
+	CommandCapture_Put32(elementCount);
+	CommandCapture_Put32(elementSizeInBytes);
+	CommandCapture_Put32(vertexStride);
+	CommandCapture_Put32(options);
+	CommandCapture_Put(data, elementCount * elementSizeInBytes);
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+}
+
+void CommandCapture_FNA3D_SetIndexBufferData(
+	FNA3D_Device *device,
+	FNA3D_Buffer *buffer,
+	int32_t offsetInBytes,
+	void *data,
+	int32_t dataLength,
+	FNA3D_SetDataOptions options
+) {
+	if (!captureEnabled)
+	{
+		FNA3D_SetIndexBufferData(device, buffer, offsetInBytes, data, dataLength, options);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	FNA3D_SetIndexBufferData(device, buffer, offsetInBytes, data, dataLength, options);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_FNA3D_SET_INDEX_BUFFER_DATA);
+	CommandCapture_PutHandle(buffer);
+	CommandCapture_Put32(offsetInBytes);
+	CommandCapture_Put32(options);
+	CommandCapture_Put32(dataLength);
+	CommandCapture_Put(data, dataLength);
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+}
+
+/* FNA3D destruction */
+
+#define COMMAND_CAPTURE_FNA3D_DISPOSE(name, type, op) \
+	void CommandCapture_FNA3D_AddDispose##name(FNA3D_Device *device, type *object) \
+	{ \
+		if (!captureEnabled) \
+		{ \
+			FNA3D_AddDispose##name(device, object); \
+			return; \
+		} \
+	\
+		SDL_LockMutex(captureLock); \
+		FNA3D_AddDispose##name(device, object); \
+	\
+		CommandCapture_Begin(op); \
+		CommandCapture_PutHandle(object); \
+		CommandCapture_End(); \
+	\
+		SDL_UnlockMutex(captureLock); \
+	}
+
+COMMAND_CAPTURE_FNA3D_DISPOSE(Texture, FNA3D_Texture, COMMAND_CAPTURE_OP_FNA3D_DISPOSE_TEXTURE)
+COMMAND_CAPTURE_FNA3D_DISPOSE(VertexBuffer, FNA3D_Buffer, COMMAND_CAPTURE_OP_FNA3D_DISPOSE_VERTEX_BUFFER)
+COMMAND_CAPTURE_FNA3D_DISPOSE(IndexBuffer, FNA3D_Buffer, COMMAND_CAPTURE_OP_FNA3D_DISPOSE_INDEX_BUFFER)
+
+/* The effect also leaves the parameter table, so a reused pointer starts over */
+void CommandCapture_FNA3D_AddDisposeEffect(FNA3D_Device *device, FNA3D_Effect *effect)
+{
+	if (!captureEnabled)
+	{
+		FNA3D_AddDisposeEffect(device, effect);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	FNA3D_AddDisposeEffect(device, effect);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_FNA3D_DISPOSE_EFFECT);
+	CommandCapture_PutHandle(effect);
+	CommandCapture_End();
+
+	CapturedEffect *captured = CommandCapture_FindEffect(effect);
+	if (captured != NULL)
+	{
+		*captured = effects[--effectCount];
+	}
+
+	SDL_UnlockMutex(captureLock);
+}
+
+/* FNA3D state and drawing. The state structs hold no pointers. */
+
+#define COMMAND_CAPTURE_FNA3D_STATE(name, type, op) \
+	void CommandCapture_FNA3D_##name(FNA3D_Device *device, type *state) \
+	{ \
+		if (!captureEnabled) \
+		{ \
+			FNA3D_##name(device, state); \
+			return; \
+		} \
+	\
+		SDL_LockMutex(captureLock); \
+		FNA3D_##name(device, state); \
+	\
+		CommandCapture_Begin(op); \
+		CommandCapture_Put(state, sizeof(type)); \
+		CommandCapture_End(); \
+	\
+		SDL_UnlockMutex(captureLock); \
+	}
+
+COMMAND_CAPTURE_FNA3D_STATE(SetViewport, FNA3D_Viewport, COMMAND_CAPTURE_OP_FNA3D_SET_VIEWPORT)
+COMMAND_CAPTURE_FNA3D_STATE(SetBlendState, FNA3D_BlendState, COMMAND_CAPTURE_OP_FNA3D_SET_BLEND_STATE)
+COMMAND_CAPTURE_FNA3D_STATE(SetDepthStencilState, FNA3D_DepthStencilState, COMMAND_CAPTURE_OP_FNA3D_SET_DEPTH_STENCIL_STATE)
+COMMAND_CAPTURE_FNA3D_STATE(ApplyRasterizerState, FNA3D_RasterizerState, COMMAND_CAPTURE_OP_FNA3D_APPLY_RASTERIZER_STATE)
+
+void CommandCapture_FNA3D_VerifySampler(
+	FNA3D_Device *device,
+	int32_t index,
+	FNA3D_Texture *texture,
+	FNA3D_SamplerState *sampler
+) {
+	if (!captureEnabled)
+	{
+		FNA3D_VerifySampler(device, index, texture, sampler);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	FNA3D_VerifySampler(device, index, texture, sampler);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_FNA3D_VERIFY_SAMPLER);
+	CommandCapture_Put32(index);
+	CommandCapture_PutHandle(texture);
+	CommandCapture_Put(sampler, sizeof(FNA3D_SamplerState));
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+}
+
+void CommandCapture_FNA3D_ApplyVertexBufferBindings(
+	FNA3D_Device *device,
+	FNA3D_VertexBufferBinding *bindings,
+	int32_t numBindings,
+	uint8_t bindingsUpdated,
+	int32_t baseVertex
+) {
+	if (!captureEnabled)
+	{
+		FNA3D_ApplyVertexBufferBindings(device, bindings, numBindings, bindingsUpdated, baseVertex);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	FNA3D_ApplyVertexBufferBindings(device, bindings, numBindings, bindingsUpdated, baseVertex);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_FNA3D_APPLY_VERTEX_BUFFER_BINDINGS);
+	CommandCapture_Put32(numBindings);
+	for (int32_t i = 0; i < numBindings; i++)
+	{
+		FNA3D_VertexDeclaration *declaration = &bindings[i].vertexDeclaration;
+		CommandCapture_PutHandle(bindings[i].vertexBuffer);
+		CommandCapture_Put32(declaration->vertexStride);
+		CommandCapture_Put32(declaration->elementCount);
+		CommandCapture_Put(declaration->elements, declaration->elementCount * sizeof(FNA3D_VertexElement));
+		CommandCapture_Put32(bindings[i].vertexOffset);
+		CommandCapture_Put32(bindings[i].instanceFrequency);
+	}
+	CommandCapture_Put32(bindingsUpdated);
+	CommandCapture_Put32(baseVertex);
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+}
+
+void CommandCapture_FNA3D_SetRenderTargets(
+	FNA3D_Device *device,
+	FNA3D_RenderTargetBinding *renderTargets,
+	int32_t numRenderTargets,
+	FNA3D_Renderbuffer *depthStencilBuffer,
+	FNA3D_DepthFormat depthFormat,
+	uint8_t preserveTargetContents
+) {
+	if (!captureEnabled)
+	{
+		FNA3D_SetRenderTargets(
+			device,
+			renderTargets,
+			numRenderTargets,
+			depthStencilBuffer,
+			depthFormat,
+			preserveTargetContents
+		);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	FNA3D_SetRenderTargets(
+		device,
+		renderTargets,
+		numRenderTargets,
+		depthStencilBuffer,
+		depthFormat,
+		preserveTargetContents
+	);
+
+	/* twod and cube share their two words */
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_FNA3D_SET_RENDER_TARGETS);
+	CommandCapture_Put32(numRenderTargets);
+	for (int32_t i = 0; i < numRenderTargets; i++)
+	{
+		CommandCapture_Put32(renderTargets[i].type);
+		CommandCapture_Put32(renderTargets[i].twod.width);
+		CommandCapture_Put32(renderTargets[i].twod.height);
+		CommandCapture_Put32(renderTargets[i].levelCount);
+		CommandCapture_Put32(renderTargets[i].multiSampleCount);
+		CommandCapture_PutHandle(renderTargets[i].texture);
+		CommandCapture_PutHandle(renderTargets[i].colorBuffer);
+	}
+	CommandCapture_PutHandle(depthStencilBuffer);
+	CommandCapture_Put32(depthFormat);
+	CommandCapture_Put32(preserveTargetContents);
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+}
+
+/* Numeric parameters only; textures and samplers reach FNA3D through VerifySampler */
+void CommandCapture_FNA3D_ApplyEffect(
+	FNA3D_Device *device,
+	FNA3D_Effect *effect,
+	uint32_t pass,
+	MOJOSHADER_effectStateChanges *stateChanges
+) {
+	if (!captureEnabled)
+	{
+		FNA3D_ApplyEffect(device, effect, pass, stateChanges);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	FNA3D_ApplyEffect(device, effect, pass, stateChanges);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_FNA3D_APPLY_EFFECT);
+	CommandCapture_PutHandle(effect);
+	CommandCapture_Put32(pass);
+
+	CapturedEffect *captured = CommandCapture_FindEffect(effect);
+	MOJOSHADER_effect *effectData = captured != NULL ? captured->effectData : NULL;
+	uint32_t paramCount = 0;
+	for (int32_t i = 0; effectData != NULL && i < effectData->param_count; i++)
+	{
+		paramCount += effectData->params[i].value.type.parameter_class <= MOJOSHADER_SYMCLASS_MATRIX_COLUMNS;
+	}
+
+	CommandCapture_Put32(paramCount);
+	for (int32_t i = 0; effectData != NULL && i < effectData->param_count; i++)
+	{
+		MOJOSHADER_effectValue *value = &effectData->params[i].value;
+		if (value->type.parameter_class <= MOJOSHADER_SYMCLASS_MATRIX_COLUMNS)
+		{
+			CommandCapture_Put32(i);
+			CommandCapture_Put32(value->value_count * 4);
+			CommandCapture_Put(value->values, value->value_count * 4);
+		}
+	}
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+}
+
+void CommandCapture_FNA3D_Clear(
+	FNA3D_Device *device,
+	FNA3D_ClearOptions options,
+	FNA3D_Vec4 *color,
+	float depth,
+	int32_t stencil
+) {
+	if (!captureEnabled)
+	{
+		FNA3D_Clear(device, options, color, depth, stencil);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	FNA3D_Clear(device, options, color, depth, stencil);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_FNA3D_CLEAR);
+	CommandCapture_Put32(options);
+	CommandCapture_Put(color, sizeof(FNA3D_Vec4));
+	CommandCapture_Put(&depth, sizeof(depth));
+	CommandCapture_Put32(stencil);
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+}
+
+void CommandCapture_FNA3D_DrawIndexedPrimitives(
+	FNA3D_Device *device,
+	FNA3D_PrimitiveType primitiveType,
+	int32_t baseVertex,
+	int32_t minVertexIndex,
+	int32_t numVertices,
+	int32_t startIndex,
+	int32_t primitiveCount,
+	FNA3D_Buffer *indices,
+	FNA3D_IndexElementSize indexElementSize
+) {
+	if (!captureEnabled)
+	{
+		FNA3D_DrawIndexedPrimitives(
+			device,
+			primitiveType,
+			baseVertex,
+			minVertexIndex,
+			numVertices,
+			startIndex,
+			primitiveCount,
+			indices,
+			indexElementSize
+		);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	FNA3D_DrawIndexedPrimitives(
+		device,
+		primitiveType,
+		baseVertex,
+		minVertexIndex,
+		numVertices,
+		startIndex,
+		primitiveCount,
+		indices,
+		indexElementSize
+	);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_FNA3D_DRAW_INDEXED_PRIMITIVES);
+	CommandCapture_Put32(primitiveType);
+	CommandCapture_Put32(baseVertex);
+	CommandCapture_Put32(minVertexIndex);
+	CommandCapture_Put32(numVertices);
+	CommandCapture_Put32(startIndex);
+	CommandCapture_Put32(primitiveCount);
+	CommandCapture_PutHandle(indices);
+	CommandCapture_Put32(indexElementSize);
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+}
+
+void CommandCapture_FNA3D_SwapBuffers(
+	FNA3D_Device *device,
+	FNA3D_Rect *sourceRectangle,
+	FNA3D_Rect *destinationRectangle,
+	void *overrideWindowHandle
+) {
+	if (!captureEnabled)
+	{
+		FNA3D_SwapBuffers(device, sourceRectangle, destinationRectangle, overrideWindowHandle);
+		return;
+	}
+
+	SDL_LockMutex(captureLock);
+	FNA3D_SwapBuffers(device, sourceRectangle, destinationRectangle, overrideWindowHandle);
+
+	CommandCapture_Begin(COMMAND_CAPTURE_OP_FNA3D_SWAP_BUFFERS);
+	CommandCapture_Put32(sourceRectangle != NULL);
+	if (sourceRectangle != NULL)
+	{
+		CommandCapture_Put(sourceRectangle, sizeof(FNA3D_Rect));
+	}
+	CommandCapture_Put32(destinationRectangle != NULL);
+	if (destinationRectangle != NULL)
+	{
+		CommandCapture_Put(destinationRectangle, sizeof(FNA3D_Rect));
+	}
+	CommandCapture_End();
+
+	SDL_UnlockMutex(captureLock);
+}
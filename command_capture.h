@@ -0,0 +1,499 @@
+#ifndef COMMAND_CAPTURE_H
+#define COMMAND_CAPTURE_H
+
+/* --capture-commands PATH: every Refresh and FNA3D call the app makes
+ * for its frames, written to a binary trace that RefreshReplay
+ * (command_replay.c) runs again headlessly and as fast as it can. Replaying
+ * one trace gives the same workload, down to the uniform bytes, for A/B
+ * runs of Refresh, FNA3D or driver changes without input or timing noise.
+ *
+ * Code calls the CommandCapture_ wrappers below by name wherever a call
+ * belongs in the trace; nothing is redirected behind its back, and a call
+ * made straight to Refresh_ or FNA3D_ is simply not captured. A wrapper
+ * forwards the call and, while a capture is open, writes one record of it.
+ * Records are written and forwarded under one lock, so calls from the tiled
+ * pass's workers keep the order Refresh saw them in; that order matters
+ * because Refresh tracks image layouts at record time. With no capture open
+ * a wrapper is a load, a branch and the call.
+ *
+ * FNA3D's device creation, teardown and window queries are left out; the
+ * replayer makes an FNA3D device of its own on a hidden window and a
+ * Refresh device that shares its Vulkan device, as RefreshTest does, so
+ * the interop textures are made again from the replayed Refresh textures.
+ * Effect parameters are written to MOJOSHADER's memory rather than passed
+ * to a call, so every ApplyEffect record carries the numeric parameter
+ * values of its effect.
+ *
+ * The trace starts with a CommandCaptureHeader, followed by records of a
+ * CommandCaptureRecord and size bytes of arguments each. Objects are
+ * written as the pointer values Refresh returned during the capture, which
+ * the replayer maps to its own objects; a pointer Refresh reuses after a
+ * destroy simply maps to the new object. Argument structs without pointers
+ * are written as they are in memory, so traces are only portable between
+ * builds against the same Refresh.h, on hosts of the same endianness.
+ *
+ * Uniform pushes and sampler binds carry no size or count in Refresh's
+ * API, it comes from the bound pipeline. The capture tracks each pipeline's
+ * layout and each command buffer's bound pipelines to write them out, and
+ * the replayer maps the param offsets pushes return the same way as objects.
+ */
+
+#include <stdint.h>
+
+#include <Refresh.h>
+
+#include <FNA3D.h>
+#include <FNA3D_SysRenderer.h>
+
+#define MOJOSHADER_NO_VERSION_INCLUDE
+#define MOJOSHADER_EFFECT_SUPPORT
+#include <mojoshader.h>
+#include <mojoshader_effects.h>
+
+#define COMMAND_CAPTURE_MAGIC 0x50414352 /* "RCAP" */
+#define COMMAND_CAPTURE_VERSION 2
+
+typedef struct CommandCaptureHeader
+{
+	uint32_t magic;
+	uint32_t version;
+} CommandCaptureHeader;
+
+typedef struct CommandCaptureRecord
+{
+	uint32_t op; /* CommandCaptureOp */
+	uint32_t size;
+} CommandCaptureRecord;
+
+typedef enum CommandCaptureOp
+{
+	/* Written by the app after each frame's last submission */
+	COMMAND_CAPTURE_OP_FRAME,
+
+	COMMAND_CAPTURE_OP_CREATE_TEXTURE_2D,
+	COMMAND_CAPTURE_OP_CREATE_COLOR_TARGET,
+	COMMAND_CAPTURE_OP_CREATE_DEPTH_STENCIL_TARGET,
+	COMMAND_CAPTURE_OP_CREATE_FRAMEBUFFER,
+	COMMAND_CAPTURE_OP_CREATE_RENDER_PASS,
+	COMMAND_CAPTURE_OP_CREATE_SHADER_MODULE,
+	COMMAND_CAPTURE_OP_CREATE_SAMPLER,
+	COMMAND_CAPTURE_OP_CREATE_BUFFER,
+	COMMAND_CAPTURE_OP_CREATE_COMPUTE_PIPELINE,
+	COMMAND_CAPTURE_OP_CREATE_GRAPHICS_PIPELINE,
+
+	COMMAND_CAPTURE_OP_SET_TEXTURE_DATA,
+	COMMAND_CAPTURE_OP_SET_BUFFER_DATA,
+	COMMAND_CAPTURE_OP_GET_BUFFER_DATA,
+
+	COMMAND_CAPTURE_OP_DESTROY_TEXTURE,
+	COMMAND_CAPTURE_OP_DESTROY_SAMPLER,
+	COMMAND_CAPTURE_OP_DESTROY_BUFFER,
+	COMMAND_CAPTURE_OP_DESTROY_COLOR_TARGET,
+	COMMAND_CAPTURE_OP_DESTROY_DEPTH_STENCIL_TARGET,
+	COMMAND_CAPTURE_OP_DESTROY_FRAMEBUFFER,
+	COMMAND_CAPTURE_OP_DESTROY_SHADER_MODULE,
+	COMMAND_CAPTURE_OP_DESTROY_RENDER_PASS,
+	COMMAND_CAPTURE_OP_DESTROY_COMPUTE_PIPELINE,
+	COMMAND_CAPTURE_OP_DESTROY_GRAPHICS_PIPELINE,
+
+	COMMAND_CAPTURE_OP_ACQUIRE_COMMAND_BUFFER,
+	COMMAND_CAPTURE_OP_BEGIN_RENDER_PASS,
+	COMMAND_CAPTURE_OP_END_RENDER_PASS,
+	COMMAND_CAPTURE_OP_BIND_GRAPHICS_PIPELINE,
+	COMMAND_CAPTURE_OP_BIND_VERTEX_BUFFERS,
+	COMMAND_CAPTURE_OP_BIND_VERTEX_SAMPLERS,
+	COMMAND_CAPTURE_OP_BIND_FRAGMENT_SAMPLERS,
+	COMMAND_CAPTURE_OP_PUSH_VERTEX_SHADER_PARAMS,
+	COMMAND_CAPTURE_OP_PUSH_FRAGMENT_SHADER_PARAMS,
+	COMMAND_CAPTURE_OP_DRAW_PRIMITIVES,
+	COMMAND_CAPTURE_OP_CLEAR,
+	COMMAND_CAPTURE_OP_BIND_COMPUTE_PIPELINE,
+	COMMAND_CAPTURE_OP_BIND_COMPUTE_TEXTURES,
+	COMMAND_CAPTURE_OP_PUSH_COMPUTE_SHADER_PARAMS,
+	COMMAND_CAPTURE_OP_DISPATCH_COMPUTE,
+	COMMAND_CAPTURE_OP_COPY_TEXTURE_TO_TEXTURE,
+	COMMAND_CAPTURE_OP_COPY_TEXTURE_TO_BUFFER,
+	COMMAND_CAPTURE_OP_SUBMIT,
+	COMMAND_CAPTURE_OP_WAIT,
+
+	COMMAND_CAPTURE_OP_FNA3D_CREATE_TEXTURE_2D,
+	COMMAND_CAPTURE_OP_FNA3D_CREATE_SYS_TEXTURE,
+	COMMAND_CAPTURE_OP_FNA3D_GEN_VERTEX_BUFFER,
+	COMMAND_CAPTURE_OP_FNA3D_GEN_INDEX_BUFFER,
+	COMMAND_CAPTURE_OP_FNA3D_CREATE_EFFECT,
+
+	COMMAND_CAPTURE_OP_FNA3D_SET_TEXTURE_DATA_2D,
+	COMMAND_CAPTURE_OP_FNA3D_GET_TEXTURE_DATA_2D,
+	COMMAND_CAPTURE_OP_FNA3D_SET_VERTEX_BUFFER_DATA,
+	COMMAND_CAPTURE_OP_FNA3D_SET_INDEX_BUFFER_DATA,
+
+	COMMAND_CAPTURE_OP_FNA3D_DISPOSE_TEXTURE,
+	COMMAND_CAPTURE_OP_FNA3D_DISPOSE_VERTEX_BUFFER,
+	COMMAND_CAPTURE_OP_FNA3D_DISPOSE_INDEX_BUFFER,
+	COMMAND_CAPTURE_OP_FNA3D_DISPOSE_EFFECT,
+
+	COMMAND_CAPTURE_OP_FNA3D_SET_VIEWPORT,
+	COMMAND_CAPTURE_OP_FNA3D_SET_BLEND_STATE,
+	COMMAND_CAPTURE_OP_FNA3D_SET_DEPTH_STENCIL_STATE,
+	COMMAND_CAPTURE_OP_FNA3D_APPLY_RASTERIZER_STATE,
+	COMMAND_CAPTURE_OP_FNA3D_VERIFY_SAMPLER,
+	COMMAND_CAPTURE_OP_FNA3D_APPLY_VERTEX_BUFFER_BINDINGS,
+	COMMAND_CAPTURE_OP_FNA3D_SET_RENDER_TARGETS,
+	COMMAND_CAPTURE_OP_FNA3D_APPLY_EFFECT,
+	COMMAND_CAPTURE_OP_FNA3D_CLEAR,
+	COMMAND_CAPTURE_OP_FNA3D_DRAW_INDEXED_PRIMITIVES,
+	COMMAND_CAPTURE_OP_FNA3D_SWAP_BUFFERS,
+
+	COMMAND_CAPTURE_OP_COUNT
+} CommandCaptureOp;
+
+/* Indexes the param offsets of a command buffer */
+typedef enum CommandCaptureStage
+{
+	COMMAND_CAPTURE_STAGE_VERTEX,
+	COMMAND_CAPTURE_STAGE_FRAGMENT,
+	COMMAND_CAPTURE_STAGE_COMPUTE,
+	COMMAND_CAPTURE_STAGE_COUNT
+} CommandCaptureStage;
+
+/* Before the first call to capture; returns 0 if the file can't be
+ * created
+ */
+uint8_t CommandCapture_Open(const char *path);
+
+/* After the last one. Does nothing when no capture is open. */
+void CommandCapture_Close(void);
+
+void CommandCapture_EndFrame(void);
+
+Refresh_Texture* CommandCapture_CreateTexture2D(
+	Refresh_Device *device,
+	Refresh_ColorFormat format,
+	uint32_t width,
+	uint32_t height,
+	uint32_t levelCount,
+	Refresh_TextureUsageFlags usageFlags
+);
+Refresh_ColorTarget* CommandCapture_CreateColorTarget(
+	Refresh_Device *device,
+	Refresh_SampleCount multisampleCount,
+	Refresh_TextureSlice *textureSlice
+);
+Refresh_DepthStencilTarget* CommandCapture_CreateDepthStencilTarget(
+	Refresh_Device *device,
+	uint32_t width,
+	uint32_t height,
+	Refresh_DepthFormat format
+);
+Refresh_Framebuffer* CommandCapture_CreateFramebuffer(
+	Refresh_Device *device,
+	Refresh_FramebufferCreateInfo *framebufferCreateInfo
+);
+Refresh_RenderPass* CommandCapture_CreateRenderPass(
+	Refresh_Device *device,
+	Refresh_RenderPassCreateInfo *renderPassCreateInfo
+);
+Refresh_ShaderModule* CommandCapture_CreateShaderModule(
+	Refresh_Device *device,
+	Refresh_ShaderModuleCreateInfo *shaderModuleCreateInfo
+);
+Refresh_Sampler* CommandCapture_CreateSampler(
+	Refresh_Device *device,
+	Refresh_SamplerStateCreateInfo *samplerStateCreateInfo
+);
+Refresh_Buffer* CommandCapture_CreateBuffer(
+	Refresh_Device *device,
+	Refresh_BufferUsageFlags usageFlags,
+	uint32_t sizeInBytes
+);
+Refresh_ComputePipeline* CommandCapture_CreateComputePipeline(
+	Refresh_Device *device,
+	Refresh_ComputePipelineCreateInfo *pipelineCreateInfo
+);
+Refresh_GraphicsPipeline* CommandCapture_CreateGraphicsPipeline(
+	Refresh_Device *device,
+	Refresh_GraphicsPipelineCreateInfo *pipelineCreateInfo
+);
+
+void CommandCapture_SetTextureData(
+	Refresh_Device *device,
+	Refresh_TextureSlice *textureSlice,
+	void *data,
+	uint32_t dataLengthInBytes
+);
+void CommandCapture_SetBufferData(
+	Refresh_Device *device,
+	Refresh_Buffer *buffer,
+	uint32_t offsetInBytes,
+	void *data,
+	uint32_t dataLength
+);
+void CommandCapture_GetBufferData(
+	Refresh_Device *device,
+	Refresh_Buffer *buffer,
+	void *data,
+	uint32_t dataLengthInBytes
+);
+
+void CommandCapture_QueueDestroyTexture(Refresh_Device *device, Refresh_Texture *texture);
+void CommandCapture_QueueDestroySampler(Refresh_Device *device, Refresh_Sampler *sampler);
+void CommandCapture_QueueDestroyBuffer(Refresh_Device *device, Refresh_Buffer *buffer);
+void CommandCapture_QueueDestroyColorTarget(Refresh_Device *device, Refresh_ColorTarget *colorTarget);
+void CommandCapture_QueueDestroyDepthStencilTarget(Refresh_Device *device, Refresh_DepthStencilTarget *depthStencilTarget);
+void CommandCapture_QueueDestroyFramebuffer(Refresh_Device *device, Refresh_Framebuffer *frameBuffer);
+void CommandCapture_QueueDestroyShaderModule(Refresh_Device *device, Refresh_ShaderModule *shaderModule);
+void CommandCapture_QueueDestroyRenderPass(Refresh_Device *device, Refresh_RenderPass *renderPass);
+void CommandCapture_QueueDestroyComputePipeline(Refresh_Device *device, Refresh_ComputePipeline *computePipeline);
+void CommandCapture_QueueDestroyGraphicsPipeline(Refresh_Device *device, Refresh_GraphicsPipeline *graphicsPipeline);
+
+Refresh_CommandBuffer* CommandCapture_AcquireCommandBuffer(Refresh_Device *device, uint8_t fixed);
+void CommandCapture_BeginRenderPass(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	Refresh_RenderPass *renderPass,
+	Refresh_Framebuffer *framebuffer,
+	Refresh_Rect renderArea,
+	Refresh_Color *pColorClearValues,
+	uint32_t colorClearCount,
+	Refresh_DepthStencilValue *depthStencilClearValue
+);
+void CommandCapture_EndRenderPass(Refresh_Device *device, Refresh_CommandBuffer *commandBuffer);
+void CommandCapture_BindGraphicsPipeline(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	Refresh_GraphicsPipeline *graphicsPipeline
+);
+void CommandCapture_BindVertexBuffers(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	uint32_t firstBinding,
+	uint32_t bindingCount,
+	Refresh_Buffer **pBuffers,
+	uint64_t *pOffsets
+);
+void CommandCapture_BindVertexSamplers(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	Refresh_Texture **pTextures,
+	Refresh_Sampler **pSamplers
+);
+void CommandCapture_BindFragmentSamplers(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	Refresh_Texture **pTextures,
+	Refresh_Sampler **pSamplers
+);
+uint32_t CommandCapture_PushVertexShaderParams(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	void *data,
+	uint32_t elementCount
+);
+uint32_t CommandCapture_PushFragmentShaderParams(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	void *data,
+	uint32_t elementCount
+);
+void CommandCapture_DrawPrimitives(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	uint32_t vertexStart,
+	uint32_t primitiveCount,
+	uint32_t vertexParamOffset,
+	uint32_t fragmentParamOffset
+);
+void CommandCapture_Clear(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	Refresh_Rect *clearRect,
+	Refresh_ClearOptions options,
+	Refresh_Color *colors,
+	uint32_t colorCount,
+	float depth,
+	int32_t stencil
+);
+void CommandCapture_BindComputePipeline(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	Refresh_ComputePipeline *computePipeline
+);
+void CommandCapture_BindComputeTextures(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	Refresh_Texture **pTextures
+);
+uint32_t CommandCapture_PushComputeShaderParams(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	void *data,
+	uint32_t elementCount
+);
+void CommandCapture_DispatchCompute(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	uint32_t groupCountX,
+	uint32_t groupCountY,
+	uint32_t groupCountZ,
+	uint32_t computeParamOffset
+);
+void CommandCapture_CopyTextureToTexture(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	Refresh_TextureSlice *sourceTextureSlice,
+	Refresh_TextureSlice *destinationTextureSlice,
+	Refresh_Filter filter
+);
+void CommandCapture_CopyTextureToBuffer(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	Refresh_TextureSlice *textureSlice,
+	Refresh_Buffer *buffer
+);
+void CommandCapture_Submit(
+	Refresh_Device *device,
+	uint32_t commandBufferCount,
+	Refresh_CommandBuffer **pCommandBuffers
+);
+void CommandCapture_Wait(Refresh_Device *device);
+
+/* FNA3D */
+
+FNA3D_Texture* CommandCapture_FNA3D_CreateTexture2D(
+	FNA3D_Device *device,
+	FNA3D_SurfaceFormat format,
+	int32_t width,
+	int32_t height,
+	int32_t levelCount,
+	uint8_t isRenderTarget
+);
+/* texture is the Refresh texture whose image and view sysTexture holds */
+FNA3D_Texture* CommandCapture_FNA3D_CreateSysTextureEXT(
+	FNA3D_Device *device,
+	FNA3D_SysTextureEXT *sysTexture,
+	Refresh_Texture *texture
+);
+FNA3D_Buffer* CommandCapture_FNA3D_GenVertexBuffer(
+	FNA3D_Device *device,
+	uint8_t dynamic,
+	FNA3D_BufferUsage usage,
+	int32_t sizeInBytes
+);
+FNA3D_Buffer* CommandCapture_FNA3D_GenIndexBuffer(
+	FNA3D_Device *device,
+	uint8_t dynamic,
+	FNA3D_BufferUsage usage,
+	int32_t sizeInBytes
+);
+void CommandCapture_FNA3D_CreateEffect(
+	FNA3D_Device *device,
+	uint8_t *effectCode,
+	uint32_t effectCodeLength,
+	FNA3D_Effect **effect,
+	MOJOSHADER_effect **effectData
+);
+
+void CommandCapture_FNA3D_SetTextureData2D(
+	FNA3D_Device *device,
+	FNA3D_Texture *texture,
+	int32_t x,
+	int32_t y,
+	int32_t w,
+	int32_t h,
+	int32_t level,
+	void *data,
+	int32_t dataLength
+);
+void CommandCapture_FNA3D_GetTextureData2D(
+	FNA3D_Device *device,
+	FNA3D_Texture *texture,
+	int32_t x,
+	int32_t y,
+	int32_t w,
+	int32_t h,
+	int32_t level,
+	void *data,
+	int32_t dataLength
+);
+void CommandCapture_FNA3D_SetVertexBufferData(
+	FNA3D_Device *device,
+	FNA3D_Buffer *buffer,
+	int32_t offsetInBytes,
+	void *data,
+	int32_t elementCount,
+	int32_t elementSizeInBytes,
+	int32_t vertexStride,
+	FNA3D_SetDataOptions options
+);
+void CommandCapture_FNA3D_SetIndexBufferData(
+	FNA3D_Device *device,
+	FNA3D_Buffer *buffer,
+	int32_t offsetInBytes,
+	void *data,
+	int32_t dataLength,
+	FNA3D_SetDataOptions options
+);
+
+void CommandCapture_FNA3D_AddDisposeTexture(FNA3D_Device *device, FNA3D_Texture *texture);
+void CommandCapture_FNA3D_AddDisposeVertexBuffer(FNA3D_Device *device, FNA3D_Buffer *buffer);
+void CommandCapture_FNA3D_AddDisposeIndexBuffer(FNA3D_Device *device, FNA3D_Buffer *buffer);
+void CommandCapture_FNA3D_AddDisposeEffect(FNA3D_Device *device, FNA3D_Effect *effect);
+
+void CommandCapture_FNA3D_SetViewport(FNA3D_Device *device, FNA3D_Viewport *viewport);
+void CommandCapture_FNA3D_SetBlendState(FNA3D_Device *device, FNA3D_BlendState *blendState);
+void CommandCapture_FNA3D_SetDepthStencilState(FNA3D_Device *device, FNA3D_DepthStencilState *depthStencilState);
+void CommandCapture_FNA3D_ApplyRasterizerState(FNA3D_Device *device, FNA3D_RasterizerState *rasterizerState);
+void CommandCapture_FNA3D_VerifySampler(
+	FNA3D_Device *device,
+	int32_t index,
+	FNA3D_Texture *texture,
+	FNA3D_SamplerState *sampler
+);
+void CommandCapture_FNA3D_ApplyVertexBufferBindings(
+	FNA3D_Device *device,
+	FNA3D_VertexBufferBinding *bindings,
+	int32_t numBindings,
+	uint8_t bindingsUpdated,
+	int32_t baseVertex
+);
+void CommandCapture_FNA3D_SetRenderTargets(
+	FNA3D_Device *device,
+	FNA3D_RenderTargetBinding *renderTargets,
+	int32_t numRenderTargets,
+	FNA3D_Renderbuffer *depthStencilBuffer,
+	FNA3D_DepthFormat depthFormat,
+	uint8_t preserveTargetContents
+);
+void CommandCapture_FNA3D_ApplyEffect(
+	FNA3D_Device *device,
+	FNA3D_Effect *effect,
+	uint32_t pass,
+	MOJOSHADER_effectStateChanges *stateChanges
+);
+void CommandCapture_FNA3D_Clear(
+	FNA3D_Device *device,
+	FNA3D_ClearOptions options,
+	FNA3D_Vec4 *color,
+	float depth,
+	int32_t stencil
+);
+void CommandCapture_FNA3D_DrawIndexedPrimitives(
+	FNA3D_Device *device,
+	FNA3D_PrimitiveType primitiveType,
+	int32_t baseVertex,
+	int32_t minVertexIndex,
+	int32_t numVertices,
+	int32_t startIndex,
+	int32_t primitiveCount,
+	FNA3D_Buffer *indices,
+	FNA3D_IndexElementSize indexElementSize
+);
+/* The replayer presents to its own window, overrideWindowHandle isn't kept */
+void CommandCapture_FNA3D_SwapBuffers(
+	FNA3D_Device *device,
+	FNA3D_Rect *sourceRectangle,
+	FNA3D_Rect *destinationRectangle,
+	void *overrideWindowHandle
+);
+
+#endif /* COMMAND_CAPTURE_H */
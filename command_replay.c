@@ -0,0 +1,1476 @@
+/* RefreshReplay: runs a trace written with RefreshTest --capture-commands
+ * on FNA3D and Refresh devices of its own, as fast as it can, and prints
+ * frame time statistics.
+ *
+ * usage: RefreshReplay trace.rcap [--loops N] [--debug]
+ *
+ * Each loop replays the whole trace, resource creation and destruction
+ * included. The startup up to the first frame marker, uploads and pipeline
+ * creation, is reported apart from the frames. FNA3D's device needs a
+ * window, which stays hidden; a captured SwapBuffers presents to it, see
+ * command_capture.h.
+ */
+
+#include "command_capture.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <SDL.h>
+
+#include <Refresh_SysRenderer.h>
+
+#include "benchmark.h"
+
+#define REPLAY_COMMAND_BUFFERS_MAX 64
+#define REPLAY_EFFECTS_MAX 16
+
+/* Captured pointer values to this run's objects */
+typedef struct ReplayObjects
+{
+	uint64_t *keys; /* 0 is an empty slot */
+	void **values;
+	uint32_t count;
+	uint32_t capacity; /* a power of two */
+} ReplayObjects;
+
+/* The param offsets Refresh returned for the last push of each stage,
+ * during the capture and now
+ */
+typedef struct ReplayCommandBuffer
+{
+	uint64_t handle;
+	Refresh_CommandBuffer *commandBuffer;
+	uint32_t capturedOffsets[COMMAND_CAPTURE_STAGE_COUNT];
+	uint32_t offsets[COMMAND_CAPTURE_STAGE_COUNT];
+} ReplayCommandBuffer;
+
+/* ApplyEffect records write their parameters to this run's effect */
+typedef struct ReplayEffect
+{
+	FNA3D_Effect *effect;
+	MOJOSHADER_effect *effectData;
+} ReplayEffect;
+
+typedef struct Replay
+{
+	Refresh_Device *device;
+	FNA3D_Device *fnaDevice;
+	ReplayObjects objects;
+	ReplayCommandBuffer commandBuffers[REPLAY_COMMAND_BUFFERS_MAX];
+	ReplayEffect effects[REPLAY_EFFECTS_MAX];
+	uint32_t effectCount;
+
+	/* GetBufferData and GetTextureData2D target */
+	uint8_t *scratch;
+	uint32_t scratchSize;
+
+	uint64_t recordCount;
+	uint32_t unmappedOffsetCount;
+} Replay;
+
+/* One record's arguments; reads past the end return zeroes */
+typedef struct ReplayReader
+{
+	const uint8_t *at;
+	const uint8_t *end;
+	bool overrun;
+} ReplayReader;
+
+static uint64_t ReplayObjects_Hash(uint64_t key)
+{
+	key ^= key >> 33;
+	key *= 0xFF51AFD7ED558CCDULL;
+	key ^= key >> 33;
+	return key;
+}
+
+static void ReplayObjects_Set(ReplayObjects *objects, uint64_t key, void *value);
+
+static void ReplayObjects_Grow(ReplayObjects *objects)
+{
+	uint64_t *keys = objects->keys;
+	void **values = objects->values;
+	uint32_t capacity = objects->capacity;
+
+	objects->capacity = capacity > 0 ? capacity * 2 : 1024;
+	objects->count = 0;
+	objects->keys = SDL_malloc(sizeof(uint64_t) * objects->capacity);
+	objects->values = SDL_malloc(sizeof(void*) * objects->capacity);
+	SDL_memset(objects->keys, 0, sizeof(uint64_t) * objects->capacity);
+
+	for (uint32_t i = 0; i < capacity; i++)
+	{
+		if (keys[i] != 0)
+		{
+			ReplayObjects_Set(objects, keys[i], values[i]);
+		}
+	}
+
+	SDL_free(keys);
+	SDL_free(values);
+}
+
+/* Entries are never removed: a destroyed object's pointer is either never
+ * seen again or comes back as a new object, which overwrites it
+ */
+static void ReplayObjects_Set(ReplayObjects *objects, uint64_t key, void *value)
+{
+	if (key == 0)
+	{
+		return;
+	}
+
+	if ((objects->count + 1) * 2 > objects->capacity)
+	{
+		ReplayObjects_Grow(objects);
+	}
+
+	uint32_t mask = objects->capacity - 1;
+	uint32_t i = (uint32_t) ReplayObjects_Hash(key) & mask;
+	while (objects->keys[i] != 0 && objects->keys[i] != key)
+	{
+		i = (i + 1) & mask;
+	}
+
+	if (objects->keys[i] == 0)
+	{
+		objects->keys[i] = key;
+		objects->count += 1;
+	}
+	objects->values[i] = value;
+}
+
+static void* ReplayObjects_Get(ReplayObjects *objects, uint64_t key)
+{
+	if (key == 0 || objects->capacity == 0)
+	{
+		return NULL;
+	}
+
+	uint32_t mask = objects->capacity - 1;
+	uint32_t i = (uint32_t) ReplayObjects_Hash(key) & mask;
+	while (objects->keys[i] != 0)
+	{
+		if (objects->keys[i] == key)
+		{
+			return objects->values[i];
+		}
+		i = (i + 1) & mask;
+	}
+
+	return NULL;
+}
+
+static const void* ReplayReader_Get(ReplayReader *reader, uint32_t size)
+{
+	static const uint8_t zeroes[64];
+
+	if ((size_t) (reader->end - reader->at) < size)
+	{
+		reader->overrun = true;
+		reader->at = reader->end;
+		return size <= sizeof(zeroes) ? zeroes : NULL;
+	}
+
+	const uint8_t *data = reader->at;
+	reader->at += size;
+	return data;
+}
+
+static void ReplayReader_Copy(ReplayReader *reader, void *destination, uint32_t size)
+{
+	const void *data = ReplayReader_Get(reader, size);
+	if (data != NULL)
+	{
+		SDL_memcpy(destination, data, size);
+	}
+	else
+	{
+		SDL_memset(destination, 0, size);
+	}
+}
+
+static uint32_t ReplayReader_Get32(ReplayReader *reader)
+{
+	uint32_t value;
+	ReplayReader_Copy(reader, &value, sizeof(value));
+	return value;
+}
+
+static uint64_t ReplayReader_Get64(ReplayReader *reader)
+{
+	uint64_t value;
+	ReplayReader_Copy(reader, &value, sizeof(value));
+	return value;
+}
+
+static void* ReplayReader_GetObject(ReplayReader *reader, Replay *replay)
+{
+	return ReplayObjects_Get(&replay->objects, ReplayReader_Get64(reader));
+}
+
+/* Arrays are read in place, the trace stays loaded for the whole replay */
+static const void* ReplayReader_GetArray(ReplayReader *reader, uint32_t count, uint32_t elementSize)
+{
+	if (count == 0)
+	{
+		return NULL;
+	}
+	return ReplayReader_Get(reader, count * elementSize);
+}
+
+static void ReplayReader_GetSlice(ReplayReader *reader, Replay *replay, Refresh_TextureSlice *slice)
+{
+	slice->texture = ReplayReader_GetObject(reader, replay);
+	ReplayReader_Copy(reader, &slice->rectangle, sizeof(Refresh_Rect));
+	slice->depth = ReplayReader_Get32(reader);
+	slice->layer = ReplayReader_Get32(reader);
+	slice->level = ReplayReader_Get32(reader);
+}
+
+/* The entry point name is copied into name, which must hold 64 bytes */
+static void ReplayReader_GetShaderStage(
+	ReplayReader *reader,
+	Replay *replay,
+	Refresh_ShaderStageState *stage,
+	char *name
+) {
+	stage->shaderModule = ReplayReader_GetObject(reader, replay);
+
+	uint32_t length = ReplayReader_Get32(reader);
+	const char *data = ReplayReader_GetArray(reader, length, 1);
+	length = SDL_min(length, 63);
+	if (data != NULL)
+	{
+		SDL_memcpy(name, data, length);
+	}
+	name[length] = '\0';
+	stage->entryPointName = name;
+
+	stage->uniformBufferSize = ReplayReader_Get64(reader);
+}
+
+static ReplayCommandBuffer* Replay_FindCommandBuffer(Replay *replay, uint64_t handle)
+{
+	for (uint32_t i = 0; i < REPLAY_COMMAND_BUFFERS_MAX; i++)
+	{
+		if (replay->commandBuffers[i].handle == handle)
+		{
+			return &replay->commandBuffers[i];
+		}
+	}
+
+	return NULL;
+}
+
+static Refresh_CommandBuffer* ReplayReader_GetCommandBuffer(
+	ReplayReader *reader,
+	Replay *replay,
+	ReplayCommandBuffer **replayCommandBuffer
+) {
+	ReplayCommandBuffer *found = Replay_FindCommandBuffer(replay, ReplayReader_Get64(reader));
+	if (replayCommandBuffer != NULL)
+	{
+		*replayCommandBuffer = found;
+	}
+	return found != NULL ? found->commandBuffer : NULL;
+}
+
+/* A draw's offset is the one of the push it refers to, made in this run */
+static uint32_t Replay_MapOffset(
+	Replay *replay,
+	ReplayCommandBuffer *commandBuffer,
+	CommandCaptureStage stage,
+	uint32_t capturedOffset
+) {
+	if (commandBuffer->capturedOffsets[stage] == capturedOffset)
+	{
+		return commandBuffer->offsets[stage];
+	}
+
+	if (capturedOffset != 0)
+	{
+		replay->unmappedOffsetCount += 1;
+	}
+	return capturedOffset;
+}
+
+static void Replay_PushParams(Replay *replay, ReplayReader *reader, CommandCaptureStage stage)
+{
+	ReplayCommandBuffer *commandBuffer;
+	Refresh_CommandBuffer *refreshCommandBuffer = ReplayReader_GetCommandBuffer(reader, replay, &commandBuffer);
+	uint32_t capturedOffset = ReplayReader_Get32(reader);
+	uint32_t elementCount = ReplayReader_Get32(reader);
+	uint32_t elementSize = ReplayReader_Get32(reader);
+	void *data = (void*) ReplayReader_GetArray(reader, elementCount, elementSize);
+
+	if (commandBuffer == NULL || data == NULL)
+	{
+		return;
+	}
+
+	uint32_t offset;
+	switch (stage)
+	{
+	case COMMAND_CAPTURE_STAGE_VERTEX:
+		offset = Refresh_PushVertexShaderParams(replay->device, refreshCommandBuffer, data, elementCount);
+		break;
+	case COMMAND_CAPTURE_STAGE_FRAGMENT:
+		offset = Refresh_PushFragmentShaderParams(replay->device, refreshCommandBuffer, data, elementCount);
+		break;
+	default:
+		offset = Refresh_PushComputeShaderParams(replay->device, refreshCommandBuffer, data, elementCount);
+		break;
+	}
+
+	commandBuffer->capturedOffsets[stage] = capturedOffset;
+	commandBuffer->offsets[stage] = offset;
+}
+
+static void Replay_BindSamplers(Replay *replay, ReplayReader *reader, bool fragment)
+{
+	Refresh_Texture *textures[32];
+	Refresh_Sampler *samplers[32];
+
+	Refresh_CommandBuffer *commandBuffer = ReplayReader_GetCommandBuffer(reader, replay, NULL);
+	uint32_t count = ReplayReader_Get32(reader);
+	count = SDL_min(count, 32);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		textures[i] = ReplayReader_GetObject(reader, replay);
+		samplers[i] = ReplayReader_GetObject(reader, replay);
+	}
+
+	if (fragment)
+	{
+		Refresh_BindFragmentSamplers(replay->device, commandBuffer, textures, samplers);
+	}
+	else
+	{
+		Refresh_BindVertexSamplers(replay->device, commandBuffer, textures, samplers);
+	}
+}
+
+static void Replay_CreateGraphicsPipeline(Replay *replay, ReplayReader *reader)
+{
+	Refresh_GraphicsPipelineCreateInfo createInfo;
+	char vertexEntryPoint[64], fragmentEntryPoint[64];
+
+	uint64_t handle = ReplayReader_Get64(reader);
+	ReplayReader_GetShaderStage(reader, replay, &createInfo.vertexShaderState, vertexEntryPoint);
+	ReplayReader_GetShaderStage(reader, replay, &createInfo.fragmentShaderState, fragmentEntryPoint);
+
+	Refresh_VertexInputState *vertexInputState = &createInfo.vertexInputState;
+	vertexInputState->vertexBindingCount = ReplayReader_Get32(reader);
+	vertexInputState->vertexBindings = ReplayReader_GetArray(
+		reader,
+		vertexInputState->vertexBindingCount,
+		sizeof(Refresh_VertexBinding)
+	);
+	vertexInputState->vertexAttributeCount = ReplayReader_Get32(reader);
+	vertexInputState->vertexAttributes = ReplayReader_GetArray(
+		reader,
+		vertexInputState->vertexAttributeCount,
+		sizeof(Refresh_VertexAttribute)
+	);
+
+	createInfo.topologyState.topology = (Refresh_PrimitiveType) ReplayReader_Get32(reader);
+
+	Refresh_ViewportState *viewportState = &createInfo.viewportState;
+	viewportState->viewportCount = ReplayReader_Get32(reader);
+	viewportState->viewports = ReplayReader_GetArray(reader, viewportState->viewportCount, sizeof(Refresh_Viewport));
+	viewportState->scissorCount = ReplayReader_Get32(reader);
+	viewportState->scissors = ReplayReader_GetArray(reader, viewportState->scissorCount, sizeof(Refresh_Rect));
+
+	ReplayReader_Copy(reader, &createInfo.rasterizerState, sizeof(Refresh_RasterizerState));
+	ReplayReader_Copy(reader, &createInfo.multisampleState, sizeof(Refresh_MultisampleState));
+	ReplayReader_Copy(reader, &createInfo.depthStencilState, sizeof(Refresh_DepthStencilState));
+
+	Refresh_ColorBlendState *colorBlendState = &createInfo.colorBlendState;
+	colorBlendState->logicOpEnable = (uint8_t) ReplayReader_Get32(reader);
+	colorBlendState->logicOp = (Refresh_LogicOp) ReplayReader_Get32(reader);
+	colorBlendState->blendStateCount = ReplayReader_Get32(reader);
+	colorBlendState->blendStates = ReplayReader_GetArray(
+		reader,
+		colorBlendState->blendStateCount,
+		sizeof(Refresh_ColorTargetBlendState)
+	);
+	ReplayReader_Copy(reader, colorBlendState->blendConstants, sizeof(colorBlendState->blendConstants));
+
+	ReplayReader_Copy(reader, &createInfo.pipelineLayoutCreateInfo, sizeof(Refresh_GraphicsPipelineLayoutCreateInfo));
+	createInfo.renderPass = ReplayReader_GetObject(reader, replay);
+
+	if (!reader->overrun)
+	{
+		ReplayObjects_Set(&replay->objects, handle, Refresh_CreateGraphicsPipeline(replay->device, &createInfo));
+	}
+}
+
+static uint8_t* Replay_Scratch(Replay *replay, uint32_t size)
+{
+	if (size > replay->scratchSize)
+	{
+		replay->scratch = SDL_realloc(replay->scratch, size);
+		replay->scratchSize = size;
+	}
+	return replay->scratch;
+}
+
+static MOJOSHADER_effect* Replay_FindEffect(Replay *replay, FNA3D_Effect *effect)
+{
+	for (uint32_t i = 0; i < replay->effectCount; i++)
+	{
+		if (replay->effects[i].effect == effect)
+		{
+			return replay->effects[i].effectData;
+		}
+	}
+
+	return NULL;
+}
+
+static void Replay_ApplyVertexBufferBindings(Replay *replay, ReplayReader *reader)
+{
+	FNA3D_VertexBufferBinding bindings[16];
+
+	uint32_t count = ReplayReader_Get32(reader);
+	count = SDL_min(count, 16);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		FNA3D_VertexDeclaration *declaration = &bindings[i].vertexDeclaration;
+		bindings[i].vertexBuffer = ReplayReader_GetObject(reader, replay);
+		declaration->vertexStride = (int32_t) ReplayReader_Get32(reader);
+		declaration->elementCount = (int32_t) ReplayReader_Get32(reader);
+		declaration->elements = (FNA3D_VertexElement*) ReplayReader_GetArray(
+			reader,
+			declaration->elementCount,
+			sizeof(FNA3D_VertexElement)
+		);
+		bindings[i].vertexOffset = (int32_t) ReplayReader_Get32(reader);
+		bindings[i].instanceFrequency = (int32_t) ReplayReader_Get32(reader);
+	}
+	uint8_t bindingsUpdated = (uint8_t) ReplayReader_Get32(reader);
+	int32_t baseVertex = (int32_t) ReplayReader_Get32(reader);
+
+	if (!reader->overrun)
+	{
+		FNA3D_ApplyVertexBufferBindings(replay->fnaDevice, bindings, count, bindingsUpdated, baseVertex);
+	}
+}
+
+static void Replay_SetRenderTargets(Replay *replay, ReplayReader *reader)
+{
+	FNA3D_RenderTargetBinding renderTargets[4];
+
+	uint32_t count = ReplayReader_Get32(reader);
+	count = SDL_min(count, 4);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		renderTargets[i].type = (uint8_t) ReplayReader_Get32(reader);
+		renderTargets[i].twod.width = (int32_t) ReplayReader_Get32(reader);
+		renderTargets[i].twod.height = (int32_t) ReplayReader_Get32(reader);
+		renderTargets[i].levelCount = (int32_t) ReplayReader_Get32(reader);
+		renderTargets[i].multiSampleCount = (int32_t) ReplayReader_Get32(reader);
+		renderTargets[i].texture = ReplayReader_GetObject(reader, replay);
+		renderTargets[i].colorBuffer = ReplayReader_GetObject(reader, replay);
+	}
+	FNA3D_Renderbuffer *depthStencilBuffer = ReplayReader_GetObject(reader, replay);
+	FNA3D_DepthFormat depthFormat = (FNA3D_DepthFormat) ReplayReader_Get32(reader);
+	uint8_t preserveTargetContents = (uint8_t) ReplayReader_Get32(reader);
+
+	FNA3D_SetRenderTargets(
+		replay->fnaDevice,
+		count > 0 ? renderTargets : NULL,
+		count,
+		depthStencilBuffer,
+		depthFormat,
+		preserveTargetContents
+	);
+}
+
+/* Parameters the effect doesn't have, or has at another size, are skipped */
+static void Replay_ApplyEffect(Replay *replay, ReplayReader *reader)
+{
+	FNA3D_Effect *effect = ReplayReader_GetObject(reader, replay);
+	uint32_t pass = ReplayReader_Get32(reader);
+	MOJOSHADER_effect *effectData = Replay_FindEffect(replay, effect);
+
+	uint32_t paramCount = ReplayReader_Get32(reader);
+	for (uint32_t i = 0; i < paramCount; i++)
+	{
+		uint32_t param = ReplayReader_Get32(reader);
+		uint32_t size = ReplayReader_Get32(reader);
+		const void *values = ReplayReader_GetArray(reader, size, 1);
+
+		if (	effectData != NULL &&
+			values != NULL &&
+			param < (uint32_t) effectData->param_count &&
+			effectData->params[param].value.value_count * 4 == size	)
+		{
+			SDL_memcpy(effectData->params[param].value.values, values, size);
+		}
+	}
+
+	if (effect != NULL)
+	{
+		MOJOSHADER_effectStateChanges stateChanges;
+		SDL_memset(&stateChanges, 0, sizeof(stateChanges));
+		FNA3D_ApplyEffect(replay->fnaDevice, effect, pass, &stateChanges);
+	}
+}
+
+/* Returns false for records this build doesn't know */
+static bool Replay_FNA3DRecord(Replay *replay, uint32_t op, ReplayReader *reader)
+{
+	FNA3D_Device *device = replay->fnaDevice;
+	uint64_t handle;
+
+	switch (op)
+	{
+	case COMMAND_CAPTURE_OP_FNA3D_CREATE_TEXTURE_2D:
+	{
+		handle = ReplayReader_Get64(reader);
+		FNA3D_SurfaceFormat format = (FNA3D_SurfaceFormat) ReplayReader_Get32(reader);
+		int32_t width = (int32_t) ReplayReader_Get32(reader);
+		int32_t height = (int32_t) ReplayReader_Get32(reader);
+		int32_t levelCount = (int32_t) ReplayReader_Get32(reader);
+		uint8_t isRenderTarget = (uint8_t) ReplayReader_Get32(reader);
+		ReplayObjects_Set(
+			&replay->objects,
+			handle,
+			FNA3D_CreateTexture2D(device, format, width, height, levelCount, isRenderTarget)
+		);
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_FNA3D_CREATE_SYS_TEXTURE:
+	{
+		Refresh_TextureHandlesEXT textureHandles;
+		FNA3D_SysTextureEXT sysTexture;
+
+		handle = ReplayReader_Get64(reader);
+		Refresh_Texture *texture = ReplayReader_GetObject(reader, replay);
+		if (texture == NULL)
+		{
+			break;
+		}
+
+		Refresh_GetTextureHandlesEXT(replay->device, texture, &textureHandles);
+		sysTexture.version = 0;
+		sysTexture.rendererType = FNA3D_RENDERER_TYPE_VULKAN_EXT;
+		sysTexture.texture.vulkan.image = textureHandles.texture.vulkan.image;
+		sysTexture.texture.vulkan.view = textureHandles.texture.vulkan.view;
+		ReplayObjects_Set(&replay->objects, handle, FNA3D_CreateSysTextureEXT(device, &sysTexture));
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_FNA3D_GEN_VERTEX_BUFFER:
+	case COMMAND_CAPTURE_OP_FNA3D_GEN_INDEX_BUFFER:
+	{
+		handle = ReplayReader_Get64(reader);
+		uint8_t dynamic = (uint8_t) ReplayReader_Get32(reader);
+		FNA3D_BufferUsage usage = (FNA3D_BufferUsage) ReplayReader_Get32(reader);
+		int32_t size = (int32_t) ReplayReader_Get32(reader);
+		ReplayObjects_Set(
+			&replay->objects,
+			handle,
+			op == COMMAND_CAPTURE_OP_FNA3D_GEN_VERTEX_BUFFER ?
+				FNA3D_GenVertexBuffer(device, dynamic, usage, size) :
+				FNA3D_GenIndexBuffer(device, dynamic, usage, size)
+		);
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_FNA3D_CREATE_EFFECT:
+	{
+		handle = ReplayReader_Get64(reader);
+		uint32_t length = ReplayReader_Get32(reader);
+		uint8_t *code = (uint8_t*) ReplayReader_GetArray(reader, length, 1);
+		if (code == NULL)
+		{
+			break;
+		}
+		if (replay->effectCount == REPLAY_EFFECTS_MAX)
+		{
+			fprintf(stderr, "More than %d effects alive at once\n", REPLAY_EFFECTS_MAX);
+			return false;
+		}
+
+		ReplayEffect *replayEffect = &replay->effects[replay->effectCount++];
+		FNA3D_CreateEffect(device, code, length, &replayEffect->effect, &replayEffect->effectData);
+		ReplayObjects_Set(&replay->objects, handle, replayEffect->effect);
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_FNA3D_SET_TEXTURE_DATA_2D:
+	{
+		FNA3D_Texture *texture = ReplayReader_GetObject(reader, replay);
+		int32_t x = (int32_t) ReplayReader_Get32(reader);
+		int32_t y = (int32_t) ReplayReader_Get32(reader);
+		int32_t w = (int32_t) ReplayReader_Get32(reader);
+		int32_t h = (int32_t) ReplayReader_Get32(reader);
+		int32_t level = (int32_t) ReplayReader_Get32(reader);
+		uint32_t length = ReplayReader_Get32(reader);
+		void *data = (void*) ReplayReader_GetArray(reader, length, 1);
+		if (data != NULL)
+		{
+			FNA3D_SetTextureData2D(device, texture, x, y, w, h, level, data, (int32_t) length);
+		}
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_FNA3D_GET_TEXTURE_DATA_2D:
+	{
+		FNA3D_Texture *texture = ReplayReader_GetObject(reader, replay);
+		int32_t x = (int32_t) ReplayReader_Get32(reader);
+		int32_t y = (int32_t) ReplayReader_Get32(reader);
+		int32_t w = (int32_t) ReplayReader_Get32(reader);
+		int32_t h = (int32_t) ReplayReader_Get32(reader);
+		int32_t level = (int32_t) ReplayReader_Get32(reader);
+		uint32_t length = ReplayReader_Get32(reader);
+		FNA3D_GetTextureData2D(device, texture, x, y, w, h, level, Replay_Scratch(replay, length), (int32_t) length);
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_FNA3D_SET_VERTEX_BUFFER_DATA:
+	{
+		FNA3D_Buffer *buffer = ReplayReader_GetObject(reader, replay);
+		int32_t offset = (int32_t) ReplayReader_Get32(reader);
+		uint32_t elementCount = ReplayReader_Get32(reader);
+		uint32_t elementSize = ReplayReader_Get32(reader);
+		int32_t vertexStride = (int32_t) ReplayReader_Get32(reader);
+		FNA3D_SetDataOptions options = (FNA3D_SetDataOptions) ReplayReader_Get32(reader);
+		void *data = (void*) ReplayReader_GetArray(reader, elementCount, elementSize);
+		if (data != NULL)
+		{
+			FNA3D_SetVertexBufferData(device, buffer, offset, data, elementCount, elementSize, vertexStride, options);
+		}
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_FNA3D_SET_INDEX_BUFFER_DATA:
+	{
+		FNA3D_Buffer *buffer = ReplayReader_GetObject(reader, replay);
+		int32_t offset = (int32_t) ReplayReader_Get32(reader);
+		FNA3D_SetDataOptions options = (FNA3D_SetDataOptions) ReplayReader_Get32(reader);
+		uint32_t length = ReplayReader_Get32(reader);
+		void *data = (void*) ReplayReader_GetArray(reader, length, 1);
+		if (data != NULL)
+		{
+			FNA3D_SetIndexBufferData(device, buffer, offset, data, (int32_t) length, options);
+		}
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_FNA3D_DISPOSE_TEXTURE:
+		FNA3D_AddDisposeTexture(device, ReplayReader_GetObject(reader, replay));
+		break;
+	case COMMAND_CAPTURE_OP_FNA3D_DISPOSE_VERTEX_BUFFER:
+		FNA3D_AddDisposeVertexBuffer(device, ReplayReader_GetObject(reader, replay));
+		break;
+	case COMMAND_CAPTURE_OP_FNA3D_DISPOSE_INDEX_BUFFER:
+		FNA3D_AddDisposeIndexBuffer(device, ReplayReader_GetObject(reader, replay));
+		break;
+
+	case COMMAND_CAPTURE_OP_FNA3D_DISPOSE_EFFECT:
+	{
+		FNA3D_Effect *effect = ReplayReader_GetObject(reader, replay);
+		for (uint32_t i = 0; i < replay->effectCount; i++)
+		{
+			if (replay->effects[i].effect == effect)
+			{
+				replay->effects[i] = replay->effects[--replay->effectCount];
+				break;
+			}
+		}
+		FNA3D_AddDisposeEffect(device, effect);
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_FNA3D_SET_VIEWPORT:
+	{
+		FNA3D_Viewport viewport;
+		ReplayReader_Copy(reader, &viewport, sizeof(viewport));
+		FNA3D_SetViewport(device, &viewport);
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_FNA3D_SET_BLEND_STATE:
+	{
+		FNA3D_BlendState blendState;
+		ReplayReader_Copy(reader, &blendState, sizeof(blendState));
+		FNA3D_SetBlendState(device, &blendState);
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_FNA3D_SET_DEPTH_STENCIL_STATE:
+	{
+		FNA3D_DepthStencilState depthStencilState;
+		ReplayReader_Copy(reader, &depthStencilState, sizeof(depthStencilState));
+		FNA3D_SetDepthStencilState(device, &depthStencilState);
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_FNA3D_APPLY_RASTERIZER_STATE:
+	{
+		FNA3D_RasterizerState rasterizerState;
+		ReplayReader_Copy(reader, &rasterizerState, sizeof(rasterizerState));
+		FNA3D_ApplyRasterizerState(device, &rasterizerState);
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_FNA3D_VERIFY_SAMPLER:
+	{
+		FNA3D_SamplerState samplerState;
+		int32_t index = (int32_t) ReplayReader_Get32(reader);
+		FNA3D_Texture *texture = ReplayReader_GetObject(reader, replay);
+		ReplayReader_Copy(reader, &samplerState, sizeof(samplerState));
+		FNA3D_VerifySampler(device, index, texture, &samplerState);
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_FNA3D_APPLY_VERTEX_BUFFER_BINDINGS:
+		Replay_ApplyVertexBufferBindings(replay, reader);
+		break;
+
+	case COMMAND_CAPTURE_OP_FNA3D_SET_RENDER_TARGETS:
+		Replay_SetRenderTargets(replay, reader);
+		break;
+
+	case COMMAND_CAPTURE_OP_FNA3D_APPLY_EFFECT:
+		Replay_ApplyEffect(replay, reader);
+		break;
+
+	case COMMAND_CAPTURE_OP_FNA3D_CLEAR:
+	{
+		FNA3D_Vec4 color;
+		float depth;
+
+		FNA3D_ClearOptions options = (FNA3D_ClearOptions) ReplayReader_Get32(reader);
+		ReplayReader_Copy(reader, &color, sizeof(color));
+		ReplayReader_Copy(reader, &depth, sizeof(depth));
+		int32_t stencil = (int32_t) ReplayReader_Get32(reader);
+		FNA3D_Clear(device, options, &color, depth, stencil);
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_FNA3D_DRAW_INDEXED_PRIMITIVES:
+	{
+		FNA3D_PrimitiveType primitiveType = (FNA3D_PrimitiveType) ReplayReader_Get32(reader);
+		int32_t baseVertex = (int32_t) ReplayReader_Get32(reader);
+		int32_t minVertexIndex = (int32_t) ReplayReader_Get32(reader);
+		int32_t numVertices = (int32_t) ReplayReader_Get32(reader);
+		int32_t startIndex = (int32_t) ReplayReader_Get32(reader);
+		int32_t primitiveCount = (int32_t) ReplayReader_Get32(reader);
+		FNA3D_Buffer *indices = ReplayReader_GetObject(reader, replay);
+		FNA3D_IndexElementSize indexElementSize = (FNA3D_IndexElementSize) ReplayReader_Get32(reader);
+		FNA3D_DrawIndexedPrimitives(
+			device,
+			primitiveType,
+			baseVertex,
+			minVertexIndex,
+			numVertices,
+			startIndex,
+			primitiveCount,
+			indices,
+			indexElementSize
+		);
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_FNA3D_SWAP_BUFFERS:
+	{
+		FNA3D_Rect sourceRectangle, destinationRectangle;
+
+		bool hasSourceRectangle = ReplayReader_Get32(reader) != 0;
+		if (hasSourceRectangle)
+		{
+			ReplayReader_Copy(reader, &sourceRectangle, sizeof(sourceRectangle));
+		}
+		bool hasDestinationRectangle = ReplayReader_Get32(reader) != 0;
+		if (hasDestinationRectangle)
+		{
+			ReplayReader_Copy(reader, &destinationRectangle, sizeof(destinationRectangle));
+		}
+		FNA3D_SwapBuffers(
+			device,
+			hasSourceRectangle ? &sourceRectangle : NULL,
+			hasDestinationRectangle ? &destinationRectangle : NULL,
+			NULL
+		);
+		break;
+	}
+
+	default:
+		fprintf(stderr, "Unknown record %u\n", op);
+		return false;
+	}
+
+	return true;
+}
+
+/* Returns false for records this build doesn't know */
+static bool Replay_Record(Replay *replay, uint32_t op, ReplayReader *reader)
+{
+	Refresh_Device *device = replay->device;
+	Refresh_TextureSlice slice, destinationSlice;
+	Refresh_CommandBuffer *commandBuffer;
+	ReplayCommandBuffer *replayCommandBuffer;
+	uint64_t handle;
+
+	switch (op)
+	{
+	case COMMAND_CAPTURE_OP_CREATE_TEXTURE_2D:
+	{
+		handle = ReplayReader_Get64(reader);
+		Refresh_ColorFormat format = (Refresh_ColorFormat) ReplayReader_Get32(reader);
+		uint32_t width = ReplayReader_Get32(reader);
+		uint32_t height = ReplayReader_Get32(reader);
+		uint32_t levelCount = ReplayReader_Get32(reader);
+		Refresh_TextureUsageFlags usageFlags = ReplayReader_Get32(reader);
+		ReplayObjects_Set(
+			&replay->objects,
+			handle,
+			Refresh_CreateTexture2D(device, format, width, height, levelCount, usageFlags)
+		);
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_CREATE_COLOR_TARGET:
+	{
+		handle = ReplayReader_Get64(reader);
+		Refresh_SampleCount sampleCount = (Refresh_SampleCount) ReplayReader_Get32(reader);
+		ReplayReader_GetSlice(reader, replay, &slice);
+		ReplayObjects_Set(&replay->objects, handle, Refresh_CreateColorTarget(device, sampleCount, &slice));
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_CREATE_DEPTH_STENCIL_TARGET:
+	{
+		handle = ReplayReader_Get64(reader);
+		uint32_t width = ReplayReader_Get32(reader);
+		uint32_t height = ReplayReader_Get32(reader);
+		Refresh_DepthFormat format = (Refresh_DepthFormat) ReplayReader_Get32(reader);
+		ReplayObjects_Set(&replay->objects, handle, Refresh_CreateDepthStencilTarget(device, width, height, format));
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_CREATE_FRAMEBUFFER:
+	{
+		Refresh_ColorTarget *colorTargets[8];
+		Refresh_FramebufferCreateInfo createInfo;
+
+		handle = ReplayReader_Get64(reader);
+		createInfo.renderPass = ReplayReader_GetObject(reader, replay);
+		createInfo.colorTargetCount = ReplayReader_Get32(reader);
+		createInfo.colorTargetCount = SDL_min(createInfo.colorTargetCount, 8);
+		for (uint32_t i = 0; i < createInfo.colorTargetCount; i++)
+		{
+			colorTargets[i] = ReplayReader_GetObject(reader, replay);
+		}
+		createInfo.pColorTargets = colorTargets;
+		createInfo.pDepthStencilTarget = ReplayReader_GetObject(reader, replay);
+		createInfo.width = ReplayReader_Get32(reader);
+		createInfo.height = ReplayReader_Get32(reader);
+		ReplayObjects_Set(&replay->objects, handle, Refresh_CreateFramebuffer(device, &createInfo));
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_CREATE_RENDER_PASS:
+	{
+		Refresh_RenderPassCreateInfo createInfo;
+
+		handle = ReplayReader_Get64(reader);
+		createInfo.colorTargetCount = ReplayReader_Get32(reader);
+		createInfo.colorTargetDescriptions = ReplayReader_GetArray(
+			reader,
+			createInfo.colorTargetCount,
+			sizeof(Refresh_ColorTargetDescription)
+		);
+		createInfo.depthTargetDescription = NULL;
+		if (ReplayReader_Get32(reader))
+		{
+			createInfo.depthTargetDescription = ReplayReader_Get(reader, sizeof(Refresh_DepthStencilTargetDescription));
+		}
+		if (!reader->overrun)
+		{
+			ReplayObjects_Set(&replay->objects, handle, Refresh_CreateRenderPass(device, &createInfo));
+		}
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_CREATE_SHADER_MODULE:
+	{
+		Refresh_ShaderModuleCreateInfo createInfo;
+
+		handle = ReplayReader_Get64(reader);
+		createInfo.codeSize = ReplayReader_Get32(reader);
+		createInfo.byteCode = ReplayReader_GetArray(reader, (uint32_t) createInfo.codeSize, 1);
+		if (!reader->overrun)
+		{
+			ReplayObjects_Set(&replay->objects, handle, Refresh_CreateShaderModule(device, &createInfo));
+		}
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_CREATE_SAMPLER:
+	{
+		Refresh_SamplerStateCreateInfo createInfo;
+
+		handle = ReplayReader_Get64(reader);
+		ReplayReader_Copy(reader, &createInfo, sizeof(createInfo));
+		ReplayObjects_Set(&replay->objects, handle, Refresh_CreateSampler(device, &createInfo));
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_CREATE_BUFFER:
+	{
+		handle = ReplayReader_Get64(reader);
+		Refresh_BufferUsageFlags usageFlags = ReplayReader_Get32(reader);
+		uint32_t size = ReplayReader_Get32(reader);
+		ReplayObjects_Set(&replay->objects, handle, Refresh_CreateBuffer(device, usageFlags, size));
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_CREATE_COMPUTE_PIPELINE:
+	{
+		Refresh_ComputePipelineCreateInfo createInfo;
+		char entryPoint[64];
+
+		handle = ReplayReader_Get64(reader);
+		ReplayReader_GetShaderStage(reader, replay, &createInfo.computeShaderState, entryPoint);
+		ReplayReader_Copy(reader, &createInfo.pipelineLayoutCreateInfo, sizeof(Refresh_ComputePipelineLayoutCreateInfo));
+		ReplayObjects_Set(&replay->objects, handle, Refresh_CreateComputePipeline(device, &createInfo));
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_CREATE_GRAPHICS_PIPELINE:
+		Replay_CreateGraphicsPipeline(replay, reader);
+		break;
+
+	case COMMAND_CAPTURE_OP_SET_TEXTURE_DATA:
+	{
+		ReplayReader_GetSlice(reader, replay, &slice);
+		uint32_t length = ReplayReader_Get32(reader);
+		void *data = (void*) ReplayReader_GetArray(reader, length, 1);
+		if (data != NULL)
+		{
+			Refresh_SetTextureData(device, &slice, data, length);
+		}
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_SET_BUFFER_DATA:
+	{
+		Refresh_Buffer *buffer = ReplayReader_GetObject(reader, replay);
+		uint32_t offset = ReplayReader_Get32(reader);
+		uint32_t length = ReplayReader_Get32(reader);
+		void *data = (void*) ReplayReader_GetArray(reader, length, 1);
+		if (data != NULL)
+		{
+			Refresh_SetBufferData(device, buffer, offset, data, length);
+		}
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_GET_BUFFER_DATA:
+	{
+		Refresh_Buffer *buffer = ReplayReader_GetObject(reader, replay);
+		uint32_t length = ReplayReader_Get32(reader);
+		Refresh_GetBufferData(device, buffer, Replay_Scratch(replay, length), length);
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_DESTROY_TEXTURE:
+		Refresh_QueueDestroyTexture(device, ReplayReader_GetObject(reader, replay));
+		break;
+	case COMMAND_CAPTURE_OP_DESTROY_SAMPLER:
+		Refresh_QueueDestroySampler(device, ReplayReader_GetObject(reader, replay));
+		break;
+	case COMMAND_CAPTURE_OP_DESTROY_BUFFER:
+		Refresh_QueueDestroyBuffer(device, ReplayReader_GetObject(reader, replay));
+		break;
+	case COMMAND_CAPTURE_OP_DESTROY_COLOR_TARGET:
+		Refresh_QueueDestroyColorTarget(device, ReplayReader_GetObject(reader, replay));
+		break;
+	case COMMAND_CAPTURE_OP_DESTROY_DEPTH_STENCIL_TARGET:
+		Refresh_QueueDestroyDepthStencilTarget(device, ReplayReader_GetObject(reader, replay));
+		break;
+	case COMMAND_CAPTURE_OP_DESTROY_FRAMEBUFFER:
+		Refresh_QueueDestroyFramebuffer(device, ReplayReader_GetObject(reader, replay));
+		break;
+	case COMMAND_CAPTURE_OP_DESTROY_SHADER_MODULE:
+		Refresh_QueueDestroyShaderModule(device, ReplayReader_GetObject(reader, replay));
+		break;
+	case COMMAND_CAPTURE_OP_DESTROY_RENDER_PASS:
+		Refresh_QueueDestroyRenderPass(device, ReplayReader_GetObject(reader, replay));
+		break;
+	case COMMAND_CAPTURE_OP_DESTROY_COMPUTE_PIPELINE:
+		Refresh_QueueDestroyComputePipeline(device, ReplayReader_GetObject(reader, replay));
+		break;
+	case COMMAND_CAPTURE_OP_DESTROY_GRAPHICS_PIPELINE:
+		Refresh_QueueDestroyGraphicsPipeline(device, ReplayReader_GetObject(reader, replay));
+		break;
+
+	case COMMAND_CAPTURE_OP_ACQUIRE_COMMAND_BUFFER:
+	{
+		handle = ReplayReader_Get64(reader);
+		uint8_t fixed = (uint8_t) ReplayReader_Get32(reader);
+
+		replayCommandBuffer = Replay_FindCommandBuffer(replay, handle);
+		if (replayCommandBuffer == NULL)
+		{
+			replayCommandBuffer = Replay_FindCommandBuffer(replay, 0);
+		}
+		if (replayCommandBuffer == NULL)
+		{
+			fprintf(stderr, "More than %d command buffers open at once\n", REPLAY_COMMAND_BUFFERS_MAX);
+			return false;
+		}
+
+		SDL_memset(replayCommandBuffer, 0, sizeof(ReplayCommandBuffer));
+		replayCommandBuffer->handle = handle;
+		replayCommandBuffer->commandBuffer = Refresh_AcquireCommandBuffer(device, fixed);
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_BEGIN_RENDER_PASS:
+	{
+		commandBuffer = ReplayReader_GetCommandBuffer(reader, replay, NULL);
+		Refresh_RenderPass *renderPass = ReplayReader_GetObject(reader, replay);
+		Refresh_Framebuffer *framebuffer = ReplayReader_GetObject(reader, replay);
+		Refresh_Rect renderArea;
+		ReplayReader_Copy(reader, &renderArea, sizeof(renderArea));
+		uint32_t colorClearCount = ReplayReader_Get32(reader);
+		Refresh_Color *colorClearValues = (Refresh_Color*) ReplayReader_GetArray(reader, colorClearCount, sizeof(Refresh_Color));
+		Refresh_DepthStencilValue depthStencilClearValue;
+		bool hasDepthStencilClearValue = ReplayReader_Get32(reader) != 0;
+		if (hasDepthStencilClearValue)
+		{
+			ReplayReader_Copy(reader, &depthStencilClearValue, sizeof(depthStencilClearValue));
+		}
+
+		Refresh_BeginRenderPass(
+			device,
+			commandBuffer,
+			renderPass,
+			framebuffer,
+			renderArea,
+			colorClearValues,
+			colorClearCount,
+			hasDepthStencilClearValue ? &depthStencilClearValue : NULL
+		);
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_END_RENDER_PASS:
+		Refresh_EndRenderPass(device, ReplayReader_GetCommandBuffer(reader, replay, NULL));
+		break;
+
+	case COMMAND_CAPTURE_OP_BIND_GRAPHICS_PIPELINE:
+		commandBuffer = ReplayReader_GetCommandBuffer(reader, replay, NULL);
+		Refresh_BindGraphicsPipeline(device, commandBuffer, ReplayReader_GetObject(reader, replay));
+		break;
+
+	case COMMAND_CAPTURE_OP_BIND_VERTEX_BUFFERS:
+	{
+		Refresh_Buffer *buffers[16];
+		uint64_t offsets[16];
+
+		commandBuffer = ReplayReader_GetCommandBuffer(reader, replay, NULL);
+		uint32_t firstBinding = ReplayReader_Get32(reader);
+		uint32_t bindingCount = ReplayReader_Get32(reader);
+		bindingCount = SDL_min(bindingCount, 16);
+		for (uint32_t i = 0; i < bindingCount; i++)
+		{
+			buffers[i] = ReplayReader_GetObject(reader, replay);
+			offsets[i] = ReplayReader_Get64(reader);
+		}
+		Refresh_BindVertexBuffers(device, commandBuffer, firstBinding, bindingCount, buffers, offsets);
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_BIND_VERTEX_SAMPLERS:
+		Replay_BindSamplers(replay, reader, false);
+		break;
+	case COMMAND_CAPTURE_OP_BIND_FRAGMENT_SAMPLERS:
+		Replay_BindSamplers(replay, reader, true);
+		break;
+
+	case COMMAND_CAPTURE_OP_PUSH_VERTEX_SHADER_PARAMS:
+		Replay_PushParams(replay, reader, COMMAND_CAPTURE_STAGE_VERTEX);
+		break;
+	case COMMAND_CAPTURE_OP_PUSH_FRAGMENT_SHADER_PARAMS:
+		Replay_PushParams(replay, reader, COMMAND_CAPTURE_STAGE_FRAGMENT);
+		break;
+	case COMMAND_CAPTURE_OP_PUSH_COMPUTE_SHADER_PARAMS:
+		Replay_PushParams(replay, reader, COMMAND_CAPTURE_STAGE_COMPUTE);
+		break;
+
+	case COMMAND_CAPTURE_OP_DRAW_PRIMITIVES:
+	{
+		commandBuffer = ReplayReader_GetCommandBuffer(reader, replay, &replayCommandBuffer);
+		uint32_t vertexStart = ReplayReader_Get32(reader);
+		uint32_t primitiveCount = ReplayReader_Get32(reader);
+		uint32_t vertexParamOffset = ReplayReader_Get32(reader);
+		uint32_t fragmentParamOffset = ReplayReader_Get32(reader);
+		if (replayCommandBuffer == NULL)
+		{
+			break;
+		}
+
+		Refresh_DrawPrimitives(
+			device,
+			commandBuffer,
+			vertexStart,
+			primitiveCount,
+			Replay_MapOffset(replay, replayCommandBuffer, COMMAND_CAPTURE_STAGE_VERTEX, vertexParamOffset),
+			Replay_MapOffset(replay, replayCommandBuffer, COMMAND_CAPTURE_STAGE_FRAGMENT, fragmentParamOffset)
+		);
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_CLEAR:
+	{
+		Refresh_Rect clearRect;
+
+		commandBuffer = ReplayReader_GetCommandBuffer(reader, replay, NULL);
+		ReplayReader_Copy(reader, &clearRect, sizeof(clearRect));
+		Refresh_ClearOptions options = ReplayReader_Get32(reader);
+		uint32_t colorCount = ReplayReader_Get32(reader);
+		Refresh_Color *colors = (Refresh_Color*) ReplayReader_GetArray(reader, colorCount, sizeof(Refresh_Color));
+		float depth;
+		ReplayReader_Copy(reader, &depth, sizeof(depth));
+		int32_t stencil = (int32_t) ReplayReader_Get32(reader);
+		Refresh_Clear(device, commandBuffer, &clearRect, options, colors, colorCount, depth, stencil);
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_BIND_COMPUTE_PIPELINE:
+		commandBuffer = ReplayReader_GetCommandBuffer(reader, replay, NULL);
+		Refresh_BindComputePipeline(device, commandBuffer, ReplayReader_GetObject(reader, replay));
+		break;
+
+	case COMMAND_CAPTURE_OP_BIND_COMPUTE_TEXTURES:
+	{
+		Refresh_Texture *textures[16];
+
+		commandBuffer = ReplayReader_GetCommandBuffer(reader, replay, NULL);
+		uint32_t count = ReplayReader_Get32(reader);
+		count = SDL_min(count, 16);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			textures[i] = ReplayReader_GetObject(reader, replay);
+		}
+		Refresh_BindComputeTextures(device, commandBuffer, textures);
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_DISPATCH_COMPUTE:
+	{
+		commandBuffer = ReplayReader_GetCommandBuffer(reader, replay, &replayCommandBuffer);
+		uint32_t groupCountX = ReplayReader_Get32(reader);
+		uint32_t groupCountY = ReplayReader_Get32(reader);
+		uint32_t groupCountZ = ReplayReader_Get32(reader);
+		uint32_t computeParamOffset = ReplayReader_Get32(reader);
+		if (replayCommandBuffer == NULL)
+		{
+			break;
+		}
+
+		Refresh_DispatchCompute(
+			device,
+			commandBuffer,
+			groupCountX,
+			groupCountY,
+			groupCountZ,
+			Replay_MapOffset(replay, replayCommandBuffer, COMMAND_CAPTURE_STAGE_COMPUTE, computeParamOffset)
+		);
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_COPY_TEXTURE_TO_TEXTURE:
+	{
+		commandBuffer = ReplayReader_GetCommandBuffer(reader, replay, NULL);
+		ReplayReader_GetSlice(reader, replay, &slice);
+		ReplayReader_GetSlice(reader, replay, &destinationSlice);
+		Refresh_Filter filter = (Refresh_Filter) ReplayReader_Get32(reader);
+		Refresh_CopyTextureToTexture(device, commandBuffer, &slice, &destinationSlice, filter);
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_COPY_TEXTURE_TO_BUFFER:
+		commandBuffer = ReplayReader_GetCommandBuffer(reader, replay, NULL);
+		ReplayReader_GetSlice(reader, replay, &slice);
+		Refresh_CopyTextureToBuffer(device, commandBuffer, &slice, ReplayReader_GetObject(reader, replay));
+		break;
+
+	case COMMAND_CAPTURE_OP_SUBMIT:
+	{
+		Refresh_CommandBuffer *commandBuffers[REPLAY_COMMAND_BUFFERS_MAX];
+
+		uint32_t count = ReplayReader_Get32(reader);
+		count = SDL_min(count, REPLAY_COMMAND_BUFFERS_MAX);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			replayCommandBuffer = Replay_FindCommandBuffer(replay, ReplayReader_Get64(reader));
+			if (replayCommandBuffer == NULL)
+			{
+				fprintf(stderr, "Submit of a command buffer that was never acquired\n");
+				return false;
+			}
+
+			commandBuffers[i] = replayCommandBuffer->commandBuffer;
+			SDL_memset(replayCommandBuffer, 0, sizeof(ReplayCommandBuffer));
+		}
+		Refresh_Submit(device, count, commandBuffers);
+		break;
+	}
+
+	case COMMAND_CAPTURE_OP_WAIT:
+		Refresh_Wait(device);
+		break;
+
+	default:
+		return Replay_FNA3DRecord(replay, op, reader);
+	}
+
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2)
+	{
+		printf("usage: %s trace.rcap [--loops N] [--debug]\n", argv[0]);
+		return -1;
+	}
+
+	const char *tracePath = argv[1];
+	uint32_t loopCount = 1;
+	uint8_t debugMode = 0;
+	for (int i = 2; i < argc; i++)
+	{
+		if (SDL_strcmp(argv[i], "--loops") == 0 && i + 1 < argc)
+		{
+			loopCount = SDL_atoi(argv[++i]);
+			if (loopCount == 0)
+			{
+				fprintf(stderr, "--loops must be greater than zero\n");
+				return -1;
+			}
+		}
+		else if (SDL_strcmp(argv[i], "--debug") == 0)
+		{
+			debugMode = 1;
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return -1;
+		}
+	}
+
+	size_t traceSize;
+	uint8_t *trace = (uint8_t*) SDL_LoadFile(tracePath, &traceSize);
+	if (trace == NULL)
+	{
+		fprintf(stderr, "Failed to load %s\n", tracePath);
+		return -1;
+	}
+
+	CommandCaptureHeader header;
+	if (traceSize < sizeof(header))
+	{
+		fprintf(stderr, "%s is not a command capture\n", tracePath);
+		return -1;
+	}
+	SDL_memcpy(&header, trace, sizeof(header));
+	if (header.magic != COMMAND_CAPTURE_MAGIC || header.version != COMMAND_CAPTURE_VERSION)
+	{
+		fprintf(stderr, "%s is not a version %d command capture\n", tracePath, COMMAND_CAPTURE_VERSION);
+		return -1;
+	}
+
+	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER) < 0)
+	{
+		fprintf(stderr, "Failed to initialize SDL\n\t%s\n", SDL_GetError());
+		return -1;
+	}
+
+	SDL_SetHint("FNA3D_FORCE_DRIVER", "Vulkan");
+
+	SDL_Window *window = SDL_CreateWindow(
+		"Refresh Replay",
+		SDL_WINDOWPOS_UNDEFINED,
+		SDL_WINDOWPOS_UNDEFINED,
+		1280,
+		720,
+		FNA3D_PrepareWindowAttributes() | SDL_WINDOW_HIDDEN
+	);
+
+	if (window == NULL)
+	{
+		fprintf(stderr, "Failed to create window\n\t%s\n", SDL_GetError());
+		return -1;
+	}
+
+	int width, height;
+	FNA3D_GetDrawableSize(window, &width, &height);
+
+	FNA3D_PresentationParameters presentationParameters;
+	SDL_memset(&presentationParameters, 0, sizeof(presentationParameters));
+	presentationParameters.backBufferWidth = width;
+	presentationParameters.backBufferHeight = height;
+	presentationParameters.deviceWindowHandle = window;
+	presentationParameters.presentationInterval = FNA3D_PRESENTINTERVAL_IMMEDIATE;
+
+	Replay replay;
+	SDL_memset(&replay, 0, sizeof(replay));
+	replay.fnaDevice = FNA3D_CreateDevice(&presentationParameters, debugMode);
+
+	if (replay.fnaDevice == NULL)
+	{
+		fprintf(stderr, "Failed to create the FNA3D device\n");
+		return -1;
+	}
+
+	/* On FNA3D's Vulkan device, as in RefreshTest, so the interop textures work */
+	FNA3D_SysRendererEXT sysRenderer;
+	sysRenderer.version = 0;
+	FNA3D_GetSysRendererEXT(replay.fnaDevice, &sysRenderer);
+
+	replay.device = Refresh_CreateDeviceUsingExternal(
+		sysRenderer.renderer.vulkan.instance,
+		sysRenderer.renderer.vulkan.physicalDevice,
+		sysRenderer.renderer.vulkan.logicalDevice,
+		sysRenderer.renderer.vulkan.queueFamilyIndex,
+		debugMode
+	);
+
+	if (replay.device == NULL)
+	{
+		fprintf(stderr, "Failed to create the Refresh device\n");
+		return -1;
+	}
+
+	Benchmark benchmark;
+	Benchmark_Init(&benchmark, 0);
+	double *startupTimes = SDL_malloc(sizeof(double) * loopCount);
+
+	uint64_t replayStart = SDL_GetPerformanceCounter();
+	bool failed = false;
+
+	for (uint32_t loop = 0; loop < loopCount && !failed; loop++)
+	{
+		const uint8_t *at = trace + sizeof(header);
+		const uint8_t *end = trace + traceSize;
+		uint64_t loopStart = SDL_GetPerformanceCounter();
+		bool inFrame = false;
+
+		startupTimes[loop] = 0.0;
+
+		while (at < end)
+		{
+			CommandCaptureRecord record;
+			if ((size_t) (end - at) < sizeof(record))
+			{
+				fprintf(stderr, "Trace ends inside a record\n");
+				failed = true;
+				break;
+			}
+			SDL_memcpy(&record, at, sizeof(record));
+			at += sizeof(record);
+
+			if ((size_t) (end - at) < record.size)
+			{
+				fprintf(stderr, "Trace ends inside a record\n");
+				failed = true;
+				break;
+			}
+
+			/* Frame markers end one frame and start the next */
+			if (record.op == COMMAND_CAPTURE_OP_FRAME)
+			{
+				if (inFrame)
+				{
+					Benchmark_EndFrame(&benchmark);
+				}
+				else
+				{
+					startupTimes[loop] = (SDL_GetPerformanceCounter() - loopStart) * 1000.0 / SDL_GetPerformanceFrequency();
+				}
+				Benchmark_BeginFrame(&benchmark);
+				inFrame = true;
+			}
+			else
+			{
+				ReplayReader reader;
+				reader.at = at;
+				reader.end = at + record.size;
+				reader.overrun = false;
+
+				if (!Replay_Record(&replay, record.op, &reader))
+				{
+					failed = true;
+					break;
+				}
+				if (reader.overrun)
+				{
+					fprintf(stderr, "Record %u is shorter than its arguments\n", record.op);
+					failed = true;
+					break;
+				}
+			}
+
+			replay.recordCount += 1;
+			at += record.size;
+		}
+
+		/* The teardown after the last marker isn't part of any frame */
+		Refresh_Wait(replay.device);
+	}
+
+	double replaySeconds = (SDL_GetPerformanceCounter() - replayStart) / (double) SDL_GetPerformanceFrequency();
+
+	if (!failed)
+	{
+		BenchmarkSummary startup;
+		Benchmark_Summarize(startupTimes, loopCount, &startup);
+
+		printf(
+			"replay: %u loops of %s, %llu records in %.2f s (%.0f records/s)\n",
+			loopCount,
+			tracePath,
+			(unsigned long long) replay.recordCount,
+			replaySeconds,
+			replay.recordCount / replaySeconds
+		);
+		printf("startup: median %.2f ms, max %.2f ms\n", startup.median, startup.max);
+		Benchmark_Report(&benchmark, "replay", stdout);
+
+		if (replay.unmappedOffsetCount > 0)
+		{
+			printf(
+				"%u draws used a param offset other than their command buffer's last push\n",
+				replay.unmappedOffsetCount
+			);
+		}
+	}
+
+	Benchmark_Quit(&benchmark);
+	SDL_free(startupTimes);
+	SDL_free(replay.scratch);
+	SDL_free(replay.objects.keys);
+	SDL_free(replay.objects.values);
+	SDL_free(trace);
+
+	Refresh_DestroyDevice(replay.device);
+	FNA3D_DestroyDevice(replay.fnaDevice);
+	SDL_DestroyWindow(window);
+	SDL_Quit();
+
+	return failed ? -1 : 0;
+}
@@ -0,0 +1,86 @@
+#include "cpu_raymarch.h"
+
+static const char *kernelNames[CPU_RAYMARCH_KERNEL_COUNT] =
+{
+	"scalar", "sse4.1", "avx2"
+};
+
+static void CpuRaymarch_TileJob(void *userdata)
+{
+	CpuRaymarchTile *tile = (CpuRaymarchTile*) userdata;
+	tile->cpu->tileFunc(tile->cpu->frame, tile->x0, tile->y0, tile->x1, tile->y1);
+}
+
+CpuRaymarch* CpuRaymarch_Create(JobSystem *jobs, CpuRaymarchKernel maxKernel)
+{
+	CpuRaymarch *cpu = SDL_malloc(sizeof(CpuRaymarch));
+	SDL_memset(cpu, 0, sizeof(CpuRaymarch));
+
+	cpu->jobs = jobs;
+	cpu->kernel = CPU_RAYMARCH_KERNEL_SCALAR;
+	cpu->tileFunc = CpuRaymarch_TileScalar;
+
+#ifdef CPU_RAYMARCH_SSE41
+	if (maxKernel >= CPU_RAYMARCH_KERNEL_SSE41 && SDL_HasSSE41())
+	{
+		cpu->kernel = CPU_RAYMARCH_KERNEL_SSE41;
+		cpu->tileFunc = CpuRaymarch_TileSSE41;
+	}
+#endif
+#ifdef CPU_RAYMARCH_AVX2
+	if (maxKernel >= CPU_RAYMARCH_KERNEL_AVX2 && SDL_HasAVX2())
+	{
+		cpu->kernel = CPU_RAYMARCH_KERNEL_AVX2;
+		cpu->tileFunc = CpuRaymarch_TileAVX2;
+	}
+#endif
+
+	return cpu;
+}
+
+void CpuRaymarch_Destroy(CpuRaymarch *cpu)
+{
+	SDL_free(cpu->tiles);
+	SDL_free(cpu);
+}
+
+void CpuRaymarch_Render(CpuRaymarch *cpu, const CpuRaymarchFrame *frame)
+{
+	uint32_t width = (uint32_t) frame->uniforms.resolutionX;
+	uint32_t height = (uint32_t) frame->uniforms.resolutionY;
+	uint32_t columnCount = (width + CPU_RAYMARCH_TILE_SIZE - 1) / CPU_RAYMARCH_TILE_SIZE;
+	uint32_t rowCount = (height + CPU_RAYMARCH_TILE_SIZE - 1) / CPU_RAYMARCH_TILE_SIZE;
+	uint32_t tileCount = columnCount * rowCount;
+
+	if (tileCount > cpu->tileCapacity)
+	{
+		cpu->tiles = SDL_realloc(cpu->tiles, tileCount * sizeof(CpuRaymarchTile));
+		cpu->tileCapacity = tileCount;
+	}
+
+	cpu->frame = frame;
+
+	for (uint32_t i = 0; i < tileCount; i++)
+	{
+		CpuRaymarchTile *tile = &cpu->tiles[i];
+		tile->cpu = cpu;
+		tile->x0 = (i % columnCount) * CPU_RAYMARCH_TILE_SIZE;
+		tile->y0 = (i / columnCount) * CPU_RAYMARCH_TILE_SIZE;
+		tile->x1 = SDL_min(tile->x0 + CPU_RAYMARCH_TILE_SIZE, width);
+		tile->y1 = SDL_min(tile->y0 + CPU_RAYMARCH_TILE_SIZE, height);
+
+		JobSystem_Submit(cpu->jobs, &tile->job, CpuRaymarch_TileJob, tile);
+	}
+
+	for (uint32_t i = 0; i < tileCount; i++)
+	{
+		JobSystem_Wait(cpu->jobs, &cpu->tiles[i].job);
+	}
+
+	cpu->frame = NULL;
+}
+
+const char* CpuRaymarch_KernelName(CpuRaymarchKernel kernel)
+{
+	return kernelNames[kernel];
+}
@@ -0,0 +1,117 @@
+#ifndef CPU_RAYMARCH_H
+#define CPU_RAYMARCH_H
+
+/* CPU reference renderer for the raymarch scenes.
+ *
+ * hexagon_grid.frag, seascape.glsl and color_phase.frag ported to C, for
+ * checking GPU output and timing shading throughput on hosts with no
+ * Vulkan at all; see RaymarchReference (raymarch_reference.c). It reads
+ * the same RaymarchUniforms and quality tiers as the GPU passes.
+ *
+ * The port lives in cpu_raymarch_kernel.h, written once against a handful
+ * of lane operations, one pixel per lane. cpu_raymarch_avx2.c,
+ * cpu_raymarch_sse41.c and cpu_raymarch_scalar.c define those operations
+ * for 8, 4 and 1 lanes and include the kernel; CpuRaymarch_Create picks the
+ * widest one the CPU runs. All three use the same polynomial sin, exp2 and
+ * friends in the same order, so their output is bit-identical.
+ *
+ * A frame is cut into tiles that go to the job system, and the caller waits
+ * for all of them.
+ *
+ * Expect small differences from the GPU: transcendental functions are
+ * approximated differently, textures are sampled bilinearly from the
+ * uncompressed PNG's level 0 instead of the DDS mip chain, and noise.png's
+ * texelFetch past its 256x256 edge reads zero, as with robust image access.
+ * seascape hashes with sin of large arguments, so its waves differ in
+ * places; compare it by PSNR rather than per pixel.
+ */
+
+#include <stdint.h>
+
+#include "jobs.h"
+#include "raymarch_scenes.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CPU_RAYMARCH_SSE41
+#define CPU_RAYMARCH_AVX2
+#endif
+
+#define CPU_RAYMARCH_TILE_SIZE 32
+
+typedef enum CpuRaymarchKernel
+{
+	CPU_RAYMARCH_KERNEL_SCALAR,
+	CPU_RAYMARCH_KERNEL_SSE41,
+	CPU_RAYMARCH_KERNEL_AVX2,
+	CPU_RAYMARCH_KERNEL_COUNT
+} CpuRaymarchKernel;
+
+/* R8G8B8A8, as Refresh_Image_Load returns it */
+typedef struct CpuRaymarchTexture
+{
+	const uint8_t *pixels;
+	uint32_t width;
+	uint32_t height;
+} CpuRaymarchTexture;
+
+typedef struct CpuRaymarchFrame
+{
+	RaymarchScene scene;
+	const SpecializationConstant *constants; /* a row of raymarchQualityConstants */
+	RaymarchUniforms uniforms;
+
+	/* hexagon_grid's iChannel0 and iChannel1, seascape has none */
+	CpuRaymarchTexture wood;
+	CpuRaymarchTexture noise;
+
+	/* R8G8B8A8, top row first like a readback; size from the uniforms */
+	uint8_t *pixels;
+} CpuRaymarchFrame;
+
+/* Shades the pixels in [x0, x1) x [y0, y1) */
+typedef void (*CpuRaymarchTileFunc)(
+	const CpuRaymarchFrame *frame,
+	uint32_t x0,
+	uint32_t y0,
+	uint32_t x1,
+	uint32_t y1
+);
+
+void CpuRaymarch_TileScalar(const CpuRaymarchFrame *frame, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1);
+#ifdef CPU_RAYMARCH_SSE41
+void CpuRaymarch_TileSSE41(const CpuRaymarchFrame *frame, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1);
+#endif
+#ifdef CPU_RAYMARCH_AVX2
+void CpuRaymarch_TileAVX2(const CpuRaymarchFrame *frame, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1);
+#endif
+
+typedef struct CpuRaymarchTile
+{
+	Job job;
+	struct CpuRaymarch *cpu;
+	uint32_t x0, y0, x1, y1;
+} CpuRaymarchTile;
+
+typedef struct CpuRaymarch
+{
+	JobSystem *jobs;
+	CpuRaymarchKernel kernel;
+	CpuRaymarchTileFunc tileFunc;
+
+	/* Grown to the largest frame rendered so far */
+	CpuRaymarchTile *tiles;
+	uint32_t tileCapacity;
+
+	const CpuRaymarchFrame *frame; /* only during CpuRaymarch_Render */
+} CpuRaymarch;
+
+/* Uses the widest kernel the CPU supports, at most maxKernel */
+CpuRaymarch* CpuRaymarch_Create(JobSystem *jobs, CpuRaymarchKernel maxKernel);
+void CpuRaymarch_Destroy(CpuRaymarch *cpu);
+
+/* Returns once every tile is done */
+void CpuRaymarch_Render(CpuRaymarch *cpu, const CpuRaymarchFrame *frame);
+
+const char* CpuRaymarch_KernelName(CpuRaymarchKernel kernel);
+
+#endif /* CPU_RAYMARCH_H */
@@ -0,0 +1,67 @@
+/* Eight lanes of AVX2 */
+
+#include "cpu_raymarch.h"
+
+#ifdef CPU_RAYMARCH_AVX2
+
+#include <immintrin.h>
+
+#define LANE_COUNT 8
+#define LANE_TARGET __attribute__((target("avx2")))
+#define CPU_RAYMARCH_TILE_FUNCTION CpuRaymarch_TileAVX2
+
+typedef __m256 Lane;
+typedef __m256i LaneInt;
+typedef __m256 LaneMask;
+
+static inline LANE_TARGET Lane Lane_Set(float x) { return _mm256_set1_ps(x); }
+static inline LANE_TARGET Lane Lane_Index(void) { return _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f); }
+static inline LANE_TARGET Lane Lane_Load(const float *x) { return _mm256_loadu_ps(x); }
+static inline LANE_TARGET void Lane_Store(float *x, Lane a) { _mm256_storeu_ps(x, a); }
+
+static inline LANE_TARGET Lane Lane_Add(Lane a, Lane b) { return _mm256_add_ps(a, b); }
+static inline LANE_TARGET Lane Lane_Sub(Lane a, Lane b) { return _mm256_sub_ps(a, b); }
+static inline LANE_TARGET Lane Lane_Mul(Lane a, Lane b) { return _mm256_mul_ps(a, b); }
+static inline LANE_TARGET Lane Lane_Div(Lane a, Lane b) { return _mm256_div_ps(a, b); }
+static inline LANE_TARGET Lane Lane_Min(Lane a, Lane b) { return _mm256_min_ps(a, b); }
+static inline LANE_TARGET Lane Lane_Max(Lane a, Lane b) { return _mm256_max_ps(a, b); }
+static inline LANE_TARGET Lane Lane_Sqrt(Lane a) { return _mm256_sqrt_ps(a); }
+static inline LANE_TARGET Lane Lane_Floor(Lane a) { return _mm256_floor_ps(a); }
+static inline LANE_TARGET Lane Lane_Abs(Lane a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+
+static inline LANE_TARGET LaneMask Lane_Less(Lane a, Lane b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+static inline LANE_TARGET Lane Lane_Select(LaneMask m, Lane a, Lane b) { return _mm256_blendv_ps(b, a, m); }
+
+static inline LANE_TARGET LaneInt Lane_ToInt(Lane a) { return _mm256_cvttps_epi32(a); }
+static inline LANE_TARGET Lane Lane_FromInt(LaneInt a) { return _mm256_cvtepi32_ps(a); }
+static inline LANE_TARGET LaneInt Lane_AsInt(Lane a) { return _mm256_castps_si256(a); }
+static inline LANE_TARGET Lane Lane_FromBits(LaneInt a) { return _mm256_castsi256_ps(a); }
+
+static inline LANE_TARGET LaneMask Mask_And(LaneMask a, LaneMask b) { return _mm256_and_ps(a, b); }
+static inline LANE_TARGET LaneMask Mask_Or(LaneMask a, LaneMask b) { return _mm256_or_ps(a, b); }
+static inline LANE_TARGET LaneMask Mask_AndNot(LaneMask a, LaneMask b) { return _mm256_andnot_ps(b, a); }
+static inline LANE_TARGET LaneMask Mask_Not(LaneMask a) { return _mm256_xor_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(-1))); }
+static inline LANE_TARGET LaneMask Mask_All(void) { return _mm256_castsi256_ps(_mm256_set1_epi32(-1)); }
+static inline LANE_TARGET LaneMask Mask_None(void) { return _mm256_setzero_ps(); }
+static inline LANE_TARGET uint8_t Mask_Any(LaneMask a) { return _mm256_movemask_ps(a) != 0; }
+
+static inline LANE_TARGET LaneInt LaneInt_Set(int32_t x) { return _mm256_set1_epi32(x); }
+static inline LANE_TARGET LaneInt LaneInt_Add(LaneInt a, LaneInt b) { return _mm256_add_epi32(a, b); }
+static inline LANE_TARGET LaneInt LaneInt_Sub(LaneInt a, LaneInt b) { return _mm256_sub_epi32(a, b); }
+static inline LANE_TARGET LaneInt LaneInt_Mul(LaneInt a, LaneInt b) { return _mm256_mullo_epi32(a, b); }
+static inline LANE_TARGET LaneInt LaneInt_Xor(LaneInt a, LaneInt b) { return _mm256_xor_si256(a, b); }
+static inline LANE_TARGET LaneInt LaneInt_And(LaneInt a, LaneInt b) { return _mm256_and_si256(a, b); }
+static inline LANE_TARGET LaneInt LaneInt_ShiftLeft(LaneInt a, int n) { return _mm256_slli_epi32(a, n); }
+static inline LANE_TARGET LaneInt LaneInt_ShiftRight(LaneInt a, int n) { return _mm256_srai_epi32(a, n); }
+static inline LANE_TARGET LaneMask LaneInt_Equal(LaneInt a, LaneInt b) { return _mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)); }
+static inline LANE_TARGET LaneMask LaneInt_Less(LaneInt a, LaneInt b) { return _mm256_castsi256_ps(_mm256_cmpgt_epi32(b, a)); }
+static inline LANE_TARGET void LaneInt_Store(int32_t *x, LaneInt a) { _mm256_storeu_si256((__m256i*) x, a); }
+
+static inline LANE_TARGET LaneInt LaneInt_Select(LaneMask m, LaneInt a, LaneInt b)
+{
+	return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(b), _mm256_castsi256_ps(a), m));
+}
+
+#include "cpu_raymarch_kernel.h"
+
+#endif /* CPU_RAYMARCH_AVX2 */
@@ -0,0 +1,1294 @@
+/* hexagon_grid.frag, seascape.glsl and color_phase.frag, one pixel per lane.
+ *
+ * Included once by each of cpu_raymarch_scalar.c, cpu_raymarch_sse41.c and
+ * cpu_raymarch_avx2.c, after they define LANE_COUNT, LANE_TARGET, the Lane,
+ * LaneInt and LaneMask types and their operations, and
+ * CPU_RAYMARCH_TILE_FUNCTION, the name to give the tile entry point. So
+ * there is no include guard.
+ *
+ * Functions keep the GLSL names and order so the two read side by side.
+ * Loops whose length differs per pixel run until every lane has finished,
+ * with finished lanes masked out of the updates.
+ */
+
+typedef struct Vec2
+{
+	Lane x, y;
+} Vec2;
+
+typedef struct Vec3
+{
+	Lane x, y, z;
+} Vec3;
+
+typedef struct IVec2
+{
+	LaneInt x, y;
+} IVec2;
+
+/* Scalars */
+
+static inline LANE_TARGET LaneMask Lane_Greater(Lane a, Lane b)
+{
+	return Lane_Less(b, a);
+}
+
+static inline LANE_TARGET Lane Lane_MulAdd(Lane a, Lane b, Lane c)
+{
+	return Lane_Add(Lane_Mul(a, b), c);
+}
+
+static inline LANE_TARGET Lane Lane_Clamp(Lane x, float low, float high)
+{
+	return Lane_Min(Lane_Max(x, Lane_Set(low)), Lane_Set(high));
+}
+
+static inline LANE_TARGET Lane Lane_Fract(Lane x)
+{
+	return Lane_Sub(x, Lane_Floor(x));
+}
+
+static inline LANE_TARGET Lane Lane_Mix(Lane a, Lane b, Lane t)
+{
+	return Lane_Add(a, Lane_Mul(Lane_Sub(b, a), t));
+}
+
+static inline LANE_TARGET Lane Lane_Smoothstep(float edge0, float edge1, Lane x)
+{
+	Lane t = Lane_Clamp(Lane_Mul(Lane_Sub(x, Lane_Set(edge0)), Lane_Set(1.0f / (edge1 - edge0))), 0.0f, 1.0f);
+	return Lane_Mul(Lane_Mul(t, t), Lane_Sub(Lane_Set(3.0f), Lane_Add(t, t)));
+}
+
+/* Cephes sinf and cosf: reduce to [-pi/4, pi/4] by multiples of pi/2, with
+ * pi/4 split in three so the reduction stays exact up to |x| of about 50000
+ */
+static LANE_TARGET void Lane_SinCos(Lane x, Lane *sinOut, Lane *cosOut)
+{
+	Lane sinSign = Lane_Select(Lane_Less(x, Lane_Set(0.0f)), Lane_Set(-1.0f), Lane_Set(1.0f));
+	x = Lane_Abs(x);
+
+	/* Octant, rounded up to even */
+	LaneInt j = Lane_ToInt(Lane_Mul(x, Lane_Set(1.27323954473516f)));
+	j = LaneInt_And(LaneInt_Add(j, LaneInt_Set(1)), LaneInt_Set(~1));
+	Lane y = Lane_FromInt(j);
+
+	x = Lane_Sub(x, Lane_Mul(y, Lane_Set(0.78515625f)));
+	x = Lane_Sub(x, Lane_Mul(y, Lane_Set(2.4187564849853515625e-4f)));
+	x = Lane_Sub(x, Lane_Mul(y, Lane_Set(3.77489497744594108e-8f)));
+	Lane z = Lane_Mul(x, x);
+
+	Lane polyCos = Lane_Set(2.443315711809948e-5f);
+	polyCos = Lane_MulAdd(polyCos, z, Lane_Set(-1.388731625493765e-3f));
+	polyCos = Lane_MulAdd(polyCos, z, Lane_Set(4.166664568298827e-2f));
+	polyCos = Lane_Mul(Lane_Mul(polyCos, z), z);
+	polyCos = Lane_Sub(polyCos, Lane_Mul(z, Lane_Set(0.5f)));
+	polyCos = Lane_Add(polyCos, Lane_Set(1.0f));
+
+	Lane polySin = Lane_Set(-1.9515295891e-4f);
+	polySin = Lane_MulAdd(polySin, z, Lane_Set(8.3321608736e-3f));
+	polySin = Lane_MulAdd(polySin, z, Lane_Set(-1.6666654611e-1f));
+	polySin = Lane_MulAdd(Lane_Mul(polySin, z), x, x);
+
+	/* Octants 2 and 6 swap the polynomials, 4 flips sin and 2 and 4 flip cos */
+	LaneMask swap = LaneInt_Equal(LaneInt_And(j, LaneInt_Set(2)), LaneInt_Set(2));
+	LaneMask sinFlip = LaneInt_Equal(LaneInt_And(j, LaneInt_Set(4)), LaneInt_Set(4));
+	LaneMask cosFlip = LaneInt_Equal(LaneInt_And(LaneInt_Sub(j, LaneInt_Set(2)), LaneInt_Set(4)), LaneInt_Set(0));
+
+	sinSign = Lane_Select(sinFlip, Lane_Sub(Lane_Set(0.0f), sinSign), sinSign);
+	*sinOut = Lane_Mul(Lane_Select(swap, polyCos, polySin), sinSign);
+	*cosOut = Lane_Mul(
+		Lane_Select(swap, polySin, polyCos),
+		Lane_Select(cosFlip, Lane_Set(-1.0f), Lane_Set(1.0f))
+	);
+}
+
+static inline LANE_TARGET Lane Lane_Sin(Lane x)
+{
+	Lane s, c;
+	Lane_SinCos(x, &s, &c);
+	return s;
+}
+
+static inline LANE_TARGET Lane Lane_Cos(Lane x)
+{
+	Lane s, c;
+	Lane_SinCos(x, &s, &c);
+	return c;
+}
+
+/* Cephes exp2f */
+static LANE_TARGET Lane Lane_Exp2(Lane x)
+{
+	x = Lane_Clamp(x, -126.0f, 127.0f);
+
+	Lane whole = Lane_Floor(Lane_Add(x, Lane_Set(0.5f)));
+	x = Lane_Sub(x, whole);
+
+	Lane p = Lane_Set(1.535336188319500e-4f);
+	p = Lane_MulAdd(p, x, Lane_Set(1.339887440266574e-3f));
+	p = Lane_MulAdd(p, x, Lane_Set(9.618437357674640e-3f));
+	p = Lane_MulAdd(p, x, Lane_Set(5.550332471162809e-2f));
+	p = Lane_MulAdd(p, x, Lane_Set(2.402264791363012e-1f));
+	p = Lane_MulAdd(p, x, Lane_Set(6.931472028550421e-1f));
+	p = Lane_MulAdd(p, x, Lane_Set(1.0f));
+
+	LaneInt exponent = LaneInt_ShiftLeft(LaneInt_Add(Lane_ToInt(whole), LaneInt_Set(127)), 23);
+	return Lane_Mul(p, Lane_FromBits(exponent));
+}
+
+/* Cephes log2f, for positive normal x */
+static LANE_TARGET Lane Lane_Log2(Lane x)
+{
+	LaneInt bits = Lane_AsInt(x);
+	Lane exponent = Lane_FromInt(LaneInt_Sub(LaneInt_ShiftRight(bits, 23), LaneInt_Set(126)));
+	x = Lane_FromBits(LaneInt_Add(LaneInt_And(bits, LaneInt_Set(0x007FFFFF)), LaneInt_Set(0x3F000000)));
+
+	/* Mantissa in [sqrt(1/2), sqrt(2)) - 1 */
+	LaneMask small = Lane_Less(x, Lane_Set(0.707106781186547524f));
+	exponent = Lane_Select(small, Lane_Sub(exponent, Lane_Set(1.0f)), exponent);
+	x = Lane_Sub(Lane_Select(small, Lane_Add(x, x), x), Lane_Set(1.0f));
+
+	Lane z = Lane_Mul(x, x);
+	Lane y = Lane_Set(7.0376836292e-2f);
+	y = Lane_MulAdd(y, x, Lane_Set(-1.1514610310e-1f));
+	y = Lane_MulAdd(y, x, Lane_Set(1.1676998740e-1f));
+	y = Lane_MulAdd(y, x, Lane_Set(-1.2420140846e-1f));
+	y = Lane_MulAdd(y, x, Lane_Set(1.4249322787e-1f));
+	y = Lane_MulAdd(y, x, Lane_Set(-1.6668057665e-1f));
+	y = Lane_MulAdd(y, x, Lane_Set(2.0000714765e-1f));
+	y = Lane_MulAdd(y, x, Lane_Set(-2.4999993993e-1f));
+	y = Lane_MulAdd(y, x, Lane_Set(3.3333331174e-1f));
+	y = Lane_Mul(Lane_Mul(y, x), z);
+	y = Lane_Sub(y, Lane_Mul(z, Lane_Set(0.5f)));
+
+	Lane result = Lane_Mul(y, Lane_Set(0.44269504088896340736f));
+	result = Lane_MulAdd(x, Lane_Set(0.44269504088896340736f), result);
+	result = Lane_Add(result, y);
+	result = Lane_Add(result, x);
+	return Lane_Add(result, exponent);
+}
+
+/* GLSL leaves pow of x <= 0 undefined, GPUs give 0 for x == 0 */
+static inline LANE_TARGET Lane Lane_Pow(Lane x, Lane y)
+{
+	Lane result = Lane_Exp2(Lane_Mul(y, Lane_Log2(x)));
+	return Lane_Select(Lane_Greater(x, Lane_Set(0.0f)), result, Lane_Set(0.0f));
+}
+
+/* Cephes atanf of y / x, with GLSL atan(y, x)'s quadrants */
+static LANE_TARGET Lane Lane_Atan2(Lane y, Lane x)
+{
+	Lane t = Lane_Div(y, x);
+	Lane sign = Lane_Select(Lane_Less(t, Lane_Set(0.0f)), Lane_Set(-1.0f), Lane_Set(1.0f));
+	t = Lane_Abs(t);
+
+	LaneMask large = Lane_Greater(t, Lane_Set(2.414213562373095f));
+	LaneMask medium = Mask_AndNot(Lane_Greater(t, Lane_Set(0.4142135623730950f)), large);
+	Lane base = Lane_Select(large, Lane_Set(1.5707963267948966f), Lane_Select(medium, Lane_Set(0.7853981633974483f), Lane_Set(0.0f)));
+	t = Lane_Select(
+		large,
+		Lane_Div(Lane_Set(-1.0f), t),
+		Lane_Select(medium, Lane_Div(Lane_Sub(t, Lane_Set(1.0f)), Lane_Add(t, Lane_Set(1.0f))), t)
+	);
+
+	Lane z = Lane_Mul(t, t);
+	Lane p = Lane_Set(8.05374449538e-2f);
+	p = Lane_MulAdd(p, z, Lane_Set(-1.38776856032e-1f));
+	p = Lane_MulAdd(p, z, Lane_Set(1.99777106478e-1f));
+	p = Lane_MulAdd(p, z, Lane_Set(-3.33329491539e-1f));
+	Lane angle = Lane_Mul(Lane_Add(Lane_MulAdd(Lane_Mul(p, z), t, t), base), sign);
+
+	/* Left half plane, then the y axis */
+	Lane halfTurn = Lane_Select(Lane_Less(y, Lane_Set(0.0f)), Lane_Set(-3.14159265358979f), Lane_Set(3.14159265358979f));
+	angle = Lane_Select(Lane_Less(x, Lane_Set(0.0f)), Lane_Add(angle, halfTurn), angle);
+
+	Lane quarterTurn = Lane_Select(Lane_Less(y, Lane_Set(0.0f)), Lane_Set(-1.5707963267948966f), Lane_Set(1.5707963267948966f));
+	LaneMask onAxis = Mask_And(Mask_Not(Lane_Less(x, Lane_Set(0.0f))), Mask_Not(Lane_Greater(x, Lane_Set(0.0f))));
+	return Lane_Select(onAxis, quarterTurn, angle);
+}
+
+/* Cephes asinf, for x in [-1, 1] */
+static LANE_TARGET Lane Lane_Acos(Lane x)
+{
+	Lane sign = Lane_Select(Lane_Less(x, Lane_Set(0.0f)), Lane_Set(-1.0f), Lane_Set(1.0f));
+	Lane a = Lane_Abs(x);
+
+	LaneMask large = Lane_Greater(a, Lane_Set(0.5f));
+	Lane z = Lane_Select(large, Lane_Mul(Lane_Set(0.5f), Lane_Sub(Lane_Set(1.0f), a)), Lane_Mul(a, a));
+	Lane t = Lane_Select(large, Lane_Sqrt(z), a);
+
+	Lane p = Lane_Set(4.2163199048e-2f);
+	p = Lane_MulAdd(p, z, Lane_Set(2.4181311049e-2f));
+	p = Lane_MulAdd(p, z, Lane_Set(4.5470025998e-2f));
+	p = Lane_MulAdd(p, z, Lane_Set(7.4953002686e-2f));
+	p = Lane_MulAdd(p, z, Lane_Set(1.6666752422e-1f));
+	p = Lane_MulAdd(Lane_Mul(p, z), t, t);
+	p = Lane_Select(large, Lane_Sub(Lane_Set(1.5707963267948966f), Lane_Add(p, p)), p);
+
+	return Lane_Sub(Lane_Set(1.5707963267948966f), Lane_Mul(p, sign));
+}
+
+/* Vectors */
+
+static inline LANE_TARGET Vec2 Vec2_Make(Lane x, Lane y)
+{
+	Vec2 v;
+	v.x = x;
+	v.y = y;
+	return v;
+}
+
+static inline LANE_TARGET Vec3 Vec3_Make(Lane x, Lane y, Lane z)
+{
+	Vec3 v;
+	v.x = x;
+	v.y = y;
+	v.z = z;
+	return v;
+}
+
+static inline LANE_TARGET Vec3 Vec3_Set(float x, float y, float z)
+{
+	return Vec3_Make(Lane_Set(x), Lane_Set(y), Lane_Set(z));
+}
+
+static inline LANE_TARGET Vec3 Vec3_Add(Vec3 a, Vec3 b)
+{
+	return Vec3_Make(Lane_Add(a.x, b.x), Lane_Add(a.y, b.y), Lane_Add(a.z, b.z));
+}
+
+static inline LANE_TARGET Vec3 Vec3_Sub(Vec3 a, Vec3 b)
+{
+	return Vec3_Make(Lane_Sub(a.x, b.x), Lane_Sub(a.y, b.y), Lane_Sub(a.z, b.z));
+}
+
+static inline LANE_TARGET Vec3 Vec3_Mul(Vec3 a, Vec3 b)
+{
+	return Vec3_Make(Lane_Mul(a.x, b.x), Lane_Mul(a.y, b.y), Lane_Mul(a.z, b.z));
+}
+
+static inline LANE_TARGET Vec3 Vec3_Scale(Vec3 a, Lane s)
+{
+	return Vec3_Make(Lane_Mul(a.x, s), Lane_Mul(a.y, s), Lane_Mul(a.z, s));
+}
+
+static inline LANE_TARGET Lane Vec3_Dot(Vec3 a, Vec3 b)
+{
+	return Lane_Add(Lane_Add(Lane_Mul(a.x, b.x), Lane_Mul(a.y, b.y)), Lane_Mul(a.z, b.z));
+}
+
+static inline LANE_TARGET Vec3 Vec3_Cross(Vec3 a, Vec3 b)
+{
+	return Vec3_Make(
+		Lane_Sub(Lane_Mul(a.y, b.z), Lane_Mul(a.z, b.y)),
+		Lane_Sub(Lane_Mul(a.z, b.x), Lane_Mul(a.x, b.z)),
+		Lane_Sub(Lane_Mul(a.x, b.y), Lane_Mul(a.y, b.x))
+	);
+}
+
+static inline LANE_TARGET Vec3 Vec3_Normalize(Vec3 a)
+{
+	return Vec3_Scale(a, Lane_Div(Lane_Set(1.0f), Lane_Sqrt(Vec3_Dot(a, a))));
+}
+
+static inline LANE_TARGET Vec3 Vec3_Mix(Vec3 a, Vec3 b, Lane t)
+{
+	return Vec3_Make(Lane_Mix(a.x, b.x, t), Lane_Mix(a.y, b.y, t), Lane_Mix(a.z, b.z, t));
+}
+
+static inline LANE_TARGET Vec3 Vec3_Reflect(Vec3 i, Vec3 n)
+{
+	return Vec3_Sub(i, Vec3_Scale(n, Lane_Mul(Lane_Set(2.0f), Vec3_Dot(n, i))));
+}
+
+static inline LANE_TARGET Vec3 Vec3_Select(LaneMask m, Vec3 a, Vec3 b)
+{
+	return Vec3_Make(Lane_Select(m, a.x, b.x), Lane_Select(m, a.y, b.y), Lane_Select(m, a.z, b.z));
+}
+
+static inline LANE_TARGET IVec2 IVec2_Make(LaneInt x, LaneInt y)
+{
+	IVec2 v;
+	v.x = x;
+	v.y = y;
+	return v;
+}
+
+static inline LANE_TARGET IVec2 IVec2_Add(IVec2 a, IVec2 b)
+{
+	return IVec2_Make(LaneInt_Add(a.x, b.x), LaneInt_Add(a.y, b.y));
+}
+
+static inline LANE_TARGET IVec2 IVec2_Select(LaneMask m, IVec2 a, IVec2 b)
+{
+	return IVec2_Make(LaneInt_Select(m, a.x, b.x), LaneInt_Select(m, a.y, b.y));
+}
+
+/* Textures, one lane at a time */
+
+static LANE_TARGET Vec3 Texture_Sample(const CpuRaymarchTexture *texture, Vec2 uv)
+{
+	float u[LANE_COUNT], v[LANE_COUNT];
+	float r[LANE_COUNT], g[LANE_COUNT], b[LANE_COUNT];
+
+	Lane_Store(u, uv.x);
+	Lane_Store(v, uv.y);
+
+	for (uint32_t lane = 0; lane < LANE_COUNT; lane++)
+	{
+		float x = u[lane] * texture->width - 0.5f;
+		float y = v[lane] * texture->height - 0.5f;
+
+		/* Lanes that missed can carry infinities, their color is discarded */
+		if (!(SDL_fabsf(x) < 16777216.0f && SDL_fabsf(y) < 16777216.0f))
+		{
+			r[lane] = g[lane] = b[lane] = 0.0f;
+			continue;
+		}
+
+		float x0 = SDL_floorf(x);
+		float y0 = SDL_floorf(y);
+		float fx = x - x0;
+		float fy = y - y0;
+
+		/* Repeat addressing, the remainder made positive */
+		int32_t column = (int32_t) SDL_fmodf(x0, (float) texture->width);
+		int32_t row = (int32_t) SDL_fmodf(y0, (float) texture->height);
+		column += column < 0 ? texture->width : 0;
+		row += row < 0 ? texture->height : 0;
+		uint32_t column1 = (column + 1) % texture->width;
+		uint32_t row1 = (row + 1) % texture->height;
+
+		const uint8_t *t00 = texture->pixels + (row * texture->width + column) * 4;
+		const uint8_t *t10 = texture->pixels + (row * texture->width + column1) * 4;
+		const uint8_t *t01 = texture->pixels + (row1 * texture->width + column) * 4;
+		const uint8_t *t11 = texture->pixels + (row1 * texture->width + column1) * 4;
+
+		float channels[3];
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			float top = t00[c] + (t10[c] - t00[c]) * fx;
+			float bottom = t01[c] + (t11[c] - t01[c]) * fx;
+			channels[c] = (top + (bottom - top) * fy) * (1.0f / 255.0f);
+		}
+
+		r[lane] = channels[0];
+		g[lane] = channels[1];
+		b[lane] = channels[2];
+	}
+
+	return Vec3_Make(Lane_Load(r), Lane_Load(g), Lane_Load(b));
+}
+
+/* Level 0, zero past the edge */
+static LANE_TARGET Vec2 Texture_Fetch(const CpuRaymarchTexture *texture, IVec2 coord)
+{
+	int32_t x[LANE_COUNT], y[LANE_COUNT];
+	float r[LANE_COUNT], g[LANE_COUNT];
+
+	LaneInt_Store(x, coord.x);
+	LaneInt_Store(y, coord.y);
+
+	for (uint32_t lane = 0; lane < LANE_COUNT; lane++)
+	{
+		r[lane] = 0.0f;
+		g[lane] = 0.0f;
+
+		if (	x[lane] >= 0 && (uint32_t) x[lane] < texture->width &&
+			y[lane] >= 0 && (uint32_t) y[lane] < texture->height	)
+		{
+			const uint8_t *texel = texture->pixels + (y[lane] * texture->width + x[lane]) * 4;
+			r[lane] = texel[0] * (1.0f / 255.0f);
+			g[lane] = texel[1] * (1.0f / 255.0f);
+		}
+	}
+
+	return Vec2_Make(Lane_Load(r), Lane_Load(g));
+}
+
+/* hexagon_grid.frag */
+
+#define HEXAGON_K3 0.866025f
+#define HEXAGON_MAX_HEIGHT 6.0f
+#define HEXAGON_SHADOW_STEPS 8
+
+/* The prism wall faces, sid 0 to 5 in getPrismWall: the neighbour across
+ * the wall and the wall's two top corners around the prism's center
+ */
+static const int32_t hexagonWallNeighbours[6][2] =
+{
+	{ 2, 0 }, { 1, -1 }, { -1, -1 }, { -2, 0 }, { -1, 1 }, { 1, 1 }
+};
+
+/* kC1 = 1/sqrt(3), kC2 = 2/sqrt(3) */
+static const float hexagonWallCorners[6][4] =
+{
+	{ 1.0f, 0.577350269f, 1.0f, -0.577350269f },
+	{ 1.0f, -0.577350269f, 0.0f, -1.154700538f },
+	{ 0.0f, -1.154700538f, -1.0f, -0.577350269f },
+	{ -1.0f, -0.577350269f, -1.0f, 0.577350269f },
+	{ -1.0f, 0.577350269f, 0.0f, 1.154700538f },
+	{ 0.0f, 1.154700538f, 1.0f, 0.577350269f }
+};
+
+/* The faceID each wall is skipped for in calcOcclusion */
+static const int32_t hexagonWallSkipFaces[6] =
+{
+	1, -3, -2, -1, 3, 2
+};
+
+/* Truncating n / 3 through floats, exact while |n| < 2^22 */
+static inline LANE_TARGET LaneInt Hexagon_Div3(LaneInt n)
+{
+	return Lane_ToInt(Lane_Div(Lane_FromInt(n), Lane_Set(3.0f)));
+}
+
+static inline LANE_TARGET LaneInt Hexagon_Mod3(LaneInt n)
+{
+	LaneInt negative = LaneInt_Sub(LaneInt_Set(2), n);
+	LaneInt negativeMod = LaneInt_Sub(negative, LaneInt_Mul(Hexagon_Div3(negative), LaneInt_Set(3)));
+	LaneInt positiveMod = LaneInt_Sub(n, LaneInt_Mul(Hexagon_Div3(n), LaneInt_Set(3)));
+
+	return LaneInt_Select(
+		LaneInt_Less(n, LaneInt_Set(0)),
+		LaneInt_Sub(LaneInt_Set(2), negativeMod),
+		positiveMod
+	);
+}
+
+static inline LANE_TARGET LaneInt Hexagon_Hash(LaneInt n)
+{
+	n = LaneInt_Xor(LaneInt_ShiftLeft(n, 13), n);
+	LaneInt inner = LaneInt_Add(LaneInt_Mul(LaneInt_Mul(n, n), LaneInt_Set(15731)), LaneInt_Set(789221));
+	return LaneInt_Add(LaneInt_Mul(n, inner), LaneInt_Set(1376312589));
+}
+
+static LANE_TARGET IVec2 Hexagon_ID(Vec2 p)
+{
+	Lane qx = p.x;
+	Lane qy = Lane_Add(Lane_Mul(p.y, Lane_Set(1.732050807f * 0.5f)), Lane_Mul(p.x, Lane_Set(0.5f)));
+
+	Lane floorX = Lane_Floor(qx);
+	Lane floorY = Lane_Floor(qy);
+	IVec2 pi = IVec2_Make(Lane_ToInt(floorX), Lane_ToInt(floorY));
+	Lane pfx = Lane_Sub(qx, floorX);
+	Lane pfy = Lane_Sub(qy, floorY);
+
+	LaneInt v = Hexagon_Mod3(LaneInt_Add(pi.x, pi.y));
+	LaneInt ca = LaneInt_Select(LaneInt_Less(v, LaneInt_Set(1)), LaneInt_Set(0), LaneInt_Set(1));
+	LaneInt cb = LaneInt_Select(LaneInt_Less(v, LaneInt_Set(2)), LaneInt_Set(0), LaneInt_Set(1));
+	LaneMask xOver = Lane_Greater(pfx, pfy);
+	LaneInt max = LaneInt_Select(xOver, LaneInt_Set(0), LaneInt_Set(1));
+	LaneInt may = LaneInt_Select(xOver, LaneInt_Set(1), LaneInt_Set(0));
+
+	IVec2 id = IVec2_Make(
+		LaneInt_Sub(LaneInt_Add(pi.x, ca), LaneInt_Mul(cb, max)),
+		LaneInt_Sub(LaneInt_Add(pi.y, ca), LaneInt_Mul(cb, may))
+	);
+
+	return IVec2_Make(id.x, LaneInt_Sub(id.y, Hexagon_Div3(LaneInt_Add(id.x, id.y))));
+}
+
+static inline LANE_TARGET Vec2 Hexagon_CenterFromID(IVec2 id)
+{
+	return Vec2_Make(Lane_FromInt(id.x), Lane_Mul(Lane_FromInt(id.y), Lane_Set(1.732050807f)));
+}
+
+static LANE_TARGET Lane Hexagon_Map(Vec2 p, Lane time)
+{
+	Lane px = Lane_Mul(p.x, Lane_Set(0.5f));
+	Lane py = Lane_Mul(p.y, Lane_Set(0.5f));
+
+	Lane inner = Lane_Sin(Lane_Mul(py, Lane_Set(0.24f)));
+	Lane f = Lane_Mul(
+		Lane_Sin(Lane_Add(Lane_Add(Lane_Mul(Lane_Set(0.53f), px), Lane_Mul(Lane_Set(0.5f), time)), inner)),
+		Lane_Sin(Lane_Add(Lane_Mul(Lane_Set(0.13f), py), time))
+	);
+	f = Lane_Add(Lane_Set(0.5f), Lane_Mul(Lane_Set(0.5f), f));
+
+	Lane g = Lane_Mul(
+		Lane_Sin(Lane_Add(Lane_Mul(Lane_Set(1.7f), px), Lane_Mul(Lane_Set(1.32f), time))),
+		Lane_Sin(Lane_Add(Lane_Mul(Lane_Set(1.3f), py), Lane_Mul(time, Lane_Set(2.1f))))
+	);
+	f = Lane_Mul(f, Lane_Add(Lane_Set(0.75f), Lane_Mul(Lane_Set(0.25f), g)));
+
+	return Lane_Mul(Lane_Set(HEXAGON_MAX_HEIGHT), Lane_Add(Lane_Set(0.005f), Lane_Mul(Lane_Set(0.995f), f)));
+}
+
+/* The per-ray constants castRay and castShadowRay share */
+typedef struct HexagonRay
+{
+	Lane d1, d2, d3, d4;
+	Lane s1, s2, s3, s4;
+	IVec2 i1, i2, i3;
+} HexagonRay;
+
+static LANE_TARGET HexagonRay Hexagon_RaySetup(Vec3 rd)
+{
+	HexagonRay ray;
+	Lane zero = Lane_Set(0.0f);
+	Lane one = Lane_Set(1.0f);
+
+	ray.d1 = Lane_Div(one, rd.x);
+	ray.d2 = Lane_Div(one, Lane_Add(Lane_Mul(rd.x, Lane_Set(0.5f)), Lane_Mul(rd.z, Lane_Set(HEXAGON_K3))));
+	ray.d3 = Lane_Div(one, Lane_Add(Lane_Mul(rd.x, Lane_Set(-0.5f)), Lane_Mul(rd.z, Lane_Set(HEXAGON_K3))));
+	ray.d4 = Lane_Div(one, rd.y);
+
+	LaneMask n1 = Lane_Less(ray.d1, zero);
+	LaneMask n2 = Lane_Less(ray.d2, zero);
+	LaneMask n3 = Lane_Less(ray.d3, zero);
+	ray.s1 = Lane_Select(n1, Lane_Set(-1.0f), one);
+	ray.s2 = Lane_Select(n2, Lane_Set(-1.0f), one);
+	ray.s3 = Lane_Select(n3, Lane_Set(-1.0f), one);
+	ray.s4 = Lane_Select(Lane_Less(ray.d4, zero), Lane_Set(-1.0f), one);
+
+	ray.i1 = IVec2_Make(LaneInt_Select(n1, LaneInt_Set(-2), LaneInt_Set(2)), LaneInt_Set(0));
+	ray.i2 = IVec2_Make(LaneInt_Select(n2, LaneInt_Set(-1), LaneInt_Set(1)), LaneInt_Select(n2, LaneInt_Set(-1), LaneInt_Set(1)));
+	ray.i3 = IVec2_Make(LaneInt_Select(n3, LaneInt_Set(1), LaneInt_Set(-1)), LaneInt_Select(n3, LaneInt_Set(-1), LaneInt_Set(1)));
+
+	return ray;
+}
+
+/* Moves the lanes in active to the next hexagon along the ray */
+static inline LANE_TARGET IVec2 Hexagon_Step(const HexagonRay *ray, IVec2 hid, LaneMask active, Lane t1y, Lane t2y, Lane t3y)
+{
+	LaneMask first = Mask_And(Lane_Less(t1y, t2y), Lane_Less(t1y, t3y));
+	LaneMask second = Mask_AndNot(Lane_Less(t2y, t3y), first);
+	IVec2 step = IVec2_Select(first, ray->i1, IVec2_Select(second, ray->i2, ray->i3));
+
+	return IVec2_Select(active, IVec2_Add(hid, step), hid);
+}
+
+typedef struct HexagonHit
+{
+	Lane t;		/* -1 where the ray missed */
+	Vec3 normal;
+	IVec2 prismID;
+	LaneInt faceID;
+} HexagonHit;
+
+static LANE_TARGET HexagonHit Hexagon_CastRay(Vec3 ro, Vec3 rd, Lane time, int32_t raySteps)
+{
+	HexagonRay ray = Hexagon_RaySetup(rd);
+	IVec2 hid = Hexagon_ID(Vec2_Make(ro.x, ro.z));
+
+	Lane t1x = Lane_Set(0.0f), t2x = t1x, t3x = t1x, t4x = t1x;
+	LaneMask found = Mask_None();
+	LaneMask active = Mask_All();
+
+	for (int32_t i = 0; i < raySteps && Mask_Any(active); i++)
+	{
+		Vec2 ce = Hexagon_CenterFromID(hid);
+		Lane he = Lane_Mul(Lane_Set(0.5f), Hexagon_Map(ce, time));
+
+		Lane ocx = Lane_Sub(ro.x, ce.x);
+		Lane ocy = Lane_Sub(ro.y, he);
+		Lane ocz = Lane_Sub(ro.z, ce.y);
+
+		Lane dot1 = ocx;
+		Lane dot2 = Lane_Add(Lane_Mul(ocx, Lane_Set(0.5f)), Lane_Mul(ocz, Lane_Set(HEXAGON_K3)));
+		Lane dot3 = Lane_Add(Lane_Mul(ocx, Lane_Set(-0.5f)), Lane_Mul(ocz, Lane_Set(HEXAGON_K3)));
+
+		Lane n1x = Lane_Mul(Lane_Sub(Lane_Sub(Lane_Set(0.0f), ray.s1), dot1), ray.d1);
+		Lane n1y = Lane_Mul(Lane_Sub(ray.s1, dot1), ray.d1);
+		Lane n2x = Lane_Mul(Lane_Sub(Lane_Sub(Lane_Set(0.0f), ray.s2), dot2), ray.d2);
+		Lane n2y = Lane_Mul(Lane_Sub(ray.s2, dot2), ray.d2);
+		Lane n3x = Lane_Mul(Lane_Sub(Lane_Sub(Lane_Set(0.0f), ray.s3), dot3), ray.d3);
+		Lane n3y = Lane_Mul(Lane_Sub(ray.s3, dot3), ray.d3);
+		Lane n4x = Lane_Mul(Lane_Sub(Lane_Mul(Lane_Sub(Lane_Set(0.0f), ray.s4), he), ocy), ray.d4);
+		Lane n4y = Lane_Mul(Lane_Sub(Lane_Mul(ray.s4, he), ocy), ray.d4);
+
+		Lane tN = Lane_Max(Lane_Max(n1x, n2x), Lane_Max(n3x, n4x));
+		Lane tF = Lane_Min(Lane_Min(n1y, n2y), Lane_Min(n3y, n4y));
+		LaneMask hit = Mask_And(active, Mask_And(Lane_Less(tN, tF), Lane_Greater(tF, Lane_Set(0.0f))));
+
+		t1x = Lane_Select(hit, n1x, t1x);
+		t2x = Lane_Select(hit, n2x, t2x);
+		t3x = Lane_Select(hit, n3x, t3x);
+		t4x = Lane_Select(hit, n4x, t4x);
+		found = Mask_Or(found, hit);
+		active = Mask_AndNot(active, hit);
+
+		hid = Hexagon_Step(&ray, hid, active, n1y, n2y, n3y);
+	}
+
+	HexagonHit result;
+	Lane zero = Lane_Set(0.0f);
+
+	/* The entry face is the one with the largest near distance */
+	result.t = t1x;
+	result.normal = Vec3_Make(ray.s1, zero, zero);
+	result.faceID = LaneInt_Select(Lane_Less(ray.d1, zero), LaneInt_Set(-1), LaneInt_Set(1));
+
+	LaneMask over = Lane_Greater(t2x, result.t);
+	result.t = Lane_Select(over, t2x, result.t);
+	result.normal = Vec3_Select(over, Vec3_Make(Lane_Mul(ray.s2, Lane_Set(0.5f)), zero, Lane_Mul(ray.s2, Lane_Set(HEXAGON_K3))), result.normal);
+	result.faceID = LaneInt_Select(over, LaneInt_Select(Lane_Less(ray.d2, zero), LaneInt_Set(-2), LaneInt_Set(2)), result.faceID);
+
+	over = Lane_Greater(t3x, result.t);
+	result.t = Lane_Select(over, t3x, result.t);
+	result.normal = Vec3_Select(over, Vec3_Make(Lane_Mul(ray.s3, Lane_Set(-0.5f)), zero, Lane_Mul(ray.s3, Lane_Set(HEXAGON_K3))), result.normal);
+	result.faceID = LaneInt_Select(over, LaneInt_Select(Lane_Less(ray.d3, zero), LaneInt_Set(-3), LaneInt_Set(3)), result.faceID);
+
+	over = Lane_Greater(t4x, result.t);
+	result.t = Lane_Select(over, t4x, result.t);
+	result.normal = Vec3_Select(over, Vec3_Make(zero, ray.s4, zero), result.normal);
+	result.faceID = LaneInt_Select(over, LaneInt_Select(Lane_Less(ray.d4, zero), LaneInt_Set(4), LaneInt_Set(-4)), result.faceID);
+
+	result.t = Lane_Select(found, result.t, Lane_Set(-1.0f));
+	result.prismID = hid;
+	return result;
+}
+
+static LANE_TARGET Lane Hexagon_CastShadowRay(Vec3 ro, Vec3 rd, Lane time)
+{
+	HexagonRay ray = Hexagon_RaySetup(rd);
+	IVec2 hid = Hexagon_ID(Vec2_Make(ro.x, ro.z));
+
+	Lane dot1 = ro.x;
+	Lane dot2 = Lane_Add(Lane_Mul(ro.x, Lane_Set(0.5f)), Lane_Mul(ro.z, Lane_Set(HEXAGON_K3)));
+	Lane dot3 = Lane_Add(Lane_Mul(ro.x, Lane_Set(-0.5f)), Lane_Mul(ro.z, Lane_Set(HEXAGON_K3)));
+
+	Lane c1x = Lane_Mul(Lane_Sub(Lane_Sub(Lane_Set(0.0f), ray.s1), dot1), ray.d1);
+	Lane c1y = Lane_Mul(Lane_Sub(ray.s1, dot1), ray.d1);
+	Lane c2x = Lane_Mul(Lane_Sub(Lane_Sub(Lane_Set(0.0f), ray.s2), dot2), ray.d2);
+	Lane c2y = Lane_Mul(Lane_Sub(ray.s2, dot2), ray.d2);
+	Lane c3x = Lane_Mul(Lane_Sub(Lane_Sub(Lane_Set(0.0f), ray.s3), dot3), ray.d3);
+	Lane c3y = Lane_Mul(Lane_Sub(ray.s3, dot3), ray.d3);
+
+	LaneMask active = Mask_All();
+
+	for (int32_t i = 0; i < HEXAGON_SHADOW_STEPS && Mask_Any(active); i++)
+	{
+		Vec2 ce = Hexagon_CenterFromID(hid);
+		Lane he = Lane_Mul(Lane_Set(0.5f), Hexagon_Map(ce, time));
+
+		Lane e1 = Lane_Mul(ce.x, ray.d1);
+		Lane e2 = Lane_Mul(Lane_Add(Lane_Mul(ce.x, Lane_Set(0.5f)), Lane_Mul(ce.y, Lane_Set(HEXAGON_K3))), ray.d2);
+		Lane e3 = Lane_Mul(Lane_Add(Lane_Mul(ce.x, Lane_Set(-0.5f)), Lane_Mul(ce.y, Lane_Set(HEXAGON_K3))), ray.d3);
+
+		Lane t1x = Lane_Add(c1x, e1), t1y = Lane_Add(c1y, e1);
+		Lane t2x = Lane_Add(c2x, e2), t2y = Lane_Add(c2y, e2);
+		Lane t3x = Lane_Add(c3x, e3), t3y = Lane_Add(c3y, e3);
+		Lane t4x = Lane_Mul(Lane_Sub(Lane_Mul(Lane_Sub(Lane_Set(1.0f), ray.s4), he), ro.y), ray.d4);
+		Lane t4y = Lane_Mul(Lane_Sub(Lane_Mul(Lane_Add(Lane_Set(1.0f), ray.s4), he), ro.y), ray.d4);
+
+		Lane tN = Lane_Max(Lane_Max(t1x, t2x), Lane_Max(t3x, t4x));
+		Lane tF = Lane_Min(Lane_Min(t1y, t2y), Lane_Min(t3y, t4y));
+		LaneMask hit = Mask_And(Lane_Less(tN, tF), Lane_Greater(tF, Lane_Set(0.0f)));
+		active = Mask_AndNot(active, hit);
+
+		hid = Hexagon_Step(&ray, hid, active, t1y, t2y, t3y);
+	}
+
+	/* Lanes that never hit stay lit */
+	return Lane_Select(active, Lane_Set(1.0f), Lane_Set(0.0f));
+}
+
+/* Solid angle of a polygon around pos, projected on nor */
+static LANE_TARGET Lane Hexagon_OcclusionPolygon(Vec3 pos, Vec3 nor, const Vec3 *corners, uint32_t cornerCount)
+{
+	Vec3 v[6];
+	for (uint32_t i = 0; i < cornerCount; i++)
+	{
+		v[i] = Vec3_Normalize(Vec3_Sub(corners[i], pos));
+	}
+
+	Lane sum = Lane_Set(0.0f);
+	for (uint32_t i = 0; i < cornerCount; i++)
+	{
+		Vec3 a = v[i];
+		Vec3 b = v[(i + 1) % cornerCount];
+		Lane k = Lane_Mul(
+			Vec3_Dot(nor, Vec3_Normalize(Vec3_Cross(a, b))),
+			Lane_Acos(Lane_Clamp(Vec3_Dot(a, b), -1.0f, 1.0f))
+		);
+		sum = Lane_Add(sum, k);
+	}
+
+	return Lane_Div(Lane_Abs(sum), Lane_Set(6.283185f));
+}
+
+static LANE_TARGET Lane Hexagon_CalcOcclusion(Vec3 pos, Vec3 nor, Lane time, IVec2 prismID, LaneInt faceID)
+{
+	/* Step into the prism in front of the face that was hit */
+	IVec2 i1 = IVec2_Make(LaneInt_Set(2), LaneInt_Set(0));
+	IVec2 i2 = IVec2_Make(LaneInt_Set(1), LaneInt_Set(1));
+	IVec2 i3 = IVec2_Make(LaneInt_Set(-1), LaneInt_Set(1));
+	IVec2 minusI1 = IVec2_Make(LaneInt_Set(-2), LaneInt_Set(0));
+	IVec2 minusI2 = IVec2_Make(LaneInt_Set(-1), LaneInt_Set(-1));
+	IVec2 minusI3 = IVec2_Make(LaneInt_Set(1), LaneInt_Set(-1));
+
+	prismID = IVec2_Select(LaneInt_Equal(faceID, LaneInt_Set(-1)), IVec2_Add(prismID, i1), prismID);
+	prismID = IVec2_Select(LaneInt_Equal(faceID, LaneInt_Set(1)), IVec2_Add(prismID, minusI1), prismID);
+	prismID = IVec2_Select(LaneInt_Equal(faceID, LaneInt_Set(-2)), IVec2_Add(prismID, i2), prismID);
+	prismID = IVec2_Select(LaneInt_Equal(faceID, LaneInt_Set(2)), IVec2_Add(prismID, minusI2), prismID);
+	prismID = IVec2_Select(LaneInt_Equal(faceID, LaneInt_Set(-3)), IVec2_Add(prismID, i3), prismID);
+	prismID = IVec2_Select(LaneInt_Equal(faceID, LaneInt_Set(3)), IVec2_Add(prismID, minusI3), prismID);
+
+	Vec2 ce = Hexagon_CenterFromID(prismID);
+	Lane he = Hexagon_Map(ce, time);
+	Lane occ = Lane_Set(0.0f);
+
+	/* getPrismWall: walls whose neighbour is lower than the prism are portals */
+	for (uint32_t sid = 0; sid < 6; sid++)
+	{
+		IVec2 neighbour = IVec2_Add(
+			prismID,
+			IVec2_Make(LaneInt_Set(hexagonWallNeighbours[sid][0]), LaneInt_Set(hexagonWallNeighbours[sid][1]))
+		);
+		Lane neighbourHeight = Hexagon_Map(Hexagon_CenterFromID(neighbour), time);
+
+		LaneMask wall = Mask_AndNot(
+			Mask_Not(Lane_Less(neighbourHeight, he)),
+			LaneInt_Equal(faceID, LaneInt_Set(hexagonWallSkipFaces[sid]))
+		);
+		if (!Mask_Any(wall))
+		{
+			continue;
+		}
+
+		Lane ax = Lane_Add(ce.x, Lane_Set(hexagonWallCorners[sid][0]));
+		Lane az = Lane_Add(ce.y, Lane_Set(hexagonWallCorners[sid][1]));
+		Lane bx = Lane_Add(ce.x, Lane_Set(hexagonWallCorners[sid][2]));
+		Lane bz = Lane_Add(ce.y, Lane_Set(hexagonWallCorners[sid][3]));
+
+		Vec3 corners[4];
+		corners[0] = Vec3_Make(ax, he, az);
+		corners[1] = Vec3_Make(ax, neighbourHeight, az);
+		corners[2] = Vec3_Make(bx, neighbourHeight, bz);
+		corners[3] = Vec3_Make(bx, he, bz);
+
+		Lane quad = Hexagon_OcclusionPolygon(pos, nor, corners, 4);
+		occ = Lane_Add(occ, Lane_Select(wall, quad, Lane_Set(0.0f)));
+	}
+
+	/* getPrismTop, skipped when the top itself was hit */
+	LaneMask top = Mask_Not(LaneInt_Equal(faceID, LaneInt_Set(4)));
+	if (Mask_Any(top))
+	{
+		static const float topCorners[6][2] =
+		{
+			{ 0.0f, -1.154700538f }, { -1.0f, -0.577350269f }, { -1.0f, 0.577350269f },
+			{ 0.0f, 1.154700538f }, { 1.0f, 0.577350269f }, { 1.0f, -0.577350269f }
+		};
+
+		Vec3 corners[6];
+		for (uint32_t i = 0; i < 6; i++)
+		{
+			corners[i] = Vec3_Make(
+				Lane_Add(ce.x, Lane_Set(topCorners[i][0])),
+				he,
+				Lane_Add(ce.y, Lane_Set(topCorners[i][1]))
+			);
+		}
+
+		Lane withTop = Lane_Add(occ, Hexagon_OcclusionPolygon(pos, nor, corners, 6));
+		Lane open = Lane_Mul(Lane_Mul(Lane_Set(0.8f), Lane_Sub(Lane_Set(1.0f), withTop)), Lane_Div(pos.y, Lane_Set(HEXAGON_MAX_HEIGHT)));
+		withTop = Lane_Sub(Lane_Set(1.0f), Lane_Min(Lane_Set(0.5f), Lane_Add(Lane_Set(0.2f), open)));
+
+		occ = Lane_Select(top, withTop, occ);
+	}
+
+	return Lane_Sub(Lane_Set(1.0f), occ);
+}
+
+static LANE_TARGET Vec3 Hexagon_Render(const CpuRaymarchFrame *frame, Vec3 ro, Vec3 rd, Lane time, int32_t raySteps)
+{
+	HexagonHit hit = Hexagon_CastRay(ro, rd, time, raySteps);
+	LaneMask found = Lane_Greater(hit.t, Lane_Set(0.0f));
+
+	if (!Mask_Any(found))
+	{
+		return Vec3_Set(1.0f, 1.0f, 1.0f);
+	}
+
+	Lane t = hit.t;
+	Vec3 pos = Vec3_Add(ro, Vec3_Scale(rd, t));
+	Vec3 nor = Vec3_Scale(hit.normal, Lane_Set(-1.0f));
+	Vec2 ce = Hexagon_CenterFromID(hit.prismID);
+	Lane he = Hexagon_Map(ce, time);
+	LaneInt id = LaneInt_Add(LaneInt_Mul(hit.prismID.x, LaneInt_Set(131)), LaneInt_Mul(hit.prismID.y, LaneInt_Set(57)));
+
+	/* uvs */
+	LaneMask topFace = LaneInt_Equal(hit.faceID, LaneInt_Set(4));
+	Lane dx = Lane_Sub(pos.x, ce.x);
+	Lane dz = Lane_Sub(pos.z, ce.y);
+	Vec2 uv = Vec2_Make(
+		Lane_Select(topFace, Lane_Mul(dx, Lane_Set(0.15f)), Lane_Div(Lane_Atan2(dx, dz), Lane_Set(3.14156f))),
+		Lane_Select(topFace, Lane_Mul(dz, Lane_Set(0.15f)), Lane_Div(Lane_Sub(pos.y, he), Lane_Set(4.0f)))
+	);
+	uv.x = Lane_Add(uv.x, ce.x);
+	uv.y = Lane_Add(uv.y, ce.y);
+
+	/* material color */
+	id = Hexagon_Hash(id);
+	Lane shade = Lane_FromInt(LaneInt_And(LaneInt_ShiftRight(id, 13), LaneInt_Set(3)));
+	shade = Lane_Add(Lane_Set(0.1f), Lane_Div(Lane_Mul(Lane_Set(0.9f), shade), Lane_Set(3.0f)));
+	Vec3 mate = Vec3_Make(shade, shade, shade);
+	id = Hexagon_Hash(id);
+	LaneMask red = LaneInt_Equal(LaneInt_And(LaneInt_ShiftRight(id, 8), LaneInt_Set(15)), LaneInt_Set(0));
+	mate = Vec3_Select(red, Vec3_Set(0.7f, 0.0f, 0.0f), mate);
+
+	Vec3 sample = Texture_Sample(&frame->wood, Vec2_Make(uv.y, uv.x));
+	Vec3 tex = Vec3_Make(
+		Lane_Add(Lane_Set(0.15f), Lane_Mul(Lane_Set(0.75f), Lane_Pow(sample.x, Lane_Set(1.0f)))),
+		Lane_Add(Lane_Set(0.09f), Lane_Mul(Lane_Set(0.75f), Lane_Pow(sample.y, Lane_Set(0.95f)))),
+		Lane_Add(Lane_Set(0.07f), Lane_Mul(Lane_Set(0.75f), Lane_Pow(sample.z, Lane_Set(0.9f))))
+	);
+	mate = Vec3_Mul(mate, tex);
+
+	/* lighting */
+	Lane occ = Hexagon_CalcOcclusion(pos, nor, time, hit.prismID, hit.faceID);
+
+	/* diffuse */
+	Vec3 col = Vec3_Mul(mate, Vec3_Make(
+		Lane_Pow(occ, Lane_Set(0.95f)),
+		Lane_Pow(occ, Lane_Set(1.05f)),
+		Lane_Pow(occ, Lane_Set(1.1f))
+	));
+
+	/* specular */
+	Lane ks = Lane_Mul(tex.x, Lane_Set(2.0f));
+	Vec3 ref = Vec3_Reflect(rd, nor);
+	col = Vec3_Scale(col, Lane_Set(0.85f));
+	Lane fre = Lane_Clamp(Lane_Add(Lane_Set(1.0f), Vec3_Dot(nor, rd)), 0.0f, 1.0f);
+	Lane shadow = Hexagon_CastShadowRay(Vec3_Add(pos, Vec3_Scale(nor, Lane_Set(0.001f))), ref, time);
+	Lane specular = Lane_Mul(Lane_Mul(Lane_Set(1.1f), ks), Lane_Smoothstep(0.0f, 0.15f, ref.y));
+	specular = Lane_Mul(specular, Lane_Add(Lane_Set(0.04f), Lane_Mul(Lane_Set(0.96f), Lane_Pow(fre, Lane_Set(5.0f)))));
+	specular = Lane_Mul(specular, shadow);
+	col = Vec3_Add(col, Vec3_Make(specular, specular, specular));
+
+	/* fog */
+	Lane fog = Lane_Sub(Lane_Set(1.0f), Lane_Exp2(Lane_Mul(Lane_Set(-0.00005f), Lane_Mul(t, t))));
+	col = Vec3_Mix(col, Vec3_Set(1.0f, 1.0f, 1.0f), fog);
+
+	return Vec3_Select(found, col, Vec3_Set(1.0f, 1.0f, 1.0f));
+}
+
+static LANE_TARGET Vec3 Hexagon_Pixel(const CpuRaymarchFrame *frame, Vec2 fragCoord, int32_t aa, int32_t raySteps)
+{
+	const RaymarchUniforms *uniforms = &frame->uniforms;
+	IVec2 q = IVec2_Make(Lane_ToInt(fragCoord.x), Lane_ToInt(fragCoord.y));
+	Lane resolutionMin = Lane_Set(SDL_min(uniforms->resolutionX, uniforms->resolutionY));
+	Vec3 tot = Vec3_Set(0.0f, 0.0f, 0.0f);
+
+	/* Camera basis, the same for every sample */
+	const float cr = -0.1f;
+	Vec3 ww = Vec3_Normalize(Vec3_Set(-0.1f, -1.0f, -1.0f));
+	Vec3 uu = Vec3_Normalize(Vec3_Cross(ww, Vec3_Make(Lane_Sin(Lane_Set(cr)), Lane_Cos(Lane_Set(cr)), Lane_Set(0.0f))));
+	Vec3 vv = Vec3_Normalize(Vec3_Cross(uu, ww));
+
+	Lane dither = Lane_Set(0.0f);
+	if (aa > 1)
+	{
+		dither = Lane_Mul(Lane_Sin(Lane_Mul(fragCoord.x, Lane_Set(147.0f))), Lane_Sin(Lane_Mul(fragCoord.y, Lane_Set(131.0f))));
+		dither = Lane_Add(Lane_Set(0.5f), Lane_Mul(Lane_Set(0.5f), dither));
+	}
+
+	for (int32_t m = 0; m < aa; m++)
+	for (int32_t n = 0; n < aa; n++)
+	{
+		float ofx = (float) m / (float) aa - 0.5f;
+		float ofy = (float) n / (float) aa - 0.5f;
+		Vec2 p = Vec2_Make(
+			Lane_Div(Lane_Sub(Lane_Mul(Lane_Set(2.0f), Lane_Add(fragCoord.x, Lane_Set(ofx))), Lane_Set(uniforms->resolutionX)), resolutionMin),
+			Lane_Div(Lane_Sub(Lane_Mul(Lane_Set(2.0f), Lane_Add(fragCoord.y, Lane_Set(ofy))), Lane_Set(uniforms->resolutionY)), resolutionMin)
+		);
+
+		Lane time = Lane_Set(uniforms->time);
+		if (aa > 1)
+		{
+			Lane shift = Lane_Div(Lane_Add(Lane_Set((float) (m * aa + n)), dither), Lane_Set((float) (aa * aa)));
+			time = Lane_Sub(time, Lane_Mul(Lane_Set(0.5f * (1.0f / 24.0f)), shift));
+		}
+
+		/* camera */
+		Lane an = Lane_Mul(Lane_Set(3.0f), time);
+		Vec3 ro = Vec3_Make(Lane_Set(0.1f), Lane_Set(13.0f), Lane_Sub(Lane_Set(1.0f), an));
+
+		/* distort */
+		Lane distort = Lane_Add(Lane_Mul(Lane_Mul(p.x, p.x), Lane_Set(0.4f)), Lane_Mul(p.y, p.y));
+		distort = Lane_Add(Lane_Set(0.9f), Lane_Mul(Lane_Set(0.1f), distort));
+		p.x = Lane_Mul(p.x, distort);
+		p.y = Lane_Mul(p.y, distort);
+
+		Vec3 rd = Vec3_Normalize(Vec3_Add(
+			Vec3_Add(Vec3_Scale(uu, p.x), Vec3_Scale(vv, p.y)),
+			Vec3_Scale(ww, Lane_Set(2.0f))
+		));
+
+		/* dof */
+		if (aa > 1)
+		{
+			Vec3 fp = Vec3_Add(ro, Vec3_Scale(rd, Lane_Set(17.0f)));
+			IVec2 coord = IVec2_Make(
+				LaneInt_And(LaneInt_Add(q.x, LaneInt_Set(13 * m)), LaneInt_Set(1023)),
+				LaneInt_And(LaneInt_Add(q.y, LaneInt_Set(31 * n)), LaneInt_Set(1023))
+			);
+			Vec2 ra = Texture_Fetch(&frame->noise, coord);
+
+			Lane s, c;
+			Lane_SinCos(Lane_Mul(Lane_Set(6.2831f), ra.y), &s, &c);
+			Lane radius = Lane_Mul(Lane_Set(0.3f), Lane_Sqrt(ra.x));
+			ro.x = Lane_Add(ro.x, Lane_Mul(radius, c));
+			ro.y = Lane_Add(ro.y, Lane_Mul(radius, s));
+			rd = Vec3_Normalize(Vec3_Sub(fp, ro));
+		}
+
+		tot = Vec3_Add(tot, Hexagon_Render(frame, ro, rd, time, raySteps));
+	}
+	tot = Vec3_Scale(tot, Lane_Set(1.0f / (float) (aa * aa)));
+
+	/* hdr->ldr tonemap */
+	Lane one = Lane_Set(1.0f);
+	tot = Vec3_Make(
+		Lane_Div(Lane_Mul(tot.x, Lane_Set(1.6f)), Lane_Add(one, tot.x)),
+		Lane_Div(Lane_Mul(tot.y, Lane_Set(1.6f)), Lane_Add(one, tot.y)),
+		Lane_Div(Lane_Mul(tot.z, Lane_Set(1.6f)), Lane_Add(one, tot.z))
+	);
+	tot = Vec3_Mul(Vec3_Mul(tot, tot), Vec3_Sub(Vec3_Set(3.0f, 3.0f, 3.0f), Vec3_Scale(tot, Lane_Set(2.0f))));
+
+	/* gamma */
+	Lane gamma = Lane_Set(0.45f);
+	tot = Vec3_Make(
+		Lane_Pow(Lane_Clamp(tot.x, 0.0f, 1.0f), gamma),
+		Lane_Pow(Lane_Clamp(tot.y, 0.0f, 1.0f), gamma),
+		Lane_Pow(Lane_Clamp(tot.z, 0.0f, 1.0f), gamma)
+	);
+
+	/* color grade */
+	Lane px = Lane_Div(fragCoord.x, Lane_Set(uniforms->resolutionX));
+	Lane py = Lane_Div(fragCoord.y, Lane_Set(uniforms->resolutionY));
+	tot.x = Lane_Add(tot.x, Lane_Mul(Lane_Sub(px, Lane_Set(0.5f)), Lane_Set(0.1f)));
+	tot.y = Lane_Add(tot.y, Lane_Mul(Lane_Sub(py, Lane_Set(0.5f)), Lane_Set(0.1f)));
+	tot.z = Lane_Add(tot.z, Lane_Mul(Lane_Sub(py, Lane_Set(0.5f)), Lane_Set(0.1f)));
+
+	/* vignetting */
+	Lane vignette = Lane_Mul(Lane_Mul(Lane_Set(16.0f), px), py);
+	vignette = Lane_Mul(Lane_Mul(vignette, Lane_Sub(one, px)), Lane_Sub(one, py));
+	vignette = Lane_Add(Lane_Set(0.5f), Lane_Mul(Lane_Set(0.5f), Lane_Pow(vignette, Lane_Set(0.1f))));
+
+	return Vec3_Scale(tot, vignette);
+}
+
+/* seascape.glsl */
+
+#define SEA_HEIGHT 0.6f
+#define SEA_CHOPPY 4.0f
+#define SEA_SPEED 0.8f
+#define SEA_FREQ 0.16f
+#define SEA_PI 3.141592f
+
+typedef struct Seascape
+{
+	int32_t numSteps;
+	int32_t iterGeometry;
+	int32_t iterFragment;
+	float seaTime;
+	float epsilonNormal;
+} Seascape;
+
+static inline LANE_TARGET Lane Seascape_Hash(Lane x, Lane y)
+{
+	Lane h = Lane_Add(Lane_Mul(x, Lane_Set(127.1f)), Lane_Mul(y, Lane_Set(311.7f)));
+	return Lane_Fract(Lane_Mul(Lane_Sin(h), Lane_Set(43758.5453123f)));
+}
+
+static LANE_TARGET Lane Seascape_Noise(Vec2 p)
+{
+	Lane ix = Lane_Floor(p.x);
+	Lane iy = Lane_Floor(p.y);
+	Lane fx = Lane_Sub(p.x, ix);
+	Lane fy = Lane_Sub(p.y, iy);
+	Lane ux = Lane_Mul(Lane_Mul(fx, fx), Lane_Sub(Lane_Set(3.0f), Lane_Add(fx, fx)));
+	Lane uy = Lane_Mul(Lane_Mul(fy, fy), Lane_Sub(Lane_Set(3.0f), Lane_Add(fy, fy)));
+
+	Lane one = Lane_Set(1.0f);
+	Lane ix1 = Lane_Add(ix, one);
+	Lane iy1 = Lane_Add(iy, one);
+	Lane bottom = Lane_Mix(Seascape_Hash(ix, iy), Seascape_Hash(ix1, iy), ux);
+	Lane top = Lane_Mix(Seascape_Hash(ix, iy1), Seascape_Hash(ix1, iy1), ux);
+
+	return Lane_Add(Lane_Set(-1.0f), Lane_Mul(Lane_Set(2.0f), Lane_Mix(bottom, top, uy)));
+}
+
+static LANE_TARGET Lane Seascape_Octave(Vec2 uv, float choppy)
+{
+	Lane n = Seascape_Noise(uv);
+	uv.x = Lane_Add(uv.x, n);
+	uv.y = Lane_Add(uv.y, n);
+
+	Lane sx, cx, sy, cy;
+	Lane_SinCos(uv.x, &sx, &cx);
+	Lane_SinCos(uv.y, &sy, &cy);
+
+	Lane one = Lane_Set(1.0f);
+	Lane wvx = Lane_Sub(one, Lane_Abs(sx));
+	Lane wvy = Lane_Sub(one, Lane_Abs(sy));
+	wvx = Lane_Mix(wvx, Lane_Abs(cx), wvx);
+	wvy = Lane_Mix(wvy, Lane_Abs(cy), wvy);
+
+	return Lane_Pow(Lane_Sub(one, Lane_Pow(Lane_Mul(wvx, wvy), Lane_Set(0.65f))), Lane_Set(choppy));
+}
+
+/* map and map_detailed, which only differ in their octave count */
+static LANE_TARGET Lane Seascape_Map(const Seascape *sea, Vec3 p, int32_t iterations)
+{
+	float freq = SEA_FREQ;
+	float amp = SEA_HEIGHT;
+	float choppy = SEA_CHOPPY;
+	Vec2 uv = Vec2_Make(Lane_Mul(p.x, Lane_Set(0.75f)), p.z);
+	Lane seaTime = Lane_Set(sea->seaTime);
+	Lane h = Lane_Set(0.0f);
+
+	for (int32_t i = 0; i < iterations; i++)
+	{
+		Lane f = Lane_Set(freq);
+		Lane d = Seascape_Octave(Vec2_Make(Lane_Mul(Lane_Add(uv.x, seaTime), f), Lane_Mul(Lane_Add(uv.y, seaTime), f)), choppy);
+		d = Lane_Add(d, Seascape_Octave(Vec2_Make(Lane_Mul(Lane_Sub(uv.x, seaTime), f), Lane_Mul(Lane_Sub(uv.y, seaTime), f)), choppy));
+		h = Lane_Add(h, Lane_Mul(d, Lane_Set(amp)));
+
+		/* uv *= octave_m */
+		uv = Vec2_Make(
+			Lane_Add(Lane_Mul(uv.x, Lane_Set(1.6f)), Lane_Mul(uv.y, Lane_Set(1.2f))),
+			Lane_Add(Lane_Mul(uv.x, Lane_Set(-1.2f)), Lane_Mul(uv.y, Lane_Set(1.6f)))
+		);
+		freq *= 1.9f;
+		amp *= 0.22f;
+		choppy = choppy + (1.0f - choppy) * 0.2f;
+	}
+
+	return Lane_Sub(p.y, h);
+}
+
+static inline LANE_TARGET Vec3 Seascape_SkyColor(Vec3 e)
+{
+	Lane y = Lane_Mul(Lane_Add(Lane_Mul(Lane_Max(e.y, Lane_Set(0.0f)), Lane_Set(0.8f)), Lane_Set(0.2f)), Lane_Set(0.8f));
+	Lane inverse = Lane_Sub(Lane_Set(1.0f), y);
+
+	return Vec3_Scale(
+		Vec3_Make(Lane_Mul(inverse, inverse), inverse, Lane_Add(Lane_Set(0.6f), Lane_Mul(inverse, Lane_Set(0.4f)))),
+		Lane_Set(1.1f)
+	);
+}
+
+static LANE_TARGET Vec3 Seascape_SeaColor(Vec3 p, Vec3 n, Vec3 l, Vec3 eye, Vec3 dist)
+{
+	Vec3 waterColor = Vec3_Set(0.8f * 0.6f, 0.9f * 0.6f, 0.6f * 0.6f);
+
+	Lane fresnel = Lane_Clamp(Lane_Add(Lane_Set(1.0f), Vec3_Dot(n, eye)), 0.0f, 1.0f);
+	fresnel = Lane_Mul(Lane_Pow(fresnel, Lane_Set(3.0f)), Lane_Set(0.5f));
+
+	Vec3 reflected = Seascape_SkyColor(Vec3_Reflect(eye, n));
+	Lane diffuse = Lane_Pow(Lane_Add(Lane_Mul(Vec3_Dot(n, l), Lane_Set(0.4f)), Lane_Set(0.6f)), Lane_Set(80.0f));
+	Vec3 refracted = Vec3_Add(Vec3_Set(0.0f, 0.09f, 0.18f), Vec3_Scale(waterColor, Lane_Mul(diffuse, Lane_Set(0.12f))));
+
+	Vec3 color = Vec3_Mix(refracted, reflected, fresnel);
+
+	Lane atten = Lane_Max(Lane_Sub(Lane_Set(1.0f), Lane_Mul(Vec3_Dot(dist, dist), Lane_Set(0.001f))), Lane_Set(0.0f));
+	color = Vec3_Add(color, Vec3_Scale(waterColor, Lane_Mul(Lane_Mul(Lane_Sub(p.y, Lane_Set(SEA_HEIGHT)), Lane_Set(0.18f)), atten)));
+
+	/* specular(n, l, eye, 60.0) */
+	Lane spec = Lane_Pow(Lane_Max(Vec3_Dot(Vec3_Reflect(eye, n), l), Lane_Set(0.0f)), Lane_Set(60.0f));
+	spec = Lane_Mul(spec, Lane_Set((60.0f + 8.0f) / (SEA_PI * 8.0f)));
+
+	return Vec3_Add(color, Vec3_Make(spec, spec, spec));
+}
+
+static LANE_TARGET Vec3 Seascape_Normal(const Seascape *sea, Vec3 p, Lane eps)
+{
+	Lane y = Seascape_Map(sea, p, sea->iterFragment);
+	Lane x = Lane_Sub(Seascape_Map(sea, Vec3_Make(Lane_Add(p.x, eps), p.y, p.z), sea->iterFragment), y);
+	Lane z = Lane_Sub(Seascape_Map(sea, Vec3_Make(p.x, p.y, Lane_Add(p.z, eps)), sea->iterFragment), y);
+
+	return Vec3_Normalize(Vec3_Make(x, eps, z));
+}
+
+/* The GLSL leaves p unset for rays that miss, taken as zero here */
+static LANE_TARGET Vec3 Seascape_HeightMapTracing(const Seascape *sea, Vec3 ori, Vec3 dir)
+{
+	Lane tm = Lane_Set(0.0f);
+	Lane tx = Lane_Set(1000.0f);
+	Lane hx = Seascape_Map(sea, Vec3_Add(ori, Vec3_Scale(dir, tx)), sea->iterGeometry);
+	LaneMask active = Mask_Not(Lane_Greater(hx, Lane_Set(0.0f)));
+	Vec3 p = Vec3_Set(0.0f, 0.0f, 0.0f);
+
+	if (!Mask_Any(active))
+	{
+		return p;
+	}
+
+	Lane hm = Seascape_Map(sea, ori, sea->iterGeometry);
+	for (int32_t i = 0; i < sea->numSteps; i++)
+	{
+		Lane tmid = Lane_Mix(tm, tx, Lane_Div(hm, Lane_Sub(hm, hx)));
+		p = Vec3_Select(active, Vec3_Add(ori, Vec3_Scale(dir, tmid)), p);
+		Lane hmid = Seascape_Map(sea, p, sea->iterGeometry);
+
+		LaneMask below = Lane_Less(hmid, Lane_Set(0.0f));
+		tx = Lane_Select(below, tmid, tx);
+		hx = Lane_Select(below, hmid, hx);
+		tm = Lane_Select(below, tm, tmid);
+		hm = Lane_Select(below, hm, hmid);
+	}
+
+	return p;
+}
+
+static LANE_TARGET Vec3 Seascape_Pixel(const CpuRaymarchFrame *frame, const Seascape *sea, Vec2 fragCoord)
+{
+	const RaymarchUniforms *uniforms = &frame->uniforms;
+	float time = uniforms->time * 0.3f;
+
+	/* getCoord, y up */
+	Lane uvx = Lane_Div(fragCoord.x, Lane_Set(uniforms->resolutionX));
+	Lane uvy = Lane_Div(Lane_Sub(Lane_Set(uniforms->resolutionY), fragCoord.y), Lane_Set(uniforms->resolutionY));
+
+	/* getRay */
+	uvx = Lane_Sub(Lane_Mul(uvx, Lane_Set(2.0f)), Lane_Set(1.0f));
+	uvy = Lane_Sub(Lane_Mul(uvy, Lane_Set(2.0f)), Lane_Set(1.0f));
+	uvx = Lane_Mul(uvx, Lane_Set(uniforms->resolutionX / uniforms->resolutionY));
+
+	/* fromEuler(ang), the same for every pixel */
+	Lane a1x, a1y, a2x, a2y, a3x, a3y;
+	Lane_SinCos(Lane_Mul(Lane_Sin(Lane_Set(time * 3.0f)), Lane_Set(0.1f)), &a1x, &a1y);
+	Lane_SinCos(Lane_Add(Lane_Mul(Lane_Sin(Lane_Set(time)), Lane_Set(0.2f)), Lane_Set(0.3f)), &a2x, &a2y);
+	Lane_SinCos(Lane_Set(time), &a3x, &a3y);
+
+	Vec3 m0 = Vec3_Make(
+		Lane_Add(Lane_Mul(a1y, a3y), Lane_Mul(Lane_Mul(a1x, a2x), a3x)),
+		Lane_Add(Lane_Mul(Lane_Mul(a1y, a2x), a3x), Lane_Mul(a3y, a1x)),
+		Lane_Mul(Lane_Sub(Lane_Set(0.0f), a2y), a3x)
+	);
+	Vec3 m1 = Vec3_Make(Lane_Mul(Lane_Sub(Lane_Set(0.0f), a2y), a1x), Lane_Mul(a1y, a2y), a2x);
+	Vec3 m2 = Vec3_Make(
+		Lane_Add(Lane_Mul(Lane_Mul(a3y, a1x), a2x), Lane_Mul(a1y, a3x)),
+		Lane_Sub(Lane_Mul(a1x, a3x), Lane_Mul(Lane_Mul(a1y, a3y), a2x)),
+		Lane_Mul(a2y, a3y)
+	);
+
+	Vec3 ori = Vec3_Make(Lane_Set(0.0f), Lane_Set(3.5f), Lane_Set(time * 5.0f));
+	Vec3 dir = Vec3_Normalize(Vec3_Make(uvx, uvy, Lane_Set(-2.0f)));
+	dir.z = Lane_Add(dir.z, Lane_Mul(Lane_Sqrt(Lane_Add(Lane_Mul(uvx, uvx), Lane_Mul(uvy, uvy))), Lane_Set(0.14f)));
+	dir = Vec3_Normalize(dir);
+
+	/* dir * m, a row vector times the columns */
+	dir = Vec3_Make(Vec3_Dot(dir, m0), Vec3_Dot(dir, m1), Vec3_Dot(dir, m2));
+
+	/* getRayColor */
+	Vec3 p = Seascape_HeightMapTracing(sea, ori, dir);
+	Vec3 dist = Vec3_Sub(p, ori);
+	Vec3 n = Seascape_Normal(sea, p, Lane_Mul(Vec3_Dot(dist, dist), Lane_Set(sea->epsilonNormal)));
+	Vec3 light = Vec3_Normalize(Vec3_Set(0.0f, 1.0f, 0.8f));
+
+	Lane blend = Lane_Pow(Lane_Smoothstep(0.0f, -0.02f, dir.y), Lane_Set(0.2f));
+	Vec3 color = Vec3_Mix(Seascape_SkyColor(dir), Seascape_SeaColor(p, n, light, dir, dist), blend);
+
+	/* post */
+	Lane post = Lane_Set(0.65f);
+	return Vec3_Make(Lane_Pow(color.x, post), Lane_Pow(color.y, post), Lane_Pow(color.z, post));
+}
+
+/* color_phase.frag */
+
+static LANE_TARGET Vec3 ColorPhase_Pixel(const CpuRaymarchFrame *frame, Vec2 fragCoord)
+{
+	const RaymarchUniforms *uniforms = &frame->uniforms;
+
+	/* The fullscreen triangle's texture coordinates, which span twice the screen, v up */
+	Lane u = Lane_Div(fragCoord.x, Lane_Set(uniforms->resolutionX * 2.0f));
+	Lane v = Lane_Div(Lane_Sub(Lane_Set(uniforms->resolutionY * 2.0f), fragCoord.y), Lane_Set(uniforms->resolutionY * 2.0f));
+
+	Lane time = Lane_Set(uniforms->time);
+	Lane half = Lane_Set(0.5f);
+	return Vec3_Make(
+		Lane_MulAdd(half, Lane_Cos(Lane_Add(time, u)), half),
+		Lane_MulAdd(half, Lane_Cos(Lane_Add(Lane_Add(time, v), Lane_Set(2.0f))), half),
+		Lane_MulAdd(half, Lane_Cos(Lane_Add(Lane_Add(time, u), Lane_Set(4.0f))), half)
+	);
+}
+
+/* Tiles */
+
+static uint32_t CpuRaymarch_ConstantValue(const CpuRaymarchFrame *frame, uint32_t id)
+{
+	for (uint32_t i = 0; i < raymarchQualityConstantCounts[frame->scene]; i++)
+	{
+		if (frame->constants[i].id == id)
+		{
+			return frame->constants[i].value;
+		}
+	}
+
+	return 0;
+}
+
+LANE_TARGET void CPU_RAYMARCH_TILE_FUNCTION(
+	const CpuRaymarchFrame *frame,
+	uint32_t x0,
+	uint32_t y0,
+	uint32_t x1,
+	uint32_t y1
+) {
+	uint32_t width = (uint32_t) frame->uniforms.resolutionX;
+	Seascape sea;
+	SDL_memset(&sea, 0, sizeof(sea));
+	int32_t aa = 0;
+	int32_t raySteps = 0;
+
+	if (frame->scene == RAYMARCH_SCENE_SEASCAPE)
+	{
+		sea.numSteps = (int32_t) CpuRaymarch_ConstantValue(frame, 0);
+		sea.iterGeometry = (int32_t) CpuRaymarch_ConstantValue(frame, 1);
+		sea.iterFragment = (int32_t) CpuRaymarch_ConstantValue(frame, 2);
+		sea.seaTime = 1.0f + frame->uniforms.time * SEA_SPEED;
+		sea.epsilonNormal = 0.1f / frame->uniforms.resolutionX;
+	}
+	else
+	{
+		aa = (int32_t) CpuRaymarch_ConstantValue(frame, 0);
+		raySteps = (int32_t) CpuRaymarch_ConstantValue(frame, 1);
+	}
+
+	for (uint32_t y = y0; y < y1; y++)
+	{
+		/* The last group of a row may run past x1, its extra lanes aren't stored */
+		for (uint32_t x = x0; x < x1; x += LANE_COUNT)
+		{
+			Vec2 fragCoord = Vec2_Make(
+				Lane_Add(Lane_Index(), Lane_Set(x + 0.5f)),
+				Lane_Set(y + 0.5f)
+			);
+
+			Vec3 color;
+			if (frame->scene == RAYMARCH_SCENE_SEASCAPE)
+			{
+				color = Seascape_Pixel(frame, &sea, fragCoord);
+			}
+			else if (frame->scene == RAYMARCH_SCENE_COLOR_PHASE)
+			{
+				color = ColorPhase_Pixel(frame, fragCoord);
+			}
+			else
+			{
+				color = Hexagon_Pixel(frame, fragCoord, aa, raySteps);
+			}
+
+			float r[LANE_COUNT], g[LANE_COUNT], b[LANE_COUNT];
+			Lane_Store(r, Lane_Clamp(color.x, 0.0f, 1.0f));
+			Lane_Store(g, Lane_Clamp(color.y, 0.0f, 1.0f));
+			Lane_Store(b, Lane_Clamp(color.z, 0.0f, 1.0f));
+
+			uint32_t laneCount = SDL_min(x1 - x, LANE_COUNT);
+			uint8_t *pixel = frame->pixels + (y * width + x) * 4;
+			for (uint32_t lane = 0; lane < laneCount; lane++)
+			{
+				pixel[lane * 4 + 0] = (uint8_t) (r[lane] * 255.0f + 0.5f);
+				pixel[lane * 4 + 1] = (uint8_t) (g[lane] * 255.0f + 0.5f);
+				pixel[lane * 4 + 2] = (uint8_t) (b[lane] * 255.0f + 0.5f);
+				pixel[lane * 4 + 3] = 255;
+			}
+		}
+	}
+}
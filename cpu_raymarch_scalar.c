@@ -0,0 +1,75 @@
+/* One lane, plain C; the fallback without SSE4.1 and the easiest reading of the kernel */
+
+#include "cpu_raymarch.h"
+
+#define LANE_COUNT 1
+#define LANE_TARGET
+#define CPU_RAYMARCH_TILE_FUNCTION CpuRaymarch_TileScalar
+
+typedef float Lane;
+typedef int32_t LaneInt;
+typedef uint8_t LaneMask;
+
+static inline Lane Lane_Set(float x) { return x; }
+static inline Lane Lane_Index(void) { return 0.0f; }
+static inline Lane Lane_Load(const float *x) { return *x; }
+static inline void Lane_Store(float *x, Lane a) { *x = a; }
+
+static inline Lane Lane_Add(Lane a, Lane b) { return a + b; }
+static inline Lane Lane_Sub(Lane a, Lane b) { return a - b; }
+static inline Lane Lane_Mul(Lane a, Lane b) { return a * b; }
+static inline Lane Lane_Div(Lane a, Lane b) { return a / b; }
+static inline Lane Lane_Min(Lane a, Lane b) { return a < b ? a : b; }
+static inline Lane Lane_Max(Lane a, Lane b) { return a > b ? a : b; }
+static inline Lane Lane_Sqrt(Lane a) { return SDL_sqrtf(a); }
+static inline Lane Lane_Floor(Lane a) { return SDL_floorf(a); }
+static inline Lane Lane_Abs(Lane a) { return SDL_fabsf(a); }
+
+static inline LaneMask Lane_Less(Lane a, Lane b) { return a < b; }
+static inline Lane Lane_Select(LaneMask m, Lane a, Lane b) { return m ? a : b; }
+
+/* Truncates, and like cvttps2dq gives INT32_MIN for anything out of range */
+static inline LaneInt Lane_ToInt(Lane a)
+{
+	return (a > -2147483648.0f && a < 2147483648.0f) ? (int32_t) a : INT32_MIN;
+}
+
+static inline Lane Lane_FromInt(LaneInt a) { return (float) a; }
+
+static inline LaneInt Lane_AsInt(Lane a)
+{
+	LaneInt bits;
+	SDL_memcpy(&bits, &a, sizeof(bits));
+	return bits;
+}
+
+static inline Lane Lane_FromBits(LaneInt a)
+{
+	Lane x;
+	SDL_memcpy(&x, &a, sizeof(x));
+	return x;
+}
+
+static inline LaneMask Mask_And(LaneMask a, LaneMask b) { return a & b; }
+static inline LaneMask Mask_Or(LaneMask a, LaneMask b) { return a | b; }
+static inline LaneMask Mask_AndNot(LaneMask a, LaneMask b) { return a & !b; }
+static inline LaneMask Mask_Not(LaneMask a) { return !a; }
+static inline LaneMask Mask_All(void) { return 1; }
+static inline LaneMask Mask_None(void) { return 0; }
+static inline uint8_t Mask_Any(LaneMask a) { return a; }
+
+/* GLSL ints wrap, C's signed ones must not overflow */
+static inline LaneInt LaneInt_Set(int32_t x) { return x; }
+static inline LaneInt LaneInt_Add(LaneInt a, LaneInt b) { return (int32_t) ((uint32_t) a + (uint32_t) b); }
+static inline LaneInt LaneInt_Sub(LaneInt a, LaneInt b) { return (int32_t) ((uint32_t) a - (uint32_t) b); }
+static inline LaneInt LaneInt_Mul(LaneInt a, LaneInt b) { return (int32_t) ((uint32_t) a * (uint32_t) b); }
+static inline LaneInt LaneInt_Xor(LaneInt a, LaneInt b) { return a ^ b; }
+static inline LaneInt LaneInt_And(LaneInt a, LaneInt b) { return a & b; }
+static inline LaneInt LaneInt_ShiftLeft(LaneInt a, int n) { return (int32_t) ((uint32_t) a << n); }
+static inline LaneInt LaneInt_ShiftRight(LaneInt a, int n) { return a >> n; }
+static inline LaneMask LaneInt_Equal(LaneInt a, LaneInt b) { return a == b; }
+static inline LaneMask LaneInt_Less(LaneInt a, LaneInt b) { return a < b; }
+static inline LaneInt LaneInt_Select(LaneMask m, LaneInt a, LaneInt b) { return m ? a : b; }
+static inline void LaneInt_Store(int32_t *x, LaneInt a) { *x = a; }
+
+#include "cpu_raymarch_kernel.h"
@@ -0,0 +1,67 @@
+/* Four lanes of SSE4.1, which adds the floor and 32-bit multiply SSE2 lacks */
+
+#include "cpu_raymarch.h"
+
+#ifdef CPU_RAYMARCH_SSE41
+
+#include <smmintrin.h>
+
+#define LANE_COUNT 4
+#define LANE_TARGET __attribute__((target("sse4.1")))
+#define CPU_RAYMARCH_TILE_FUNCTION CpuRaymarch_TileSSE41
+
+typedef __m128 Lane;
+typedef __m128i LaneInt;
+typedef __m128 LaneMask;
+
+static inline LANE_TARGET Lane Lane_Set(float x) { return _mm_set1_ps(x); }
+static inline LANE_TARGET Lane Lane_Index(void) { return _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f); }
+static inline LANE_TARGET Lane Lane_Load(const float *x) { return _mm_loadu_ps(x); }
+static inline LANE_TARGET void Lane_Store(float *x, Lane a) { _mm_storeu_ps(x, a); }
+
+static inline LANE_TARGET Lane Lane_Add(Lane a, Lane b) { return _mm_add_ps(a, b); }
+static inline LANE_TARGET Lane Lane_Sub(Lane a, Lane b) { return _mm_sub_ps(a, b); }
+static inline LANE_TARGET Lane Lane_Mul(Lane a, Lane b) { return _mm_mul_ps(a, b); }
+static inline LANE_TARGET Lane Lane_Div(Lane a, Lane b) { return _mm_div_ps(a, b); }
+static inline LANE_TARGET Lane Lane_Min(Lane a, Lane b) { return _mm_min_ps(a, b); }
+static inline LANE_TARGET Lane Lane_Max(Lane a, Lane b) { return _mm_max_ps(a, b); }
+static inline LANE_TARGET Lane Lane_Sqrt(Lane a) { return _mm_sqrt_ps(a); }
+static inline LANE_TARGET Lane Lane_Floor(Lane a) { return _mm_floor_ps(a); }
+static inline LANE_TARGET Lane Lane_Abs(Lane a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+
+static inline LANE_TARGET LaneMask Lane_Less(Lane a, Lane b) { return _mm_cmplt_ps(a, b); }
+static inline LANE_TARGET Lane Lane_Select(LaneMask m, Lane a, Lane b) { return _mm_blendv_ps(b, a, m); }
+
+static inline LANE_TARGET LaneInt Lane_ToInt(Lane a) { return _mm_cvttps_epi32(a); }
+static inline LANE_TARGET Lane Lane_FromInt(LaneInt a) { return _mm_cvtepi32_ps(a); }
+static inline LANE_TARGET LaneInt Lane_AsInt(Lane a) { return _mm_castps_si128(a); }
+static inline LANE_TARGET Lane Lane_FromBits(LaneInt a) { return _mm_castsi128_ps(a); }
+
+static inline LANE_TARGET LaneMask Mask_And(LaneMask a, LaneMask b) { return _mm_and_ps(a, b); }
+static inline LANE_TARGET LaneMask Mask_Or(LaneMask a, LaneMask b) { return _mm_or_ps(a, b); }
+static inline LANE_TARGET LaneMask Mask_AndNot(LaneMask a, LaneMask b) { return _mm_andnot_ps(b, a); }
+static inline LANE_TARGET LaneMask Mask_Not(LaneMask a) { return _mm_xor_ps(a, _mm_castsi128_ps(_mm_set1_epi32(-1))); }
+static inline LANE_TARGET LaneMask Mask_All(void) { return _mm_castsi128_ps(_mm_set1_epi32(-1)); }
+static inline LANE_TARGET LaneMask Mask_None(void) { return _mm_setzero_ps(); }
+static inline LANE_TARGET uint8_t Mask_Any(LaneMask a) { return _mm_movemask_ps(a) != 0; }
+
+static inline LANE_TARGET LaneInt LaneInt_Set(int32_t x) { return _mm_set1_epi32(x); }
+static inline LANE_TARGET LaneInt LaneInt_Add(LaneInt a, LaneInt b) { return _mm_add_epi32(a, b); }
+static inline LANE_TARGET LaneInt LaneInt_Sub(LaneInt a, LaneInt b) { return _mm_sub_epi32(a, b); }
+static inline LANE_TARGET LaneInt LaneInt_Mul(LaneInt a, LaneInt b) { return _mm_mullo_epi32(a, b); }
+static inline LANE_TARGET LaneInt LaneInt_Xor(LaneInt a, LaneInt b) { return _mm_xor_si128(a, b); }
+static inline LANE_TARGET LaneInt LaneInt_And(LaneInt a, LaneInt b) { return _mm_and_si128(a, b); }
+static inline LANE_TARGET LaneInt LaneInt_ShiftLeft(LaneInt a, int n) { return _mm_slli_epi32(a, n); }
+static inline LANE_TARGET LaneInt LaneInt_ShiftRight(LaneInt a, int n) { return _mm_srai_epi32(a, n); }
+static inline LANE_TARGET LaneMask LaneInt_Equal(LaneInt a, LaneInt b) { return _mm_castsi128_ps(_mm_cmpeq_epi32(a, b)); }
+static inline LANE_TARGET LaneMask LaneInt_Less(LaneInt a, LaneInt b) { return _mm_castsi128_ps(_mm_cmplt_epi32(a, b)); }
+static inline LANE_TARGET void LaneInt_Store(int32_t *x, LaneInt a) { _mm_storeu_si128((__m128i*) x, a); }
+
+static inline LANE_TARGET LaneInt LaneInt_Select(LaneMask m, LaneInt a, LaneInt b)
+{
+	return _mm_castps_si128(_mm_blendv_ps(_mm_castsi128_ps(b), _mm_castsi128_ps(a), m));
+}
+
+#include "cpu_raymarch_kernel.h"
+
+#endif /* CPU_RAYMARCH_SSE41 */
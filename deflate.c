@@ -0,0 +1,715 @@
+#include "deflate.h"
+
+#include <SDL.h>
+
+#define DEFLATE_WINDOW_SIZE 32768
+#define DEFLATE_MIN_MATCH 4	/* the hash covers 4 bytes, so shorter matches are never found */
+#define DEFLATE_MAX_MATCH 258
+#define DEFLATE_STORED_MAX 65535
+
+#define ADLER_BASE 65521
+#define ADLER_NMAX 5552		/* most bytes before the 32-bit sums can overflow */
+
+/* Code length code order, RFC 1951 3.2.7 */
+static const uint8_t codeLengthOrder[19] =
+{
+	16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+typedef struct DeflateWriter
+{
+	uint8_t *output;
+	size_t position;
+	uint64_t bits;
+	uint32_t bitCount;
+} DeflateWriter;
+
+/* One symbol of a Huffman alphabet being built */
+typedef struct DeflateSymbol
+{
+	uint32_t frequency;
+	uint16_t symbol;
+} DeflateSymbol;
+
+typedef struct DeflateTree
+{
+	uint8_t lengths[286];
+	uint16_t codes[286];	/* bit reversed, deflate writes codes MSB first into an LSB first stream */
+} DeflateTree;
+
+/* Writes at most 32 bits, least significant first */
+static void Deflate_PutBits(DeflateWriter *writer, uint32_t value, uint32_t count)
+{
+	writer->bits |= (uint64_t) value << writer->bitCount;
+	writer->bitCount += count;
+
+	if (writer->bitCount >= 32)
+	{
+		uint8_t *out = writer->output + writer->position;
+		out[0] = (uint8_t) writer->bits;
+		out[1] = (uint8_t) (writer->bits >> 8);
+		out[2] = (uint8_t) (writer->bits >> 16);
+		out[3] = (uint8_t) (writer->bits >> 24);
+		writer->position += 4;
+		writer->bits >>= 32;
+		writer->bitCount -= 32;
+	}
+}
+
+/* Pads to a byte boundary and writes out everything buffered */
+static void Deflate_AlignToByte(DeflateWriter *writer)
+{
+	writer->bitCount = (writer->bitCount + 7) & ~7u;
+
+	while (writer->bitCount > 0)
+	{
+		writer->output[writer->position++] = (uint8_t) writer->bits;
+		writer->bits >>= 8;
+		writer->bitCount -= 8;
+	}
+	writer->bits = 0;
+}
+
+/* Length 3..258 to symbol 257..285 and its extra bits */
+static uint32_t Deflate_LengthCode(uint32_t length, uint32_t *extraBits, uint32_t *extraValue)
+{
+	uint32_t v = length - 3;
+
+	if (length == 258)
+	{
+		*extraBits = 0;
+		*extraValue = 0;
+		return 285;
+	}
+	if (v < 8)
+	{
+		*extraBits = 0;
+		*extraValue = 0;
+		return 257 + v;
+	}
+
+	uint32_t log = SDL_MostSignificantBitIndex32(v);
+	*extraBits = log - 2;
+	*extraValue = v & ((1u << *extraBits) - 1);
+	return 257 + 4 * (log - 1) + ((v >> *extraBits) & 3);
+}
+
+/* Distance 1..32768 to code 0..29 and its extra bits */
+static uint32_t Deflate_DistCode(uint32_t dist, uint32_t *extraBits, uint32_t *extraValue)
+{
+	uint32_t v = dist - 1;
+
+	if (v < 4)
+	{
+		*extraBits = 0;
+		*extraValue = 0;
+		return v;
+	}
+
+	uint32_t log = SDL_MostSignificantBitIndex32(v);
+	*extraBits = log - 1;
+	*extraValue = v & ((1u << *extraBits) - 1);
+	return 2 * log + ((v >> *extraBits) & 1);
+}
+
+static int Deflate_CompareSymbols(const void *a, const void *b)
+{
+	const DeflateSymbol *symbolA = (const DeflateSymbol*) a;
+	const DeflateSymbol *symbolB = (const DeflateSymbol*) b;
+
+	if (symbolA->frequency != symbolB->frequency)
+	{
+		return symbolA->frequency < symbolB->frequency ? -1 : 1;
+	}
+	return (int) symbolA->symbol - (int) symbolB->symbol;
+}
+
+/* Moffat and Katajainen's in-place minimum redundancy code: takes
+ * frequencies sorted ascending and leaves each one's code length in its
+ * place. count must be at least 2.
+ */
+static void Deflate_MinimumRedundancy(uint32_t *a, int32_t count)
+{
+	int32_t root, leaf, next;
+
+	a[0] += a[1];
+	root = 0;
+	leaf = 2;
+
+	for (next = 1; next < count - 1; next++)
+	{
+		if (leaf >= count || a[root] < a[leaf])
+		{
+			a[next] = a[root];
+			a[root++] = next;
+		}
+		else
+		{
+			a[next] = a[leaf++];
+		}
+
+		if (leaf >= count || (root < next && a[root] < a[leaf]))
+		{
+			a[next] += a[root];
+			a[root++] = next;
+		}
+		else
+		{
+			a[next] += a[leaf++];
+		}
+	}
+
+	a[count - 2] = 0;
+	for (next = count - 3; next >= 0; next--)
+	{
+		a[next] = a[a[next]] + 1;
+	}
+
+	int32_t available = 1;
+	int32_t used = 0;
+	uint32_t depth = 0;
+	root = count - 2;
+	next = count - 1;
+
+	while (available > 0)
+	{
+		while (root >= 0 && a[root] == depth)
+		{
+			used++;
+			root--;
+		}
+		while (available > used)
+		{
+			a[next--] = depth;
+			available--;
+		}
+		available = 2 * used;
+		depth++;
+		used = 0;
+	}
+}
+
+/* Builds length-limited canonical codes for symbolCount symbols. Unused
+ * symbols get length 0; at least two symbols always get codes, since some
+ * inflaters reject an incomplete code.
+ */
+static void Deflate_BuildTree(
+	DeflateTree *tree,
+	uint32_t *frequencies,
+	uint32_t symbolCount,
+	uint32_t maxLength
+) {
+	DeflateSymbol symbols[286];
+	uint32_t lengths[286];
+	uint32_t lengthCounts[33];
+	uint32_t usedCount = 0;
+
+	for (uint32_t i = 0; i < symbolCount; i++)
+	{
+		usedCount += frequencies[i] > 0;
+	}
+	for (uint32_t i = 0; usedCount < 2; i++)
+	{
+		if (frequencies[i] == 0)
+		{
+			frequencies[i] = 1;
+			usedCount += 1;
+		}
+	}
+
+	usedCount = 0;
+	for (uint32_t i = 0; i < symbolCount; i++)
+	{
+		tree->lengths[i] = 0;
+
+		if (frequencies[i] > 0)
+		{
+			symbols[usedCount].frequency = frequencies[i];
+			symbols[usedCount].symbol = (uint16_t) i;
+			usedCount += 1;
+		}
+	}
+
+	SDL_qsort(symbols, usedCount, sizeof(DeflateSymbol), Deflate_CompareSymbols);
+
+	SDL_memset(lengths, 0, sizeof(lengths));
+	for (uint32_t i = 0; i < usedCount; i++)
+	{
+		lengths[i] = symbols[i].frequency;
+	}
+	Deflate_MinimumRedundancy(lengths, (int32_t) usedCount);
+
+	/* Fold overlong codes into maxLength, then lengthen shorter ones until
+	 * the Kraft sum is exactly one again
+	 */
+	SDL_memset(lengthCounts, 0, sizeof(lengthCounts));
+	for (uint32_t i = 0; i < usedCount; i++)
+	{
+		lengthCounts[SDL_min(lengths[i], maxLength)] += 1;
+	}
+
+	uint32_t kraft = 0;
+	for (uint32_t i = 1; i <= maxLength; i++)
+	{
+		kraft += lengthCounts[i] << (maxLength - i);
+	}
+
+	while (kraft > (1u << maxLength))
+	{
+		lengthCounts[maxLength] -= 1;
+		for (uint32_t i = maxLength - 1; i > 0; i--)
+		{
+			if (lengthCounts[i] > 0)
+			{
+				lengthCounts[i] -= 1;
+				lengthCounts[i + 1] += 2;
+				break;
+			}
+		}
+		kraft -= 1;
+	}
+
+	/* The rarest symbols get the longest codes */
+	uint32_t s = 0;
+	for (uint32_t length = maxLength; length > 0; length--)
+	{
+		for (uint32_t k = 0; k < lengthCounts[length]; k++)
+		{
+			tree->lengths[symbols[s++].symbol] = (uint8_t) length;
+		}
+	}
+
+	/* Canonical codes, RFC 1951 3.2.2 */
+	uint32_t nextCode[16];
+	uint32_t code = 0;
+	lengthCounts[0] = 0;
+	for (uint32_t length = 1; length <= 15; length++)
+	{
+		code = (code + lengthCounts[length - 1]) << 1;
+		nextCode[length] = code;
+	}
+
+	for (uint32_t i = 0; i < symbolCount; i++)
+	{
+		uint32_t length = tree->lengths[i];
+		if (length == 0)
+		{
+			continue;
+		}
+
+		uint32_t forward = nextCode[length]++;
+		uint32_t reversed = 0;
+		for (uint32_t b = 0; b < length; b++)
+		{
+			reversed = (reversed << 1) | ((forward >> b) & 1);
+		}
+		tree->codes[i] = (uint16_t) reversed;
+	}
+}
+
+/* Run-length codes the literal/length and distance code lengths with
+ * symbols 16, 17 and 18. Each entry is symbol | extra value << 8.
+ */
+static uint32_t Deflate_EncodeCodeLengths(
+	const uint8_t *lengths,
+	uint32_t count,
+	uint16_t *encoded,
+	uint32_t *frequencies
+) {
+	uint32_t encodedCount = 0;
+	uint32_t i = 0;
+
+	while (i < count)
+	{
+		uint32_t length = lengths[i];
+		uint32_t run = 1;
+		while (i + run < count && lengths[i + run] == length)
+		{
+			run++;
+		}
+		i += run;
+
+		if (length == 0)
+		{
+			while (run >= 11)
+			{
+				uint32_t repeat = SDL_min(run, 138);
+				encoded[encodedCount++] = (uint16_t) (18 | ((repeat - 11) << 8));
+				frequencies[18] += 1;
+				run -= repeat;
+			}
+			if (run >= 3)
+			{
+				encoded[encodedCount++] = (uint16_t) (17 | ((run - 3) << 8));
+				frequencies[17] += 1;
+				run = 0;
+			}
+		}
+		else
+		{
+			encoded[encodedCount++] = (uint16_t) length;
+			frequencies[length] += 1;
+			run -= 1;
+
+			while (run >= 3)
+			{
+				uint32_t repeat = SDL_min(run, 6);
+				encoded[encodedCount++] = (uint16_t) (16 | ((repeat - 3) << 8));
+				frequencies[16] += 1;
+				run -= repeat;
+			}
+		}
+
+		while (run > 0)
+		{
+			encoded[encodedCount++] = (uint16_t) length;
+			frequencies[length] += 1;
+			run -= 1;
+		}
+	}
+
+	return encodedCount;
+}
+
+static void Deflate_WriteStored(
+	DeflateWriter *writer,
+	const uint8_t *input,
+	size_t length,
+	uint8_t last
+) {
+	do
+	{
+		uint32_t blockLength = (uint32_t) SDL_min(length, DEFLATE_STORED_MAX);
+		length -= blockLength;
+
+		Deflate_PutBits(writer, last && length == 0, 1);
+		Deflate_PutBits(writer, 0, 2);
+		Deflate_AlignToByte(writer);
+
+		uint8_t *out = writer->output + writer->position;
+		out[0] = (uint8_t) blockLength;
+		out[1] = (uint8_t) (blockLength >> 8);
+		out[2] = (uint8_t) ~blockLength;
+		out[3] = (uint8_t) (~blockLength >> 8);
+		SDL_memcpy(out + 4, input, blockLength);
+		writer->position += 4 + blockLength;
+
+		input += blockLength;
+	} while (length > 0);
+}
+
+/* Writes the tokens gathered so far, which cover length bytes at input */
+static void Deflate_FlushBlock(
+	Deflate *deflate,
+	DeflateWriter *writer,
+	const uint8_t *input,
+	size_t length,
+	uint8_t last
+) {
+	DeflateTree litLenTree, distTree, codeLengthTree;
+	uint8_t combinedLengths[286 + 30];
+	uint16_t encodedLengths[286 + 30];
+	uint32_t codeLengthFrequencies[19];
+	uint32_t extraBits, extraValue;
+
+	deflate->litLenFrequencies[256] += 1;
+
+	Deflate_BuildTree(&litLenTree, deflate->litLenFrequencies, 286, 15);
+	Deflate_BuildTree(&distTree, deflate->distFrequencies, 30, 15);
+
+	uint32_t litLenCount = 286;
+	while (litLenCount > 257 && litLenTree.lengths[litLenCount - 1] == 0)
+	{
+		litLenCount--;
+	}
+	uint32_t distCount = 30;
+	while (distCount > 1 && distTree.lengths[distCount - 1] == 0)
+	{
+		distCount--;
+	}
+
+	SDL_memcpy(combinedLengths, litLenTree.lengths, litLenCount);
+	SDL_memcpy(combinedLengths + litLenCount, distTree.lengths, distCount);
+
+	SDL_memset(codeLengthFrequencies, 0, sizeof(codeLengthFrequencies));
+	uint32_t encodedCount = Deflate_EncodeCodeLengths(
+		combinedLengths,
+		litLenCount + distCount,
+		encodedLengths,
+		codeLengthFrequencies
+	);
+	Deflate_BuildTree(&codeLengthTree, codeLengthFrequencies, 19, 7);
+
+	uint32_t codeLengthCount = 19;
+	while (codeLengthCount > 4 && codeLengthTree.lengths[codeLengthOrder[codeLengthCount - 1]] == 0)
+	{
+		codeLengthCount--;
+	}
+
+	/* Size both ways and keep the smaller */
+	static const uint8_t codeLengthExtraBits[19] =
+	{
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 3, 7
+	};
+
+	uint64_t dynamicBits = 3 + 5 + 5 + 4 + 3 * codeLengthCount;
+	for (uint32_t i = 0; i < 19; i++)
+	{
+		dynamicBits += (uint64_t) codeLengthFrequencies[i] * (codeLengthTree.lengths[i] + codeLengthExtraBits[i]);
+	}
+	for (uint32_t i = 0; i < 286; i++)
+	{
+		dynamicBits += (uint64_t) deflate->litLenFrequencies[i] * litLenTree.lengths[i];
+	}
+	for (uint32_t i = 0; i < 30; i++)
+	{
+		dynamicBits += (uint64_t) deflate->distFrequencies[i] * distTree.lengths[i];
+	}
+	for (uint32_t i = 265; i < 285; i++)
+	{
+		dynamicBits += (uint64_t) deflate->litLenFrequencies[i] * ((i - 261) / 4);
+	}
+	for (uint32_t i = 4; i < 30; i++)
+	{
+		dynamicBits += (uint64_t) deflate->distFrequencies[i] * ((i - 2) / 2);
+	}
+
+	uint64_t storedBits = (length / DEFLATE_STORED_MAX + 1) * 40 + (uint64_t) length * 8;
+
+	if (storedBits <= dynamicBits)
+	{
+		Deflate_WriteStored(writer, input, length, last);
+	}
+	else
+	{
+		Deflate_PutBits(writer, last, 1);
+		Deflate_PutBits(writer, 2, 2);
+		Deflate_PutBits(writer, litLenCount - 257, 5);
+		Deflate_PutBits(writer, distCount - 1, 5);
+		Deflate_PutBits(writer, codeLengthCount - 4, 4);
+
+		for (uint32_t i = 0; i < codeLengthCount; i++)
+		{
+			Deflate_PutBits(writer, codeLengthTree.lengths[codeLengthOrder[i]], 3);
+		}
+
+		for (uint32_t i = 0; i < encodedCount; i++)
+		{
+			uint32_t symbol = encodedLengths[i] & 0xFF;
+			Deflate_PutBits(writer, codeLengthTree.codes[symbol], codeLengthTree.lengths[symbol]);
+			if (codeLengthExtraBits[symbol] > 0)
+			{
+				Deflate_PutBits(writer, encodedLengths[i] >> 8, codeLengthExtraBits[symbol]);
+			}
+		}
+
+		for (uint32_t i = 0; i < deflate->tokenCount; i++)
+		{
+			uint32_t litLen = deflate->litLens[i];
+			uint32_t dist = deflate->dists[i];
+
+			if (dist == 0)
+			{
+				Deflate_PutBits(writer, litLenTree.codes[litLen], litLenTree.lengths[litLen]);
+				continue;
+			}
+
+			uint32_t lengthCode = Deflate_LengthCode(litLen, &extraBits, &extraValue);
+			Deflate_PutBits(writer, litLenTree.codes[lengthCode], litLenTree.lengths[lengthCode]);
+			Deflate_PutBits(writer, extraValue, extraBits);
+
+			uint32_t distCode = Deflate_DistCode(dist, &extraBits, &extraValue);
+			Deflate_PutBits(writer, distTree.codes[distCode], distTree.lengths[distCode]);
+			Deflate_PutBits(writer, extraValue, extraBits);
+		}
+
+		Deflate_PutBits(writer, litLenTree.codes[256], litLenTree.lengths[256]);
+	}
+
+	deflate->tokenCount = 0;
+	SDL_memset(deflate->litLenFrequencies, 0, sizeof(deflate->litLenFrequencies));
+	SDL_memset(deflate->distFrequencies, 0, sizeof(deflate->distFrequencies));
+}
+
+/* Compilers turn this into one unaligned load, SDL_memcpy would stay a call */
+static uint32_t Deflate_Read32(const uint8_t *p)
+{
+	return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static uint32_t Deflate_Hash(const uint8_t *p)
+{
+	return (Deflate_Read32(p) * 2654435761u) >> (32 - DEFLATE_HASH_BITS);
+}
+
+Deflate* Deflate_Create(void)
+{
+	Deflate *deflate = SDL_malloc(sizeof(Deflate));
+	SDL_memset(deflate, 0, sizeof(Deflate));
+
+	deflate->hashTable = SDL_malloc(sizeof(int32_t) << DEFLATE_HASH_BITS);
+	deflate->litLens = SDL_malloc(sizeof(uint16_t) * DEFLATE_BLOCK_TOKENS);
+	deflate->dists = SDL_malloc(sizeof(uint16_t) * DEFLATE_BLOCK_TOKENS);
+
+	return deflate;
+}
+
+void Deflate_Destroy(Deflate *deflate)
+{
+	SDL_free(deflate->hashTable);
+	SDL_free(deflate->litLens);
+	SDL_free(deflate->dists);
+	SDL_free(deflate);
+}
+
+size_t Deflate_Bound(size_t length)
+{
+	/* Every block falls back to stored, 5 bytes per 64K plus block overhead */
+	return length + length / 1024 + 64;
+}
+
+size_t Deflate_Compress(
+	Deflate *deflate,
+	const uint8_t *input,
+	size_t length,
+	uint8_t last,
+	uint8_t *output
+) {
+	DeflateWriter writer;
+	writer.output = output;
+	writer.position = 0;
+	writer.bits = 0;
+	writer.bitCount = 0;
+
+	SDL_memset(deflate->hashTable, 0, sizeof(int32_t) << DEFLATE_HASH_BITS);
+	SDL_memset(deflate->litLenFrequencies, 0, sizeof(deflate->litLenFrequencies));
+	SDL_memset(deflate->distFrequencies, 0, sizeof(deflate->distFrequencies));
+	deflate->tokenCount = 0;
+
+	uint32_t extraBits, extraValue;
+	size_t blockStart = 0;
+	size_t i = 0;
+
+	while (i < length)
+	{
+		uint32_t matchLength = 0;
+		size_t matchPosition = 0;
+
+		if (i + DEFLATE_MIN_MATCH <= length)
+		{
+			uint32_t hash = Deflate_Hash(input + i);
+			int32_t candidate = deflate->hashTable[hash] - 1;
+			deflate->hashTable[hash] = (int32_t) i + 1;
+
+			if (	candidate >= 0 &&
+				i - candidate <= DEFLATE_WINDOW_SIZE &&
+				Deflate_Read32(input + candidate) == Deflate_Read32(input + i)	)
+			{
+				size_t maxLength = SDL_min(length - i, DEFLATE_MAX_MATCH);
+				matchLength = DEFLATE_MIN_MATCH;
+				while (matchLength < maxLength && input[candidate + matchLength] == input[i + matchLength])
+				{
+					matchLength++;
+				}
+				matchPosition = candidate;
+			}
+		}
+
+		if (matchLength > 0)
+		{
+			uint32_t dist = (uint32_t) (i - matchPosition);
+			deflate->litLens[deflate->tokenCount] = (uint16_t) matchLength;
+			deflate->dists[deflate->tokenCount] = (uint16_t) dist;
+			deflate->litLenFrequencies[Deflate_LengthCode(matchLength, &extraBits, &extraValue)] += 1;
+			deflate->distFrequencies[Deflate_DistCode(dist, &extraBits, &extraValue)] += 1;
+
+			/* Hash the positions the match covers, so later runs find it */
+			size_t matchEnd = i + matchLength;
+			for (i += 1; i < matchEnd && i + DEFLATE_MIN_MATCH <= length; i++)
+			{
+				deflate->hashTable[Deflate_Hash(input + i)] = (int32_t) i + 1;
+			}
+			i = matchEnd;
+		}
+		else
+		{
+			deflate->litLens[deflate->tokenCount] = input[i];
+			deflate->dists[deflate->tokenCount] = 0;
+			deflate->litLenFrequencies[input[i]] += 1;
+			i += 1;
+		}
+
+		deflate->tokenCount += 1;
+
+		if (deflate->tokenCount == DEFLATE_BLOCK_TOKENS && i < length)
+		{
+			Deflate_FlushBlock(deflate, &writer, input + blockStart, i - blockStart, 0);
+			blockStart = i;
+		}
+	}
+
+	Deflate_FlushBlock(deflate, &writer, input + blockStart, length - blockStart, last);
+
+	if (!last)
+	{
+		/* Empty stored block, leaves the stream byte aligned for the next piece */
+		Deflate_WriteStored(&writer, NULL, 0, 0);
+	}
+	Deflate_AlignToByte(&writer);
+
+	return writer.position;
+}
+
+uint32_t Deflate_Adler32(uint32_t adler, const uint8_t *data, size_t length)
+{
+	uint32_t a = adler & 0xFFFF;
+	uint32_t b = adler >> 16;
+
+	while (length > 0)
+	{
+		size_t count = SDL_min(length, ADLER_NMAX);
+		length -= count;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			a += data[i];
+			b += a;
+		}
+		data += count;
+
+		a %= ADLER_BASE;
+		b %= ADLER_BASE;
+	}
+
+	return (b << 16) | a;
+}
+
+uint32_t Deflate_Adler32Combine(uint32_t adlerA, uint32_t adlerB, size_t lengthB)
+{
+	/* B's running sum saw A's a once per byte of B, zlib's adler32_combine */
+	uint32_t remainder = (uint32_t) (lengthB % ADLER_BASE);
+	uint32_t a = adlerA & 0xFFFF;
+	uint32_t b = (remainder * a) % ADLER_BASE;
+
+	a += (adlerB & 0xFFFF) + ADLER_BASE - 1;
+	b += (adlerA >> 16) + (adlerB >> 16) + ADLER_BASE - remainder;
+
+	if (a >= ADLER_BASE)
+	{
+		a -= ADLER_BASE;
+	}
+	if (a >= ADLER_BASE)
+	{
+		a -= ADLER_BASE;
+	}
+	if (b >= ADLER_BASE * 2)
+	{
+		b -= ADLER_BASE * 2;
+	}
+	if (b >= ADLER_BASE)
+	{
+		b -= ADLER_BASE;
+	}
+
+	return (b << 16) | a;
+}
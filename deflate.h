@@ -0,0 +1,61 @@
+#ifndef DEFLATE_H
+#define DEFLATE_H
+
+/* Fast single-pass DEFLATE (RFC 1951) compressor for screenshots.
+ *
+ * Greedy LZ77 with one hash probe per position, then a dynamic Huffman
+ * block every DEFLATE_BLOCK_TOKENS tokens, or a stored block when that
+ * comes out smaller. It trades some ratio for speed, roughly like zlib's
+ * lowest levels.
+ *
+ * Every Deflate_Compress call is independent: it only matches within its
+ * own input, and a call that is not the last ends on a byte boundary with an
+ * empty stored block, like zlib's Z_SYNC_FLUSH. So the input can be cut into
+ * pieces, compressed on as many threads, and the outputs concatenated into
+ * one stream. The Adler-32 of the whole can be put together from the
+ * pieces' with Deflate_Adler32Combine.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define DEFLATE_HASH_BITS 15
+#define DEFLATE_BLOCK_TOKENS 16384
+
+/* Scratch for one thread, reused across calls */
+typedef struct Deflate
+{
+	int32_t *hashTable;	/* 1 + last position with each hash, 0 if none */
+	uint16_t *litLens;	/* literal byte, or match length when dists is nonzero */
+	uint16_t *dists;
+	uint32_t tokenCount;
+
+	uint32_t litLenFrequencies[286];
+	uint32_t distFrequencies[30];
+} Deflate;
+
+Deflate* Deflate_Create(void);
+void Deflate_Destroy(Deflate *deflate);
+
+/* Largest output Deflate_Compress can produce for length bytes */
+size_t Deflate_Bound(size_t length);
+
+/* Compresses length bytes into output, which must hold Deflate_Bound(length)
+ * bytes, and returns the output size. last ends the stream; otherwise the
+ * output ends byte aligned so another call's output can follow it.
+ */
+size_t Deflate_Compress(
+	Deflate *deflate,
+	const uint8_t *input,
+	size_t length,
+	uint8_t last,
+	uint8_t *output
+);
+
+/* Pass 1 as adler to start */
+uint32_t Deflate_Adler32(uint32_t adler, const uint8_t *data, size_t length);
+
+/* The Adler-32 of A followed by B, from A's, B's and B's length */
+uint32_t Deflate_Adler32Combine(uint32_t adlerA, uint32_t adlerB, size_t lengthB);
+
+#endif /* DEFLATE_H */
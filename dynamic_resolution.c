@@ -0,0 +1,213 @@
+#include "dynamic_resolution.h"
+
+#include <SDL.h>
+
+#include "command_capture.h"
+#include "mip_chain.h"
+
+static const float levelScales[DYNAMIC_RESOLUTION_LEVELS_MAX] =
+{
+	1.0f, 0.875f, 0.75f, 0.625f, 0.5f
+};
+
+/* Weight of each new sample in the moving average */
+#define DYNAMIC_RESOLUTION_SMOOTHING 0.1
+
+/* A level is only raised to if predicted to use at most this much of the budget */
+#define DYNAMIC_RESOLUTION_RAISE_HEADROOM 0.85
+
+/* Samples at a level before it may be left; dropping reacts faster than raising */
+#define DYNAMIC_RESOLUTION_DROP_SAMPLES 4
+#define DYNAMIC_RESOLUTION_RAISE_SAMPLES 30
+
+static double DynamicResolution_Predict(DynamicResolution *resolution, uint32_t level)
+{
+	DynamicResolutionLevel *current = &resolution->levels[resolution->current];
+	DynamicResolutionLevel *other = &resolution->levels[level];
+
+	return resolution->smoothedMilliseconds *
+		((double) other->width * other->height) /
+		((double) current->width * current->height);
+}
+
+static void DynamicResolution_Change(DynamicResolution *resolution, uint32_t level)
+{
+	resolution->current = level;
+	resolution->sampleCount = 0;
+	resolution->changeCount += 1;
+}
+
+DynamicResolution* DynamicResolution_Create(
+	Refresh_Device *device,
+	FNA3D_Device *fnaDevice,
+	VulkanInterop *interop,
+	uint32_t targetCount,
+	uint32_t width,
+	uint32_t height,
+	uint32_t levelCount,
+	uint8_t mipmapped,
+	uint8_t computeWritable,
+	Refresh_RenderPass *renderPass,
+	double budgetMilliseconds
+) {
+	DynamicResolution *resolution = SDL_malloc(sizeof(DynamicResolution));
+	SDL_memset(resolution, 0, sizeof(DynamicResolution));
+
+	resolution->device = device;
+	resolution->levelCount = SDL_max(1, SDL_min(levelCount, DYNAMIC_RESOLUTION_LEVELS_MAX));
+	resolution->budgetMilliseconds = budgetMilliseconds;
+
+	for (uint32_t i = 0; i < resolution->levelCount; i++)
+	{
+		DynamicResolutionLevel *level = &resolution->levels[i];
+
+		level->scale = levelScales[i];
+		level->width = SDL_max(1, (uint32_t) (width * level->scale + 0.5f));
+		level->height = SDL_max(1, (uint32_t) (height * level->scale + 0.5f));
+
+		level->renderArea.x = 0;
+		level->renderArea.y = 0;
+		level->renderArea.w = level->width;
+		level->renderArea.h = level->height;
+
+		level->viewport.x = 0;
+		level->viewport.y = 0;
+		level->viewport.w = (float) level->width;
+		level->viewport.h = (float) level->height;
+		level->viewport.minDepth = 0;
+		level->viewport.maxDepth = 1;
+
+		level->targets = InteropTargets_Create(
+			device,
+			fnaDevice,
+			interop,
+			targetCount,
+			level->width,
+			level->height,
+			mipmapped ? MipChain_LevelCount(level->width, level->height) : 1,
+			computeWritable,
+			renderPass
+		);
+	}
+
+	return resolution;
+}
+
+void DynamicResolution_CreatePipelines(
+	DynamicResolution *resolution,
+	Refresh_GraphicsPipelineCreateInfo *createInfos,
+	uint32_t pipelineCount
+) {
+	pipelineCount = SDL_min(pipelineCount, DYNAMIC_RESOLUTION_PIPELINES_MAX);
+
+	for (uint32_t i = 0; i < resolution->levelCount; i++)
+	{
+		DynamicResolutionLevel *level = &resolution->levels[i];
+
+		for (uint32_t j = 0; j < pipelineCount; j++)
+		{
+			Refresh_GraphicsPipelineCreateInfo levelCreateInfo = createInfos[j];
+			levelCreateInfo.viewportState.viewports = &level->viewport;
+			levelCreateInfo.viewportState.viewportCount = 1;
+			levelCreateInfo.viewportState.scissors = &level->renderArea;
+			levelCreateInfo.viewportState.scissorCount = 1;
+
+			level->pipelines[j] = CommandCapture_CreateGraphicsPipeline(resolution->device, &levelCreateInfo);
+		}
+	}
+}
+
+void DynamicResolution_Destroy(DynamicResolution *resolution)
+{
+	for (uint32_t i = 0; i < resolution->levelCount; i++)
+	{
+		DynamicResolutionLevel *level = &resolution->levels[i];
+
+		for (uint32_t j = 0; j < DYNAMIC_RESOLUTION_PIPELINES_MAX; j++)
+		{
+			if (level->pipelines[j] != NULL)
+			{
+				CommandCapture_QueueDestroyGraphicsPipeline(resolution->device, level->pipelines[j]);
+			}
+		}
+		InteropTargets_Destroy(level->targets);
+	}
+
+	SDL_free(resolution);
+}
+
+DynamicResolutionLevel* DynamicResolution_BeginFrame(DynamicResolution *resolution)
+{
+	DynamicResolutionLevel *level = &resolution->levels[resolution->current];
+	level->frameCount += 1;
+	return level;
+}
+
+void DynamicResolution_Update(
+	DynamicResolution *resolution,
+	double gpuMilliseconds,
+	uint32_t level
+) {
+	/* Timings arrive a few frames late, older levels' would skew the average */
+	if (level != resolution->current)
+	{
+		return;
+	}
+
+	if (resolution->sampleCount == 0)
+	{
+		resolution->smoothedMilliseconds = gpuMilliseconds;
+	}
+	else
+	{
+		resolution->smoothedMilliseconds +=
+			(gpuMilliseconds - resolution->smoothedMilliseconds) * DYNAMIC_RESOLUTION_SMOOTHING;
+	}
+	resolution->sampleCount += 1;
+
+	double budget = resolution->budgetMilliseconds;
+	uint32_t current = resolution->current;
+
+	if (	resolution->smoothedMilliseconds > budget &&
+		current + 1 < resolution->levelCount &&
+		resolution->sampleCount >= DYNAMIC_RESOLUTION_DROP_SAMPLES	)
+	{
+		uint32_t next = current + 1;
+		while (	next + 1 < resolution->levelCount &&
+			DynamicResolution_Predict(resolution, next) > budget * DYNAMIC_RESOLUTION_RAISE_HEADROOM	)
+		{
+			next += 1;
+		}
+
+		DynamicResolution_Change(resolution, next);
+	}
+	else if (	current > 0 &&
+			resolution->sampleCount >= DYNAMIC_RESOLUTION_RAISE_SAMPLES &&
+			DynamicResolution_Predict(resolution, current - 1) < budget * DYNAMIC_RESOLUTION_RAISE_HEADROOM	)
+	{
+		DynamicResolution_Change(resolution, current - 1);
+	}
+}
+
+void DynamicResolution_Report(DynamicResolution *resolution, FILE *output)
+{
+	fprintf(
+		output,
+		"dynamic resolution: %.2f ms budget, %u level changes\n",
+		resolution->budgetMilliseconds,
+		resolution->changeCount
+	);
+
+	for (uint32_t i = 0; i < resolution->levelCount; i++)
+	{
+		DynamicResolutionLevel *level = &resolution->levels[i];
+		fprintf(
+			output,
+			"  %5.1f%% %ux%u: %u frames\n",
+			level->scale * 100.0f,
+			level->width,
+			level->height,
+			level->frameCount
+		);
+	}
+}
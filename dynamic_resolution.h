@@ -0,0 +1,99 @@
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+/* Dynamic resolution for the raymarch pass.
+ *
+ * Each resolution level has its own set of interop targets sized to a
+ * fraction of the drawable, plus its own pipelines since Refresh bakes the
+ * viewport into the pipeline. FNA3D stretches whichever level was rendered
+ * over the whole drawable, so switching levels needs no reallocation.
+ *
+ * The controller is fed GPU times tagged with the level they were measured
+ * at. It keeps a moving average for the current level and predicts the
+ * other levels' cost by pixel count: over budget it drops straight to the
+ * largest level predicted to fit, and it only steps back up one level at a
+ * time once that level is predicted to fit with headroom to spare.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <Refresh.h>
+#include <FNA3D.h>
+
+#include "interop_targets.h"
+#include "vulkan_interop.h"
+
+#define DYNAMIC_RESOLUTION_LEVELS_MAX 5
+#define DYNAMIC_RESOLUTION_PIPELINES_MAX 4
+
+typedef struct DynamicResolutionLevel
+{
+	float scale;
+	uint32_t width;
+	uint32_t height;
+	Refresh_Rect renderArea;
+	Refresh_Viewport viewport;
+
+	InteropTargets *targets;
+	Refresh_GraphicsPipeline *pipelines[DYNAMIC_RESOLUTION_PIPELINES_MAX];
+
+	/* Statistics */
+	uint32_t frameCount;
+} DynamicResolutionLevel;
+
+typedef struct DynamicResolution
+{
+	Refresh_Device *device;
+
+	DynamicResolutionLevel levels[DYNAMIC_RESOLUTION_LEVELS_MAX];
+	uint32_t levelCount;
+	uint32_t current;
+
+	double budgetMilliseconds;
+	double smoothedMilliseconds;
+	uint32_t sampleCount; /* at the current level */
+
+	/* Statistics */
+	uint32_t changeCount;
+} DynamicResolution;
+
+/* Level 0 is width x height. With levelCount 1 the resolution never changes. */
+DynamicResolution* DynamicResolution_Create(
+	Refresh_Device *device,
+	FNA3D_Device *fnaDevice,
+	VulkanInterop *interop,
+	uint32_t targetCount,
+	uint32_t width,
+	uint32_t height,
+	uint32_t levelCount,
+	uint8_t mipmapped,
+	uint8_t computeWritable,
+	Refresh_RenderPass *renderPass,
+	double budgetMilliseconds
+);
+
+/* Creates pipelines[i] of each level from createInfos[i], with that level's
+ * viewport and scissor
+ */
+void DynamicResolution_CreatePipelines(
+	DynamicResolution *resolution,
+	Refresh_GraphicsPipelineCreateInfo *createInfos,
+	uint32_t pipelineCount
+);
+
+void DynamicResolution_Destroy(DynamicResolution *resolution);
+
+/* The level to render this frame at */
+DynamicResolutionLevel* DynamicResolution_BeginFrame(DynamicResolution *resolution);
+
+/* Feeds one GPU time, measured at the given level, to the controller */
+void DynamicResolution_Update(
+	DynamicResolution *resolution,
+	double gpuMilliseconds,
+	uint32_t level
+);
+
+void DynamicResolution_Report(DynamicResolution *resolution, FILE *output);
+
+#endif /* DYNAMIC_RESOLUTION_H */
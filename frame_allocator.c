@@ -0,0 +1,138 @@
+#include "frame_allocator.h"
+
+#include "command_capture.h"
+#include "gpu_memory.h"
+
+FrameAllocator* FrameAllocator_Create(
+	Refresh_Device *device,
+	VulkanInterop *interop,
+	Refresh_BufferUsageFlags usageFlags,
+	uint32_t regionSize,
+	uint32_t regionCount
+) {
+	FrameAllocator *allocator = SDL_malloc(sizeof(FrameAllocator));
+	SDL_memset(allocator, 0, sizeof(FrameAllocator));
+
+	allocator->device = device;
+	allocator->interop = interop;
+
+	/* Regions start at a multiple of any alignment an allocation asks for up to 256 */
+	allocator->regionSize = (regionSize + 255) & ~255u;
+	allocator->regionCount = SDL_max(1, SDL_min(regionCount, FRAME_ALLOCATOR_REGIONS_MAX));
+
+	allocator->buffer = CommandCapture_CreateBuffer(device, usageFlags, allocator->regionSize * allocator->regionCount);
+	GpuMemory_AddBuffer(allocator->buffer, usageFlags, allocator->regionSize * allocator->regionCount);
+	allocator->shadow = SDL_malloc(allocator->regionSize);
+
+	for (uint32_t i = 0; i < allocator->regionCount; i++)
+	{
+		allocator->regions[i].fence = VulkanInterop_CreateFence(interop, 0);
+		allocator->regions[i].fencePending = 0;
+	}
+
+	/* The first BeginFrame moves to region 0 */
+	allocator->current = allocator->regionCount - 1;
+
+	return allocator;
+}
+
+void FrameAllocator_Destroy(FrameAllocator *allocator)
+{
+	for (uint32_t i = 0; i < allocator->regionCount; i++)
+	{
+		if (allocator->regions[i].fencePending)
+		{
+			VulkanInterop_WaitForFence(allocator->interop, allocator->regions[i].fence);
+		}
+		VulkanInterop_DestroyFence(allocator->interop, allocator->regions[i].fence);
+	}
+
+	GpuMemory_Remove(allocator->buffer);
+	CommandCapture_QueueDestroyBuffer(allocator->device, allocator->buffer);
+	SDL_free(allocator->shadow);
+	SDL_free(allocator);
+}
+
+void FrameAllocator_BeginFrame(FrameAllocator *allocator)
+{
+	allocator->current = (allocator->current + 1) % allocator->regionCount;
+
+	FrameAllocatorRegion *region = &allocator->regions[allocator->current];
+	if (region->fencePending)
+	{
+		if (!VulkanInterop_IsFenceSignaled(allocator->interop, region->fence))
+		{
+			VulkanInterop_WaitForFence(allocator->interop, region->fence);
+			allocator->stallCount += 1;
+		}
+		region->fencePending = 0;
+	}
+
+	SDL_AtomicSet(&allocator->used, 0);
+	allocator->frameCount += 1;
+}
+
+void* FrameAllocator_Allocate(
+	FrameAllocator *allocator,
+	uint32_t size,
+	uint32_t alignment,
+	uint32_t *offset
+) {
+	int used;
+	uint32_t start;
+
+	do
+	{
+		used = SDL_AtomicGet(&allocator->used);
+		start = ((uint32_t) used + alignment - 1) & ~(alignment - 1);
+
+		if (start + size > allocator->regionSize)
+		{
+			SDL_AtomicIncRef(&allocator->failedCount);
+			return NULL;
+		}
+	} while (!SDL_AtomicCAS(&allocator->used, used, (int) (start + size)));
+
+	*offset = allocator->current * allocator->regionSize + start;
+	return allocator->shadow + start;
+}
+
+void FrameAllocator_Flush(FrameAllocator *allocator)
+{
+	uint32_t used = (uint32_t) SDL_AtomicGet(&allocator->used);
+
+	if (used > 0)
+	{
+		CommandCapture_SetBufferData(
+			allocator->device,
+			allocator->buffer,
+			allocator->current * allocator->regionSize,
+			allocator->shadow,
+			used
+		);
+	}
+
+	allocator->peakUsed = SDL_max(allocator->peakUsed, used);
+}
+
+void FrameAllocator_Submitted(FrameAllocator *allocator)
+{
+	FrameAllocatorRegion *region = &allocator->regions[allocator->current];
+
+	VulkanInterop_ResetFence(allocator->interop, region->fence);
+	VulkanInterop_SignalFenceOnQueue(allocator->interop, region->fence);
+	region->fencePending = 1;
+}
+
+void FrameAllocator_Report(FrameAllocator *allocator, FILE *output)
+{
+	fprintf(
+		output,
+		"frame allocator: %u regions of %.1f KB, peak %.1f KB used, %u stalls, %d allocations failed\n",
+		allocator->regionCount,
+		allocator->regionSize / 1024.0,
+		allocator->peakUsed / 1024.0,
+		allocator->stallCount,
+		SDL_AtomicGet(&allocator->failedCount)
+	);
+}
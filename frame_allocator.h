@@ -0,0 +1,96 @@
+#ifndef FRAME_ALLOCATOR_H
+#define FRAME_ALLOCATOR_H
+
+/* A per-frame linear allocator for data the GPU reads for one frame only.
+ *
+ * One Refresh_Buffer is split into a region per frame in flight. An
+ * allocation bumps the current region's offset with a compare and swap, so
+ * the tiled pass's workers can share a region without a lock, and nothing
+ * is freed on its own: BeginFrame moves to the next region and recycles all
+ * of it once the fence signaled after that region's last frame has passed.
+ *
+ * Refresh doesn't expose its buffers' mappings, so writes land in a CPU
+ * shadow and Flush sends the used span as one Refresh_SetBufferData, a
+ * single copy into the current region of the host visible buffer. The
+ * shadow is free again right after, so one serves every region.
+ *
+ * Uniforms can only reach Refresh shaders through Refresh_Push*ShaderParams,
+ * which is already a per-command-buffer bump allocator inside Refresh, so
+ * what comes from here is bound as vertex data at the returned offset, as
+ * uniform_bench.c does.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <SDL.h>
+
+#include <Refresh.h>
+
+#include "vulkan_interop.h"
+
+#define FRAME_ALLOCATOR_REGIONS_MAX 4
+
+typedef struct FrameAllocatorRegion
+{
+	VkFence fence;
+	uint8_t fencePending;	/* signaled on the queue, not yet seen to complete */
+} FrameAllocatorRegion;
+
+typedef struct FrameAllocator
+{
+	Refresh_Device *device;
+	VulkanInterop *interop;
+
+	Refresh_Buffer *buffer;
+	uint8_t *shadow;
+	uint32_t regionSize;
+
+	FrameAllocatorRegion regions[FRAME_ALLOCATOR_REGIONS_MAX];
+	uint32_t regionCount;
+	uint32_t current;
+	SDL_atomic_t used;	/* bytes of the current region handed out */
+
+	/* Statistics */
+	uint32_t frameCount;
+	uint32_t peakUsed;
+	uint32_t stallCount;
+	SDL_atomic_t failedCount;
+} FrameAllocator;
+
+/* regionCount is 1 to FRAME_ALLOCATOR_REGIONS_MAX */
+FrameAllocator* FrameAllocator_Create(
+	Refresh_Device *device,
+	VulkanInterop *interop,
+	Refresh_BufferUsageFlags usageFlags,
+	uint32_t regionSize,
+	uint32_t regionCount
+);
+
+/* Waits for every region's last frame, then destroys the buffer */
+void FrameAllocator_Destroy(FrameAllocator *allocator);
+
+/* Moves to the next region, waiting for the GPU if it is still reading it */
+void FrameAllocator_BeginFrame(FrameAllocator *allocator);
+
+/* size bytes at a multiple of alignment, a power of two up to 256. Writes go to the
+ * returned pointer; the GPU sees them at offset in the buffer after Flush.
+ * Returns NULL when the region is full. Safe from any thread between
+ * BeginFrame and Flush.
+ */
+void* FrameAllocator_Allocate(
+	FrameAllocator *allocator,
+	uint32_t size,
+	uint32_t alignment,
+	uint32_t *offset
+);
+
+/* Sends this frame's allocations to the buffer, before the submit that reads them */
+void FrameAllocator_Flush(FrameAllocator *allocator);
+
+/* Fences the region once this frame's command buffers are submitted */
+void FrameAllocator_Submitted(FrameAllocator *allocator);
+
+void FrameAllocator_Report(FrameAllocator *allocator, FILE *output);
+
+#endif /* FRAME_ALLOCATOR_H */
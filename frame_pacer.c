@@ -0,0 +1,239 @@
+#include "frame_pacer.h"
+
+#include <SDL.h>
+
+#include "benchmark.h"
+
+const char *framePacerPresentModeNames[FRAME_PACER_PRESENT_COUNT] =
+{
+	"fifo",
+	"mailbox",
+	"immediate"
+};
+
+/* Weight the work peak keeps each frame, so a one-off spike fades in about a second */
+#define FRAME_PACER_PEAK_DECAY 0.95
+
+/* The margin never goes under this, and after a miss relaxes back by this fraction a frame */
+#define FRAME_PACER_MARGIN_MIN_MS 1.0
+#define FRAME_PACER_MARGIN_RELAX 0.01
+
+/* SDL_Delay may oversleep by a millisecond or more, so the end of a sleep is spun */
+#define FRAME_PACER_SPIN_MS 2
+
+static void FramePacer_SleepUntil(uint64_t wakeTicks)
+{
+	uint64_t frequency = SDL_GetPerformanceFrequency();
+	uint64_t spinTicks = frequency * FRAME_PACER_SPIN_MS / 1000;
+	uint64_t now = SDL_GetPerformanceCounter();
+
+	while (now + spinTicks < wakeTicks)
+	{
+		SDL_Delay((uint32_t) ((wakeTicks - spinTicks - now) * 1000 / frequency));
+		now = SDL_GetPerformanceCounter();
+	}
+
+	while (now < wakeTicks)
+	{
+		now = SDL_GetPerformanceCounter();
+	}
+}
+
+void FramePacer_PreparePresentation(
+	FramePacerPresentMode presentMode,
+	FNA3D_PresentationParameters *presentationParameters
+) {
+	switch (presentMode)
+	{
+	case FRAME_PACER_PRESENT_MAILBOX:
+		SDL_SetHint("FNA3D_VULKAN_FORCE_MAILBOX_VSYNC", "1");
+		presentationParameters->presentationInterval = FNA3D_PRESENTINTERVAL_ONE;
+		break;
+
+	case FRAME_PACER_PRESENT_IMMEDIATE:
+		presentationParameters->presentationInterval = FNA3D_PRESENTINTERVAL_IMMEDIATE;
+		break;
+
+	default:
+		presentationParameters->presentationInterval = FNA3D_PRESENTINTERVAL_ONE;
+		break;
+	}
+}
+
+FramePacer* FramePacer_Create(
+	VulkanInterop *interop,
+	FramePacerPresentMode presentMode,
+	uint32_t framesInFlight,
+	double periodSeconds
+) {
+	FramePacer *pacer = SDL_malloc(sizeof(FramePacer));
+	SDL_memset(pacer, 0, sizeof(FramePacer));
+
+	pacer->interop = interop;
+	pacer->presentMode = presentMode;
+	pacer->framesInFlight = SDL_min(framesInFlight, FRAME_PACER_FRAMES_IN_FLIGHT_MAX);
+
+	for (uint32_t i = 0; i < pacer->framesInFlight; i++)
+	{
+		pacer->fences[i] = VulkanInterop_CreateFence(interop, 0);
+	}
+
+	pacer->periodTicks = (uint64_t) (periodSeconds * SDL_GetPerformanceFrequency());
+	pacer->marginTicks = FRAME_PACER_MARGIN_MIN_MS * SDL_GetPerformanceFrequency() / 1000.0;
+
+	return pacer;
+}
+
+void FramePacer_Destroy(FramePacer *pacer)
+{
+	/* Only the last framesInFlight frames' fences can still be pending */
+	uint64_t first = pacer->frameIndex - SDL_min(pacer->frameIndex, pacer->framesInFlight);
+	for (uint64_t i = first; i < pacer->frameIndex; i++)
+	{
+		VulkanInterop_WaitForFence(pacer->interop, pacer->fences[i % pacer->framesInFlight]);
+	}
+
+	for (uint32_t i = 0; i < pacer->framesInFlight; i++)
+	{
+		VulkanInterop_DestroyFence(pacer->interop, pacer->fences[i]);
+	}
+
+	SDL_free(pacer);
+}
+
+void FramePacer_BeginFrame(FramePacer *pacer)
+{
+	/* The fence this frame will signal was last signaled framesInFlight frames ago */
+	if (pacer->framesInFlight > 0 && pacer->frameIndex >= pacer->framesInFlight)
+	{
+		VkFence fence = pacer->fences[pacer->frameIndex % pacer->framesInFlight];
+		if (!VulkanInterop_IsFenceSignaled(pacer->interop, fence))
+		{
+			uint64_t waitStart = SDL_GetPerformanceCounter();
+			VulkanInterop_WaitForFence(pacer->interop, fence);
+			pacer->fenceWaitCount += 1;
+			pacer->fenceWaitTicks += SDL_GetPerformanceCounter() - waitStart;
+		}
+	}
+
+	if (pacer->periodTicks > 0 && pacer->deadline > 0)
+	{
+		uint64_t lead = (uint64_t) (pacer->workPeakTicks + pacer->marginTicks);
+		uint64_t now = SDL_GetPerformanceCounter();
+
+		if (lead < pacer->deadline && now < pacer->deadline - lead)
+		{
+			FramePacer_SleepUntil(pacer->deadline - lead);
+			pacer->sleepTicks += SDL_GetPerformanceCounter() - now;
+		}
+	}
+
+	pacer->inputTicks = SDL_GetPerformanceCounter();
+}
+
+void FramePacer_BeginPresent(FramePacer *pacer)
+{
+	double workTicks = (double) (SDL_GetPerformanceCounter() - pacer->inputTicks);
+	pacer->workPeakTicks = SDL_max(workTicks, pacer->workPeakTicks * FRAME_PACER_PEAK_DECAY);
+}
+
+void FramePacer_EndFrame(FramePacer *pacer)
+{
+	uint64_t now = SDL_GetPerformanceCounter();
+
+	if (pacer->framesInFlight > 0)
+	{
+		VkFence fence = pacer->fences[pacer->frameIndex % pacer->framesInFlight];
+		VulkanInterop_ResetFence(pacer->interop, fence);
+		VulkanInterop_SignalFenceOnQueue(pacer->interop, fence);
+	}
+	pacer->frameIndex += 1;
+
+	pacer->latencies[pacer->frameCount % FRAME_PACER_LATENCY_SAMPLES] =
+		(now - pacer->inputTicks) * 1000.0 / SDL_GetPerformanceFrequency();
+	pacer->frameCount += 1;
+
+	if (pacer->periodTicks == 0)
+	{
+		return;
+	}
+
+	/* Half a period late under fifo means a vblank went by */
+	uint8_t missed = pacer->deadline > 0 && now > pacer->deadline + pacer->periodTicks / 2;
+	double marginMinTicks = FRAME_PACER_MARGIN_MIN_MS * SDL_GetPerformanceFrequency() / 1000.0;
+
+	if (missed)
+	{
+		pacer->missedCount += 1;
+		pacer->marginTicks = SDL_min(pacer->marginTicks + pacer->periodTicks / 4, (double) pacer->periodTicks);
+	}
+	else
+	{
+		pacer->marginTicks -= (pacer->marginTicks - marginMinTicks) * FRAME_PACER_MARGIN_RELAX;
+	}
+
+	/* fifo presents return on a vblank, so the next one is a period on.
+	 * A fixed schedule starts over after a miss instead of rushing to catch up.
+	 */
+	if (	pacer->presentMode == FRAME_PACER_PRESENT_FIFO ||
+		pacer->deadline == 0 ||
+		missed	)
+	{
+		pacer->deadline = now + pacer->periodTicks;
+	}
+	else
+	{
+		pacer->deadline += pacer->periodTicks;
+	}
+}
+
+void FramePacer_Report(FramePacer *pacer, FILE *output)
+{
+	if (pacer->frameCount == 0)
+	{
+		return;
+	}
+
+	double frequency = (double) SDL_GetPerformanceFrequency();
+
+	fprintf(output, "frame pacing: %s, ", framePacerPresentModeNames[pacer->presentMode]);
+	if (pacer->framesInFlight > 0)
+	{
+		fprintf(output, "frames in flight %u", pacer->framesInFlight);
+	}
+	else
+	{
+		fprintf(output, "frames in flight left to FNA3D");
+	}
+	if (pacer->periodTicks > 0)
+	{
+		fprintf(
+			output,
+			", paced to %.2f ms, %u missed deadlines",
+			pacer->periodTicks * 1000.0 / frequency,
+			pacer->missedCount
+		);
+	}
+	fprintf(output, "\n");
+
+	BenchmarkSummary summary;
+	Benchmark_Summarize(
+		pacer->latencies,
+		SDL_min(pacer->frameCount, FRAME_PACER_LATENCY_SAMPLES),
+		&summary
+	);
+
+	fprintf(output, "  input to present (ms)  min %8.3f  median %8.3f  p99 %8.3f  max %8.3f\n",
+		summary.min,
+		summary.median,
+		summary.p99,
+		summary.max
+	);
+	fprintf(
+		output,
+		"  slept %.2f ms a frame, waited on the GPU %u times for %.1f ms total\n",
+		pacer->sleepTicks * 1000.0 / frequency / pacer->frameCount,
+		pacer->fenceWaitCount,
+		pacer->fenceWaitTicks * 1000.0 / frequency
+	);
+}
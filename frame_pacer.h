@@ -0,0 +1,111 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+/* Frame pacing for the windowed loop.
+ *
+ * The present mode is FNA3D's swapchain mode: fifo queues every frame for
+ * a vblank, mailbox waits for a vblank too but replaces a queued frame
+ * instead of blocking, immediate tears. Mailbox is asked for through FNA3D's
+ * FNA3D_VULKAN_FORCE_MAILBOX_VSYNC hint, and FNA3D falls back to fifo
+ * where the surface doesn't support it.
+ *
+ * Every frame signals a fence after FNA3D_SwapBuffers, and
+ * FramePacer_BeginFrame waits for the one framesInFlight frames back, so
+ * the CPU never gets further ahead of the GPU than that. With 1, the input
+ * a frame samples never waits behind a queue of older frames.
+ *
+ * Given a frame period, BeginFrame also sleeps until just in time: the
+ * next deadline minus the predicted time from input to present. The
+ * prediction is a decaying peak of the recent record times plus a margin
+ * that grows whenever a deadline is missed, since the GPU's share isn't
+ * measured. Under fifo the deadline follows the presents, which line up
+ * with vblanks; otherwise it is a fixed schedule. Events are polled right
+ * after BeginFrame, so input is sampled as late as it can be while still
+ * making the deadline.
+ *
+ * Latency is measured from that input sample to FNA3D_SwapBuffers
+ * returning, which includes waiting for a free swapchain image. The display
+ * adds its scanout on top, which no API here reports.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <FNA3D.h>
+
+#include "vulkan_interop.h"
+
+#define FRAME_PACER_FRAMES_IN_FLIGHT_MAX 4
+
+/* The report covers this many of the most recent frames */
+#define FRAME_PACER_LATENCY_SAMPLES 4096
+
+typedef enum FramePacerPresentMode
+{
+	FRAME_PACER_PRESENT_FIFO,
+	FRAME_PACER_PRESENT_MAILBOX,
+	FRAME_PACER_PRESENT_IMMEDIATE,
+	FRAME_PACER_PRESENT_COUNT
+} FramePacerPresentMode;
+
+extern const char *framePacerPresentModeNames[FRAME_PACER_PRESENT_COUNT];
+
+typedef struct FramePacer
+{
+	VulkanInterop *interop;
+	FramePacerPresentMode presentMode;
+
+	/* Signaled after each frame's SwapBuffers, indexed by frame */
+	VkFence fences[FRAME_PACER_FRAMES_IN_FLIGHT_MAX];
+	uint32_t framesInFlight; /* 0 leaves it to FNA3D */
+	uint64_t frameIndex;
+
+	uint64_t periodTicks; /* 0 never sleeps */
+	uint64_t deadline; /* when the next present should return, 0 before the first */
+	double workPeakTicks; /* input sample to SwapBuffers call */
+	double marginTicks;
+
+	uint64_t inputTicks;
+	uint64_t presentTicks;
+
+	/* Statistics */
+	double latencies[FRAME_PACER_LATENCY_SAMPLES]; /* milliseconds */
+	uint32_t frameCount;
+	uint32_t missedCount;
+	uint32_t fenceWaitCount;
+	uint64_t fenceWaitTicks;
+	uint64_t sleepTicks;
+} FramePacer;
+
+/* Sets the hint and presentation interval for the mode, before
+ * FNA3D_CreateDevice
+ */
+void FramePacer_PreparePresentation(
+	FramePacerPresentMode presentMode,
+	FNA3D_PresentationParameters *presentationParameters
+);
+
+/* periodSeconds is the frame time to pace to, 0 to never sleep */
+FramePacer* FramePacer_Create(
+	VulkanInterop *interop,
+	FramePacerPresentMode presentMode,
+	uint32_t framesInFlight,
+	double periodSeconds
+);
+
+void FramePacer_Destroy(FramePacer *pacer);
+
+/* Waits for the GPU to catch up and for the just in time point, then marks
+ * the input sample; poll events right after
+ */
+void FramePacer_BeginFrame(FramePacer *pacer);
+
+/* Right before FNA3D_SwapBuffers */
+void FramePacer_BeginPresent(FramePacer *pacer);
+
+/* Right after FNA3D_SwapBuffers */
+void FramePacer_EndFrame(FramePacer *pacer);
+
+void FramePacer_Report(FramePacer *pacer, FILE *output);
+
+#endif /* FRAME_PACER_H */
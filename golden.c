@@ -0,0 +1,160 @@
+#include "golden.h"
+
+#include <SDL.h>
+
+#include <Refresh_Image.h>
+
+const double goldenBudgets[RAYMARCH_SCENE_COUNT][SHADER_QUALITY_COUNT] =
+{
+	{ 6.5, 6.9, 16.7 },
+	{ 9.3, 14.6, 16.7 },
+	{ 16.7, 16.7, 16.7 }
+};
+
+Golden* Golden_Create(
+	const char *directory,
+	const char *name,
+	uint32_t frameCount,
+	uint32_t width,
+	uint32_t height,
+	uint8_t update
+) {
+	Golden *golden = SDL_malloc(sizeof(Golden));
+	SDL_memset(golden, 0, sizeof(Golden));
+
+	golden->directory = directory;
+	SDL_strlcpy(golden->name, name, sizeof(golden->name));
+	golden->frameCount = SDL_min(frameCount, GOLDEN_FRAMES_MAX);
+	golden->update = update;
+
+	golden->pixelCapacity = width * height;
+	golden->diffPixels = SDL_malloc(golden->pixelCapacity * 4);
+
+	return golden;
+}
+
+void Golden_Destroy(Golden *golden)
+{
+	SDL_free(golden->diffPixels);
+	SDL_free(golden);
+}
+
+void Golden_Consume(
+	void *userdata,
+	uint32_t captureIndex,
+	uint8_t *pixels,
+	uint32_t width,
+	uint32_t height
+) {
+	Golden *golden = (Golden*) userdata;
+	char path[1024];
+
+	if (captureIndex >= golden->frameCount)
+	{
+		return;
+	}
+
+	GoldenFrame *frame = &golden->frames[captureIndex];
+	SDL_snprintf(path, sizeof(path), "%s/%s_%u.png", golden->directory, golden->name, captureIndex);
+
+	if (golden->update)
+	{
+		Refresh_Image_SavePNG(path, width, height, pixels);
+		frame->status = GOLDEN_STATUS_RECORDED;
+		return;
+	}
+
+	int32_t goldenWidth, goldenHeight, channelCount;
+	uint8_t *goldenPixels = Refresh_Image_Load(path, &goldenWidth, &goldenHeight, &channelCount);
+	if (goldenPixels == NULL)
+	{
+		/* Recording it here would pass whatever this run drew */
+		frame->status = GOLDEN_STATUS_FAILED;
+		frame->failure = "no golden image, --golden-update records one";
+		return;
+	}
+
+	/* Refresh_Image_Load always returns RGBA */
+	if (	(uint32_t) goldenWidth != width ||
+		(uint32_t) goldenHeight != height ||
+		width * height > golden->pixelCapacity	)
+	{
+		frame->status = GOLDEN_STATUS_FAILED;
+		frame->failure = "size differs";
+		Refresh_Image_Free(goldenPixels);
+		return;
+	}
+
+	uint64_t compareStart = SDL_GetPerformanceCounter();
+	ImageDiff_Compare(pixels, goldenPixels, width * height, GOLDEN_TOLERANCE, golden->diffPixels, &frame->diff);
+	frame->compareTime = (SDL_GetPerformanceCounter() - compareStart) * 1000.0 / SDL_GetPerformanceFrequency();
+
+	Refresh_Image_Free(goldenPixels);
+
+	if (	frame->diff.failedPixelCount > frame->diff.pixelCount * GOLDEN_FAILED_PIXELS_MAX ||
+		frame->diff.psnr < GOLDEN_PSNR_MIN	)
+	{
+		frame->status = GOLDEN_STATUS_FAILED;
+
+		SDL_snprintf(path, sizeof(path), "%s/%s_%u_diff.png", golden->directory, golden->name, captureIndex);
+		Refresh_Image_SavePNG(path, width, height, golden->diffPixels);
+	}
+	else
+	{
+		frame->status = GOLDEN_STATUS_PASSED;
+	}
+}
+
+uint8_t Golden_Report(Golden *golden, FILE *output)
+{
+	uint8_t passed = 1;
+
+	fprintf(output, "golden %s, %s kernel:\n", golden->name, ImageDiff_KernelName());
+
+	for (uint32_t i = 0; i < golden->frameCount; i++)
+	{
+		GoldenFrame *frame = &golden->frames[i];
+
+		switch (frame->status)
+		{
+		case GOLDEN_STATUS_PENDING:
+			fprintf(output, "  %u: FAILED, never read back\n", i);
+			passed = 0;
+			break;
+
+		case GOLDEN_STATUS_RECORDED:
+			fprintf(output, "  %u: recorded\n", i);
+			break;
+
+		case GOLDEN_STATUS_PASSED:
+		case GOLDEN_STATUS_FAILED:
+			if (frame->failure != NULL)
+			{
+				fprintf(output, "  %u: FAILED, %s\n", i, frame->failure);
+			}
+			else
+			{
+				fprintf(
+					output,
+					"  %u: %s, %u of %u pixels off by more than %d, max %u, PSNR %.2f dB (%.2f ms)\n",
+					i,
+					frame->status == GOLDEN_STATUS_PASSED ? "passed" : "FAILED",
+					frame->diff.failedPixelCount,
+					frame->diff.pixelCount,
+					GOLDEN_TOLERANCE,
+					frame->diff.maxDifference,
+					frame->diff.psnr,
+					frame->compareTime
+				);
+			}
+
+			if (frame->status == GOLDEN_STATUS_FAILED)
+			{
+				passed = 0;
+			}
+			break;
+		}
+	}
+
+	return passed;
+}
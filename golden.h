@@ -0,0 +1,103 @@
+#ifndef GOLDEN_H
+#define GOLDEN_H
+
+/* --golden DIR: a headless run that renders the raymarch pass at fixed
+ * times, reads each frame back and compares it with a PNG in DIR, for
+ * checking that changes to the render path don't change the image.
+ *
+ *	RefreshTest --golden goldens --scene seascape --quality medium
+ *
+ * Images are named after what was rendered, e.g. seascape_medium_1.png;
+ * the checkerboard path has names of its own, the compute path and the
+ * tiled pass share the plain fragment path's. A missing image fails the
+ * run; --golden-update writes the images instead of comparing them.
+ *
+ * Goldens are only comparable on the driver that recorded them, since
+ * seascape's sin hash rounds differently from one to the next. Record a
+ * set by running each scene, tier and path with --golden-update on the
+ * ICD the comparisons will run on (VK_ICD_FILENAMES).
+ *
+ * A frame passes when at most GOLDEN_FAILED_PIXELS_MAX of its pixels have
+ * a channel more than GOLDEN_TOLERANCE off, which allows for drivers
+ * rounding differently, and its PSNR is at least GOLDEN_PSNR_MIN. A
+ * frame that fails writes a _diff.png next to its golden image.
+ *
+ * Comparisons run on the readback ring's worker as frames arrive, see
+ * readback.h; the results are read once the ring is destroyed.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "image_diff.h"
+#include "raymarch_scenes.h"
+
+#define GOLDEN_FRAMES_MAX 8
+#define GOLDEN_TOLERANCE 2
+#define GOLDEN_FAILED_PIXELS_MAX 0.001
+#define GOLDEN_PSNR_MIN 40.0
+
+/* Median frame time in milliseconds a --golden run fails over with
+ * --golden-budget scene. Each scene's high tier gets a 60 Hz frame at
+ * 1280x720 and the lower tiers the share of it they cost on SwiftShader.
+ * color_phase's tiers are one shader, so all three get the full frame.
+ * None of them were measured on the driver under test, hence opt-in; the
+ * checkerboard and compute paths share their tier's.
+ */
+extern const double goldenBudgets[RAYMARCH_SCENE_COUNT][SHADER_QUALITY_COUNT];
+
+typedef enum GoldenStatus
+{
+	GOLDEN_STATUS_PENDING,	/* never read back */
+	GOLDEN_STATUS_RECORDED,	/* written as the new golden image */
+	GOLDEN_STATUS_PASSED,
+	GOLDEN_STATUS_FAILED
+} GoldenStatus;
+
+typedef struct GoldenFrame
+{
+	GoldenStatus status;
+	ImageDiffResult diff;
+	const char *failure; /* why a frame failed without a diff */
+	double compareTime; /* milliseconds */
+} GoldenFrame;
+
+typedef struct Golden
+{
+	const char *directory;
+	char name[64];
+	uint8_t update;
+
+	GoldenFrame frames[GOLDEN_FRAMES_MAX];
+	uint32_t frameCount;
+
+	/* Diff image of the frame being compared, allocated once */
+	uint8_t *diffPixels;
+	uint32_t pixelCapacity;
+} Golden;
+
+/* frameCount frames named DIR/name_N.png, of up to width x height pixels */
+Golden* Golden_Create(
+	const char *directory,
+	const char *name,
+	uint32_t frameCount,
+	uint32_t width,
+	uint32_t height,
+	uint8_t update
+);
+
+void Golden_Destroy(Golden *golden);
+
+/* ReadbackConsumeFunc, userdata is the Golden; capture i is frame i */
+void Golden_Consume(
+	void *userdata,
+	uint32_t captureIndex,
+	uint8_t *pixels,
+	uint32_t width,
+	uint32_t height
+);
+
+/* Prints a line per frame, returns 1 if none failed */
+uint8_t Golden_Report(Golden *golden, FILE *output);
+
+#endif /* GOLDEN_H */
@@ -0,0 +1,292 @@
+#include "gpu_memory.h"
+
+#include <SDL.h>
+
+const char *gpuMemoryTypeNames[GPU_MEMORY_TYPE_COUNT] =
+{
+	"texture",
+	"render target",
+	"depth stencil",
+	"vertex buffer",
+	"transfer buffer"
+};
+
+/* Objects are created and destroyed on more than one thread, and a spin
+ * lock needs no creating before the first of them
+ */
+static SDL_SpinLock ledgerLock;
+static GpuMemoryAllocation *allocations;
+static uint32_t allocationCount;
+static uint32_t allocationCapacity;
+
+#define GPU_MEMORY_MEGABYTE (1024.0 * 1024.0)
+
+/* Bytes per 4x4 block for BC formats, per texel otherwise */
+static uint32_t GpuMemory_FormatSize(Refresh_ColorFormat format, uint8_t *blockCompressed)
+{
+	*blockCompressed = 0;
+
+	switch (format)
+	{
+	case REFRESH_COLORFORMAT_BC1:
+		*blockCompressed = 1;
+		return 8;
+	case REFRESH_COLORFORMAT_BC2:
+	case REFRESH_COLORFORMAT_BC3:
+		*blockCompressed = 1;
+		return 16;
+	case REFRESH_COLORFORMAT_R8:
+		return 1;
+	case REFRESH_COLORFORMAT_R5G6B5:
+	case REFRESH_COLORFORMAT_A1R5G5B5:
+	case REFRESH_COLORFORMAT_B4G4R4A4:
+	case REFRESH_COLORFORMAT_R8G8_SNORM:
+	case REFRESH_COLORFORMAT_R16_SFLOAT:
+		return 2;
+	case REFRESH_COLORFORMAT_R16G16B16A16:
+	case REFRESH_COLORFORMAT_R32G32_SFLOAT:
+	case REFRESH_COLORFORMAT_R16G16B16A16_SFLOAT:
+		return 8;
+	case REFRESH_COLORFORMAT_R32G32B32A32_SFLOAT:
+		return 16;
+	default:
+		return 4;
+	}
+}
+
+static void GpuMemory_Add(const GpuMemoryAllocation *allocation)
+{
+	SDL_AtomicLock(&ledgerLock);
+
+	if (allocationCount == allocationCapacity)
+	{
+		allocationCapacity = allocationCapacity > 0 ? allocationCapacity * 2 : 64;
+		allocations = SDL_realloc(allocations, sizeof(GpuMemoryAllocation) * allocationCapacity);
+	}
+	allocations[allocationCount] = *allocation;
+	allocationCount += 1;
+
+	SDL_AtomicUnlock(&ledgerLock);
+}
+
+void GpuMemory_AddTexture(
+	const Refresh_Texture *texture,
+	Refresh_ColorFormat format,
+	uint32_t width,
+	uint32_t height,
+	uint32_t levelCount,
+	Refresh_TextureUsageFlags usageFlags
+) {
+	if (texture == NULL)
+	{
+		return;
+	}
+
+	uint8_t blockCompressed;
+	uint32_t formatSize = GpuMemory_FormatSize(format, &blockCompressed);
+
+	GpuMemoryAllocation allocation;
+	allocation.object = texture;
+	allocation.type = (usageFlags & (REFRESH_TEXTUREUSAGE_COLOR_TARGET_BIT | REFRESH_TEXTUREUSAGE_COMPUTE_BIT)) ?
+		GPU_MEMORY_RENDER_TARGET :
+		GPU_MEMORY_TEXTURE;
+	allocation.size = 0;
+	allocation.width = width;
+	allocation.height = height;
+	allocation.levelCount = levelCount;
+
+	for (uint32_t i = 0; i < levelCount; i++)
+	{
+		uint64_t levelWidth = SDL_max(width >> i, 1);
+		uint64_t levelHeight = SDL_max(height >> i, 1);
+
+		if (blockCompressed)
+		{
+			allocation.size += ((levelWidth + 3) / 4) * ((levelHeight + 3) / 4) * formatSize;
+		}
+		else
+		{
+			allocation.size += levelWidth * levelHeight * formatSize;
+		}
+	}
+
+	GpuMemory_Add(&allocation);
+}
+
+void GpuMemory_AddDepthStencilTarget(
+	const Refresh_DepthStencilTarget *depthStencilTarget,
+	uint32_t width,
+	uint32_t height,
+	Refresh_DepthFormat format
+) {
+	if (depthStencilTarget == NULL)
+	{
+		return;
+	}
+
+	uint32_t formatSize;
+	switch (format)
+	{
+	case REFRESH_DEPTHFORMAT_D16_UNORM: formatSize = 2; break;
+	case REFRESH_DEPTHFORMAT_D16_UNORM_S8_UINT: formatSize = 3; break;
+	case REFRESH_DEPTHFORMAT_D32_SFLOAT: formatSize = 4; break;
+	default: formatSize = 5; break;
+	}
+
+	GpuMemoryAllocation allocation;
+	allocation.object = depthStencilTarget;
+	allocation.type = GPU_MEMORY_DEPTH_STENCIL;
+	allocation.size = (uint64_t) width * height * formatSize;
+	allocation.width = width;
+	allocation.height = height;
+	allocation.levelCount = 1;
+
+	GpuMemory_Add(&allocation);
+}
+
+void GpuMemory_AddBuffer(
+	const Refresh_Buffer *buffer,
+	Refresh_BufferUsageFlags usageFlags,
+	uint32_t sizeInBytes
+) {
+	if (buffer == NULL)
+	{
+		return;
+	}
+
+	GpuMemoryAllocation allocation;
+	allocation.object = buffer;
+	allocation.type = usageFlags != 0 ? GPU_MEMORY_VERTEX_BUFFER : GPU_MEMORY_TRANSFER_BUFFER;
+	allocation.size = sizeInBytes;
+	allocation.width = 0;
+	allocation.height = 0;
+	allocation.levelCount = 0;
+
+	GpuMemory_Add(&allocation);
+}
+
+void GpuMemory_Remove(const void *object)
+{
+	SDL_AtomicLock(&ledgerLock);
+
+	for (uint32_t i = 0; i < allocationCount; i++)
+	{
+		if (allocations[i].object == object)
+		{
+			allocationCount -= 1;
+			allocations[i] = allocations[allocationCount];
+			break;
+		}
+	}
+
+	SDL_AtomicUnlock(&ledgerLock);
+}
+
+static int GpuMemory_CompareSize(const void *a, const void *b)
+{
+	uint64_t sizeA = ((const GpuMemoryAllocation*) a)->size;
+	uint64_t sizeB = ((const GpuMemoryAllocation*) b)->size;
+	return (sizeA < sizeB) - (sizeA > sizeB);
+}
+
+void GpuMemory_Report(VulkanInterop *interop, const char *when, FILE *output)
+{
+	SDL_AtomicLock(&ledgerLock);
+	uint32_t count = allocationCount;
+	GpuMemoryAllocation *sorted = SDL_malloc(sizeof(GpuMemoryAllocation) * SDL_max(count, 1));
+	SDL_memcpy(sorted, allocations, sizeof(GpuMemoryAllocation) * count);
+	SDL_AtomicUnlock(&ledgerLock);
+
+	SDL_qsort(sorted, count, sizeof(GpuMemoryAllocation), GpuMemory_CompareSize);
+
+	VulkanInteropHeap heaps[VK_MAX_MEMORY_HEAPS];
+	uint32_t heapCount = VulkanInterop_GetHeaps(interop, heaps);
+	uint32_t imageHeap = VulkanInterop_FindHeap(interop, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	uint32_t bufferHeap = VulkanInterop_FindHeap(
+		interop,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+	);
+
+	uint64_t total = 0;
+	uint64_t typeSizes[GPU_MEMORY_TYPE_COUNT] = { 0 };
+	uint32_t typeCounts[GPU_MEMORY_TYPE_COUNT] = { 0 };
+	uint64_t heapSizes[VK_MAX_MEMORY_HEAPS] = { 0 };
+	uint32_t heapCounts[VK_MAX_MEMORY_HEAPS] = { 0 };
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint32_t heap = sorted[i].levelCount > 0 ? imageHeap : bufferHeap;
+		total += sorted[i].size;
+		typeSizes[sorted[i].type] += sorted[i].size;
+		typeCounts[sorted[i].type] += 1;
+		heapSizes[heap] += sorted[i].size;
+		heapCounts[heap] += 1;
+	}
+
+	fprintf(output, "gpu memory at %s: %u objects, %.2f MB\n", when, count, total / GPU_MEMORY_MEGABYTE);
+
+	for (uint32_t i = 0; i < heapCount; i++)
+	{
+		fprintf(
+			output,
+			"  heap %u, %s, %.0f MB: estimated %.2f MB in %u objects",
+			i,
+			heaps[i].deviceLocal ? "device local" : "host",
+			heaps[i].size / GPU_MEMORY_MEGABYTE,
+			heapSizes[i] / GPU_MEMORY_MEGABYTE,
+			heapCounts[i]
+		);
+		if (heaps[i].budget > 0)
+		{
+			fprintf(
+				output,
+				", process usage %.2f MB of a %.2f MB budget",
+				heaps[i].usage / GPU_MEMORY_MEGABYTE,
+				heaps[i].budget / GPU_MEMORY_MEGABYTE
+			);
+		}
+		fprintf(output, "\n");
+	}
+
+	for (uint32_t i = 0; i < GPU_MEMORY_TYPE_COUNT; i++)
+	{
+		if (typeCounts[i] > 0)
+		{
+			fprintf(
+				output,
+				"  %-16s %4u  %10.2f MB\n",
+				gpuMemoryTypeNames[i],
+				typeCounts[i],
+				typeSizes[i] / GPU_MEMORY_MEGABYTE
+			);
+		}
+	}
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		GpuMemoryAllocation *allocation = &sorted[i];
+
+		fprintf(
+			output,
+			"    %10.2f MB  %-16s heap %u (estimated)",
+			allocation->size / GPU_MEMORY_MEGABYTE,
+			gpuMemoryTypeNames[allocation->type],
+			allocation->levelCount > 0 ? imageHeap : bufferHeap
+		);
+		if (allocation->levelCount > 0)
+		{
+			fprintf(output, "  %ux%u, %u levels", allocation->width, allocation->height, allocation->levelCount);
+		}
+		fprintf(output, "\n");
+	}
+
+	SDL_free(sorted);
+}
+
+void GpuMemory_Quit(void)
+{
+	SDL_free(allocations);
+	allocations = NULL;
+	allocationCount = 0;
+	allocationCapacity = 0;
+}
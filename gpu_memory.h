@@ -0,0 +1,83 @@
+#ifndef GPU_MEMORY_H
+#define GPU_MEMORY_H
+
+/* A ledger of the GPU memory behind every live Refresh texture, depth
+ * stencil target and buffer.
+ *
+ * Whoever creates one of these adds it right after the create call and
+ * removes it right before queueing its destruction. GpuMemory_Report lists
+ * what is live, largest first, with totals by type and by heap.
+ *
+ * Sizes come from the creation arguments, before the driver's alignment
+ * and padding. Heaps are a guess at how Refresh allocates, from memory
+ * properties alone: images from device local memory, buffers from host
+ * visible memory since Refresh maps all of them. The report marks both
+ * per-heap figures as estimates.
+ * FNA3D's objects and Refresh's internal ones aren't in the ledger; where
+ * the device has VK_EXT_memory_budget the report also gives each heap's
+ * usage by the whole process, which covers them.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <Refresh.h>
+
+#include "vulkan_interop.h"
+
+typedef enum GpuMemoryType
+{
+	GPU_MEMORY_TEXTURE,		/* sampled only */
+	GPU_MEMORY_RENDER_TARGET,	/* color target or compute storage */
+	GPU_MEMORY_DEPTH_STENCIL,
+	GPU_MEMORY_VERTEX_BUFFER,	/* any buffer with usage flags */
+	GPU_MEMORY_TRANSFER_BUFFER,	/* readback and staging, no usage flags */
+	GPU_MEMORY_TYPE_COUNT
+} GpuMemoryType;
+
+extern const char *gpuMemoryTypeNames[GPU_MEMORY_TYPE_COUNT];
+
+typedef struct GpuMemoryAllocation
+{
+	const void *object;
+	GpuMemoryType type;
+	uint64_t size;
+
+	/* 0 for buffers */
+	uint32_t width;
+	uint32_t height;
+	uint32_t levelCount;
+} GpuMemoryAllocation;
+
+void GpuMemory_AddTexture(
+	const Refresh_Texture *texture,
+	Refresh_ColorFormat format,
+	uint32_t width,
+	uint32_t height,
+	uint32_t levelCount,
+	Refresh_TextureUsageFlags usageFlags
+);
+
+void GpuMemory_AddDepthStencilTarget(
+	const Refresh_DepthStencilTarget *depthStencilTarget,
+	uint32_t width,
+	uint32_t height,
+	Refresh_DepthFormat format
+);
+
+void GpuMemory_AddBuffer(
+	const Refresh_Buffer *buffer,
+	Refresh_BufferUsageFlags usageFlags,
+	uint32_t sizeInBytes
+);
+
+/* Objects the ledger doesn't hold are ignored */
+void GpuMemory_Remove(const void *object);
+
+/* when labels the report, "startup" or "shutdown" */
+void GpuMemory_Report(VulkanInterop *interop, const char *when, FILE *output);
+
+/* Frees the ledger itself, after the last Refresh object is gone */
+void GpuMemory_Quit(void);
+
+#endif /* GPU_MEMORY_H */
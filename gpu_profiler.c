@@ -0,0 +1,112 @@
+#include "gpu_profiler.h"
+
+#include <SDL.h>
+
+GpuProfiler* GpuProfiler_Create(void)
+{
+	GpuProfiler *profiler = SDL_malloc(sizeof(GpuProfiler));
+	SDL_memset(profiler, 0, sizeof(GpuProfiler));
+
+	/* NULL unless tracing */
+	profiler->track = Trace_CreateTrack("GPU queue");
+
+	return profiler;
+}
+
+void GpuProfiler_Destroy(GpuProfiler *profiler)
+{
+	SDL_free(profiler);
+}
+
+uint32_t GpuProfiler_AddPass(GpuProfiler *profiler, const char *name)
+{
+	if (profiler->passCount == GPU_PROFILER_PASSES_MAX)
+	{
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "too many GPU passes, %s is counted as %s", name, profiler->passes[0].name);
+		return 0;
+	}
+
+	profiler->passes[profiler->passCount].name = name;
+	return profiler->passCount++;
+}
+
+void GpuProfiler_AddFrame(GpuProfiler *profiler, GpuTimerFrame *frame)
+{
+	double ticksPerMillisecond = SDL_GetPerformanceFrequency() / 1000.0;
+
+	if (profiler->track != NULL && !profiler->trackAligned)
+	{
+		profiler->trackOffsetTicks = frame->beginTicks - frame->startMilliseconds * ticksPerMillisecond;
+		profiler->trackAligned = 1;
+	}
+
+	/* Intervals are back to back, each starts where the previous one ended */
+	double start = frame->startMilliseconds;
+
+	for (uint32_t i = 0; i < frame->intervalCount; i++)
+	{
+		if (frame->passes[i] >= profiler->passCount)
+		{
+			start += frame->milliseconds[i];
+			continue;
+		}
+
+		GpuProfilerPass *pass = &profiler->passes[frame->passes[i]];
+
+		pass->history[pass->historyNext] = frame->milliseconds[i];
+		pass->historyNext = (pass->historyNext + 1) % GPU_PROFILER_HISTORY;
+		pass->historyCount = SDL_min(pass->historyCount + 1, GPU_PROFILER_HISTORY);
+		pass->sampleCount += 1;
+		pass->totalMilliseconds += frame->milliseconds[i];
+
+		if (profiler->track != NULL)
+		{
+			Trace_TrackZone(
+				profiler->track,
+				pass->name,
+				(uint64_t) (profiler->trackOffsetTicks + start * ticksPerMillisecond),
+				(uint64_t) (profiler->trackOffsetTicks + (start + frame->milliseconds[i]) * ticksPerMillisecond)
+			);
+		}
+
+		start += frame->milliseconds[i];
+	}
+
+	profiler->frameCount += 1;
+}
+
+void GpuProfiler_Report(GpuProfiler *profiler, FILE *output)
+{
+	fprintf(output, "gpu passes after %u frames, last %d samples each:\n", profiler->frameCount, GPU_PROFILER_HISTORY);
+	fprintf(output, "  %-24s %8s %8s %8s %10s\n", "pass", "avg ms", "min ms", "max ms", "run avg ms");
+
+	for (uint32_t i = 0; i < profiler->passCount; i++)
+	{
+		GpuProfilerPass *pass = &profiler->passes[i];
+
+		if (pass->historyCount == 0)
+		{
+			continue;
+		}
+
+		double sum = pass->history[0];
+		double minimum = pass->history[0];
+		double maximum = pass->history[0];
+		for (uint32_t j = 1; j < pass->historyCount; j++)
+		{
+			sum += pass->history[j];
+			minimum = SDL_min(minimum, pass->history[j]);
+			maximum = SDL_max(maximum, pass->history[j]);
+		}
+
+		fprintf(
+			output,
+			"  %-24s %8.3f %8.3f %8.3f %10.3f\n",
+			pass->name,
+			sum / pass->historyCount,
+			minimum,
+			maximum,
+			pass->totalMilliseconds / pass->sampleCount
+		);
+	}
+}
@@ -0,0 +1,61 @@
+#ifndef GPU_PROFILER_H
+#define GPU_PROFILER_H
+
+/* --gpu-profile: per-pass GPU times from the GpuTimer's intervals, kept as
+ * a rolling table over the last GPU_PROFILER_HISTORY samples of each pass.
+ * With --trace as well, every timed pass also goes on a "GPU queue" track
+ * next to the CPU zones.
+ *
+ * GPU times are placed on the performance counter by lining up the first
+ * resolved frame's first marker with the moment it was submitted, so the
+ * GPU track reads early by at most the queue latency of that one frame.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "gpu_timer.h"
+#include "trace.h"
+
+#define GPU_PROFILER_PASSES_MAX 16
+#define GPU_PROFILER_HISTORY 120
+
+typedef struct GpuProfilerPass
+{
+	const char *name;
+
+	double history[GPU_PROFILER_HISTORY];
+	uint32_t historyCount;
+	uint32_t historyNext;
+
+	/* Statistics over the whole run */
+	uint64_t sampleCount;
+	double totalMilliseconds;
+} GpuProfilerPass;
+
+typedef struct GpuProfiler
+{
+	GpuProfilerPass passes[GPU_PROFILER_PASSES_MAX];
+	uint32_t passCount;
+
+	TraceTrack *track;
+	uint8_t trackAligned;
+	double trackOffsetTicks;
+
+	uint32_t frameCount;
+} GpuProfiler;
+
+GpuProfiler* GpuProfiler_Create(void);
+
+void GpuProfiler_Destroy(GpuProfiler *profiler);
+
+/* Returns the pass id to hand to GpuTimer_Mark and GpuTimer_End. The name
+ * must outlive the profiler.
+ */
+uint32_t GpuProfiler_AddPass(GpuProfiler *profiler, const char *name);
+
+void GpuProfiler_AddFrame(GpuProfiler *profiler, GpuTimerFrame *frame);
+
+void GpuProfiler_Report(GpuProfiler *profiler, FILE *output);
+
+#endif /* GPU_PROFILER_H */
@@ -0,0 +1,279 @@
+#include "gpu_timer.h"
+
+#include <SDL.h>
+
+static void GpuTimer_Submit(GpuTimer *timer, VkCommandBuffer commandBuffer, VkFence fence)
+{
+	VkSubmitInfo submitInfo;
+	SDL_memset(&submitInfo, 0, sizeof(submitInfo));
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+
+	VkResult result = timer->interop->vkQueueSubmit(timer->interop->queue, 1, &submitInfo, fence);
+	if (result != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "vkQueueSubmit failed for GPU timestamp: %d", result);
+	}
+}
+
+static uint8_t GpuTimer_Record(
+	GpuTimer *timer,
+	VkCommandBuffer commandBuffer,
+	uint32_t query,
+	uint8_t resetQueries
+) {
+	VulkanInterop *interop = timer->interop;
+
+	VkCommandBufferBeginInfo beginInfo;
+	SDL_memset(&beginInfo, 0, sizeof(beginInfo));
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+
+	if (interop->vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+	{
+		return 0;
+	}
+
+	if (resetQueries)
+	{
+		interop->vkCmdResetQueryPool(commandBuffer, timer->queryPool, query, GPU_TIMER_MARKERS_MAX);
+	}
+	interop->vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timer->queryPool, query);
+
+	return interop->vkEndCommandBuffer(commandBuffer) == VK_SUCCESS;
+}
+
+GpuTimer* GpuTimer_Create(VulkanInterop *interop)
+{
+	uint32_t queueFamilyCount = 0;
+	interop->vkGetPhysicalDeviceQueueFamilyProperties(interop->physicalDevice, &queueFamilyCount, NULL);
+
+	if (interop->queueFamilyIndex >= queueFamilyCount)
+	{
+		return NULL;
+	}
+
+	VkQueueFamilyProperties *queueFamilies = SDL_malloc(sizeof(VkQueueFamilyProperties) * queueFamilyCount);
+	interop->vkGetPhysicalDeviceQueueFamilyProperties(interop->physicalDevice, &queueFamilyCount, queueFamilies);
+	uint32_t timestampValidBits = queueFamilies[interop->queueFamilyIndex].timestampValidBits;
+	SDL_free(queueFamilies);
+
+	if (timestampValidBits == 0)
+	{
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "queue family %u has no timestamp support", interop->queueFamilyIndex);
+		return NULL;
+	}
+
+	VkPhysicalDeviceProperties properties;
+	interop->vkGetPhysicalDeviceProperties(interop->physicalDevice, &properties);
+
+	GpuTimer *timer = SDL_malloc(sizeof(GpuTimer));
+	SDL_memset(timer, 0, sizeof(GpuTimer));
+
+	timer->interop = interop;
+	timer->nanosecondsPerTick = properties.limits.timestampPeriod;
+	timer->timestampMask = timestampValidBits >= 64 ? ~0ULL : (1ULL << timestampValidBits) - 1;
+
+	VkCommandPoolCreateInfo commandPoolCreateInfo;
+	SDL_memset(&commandPoolCreateInfo, 0, sizeof(commandPoolCreateInfo));
+	commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	commandPoolCreateInfo.queueFamilyIndex = interop->queueFamilyIndex;
+
+	VkQueryPoolCreateInfo queryPoolCreateInfo;
+	SDL_memset(&queryPoolCreateInfo, 0, sizeof(queryPoolCreateInfo));
+	queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	queryPoolCreateInfo.queryCount = GPU_TIMER_SLOT_COUNT * GPU_TIMER_MARKERS_MAX;
+
+	if (	interop->vkCreateCommandPool(interop->device, &commandPoolCreateInfo, NULL, &timer->commandPool) != VK_SUCCESS ||
+		interop->vkCreateQueryPool(interop->device, &queryPoolCreateInfo, NULL, &timer->queryPool) != VK_SUCCESS	)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "failed to create GPU timer pools");
+		GpuTimer_Destroy(timer);
+		return NULL;
+	}
+
+	VkCommandBuffer commandBuffers[GPU_TIMER_SLOT_COUNT * GPU_TIMER_MARKERS_MAX];
+
+	VkCommandBufferAllocateInfo allocateInfo;
+	SDL_memset(&allocateInfo, 0, sizeof(allocateInfo));
+	allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocateInfo.commandPool = timer->commandPool;
+	allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocateInfo.commandBufferCount = GPU_TIMER_SLOT_COUNT * GPU_TIMER_MARKERS_MAX;
+
+	if (interop->vkAllocateCommandBuffers(interop->device, &allocateInfo, commandBuffers) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "failed to allocate GPU timer command buffers");
+		GpuTimer_Destroy(timer);
+		return NULL;
+	}
+
+	for (uint32_t i = 0; i < GPU_TIMER_SLOT_COUNT; i++)
+	{
+		GpuTimerSlot *slot = &timer->slots[i];
+		slot->fence = VulkanInterop_CreateFence(interop, 0);
+
+		/* The first marker resets all of the slot's queries, since they must be reset before every write */
+		for (uint32_t j = 0; j < GPU_TIMER_MARKERS_MAX; j++)
+		{
+			slot->markers[j] = commandBuffers[i * GPU_TIMER_MARKERS_MAX + j];
+
+			if (!GpuTimer_Record(timer, slot->markers[j], i * GPU_TIMER_MARKERS_MAX + j, j == 0))
+			{
+				SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "failed to record GPU timer command buffers");
+				GpuTimer_Destroy(timer);
+				return NULL;
+			}
+		}
+	}
+
+	return timer;
+}
+
+void GpuTimer_Destroy(GpuTimer *timer)
+{
+	VulkanInterop *interop = timer->interop;
+
+	for (uint32_t i = 0; i < timer->pendingCount; i++)
+	{
+		uint32_t slotIndex = (timer->nextSlot + GPU_TIMER_SLOT_COUNT - timer->pendingCount + i) % GPU_TIMER_SLOT_COUNT;
+		VulkanInterop_WaitForFence(interop, timer->slots[slotIndex].fence);
+	}
+
+	for (uint32_t i = 0; i < GPU_TIMER_SLOT_COUNT; i++)
+	{
+		if (timer->slots[i].fence != VK_NULL_HANDLE)
+		{
+			VulkanInterop_DestroyFence(interop, timer->slots[i].fence);
+		}
+	}
+
+	/* Frees the command buffers along with it */
+	if (timer->commandPool != VK_NULL_HANDLE)
+	{
+		interop->vkDestroyCommandPool(interop->device, timer->commandPool, NULL);
+	}
+	if (timer->queryPool != VK_NULL_HANDLE)
+	{
+		interop->vkDestroyQueryPool(interop->device, timer->queryPool, NULL);
+	}
+
+	SDL_free(timer);
+}
+
+void GpuTimer_Begin(GpuTimer *timer, uint32_t tag)
+{
+	if (timer->pendingCount == GPU_TIMER_SLOT_COUNT)
+	{
+		timer->untimedCount += 1;
+		timer->timing = 0;
+		return;
+	}
+
+	GpuTimerSlot *slot = &timer->slots[timer->nextSlot];
+	slot->tag = tag;
+	slot->beginTicks = SDL_GetPerformanceCounter();
+	slot->markerCount = 1;
+
+	GpuTimer_Submit(timer, slot->markers[0], VK_NULL_HANDLE);
+	timer->timing = 1;
+}
+
+void GpuTimer_Mark(GpuTimer *timer, uint32_t pass)
+{
+	if (!timer->timing)
+	{
+		return;
+	}
+
+	GpuTimerSlot *slot = &timer->slots[timer->nextSlot];
+
+	/* The last marker is kept for End */
+	if (slot->markerCount >= GPU_TIMER_MARKERS_MAX - 1)
+	{
+		return;
+	}
+
+	slot->passes[slot->markerCount - 1] = pass;
+	GpuTimer_Submit(timer, slot->markers[slot->markerCount], VK_NULL_HANDLE);
+	slot->markerCount += 1;
+}
+
+void GpuTimer_End(GpuTimer *timer, uint32_t pass)
+{
+	if (!timer->timing)
+	{
+		return;
+	}
+
+	GpuTimerSlot *slot = &timer->slots[timer->nextSlot];
+
+	slot->passes[slot->markerCount - 1] = pass;
+	GpuTimer_Submit(timer, slot->markers[slot->markerCount], slot->fence);
+	slot->markerCount += 1;
+
+	timer->nextSlot = (timer->nextSlot + 1) % GPU_TIMER_SLOT_COUNT;
+	timer->pendingCount += 1;
+	timer->timing = 0;
+}
+
+uint8_t GpuTimer_Poll(GpuTimer *timer, GpuTimerFrame *frame)
+{
+	VulkanInterop *interop = timer->interop;
+
+	if (timer->pendingCount == 0)
+	{
+		return 0;
+	}
+
+	uint32_t slotIndex = (timer->nextSlot + GPU_TIMER_SLOT_COUNT - timer->pendingCount) % GPU_TIMER_SLOT_COUNT;
+	GpuTimerSlot *slot = &timer->slots[slotIndex];
+
+	if (!VulkanInterop_IsFenceSignaled(interop, slot->fence))
+	{
+		return 0;
+	}
+
+	VulkanInterop_ResetFence(interop, slot->fence);
+	timer->pendingCount -= 1;
+
+	uint64_t timestamps[GPU_TIMER_MARKERS_MAX];
+	VkResult result = interop->vkGetQueryPoolResults(
+		interop->device,
+		timer->queryPool,
+		slotIndex * GPU_TIMER_MARKERS_MAX,
+		slot->markerCount,
+		sizeof(uint64_t) * slot->markerCount,
+		timestamps,
+		sizeof(uint64_t),
+		VK_QUERY_RESULT_64_BIT
+	);
+
+	if (result != VK_SUCCESS)
+	{
+		return 0;
+	}
+
+	if (!timer->epochSet)
+	{
+		timer->epoch = timestamps[0];
+		timer->epochSet = 1;
+	}
+
+	frame->tag = slot->tag;
+	frame->beginTicks = slot->beginTicks;
+	frame->startMilliseconds = ((timestamps[0] - timer->epoch) & timer->timestampMask) * timer->nanosecondsPerTick / 1000000.0;
+	frame->intervalCount = slot->markerCount - 1;
+
+	for (uint32_t i = 0; i < frame->intervalCount; i++)
+	{
+		/* Unsigned subtraction and the mask handle a counter that wrapped in between */
+		uint64_t ticks = (timestamps[i + 1] - timestamps[i]) & timer->timestampMask;
+
+		frame->passes[i] = slot->passes[i];
+		frame->milliseconds[i] = ticks * timer->nanosecondsPerTick / 1000000.0;
+	}
+
+	return 1;
+}
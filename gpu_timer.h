@@ -0,0 +1,97 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+/* GPU time between points in the shared queue, measured with Vulkan
+ * timestamp queries.
+ *
+ * Neither Refresh nor FNA3D exposes queries, so each timestamp goes in a
+ * small command buffer of our own, submitted to the shared queue between
+ * their submissions. Every timestamp is written at the bottom of the pipe,
+ * once everything submitted before it has finished, so the interval
+ * between two markers is the GPU time of whatever was submitted between
+ * them. Splitting a frame's work into more submissions makes for finer
+ * intervals.
+ *
+ * A frame is Begin, any number of Marks and End, each of the last two
+ * closing an interval with a caller-chosen pass id. Results are read back
+ * a few frames later without waiting. When every slot is still in flight
+ * the frame simply goes untimed.
+ */
+
+#include <stdint.h>
+
+#include "vulkan_interop.h"
+
+#define GPU_TIMER_SLOT_COUNT 4
+#define GPU_TIMER_MARKERS_MAX 8
+
+typedef struct GpuTimerSlot
+{
+	/* Recorded once, resubmitted every time the slot is used */
+	VkCommandBuffer markers[GPU_TIMER_MARKERS_MAX];
+	VkFence fence;
+	uint32_t markerCount;
+	uint32_t passes[GPU_TIMER_MARKERS_MAX - 1];
+	uint32_t tag;
+	uint64_t beginTicks;
+} GpuTimerSlot;
+
+typedef struct GpuTimerFrame
+{
+	uint32_t tag;
+
+	/* Performance counter at Begin, and the GPU time of the first marker
+	 * relative to the first frame this timer resolved
+	 */
+	uint64_t beginTicks;
+	double startMilliseconds;
+
+	uint32_t intervalCount;
+	uint32_t passes[GPU_TIMER_MARKERS_MAX - 1];
+	double milliseconds[GPU_TIMER_MARKERS_MAX - 1];
+} GpuTimerFrame;
+
+typedef struct GpuTimer
+{
+	VulkanInterop *interop;
+
+	VkCommandPool commandPool;
+	VkQueryPool queryPool;
+	double nanosecondsPerTick;
+	uint64_t timestampMask;
+	uint64_t epoch;
+	uint8_t epochSet;
+
+	/* Slots are used round-robin, oldest pending first */
+	GpuTimerSlot slots[GPU_TIMER_SLOT_COUNT];
+	uint32_t nextSlot;
+	uint32_t pendingCount;
+	uint8_t timing;
+
+	/* Statistics */
+	uint32_t untimedCount;
+} GpuTimer;
+
+/* Returns NULL if the queue family doesn't support timestamps */
+GpuTimer* GpuTimer_Create(VulkanInterop *interop);
+
+/* Waits for pending timings before freeing them */
+void GpuTimer_Destroy(GpuTimer *timer);
+
+/* Starts a frame before its first submission. The tag is handed back with the result. */
+void GpuTimer_Begin(GpuTimer *timer, uint32_t tag);
+
+/* Ends the interval covering everything submitted since the last marker,
+ * and starts the next one. Marks past GPU_TIMER_MARKERS_MAX - 2 are ignored.
+ */
+void GpuTimer_Mark(GpuTimer *timer, uint32_t pass);
+
+/* Ends the last interval and the frame */
+void GpuTimer_End(GpuTimer *timer, uint32_t pass);
+
+/* Returns 1 and the oldest finished frame, or 0 if none has finished.
+ * Never blocks.
+ */
+uint8_t GpuTimer_Poll(GpuTimer *timer, GpuTimerFrame *frame);
+
+#endif /* GPU_TIMER_H */
@@ -18,6 +18,7 @@ layout(set = 1, binding = 1) uniform sampler2D iChannel1;
 layout(set = 3, binding = 0) uniform UniformBlock
 {
     float time;
+    float checkerboardPhase;
     vec2 resolution;
 } Uniforms;
 
@@ -26,7 +27,12 @@ layout(set = 3, binding = 0) uniform UniformBlock
 layout(location = 0) out vec4 fragColor;
 
 // make this bigger if you have a storng PC
-#define AA 2
+// Quality knobs are specialization constants, patched per tier at load time
+layout(constant_id = 0) const int AA = 2;
+layout(constant_id = 1) const int RAY_STEPS = 100;
+
+// Shade half the pixels into a half-width target, see checkerboard.h
+layout(constant_id = 2) const bool CHECKERBOARD = false;
 
 // -----------------------------------------
 // mod3 - not as trivial as you first though
@@ -125,7 +131,7 @@ vec4 castRay( in vec3 ro, in vec3 rd, in float time,
     // traverse hexagon grid (in 2D)
     bool found = false;
     vec2 t1, t2, t3, t4;
-	for( int i=0; i<100; i++ )
+	for( int i=0; i<RAY_STEPS; i++ )
 	{
         // fetch height for this hexagon
 		vec2  ce = hexagonCenFromID( hid );
@@ -480,6 +486,15 @@ void main()
 {
     vec2 fragCoord = gl_FragCoord.xy;
 
+    // each half-width column is every other pixel of its row, starting
+    // on the left or the right one by row and frame
+    if( CHECKERBOARD )
+    {
+        int row = int(fragCoord.y);
+        int column = 2*int(fragCoord.x) + ((row + int(Uniforms.checkerboardPhase))&1);
+        fragCoord.x = float(column) + 0.5;
+    }
+
 	// init random seed
     ivec2 q = ivec2(fragCoord);
 
@@ -490,12 +505,12 @@ void main()
 	{
         vec2  of = vec2(m,n)/float(AA) - 0.5;
         vec2  p = (2.0*(fragCoord+of)-Uniforms.resolution.xy)/min(Uniforms.resolution.x,Uniforms.resolution.y);
-        #if AA>1
-        float d = 0.5+0.5*sin(fragCoord.x*147.0)*sin(fragCoord.y*131.0);
-        float time = Uniforms.time - 0.5*(1.0/24.0)*(float(m*AA+n)+d)/float(AA*AA);
-        #else
         float time = Uniforms.time;
-        #endif
+        if( AA>1 )
+        {
+        float d = 0.5+0.5*sin(fragCoord.x*147.0)*sin(fragCoord.y*131.0);
+        time -= 0.5*(1.0/24.0)*(float(m*AA+n)+d)/float(AA*AA);
+        }
 
 		// camera
         float cr = -0.1;
@@ -513,12 +528,13 @@ void main()
         vec3 rd = normalize( p.x*uu + p.y*vv + 2.0*ww );
 
         // dof
-        #if AA>1
+        if( AA>1 )
+        {
         vec3 fp = ro + rd*17.0;
         vec2 ra = texelFetch(iChannel1,(q+ivec2(13*m,31*n))&1023,0).xy;
         ro.xy += 0.3*sqrt(ra.x)*vec2(cos(6.2831*ra.y),sin(6.2831*ra.y));
     	rd = normalize( fp - ro );
-        #endif
+        }
 
         // render
         vec3 col = render( ro, rd, time );
@@ -0,0 +1,260 @@
+#include "image_diff.h"
+
+#include <math.h>
+
+#include <SDL.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#define IMAGE_DIFF_SSE2
+#include <emmintrin.h>
+#endif
+
+/* MSVC has no per-function target attribute, so AVX2 needs GCC or Clang */
+#if defined(IMAGE_DIFF_SSE2) && defined(__GNUC__)
+#define IMAGE_DIFF_AVX2
+#include <immintrin.h>
+#endif
+
+/* Vector loops widen their squared error sums to 64 bits at least this
+ * often; a 32-bit lane takes 2 * 2 * 255^2 per 16 bytes and would overflow
+ * after 16513 of them
+ */
+#define IMAGE_DIFF_FLUSH_ITERATIONS 8192
+
+typedef struct ImageDiffSums
+{
+	uint32_t failedPixelCount;
+	uint8_t maxDifference;
+	uint64_t squaredError;
+} ImageDiffSums;
+
+static void ImageDiff_Scalar(
+	const uint8_t *pixels,
+	const uint8_t *referencePixels,
+	uint32_t pixelCount,
+	uint8_t tolerance,
+	uint8_t *diffPixels,
+	ImageDiffSums *sums
+) {
+	for (uint32_t i = 0; i < pixelCount; i++)
+	{
+		uint8_t failed = 0;
+
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			int32_t a = pixels[i * 4 + c];
+			int32_t b = referencePixels[i * 4 + c];
+			uint8_t difference = (uint8_t) (a > b ? a - b : b - a);
+
+			failed |= difference > tolerance;
+			sums->maxDifference = SDL_max(sums->maxDifference, difference);
+			sums->squaredError += (uint32_t) difference * difference;
+			diffPixels[i * 4 + c] = (uint8_t) SDL_min(difference * 4, 255);
+		}
+
+		diffPixels[i * 4 + 3] = 255;
+		sums->failedPixelCount += failed;
+	}
+}
+
+#ifdef IMAGE_DIFF_SSE2
+
+/* Set bits of a movemask nibble, one per passing pixel */
+static const uint8_t bitCounts[16] =
+{
+	0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+};
+
+static uint8_t ImageDiff_HorizontalMax128(__m128i v)
+{
+	v = _mm_max_epu8(v, _mm_srli_si128(v, 8));
+	v = _mm_max_epu8(v, _mm_srli_si128(v, 4));
+	v = _mm_max_epu8(v, _mm_srli_si128(v, 2));
+	v = _mm_max_epu8(v, _mm_srli_si128(v, 1));
+	return (uint8_t) _mm_cvtsi128_si32(v);
+}
+
+static uint64_t ImageDiff_HorizontalSum128(__m128i v)
+{
+	uint32_t lanes[4];
+	_mm_storeu_si128((__m128i*) lanes, v);
+	return (uint64_t) lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+/* Returns how many pixels it did, always a multiple of 4 */
+static uint32_t ImageDiff_SSE2(
+	const uint8_t *pixels,
+	const uint8_t *referencePixels,
+	uint32_t pixelCount,
+	uint8_t tolerance,
+	uint8_t *diffPixels,
+	ImageDiffSums *sums
+) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i toleranceVector = _mm_set1_epi8((char) tolerance);
+	const __m128i allOnes = _mm_set1_epi32(-1);
+	const __m128i opaque = _mm_set1_epi32((int) 0xFF000000);
+	__m128i maxVector = zero;
+	uint32_t i = 0;
+
+	while (i + 4 <= pixelCount)
+	{
+		__m128i errorVector = zero;
+		uint32_t iterations = 0;
+
+		for (; i + 4 <= pixelCount && iterations < IMAGE_DIFF_FLUSH_ITERATIONS; i += 4, iterations++)
+		{
+			__m128i a = _mm_loadu_si128((const __m128i*) (pixels + i * 4));
+			__m128i b = _mm_loadu_si128((const __m128i*) (referencePixels + i * 4));
+			__m128i difference = _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+
+			maxVector = _mm_max_epu8(maxVector, difference);
+
+			/* A pixel passes when all four of its bytes are within the tolerance */
+			__m128i within = _mm_cmpeq_epi8(_mm_subs_epu8(difference, toleranceVector), zero);
+			__m128i passed = _mm_cmpeq_epi32(within, allOnes);
+			sums->failedPixelCount += 4 - bitCounts[_mm_movemask_ps(_mm_castsi128_ps(passed))];
+
+			__m128i low = _mm_unpacklo_epi8(difference, zero);
+			__m128i high = _mm_unpackhi_epi8(difference, zero);
+			errorVector = _mm_add_epi32(errorVector, _mm_madd_epi16(low, low));
+			errorVector = _mm_add_epi32(errorVector, _mm_madd_epi16(high, high));
+
+			__m128i scaled = _mm_adds_epu8(difference, difference);
+			scaled = _mm_adds_epu8(scaled, scaled);
+			_mm_storeu_si128((__m128i*) (diffPixels + i * 4), _mm_or_si128(scaled, opaque));
+		}
+
+		sums->squaredError += ImageDiff_HorizontalSum128(errorVector);
+	}
+
+	sums->maxDifference = SDL_max(sums->maxDifference, ImageDiff_HorizontalMax128(maxVector));
+	return i;
+}
+
+#endif /* IMAGE_DIFF_SSE2 */
+
+#ifdef IMAGE_DIFF_AVX2
+
+/* Returns how many pixels it did, always a multiple of 8 */
+__attribute__((target("avx2")))
+static uint32_t ImageDiff_AVX2(
+	const uint8_t *pixels,
+	const uint8_t *referencePixels,
+	uint32_t pixelCount,
+	uint8_t tolerance,
+	uint8_t *diffPixels,
+	ImageDiffSums *sums
+) {
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i toleranceVector = _mm256_set1_epi8((char) tolerance);
+	const __m256i allOnes = _mm256_set1_epi32(-1);
+	const __m256i opaque = _mm256_set1_epi32((int) 0xFF000000);
+	__m256i maxVector = zero;
+	uint32_t i = 0;
+
+	while (i + 8 <= pixelCount)
+	{
+		__m256i errorVector = zero;
+		uint32_t iterations = 0;
+
+		for (; i + 8 <= pixelCount && iterations < IMAGE_DIFF_FLUSH_ITERATIONS; i += 8, iterations++)
+		{
+			__m256i a = _mm256_loadu_si256((const __m256i*) (pixels + i * 4));
+			__m256i b = _mm256_loadu_si256((const __m256i*) (referencePixels + i * 4));
+			__m256i difference = _mm256_or_si256(_mm256_subs_epu8(a, b), _mm256_subs_epu8(b, a));
+
+			maxVector = _mm256_max_epu8(maxVector, difference);
+
+			__m256i within = _mm256_cmpeq_epi8(_mm256_subs_epu8(difference, toleranceVector), zero);
+			__m256i passed = _mm256_cmpeq_epi32(within, allOnes);
+			int passedMask = _mm256_movemask_ps(_mm256_castsi256_ps(passed));
+			sums->failedPixelCount += 8 - bitCounts[passedMask & 0xF] - bitCounts[passedMask >> 4];
+
+			/* unpack works within 128-bit halves, which the sums don't mind */
+			__m256i low = _mm256_unpacklo_epi8(difference, zero);
+			__m256i high = _mm256_unpackhi_epi8(difference, zero);
+			errorVector = _mm256_add_epi32(errorVector, _mm256_madd_epi16(low, low));
+			errorVector = _mm256_add_epi32(errorVector, _mm256_madd_epi16(high, high));
+
+			__m256i scaled = _mm256_adds_epu8(difference, difference);
+			scaled = _mm256_adds_epu8(scaled, scaled);
+			_mm256_storeu_si256((__m256i*) (diffPixels + i * 4), _mm256_or_si256(scaled, opaque));
+		}
+
+		sums->squaredError += ImageDiff_HorizontalSum128(
+			_mm_add_epi32(_mm256_castsi256_si128(errorVector), _mm256_extracti128_si256(errorVector, 1))
+		);
+	}
+
+	__m128i maxHalves = _mm_max_epu8(_mm256_castsi256_si128(maxVector), _mm256_extracti128_si256(maxVector, 1));
+	sums->maxDifference = SDL_max(sums->maxDifference, ImageDiff_HorizontalMax128(maxHalves));
+	return i;
+}
+
+#endif /* IMAGE_DIFF_AVX2 */
+
+const char* ImageDiff_KernelName(void)
+{
+#ifdef IMAGE_DIFF_AVX2
+	if (SDL_HasAVX2())
+	{
+		return "avx2";
+	}
+#endif
+#ifdef IMAGE_DIFF_SSE2
+	return "sse2";
+#else
+	return "scalar";
+#endif
+}
+
+void ImageDiff_Compare(
+	const uint8_t *pixels,
+	const uint8_t *referencePixels,
+	uint32_t pixelCount,
+	uint8_t tolerance,
+	uint8_t *diffPixels,
+	ImageDiffResult *result
+) {
+	ImageDiffSums sums;
+	SDL_memset(&sums, 0, sizeof(sums));
+	uint32_t done = 0;
+
+#ifdef IMAGE_DIFF_AVX2
+	if (SDL_HasAVX2())
+	{
+		done = ImageDiff_AVX2(pixels, referencePixels, pixelCount, tolerance, diffPixels, &sums);
+	}
+	else
+#endif
+	{
+#ifdef IMAGE_DIFF_SSE2
+		done = ImageDiff_SSE2(pixels, referencePixels, pixelCount, tolerance, diffPixels, &sums);
+#endif
+	}
+
+	ImageDiff_Scalar(
+		pixels + done * 4,
+		referencePixels + done * 4,
+		pixelCount - done,
+		tolerance,
+		diffPixels + done * 4,
+		&sums
+	);
+
+	result->pixelCount = pixelCount;
+	result->failedPixelCount = sums.failedPixelCount;
+	result->maxDifference = sums.maxDifference;
+	result->squaredError = sums.squaredError;
+
+	if (sums.squaredError == 0 || pixelCount == 0)
+	{
+		result->psnr = HUGE_VAL;
+	}
+	else
+	{
+		double meanSquaredError = sums.squaredError / (pixelCount * 4.0);
+		result->psnr = 10.0 * SDL_log10((255.0 * 255.0) / meanSquaredError);
+	}
+}
@@ -0,0 +1,40 @@
+#ifndef IMAGE_DIFF_H
+#define IMAGE_DIFF_H
+
+/* Per-pixel comparison of two R8G8B8A8 images, for --golden.
+ *
+ * One pass gives the pixels with any channel further apart than the
+ * tolerance, the largest channel difference and the squared error for the
+ * PSNR, and writes a diff image: each channel's difference times four, on
+ * opaque alpha, so one step of quantization noise is still visible.
+ *
+ * The kernel is SSE2, 4 pixels at a time, or AVX2, 8 at a time, when the
+ * CPU has it; other architectures run the scalar loop the vector ones
+ * finish their tails with. All three give identical results.
+ */
+
+#include <stdint.h>
+
+typedef struct ImageDiffResult
+{
+	uint32_t pixelCount;
+	uint32_t failedPixelCount;	/* any channel differs by more than the tolerance */
+	uint8_t maxDifference;
+	uint64_t squaredError;		/* over all four channels */
+	double psnr;			/* dB, infinite for identical images */
+} ImageDiffResult;
+
+/* diffPixels receives pixelCount R8G8B8A8 pixels */
+void ImageDiff_Compare(
+	const uint8_t *pixels,
+	const uint8_t *referencePixels,
+	uint32_t pixelCount,
+	uint8_t tolerance,
+	uint8_t *diffPixels,
+	ImageDiffResult *result
+);
+
+/* "avx2", "sse2" or "scalar", whichever ImageDiff_Compare runs */
+const char* ImageDiff_KernelName(void);
+
+#endif /* IMAGE_DIFF_H */
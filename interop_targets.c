@@ -0,0 +1,157 @@
+#include "interop_targets.h"
+
+#include <SDL.h>
+
+#include <Refresh_SysRenderer.h>
+#include <FNA3D_SysRenderer.h>
+
+#include "command_capture.h"
+#include "gpu_memory.h"
+
+InteropTargets* InteropTargets_Create(
+	Refresh_Device *device,
+	FNA3D_Device *fnaDevice,
+	VulkanInterop *interop,
+	uint32_t count,
+	uint32_t width,
+	uint32_t height,
+	uint32_t levelCount,
+	uint8_t computeWritable,
+	Refresh_RenderPass *renderPass
+) {
+	InteropTargets *targets = (InteropTargets*) SDL_malloc(sizeof(InteropTargets));
+	SDL_memset(targets, 0, sizeof(InteropTargets));
+
+	targets->device = device;
+	targets->fnaDevice = fnaDevice;
+	targets->interop = interop;
+	targets->count = SDL_max(1, SDL_min(count, INTEROP_TARGETS_MAX));
+
+	/* Storage usage can cost the fragment path its color compression, so it is opt-in */
+	Refresh_TextureUsageFlags usageFlags = REFRESH_TEXTUREUSAGE_COLOR_TARGET_BIT | REFRESH_TEXTUREUSAGE_SAMPLER_BIT;
+	if (computeWritable)
+	{
+		usageFlags |= REFRESH_TEXTUREUSAGE_COMPUTE_BIT;
+	}
+
+	/* The first Acquire moves to target 0 */
+	targets->current = targets->count - 1;
+
+	for (uint32_t i = 0; i < targets->count; i++)
+	{
+		InteropTarget *target = &targets->targets[i];
+
+		target->texture = CommandCapture_CreateTexture2D(
+			device,
+			REFRESH_COLORFORMAT_R8G8B8A8,
+			width,
+			height,
+			levelCount,
+			usageFlags
+		);
+		GpuMemory_AddTexture(target->texture, REFRESH_COLORFORMAT_R8G8B8A8, width, height, levelCount, usageFlags);
+
+		target->slice.texture = target->texture;
+		target->slice.rectangle.x = 0;
+		target->slice.rectangle.y = 0;
+		target->slice.rectangle.w = width;
+		target->slice.rectangle.h = height;
+		target->slice.depth = 0;
+		target->slice.layer = 0;
+		target->slice.level = 0;
+
+		target->colorTarget = CommandCapture_CreateColorTarget(
+			device,
+			REFRESH_SAMPLECOUNT_1,
+			&target->slice
+		);
+
+		Refresh_FramebufferCreateInfo framebufferCreateInfo;
+		framebufferCreateInfo.width = width;
+		framebufferCreateInfo.height = height;
+		framebufferCreateInfo.colorTargetCount = 1;
+		framebufferCreateInfo.pColorTargets = &target->colorTarget;
+		framebufferCreateInfo.pDepthStencilTarget = NULL;
+		framebufferCreateInfo.renderPass = renderPass;
+
+		target->framebuffer = CommandCapture_CreateFramebuffer(device, &framebufferCreateInfo);
+
+		target->mipChain = MipChain_Create(
+			device,
+			target->texture,
+			REFRESH_COLORFORMAT_R8G8B8A8,
+			width,
+			height,
+			levelCount
+		);
+
+		Refresh_TextureHandlesEXT textureHandles;
+		Refresh_GetTextureHandlesEXT(device, target->texture, &textureHandles);
+
+		FNA3D_SysTextureEXT sysTextureCreateInfo;
+		sysTextureCreateInfo.rendererType = FNA3D_RENDERER_TYPE_VULKAN_EXT;
+		sysTextureCreateInfo.texture.vulkan.image = textureHandles.texture.vulkan.image;
+		sysTextureCreateInfo.texture.vulkan.view = textureHandles.texture.vulkan.view;
+		sysTextureCreateInfo.version = 0;
+
+		target->fnaTexture = CommandCapture_FNA3D_CreateSysTextureEXT(fnaDevice, &sysTextureCreateInfo, target->texture);
+
+		target->released = VulkanInterop_CreateFence(interop, 0);
+		target->inFlight = 0;
+	}
+
+	return targets;
+}
+
+void InteropTargets_Destroy(InteropTargets *targets)
+{
+	for (uint32_t i = 0; i < targets->count; i++)
+	{
+		InteropTarget *target = &targets->targets[i];
+
+		if (target->inFlight)
+		{
+			VulkanInterop_WaitForFence(targets->interop, target->released);
+		}
+		VulkanInterop_DestroyFence(targets->interop, target->released);
+
+		CommandCapture_FNA3D_AddDisposeTexture(targets->fnaDevice, target->fnaTexture);
+		MipChain_Destroy(targets->device, target->mipChain);
+		CommandCapture_QueueDestroyFramebuffer(targets->device, target->framebuffer);
+		CommandCapture_QueueDestroyColorTarget(targets->device, target->colorTarget);
+		GpuMemory_Remove(target->texture);
+		CommandCapture_QueueDestroyTexture(targets->device, target->texture);
+	}
+
+	SDL_free(targets);
+}
+
+InteropTarget* InteropTargets_Acquire(InteropTargets *targets)
+{
+	targets->current = (targets->current + 1) % targets->count;
+	InteropTarget *target = &targets->targets[targets->current];
+
+	if (target->inFlight)
+	{
+		if (!VulkanInterop_IsFenceSignaled(targets->interop, target->released))
+		{
+			uint64_t stallStart = SDL_GetPerformanceCounter();
+			VulkanInterop_WaitForFence(targets->interop, target->released);
+			targets->stallCount += 1;
+			targets->stallTicks += SDL_GetPerformanceCounter() - stallStart;
+		}
+		VulkanInterop_ResetFence(targets->interop, target->released);
+		target->inFlight = 0;
+	}
+
+	return target;
+}
+
+void InteropTargets_Release(InteropTargets *targets)
+{
+	InteropTarget *target = &targets->targets[targets->current];
+
+	/* Queued behind FNA3D's submission, so it signals once the sampling is done */
+	VulkanInterop_SignalFenceOnQueue(targets->interop, target->released);
+	target->inFlight = 1;
+}
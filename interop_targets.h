@@ -0,0 +1,78 @@
+#ifndef INTEROP_TARGETS_H
+#define INTEROP_TARGETS_H
+
+/* Rotating color targets shared between Refresh and FNA3D.
+ *
+ * Refresh renders frame N + 1 into a different target than the one FNA3D
+ * is sampling for frame N, so the raymarch pass of one frame and the
+ * composite pass of the previous one don't have to serialize on a single
+ * image. Neither library lets us add semaphores to its submissions, so
+ * each target is handed back with a fence signaled after FNA3D's work for
+ * that frame; Acquire waits on it before Refresh writes the target again.
+ * With two or more targets that fence is normally long signaled.
+ */
+
+#include <stdint.h>
+
+#include "vulkan_interop.h"
+
+#include <Refresh.h>
+#include <FNA3D.h>
+
+#include "mip_chain.h"
+
+#define INTEROP_TARGETS_MAX 4
+
+typedef struct InteropTarget
+{
+	Refresh_Texture *texture;
+	Refresh_TextureSlice slice;
+	Refresh_ColorTarget *colorTarget;
+	Refresh_Framebuffer *framebuffer;
+	MipChain *mipChain;
+	FNA3D_Texture *fnaTexture;
+
+	VkFence released;
+	uint8_t inFlight;
+} InteropTarget;
+
+typedef struct InteropTargets
+{
+	Refresh_Device *device;
+	FNA3D_Device *fnaDevice;
+	VulkanInterop *interop;
+
+	InteropTarget targets[INTEROP_TARGETS_MAX];
+	uint32_t count;
+	uint32_t current;
+
+	/* Statistics */
+	uint32_t stallCount;
+	uint64_t stallTicks;
+} InteropTargets;
+
+/* Targets are color only, with no depth-stencil attachment; Refresh passes still
+ * run in order. computeWritable targets can also be bound as compute storage images.
+ */
+InteropTargets* InteropTargets_Create(
+	Refresh_Device *device,
+	FNA3D_Device *fnaDevice,
+	VulkanInterop *interop,
+	uint32_t count,
+	uint32_t width,
+	uint32_t height,
+	uint32_t levelCount,
+	uint8_t computeWritable,
+	Refresh_RenderPass *renderPass
+);
+
+/* Waits for and frees every target */
+void InteropTargets_Destroy(InteropTargets *targets);
+
+/* Moves to the next target, waiting until FNA3D is done sampling it */
+InteropTarget* InteropTargets_Acquire(InteropTargets *targets);
+
+/* Call once FNA3D has submitted the frame that sampled the current target */
+void InteropTargets_Release(InteropTargets *targets);
+
+#endif /* INTEROP_TARGETS_H */
@@ -0,0 +1,176 @@
+#include "jobs.h"
+
+#include "trace.h"
+
+static int JobSystem_Worker(void *data)
+{
+	JobSystem *jobs = (JobSystem*) data;
+
+	Trace_SetThreadName("job worker");
+
+	SDL_LockMutex(jobs->lock);
+	while (1)
+	{
+		while (jobs->head == NULL && !jobs->quit)
+		{
+			SDL_CondWait(jobs->jobQueued, jobs->lock);
+		}
+		if (jobs->head == NULL)
+		{
+			break;
+		}
+
+		Job *job = jobs->head;
+		jobs->head = job->next;
+		if (jobs->head == NULL)
+		{
+			jobs->tail = NULL;
+		}
+
+		SDL_UnlockMutex(jobs->lock);
+		uint64_t jobZone = TRACE_BEGIN();
+		job->func(job->userdata);
+		TRACE_END("job", jobZone);
+		SDL_LockMutex(jobs->lock);
+
+		/* Set under the lock so a waiter can't miss the broadcast */
+		SDL_AtomicSet(&job->done, 1);
+		SDL_CondBroadcast(jobs->jobFinished);
+	}
+	SDL_UnlockMutex(jobs->lock);
+
+	return 0;
+}
+
+JobSystem* JobSystem_Create(uint32_t threadCount)
+{
+	if (threadCount == 0)
+	{
+		threadCount = SDL_GetCPUCount();
+	}
+
+	JobSystem *jobs = (JobSystem*) SDL_malloc(sizeof(JobSystem));
+	SDL_memset(jobs, 0, sizeof(JobSystem));
+
+	jobs->lock = SDL_CreateMutex();
+	jobs->jobQueued = SDL_CreateCond();
+	jobs->jobFinished = SDL_CreateCond();
+
+	jobs->threads = (SDL_Thread**) SDL_malloc(sizeof(SDL_Thread*) * threadCount);
+	for (uint32_t i = 0; i < threadCount; i++)
+	{
+		char threadName[16];
+		SDL_snprintf(threadName, sizeof(threadName), "JobWorker%u", i);
+		jobs->threads[jobs->threadCount] = SDL_CreateThread(JobSystem_Worker, threadName, jobs);
+		if (jobs->threads[jobs->threadCount] == NULL)
+		{
+			SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to create job worker: %s", SDL_GetError());
+			continue;
+		}
+		jobs->threadCount += 1;
+	}
+
+	return jobs;
+}
+
+void JobSystem_Destroy(JobSystem *jobs)
+{
+	/* Queued jobs still run, workers only exit on an empty queue */
+	SDL_LockMutex(jobs->lock);
+	jobs->quit = 1;
+	SDL_CondBroadcast(jobs->jobQueued);
+	SDL_UnlockMutex(jobs->lock);
+
+	for (uint32_t i = 0; i < jobs->threadCount; i++)
+	{
+		SDL_WaitThread(jobs->threads[i], NULL);
+	}
+
+	SDL_DestroyCond(jobs->jobFinished);
+	SDL_DestroyCond(jobs->jobQueued);
+	SDL_DestroyMutex(jobs->lock);
+	SDL_free(jobs->threads);
+	SDL_free(jobs);
+}
+
+void JobSystem_Submit(JobSystem *jobs, Job *job, JobFunc func, void *userdata)
+{
+	job->func = func;
+	job->userdata = userdata;
+	job->next = NULL;
+	SDL_AtomicSet(&job->done, 0);
+
+	/* Without workers there is nobody to hand the job to */
+	if (jobs->threadCount == 0)
+	{
+		func(userdata);
+		SDL_AtomicSet(&job->done, 1);
+		return;
+	}
+
+	SDL_LockMutex(jobs->lock);
+	if (jobs->tail == NULL)
+	{
+		jobs->head = job;
+	}
+	else
+	{
+		jobs->tail->next = job;
+	}
+	jobs->tail = job;
+	SDL_CondSignal(jobs->jobQueued);
+	SDL_UnlockMutex(jobs->lock);
+}
+
+uint8_t JobSystem_IsDone(Job *job)
+{
+	return SDL_AtomicGet(&job->done) != 0;
+}
+
+void JobSystem_Wait(JobSystem *jobs, Job *job)
+{
+	if (JobSystem_IsDone(job))
+	{
+		return;
+	}
+
+	SDL_LockMutex(jobs->lock);
+	while (!JobSystem_IsDone(job))
+	{
+		SDL_CondWait(jobs->jobFinished, jobs->lock);
+	}
+	SDL_UnlockMutex(jobs->lock);
+}
+
+int32_t JobSystem_WaitAny(JobSystem *jobs, Job **jobList, uint32_t jobCount)
+{
+	int32_t result = -1;
+
+	SDL_LockMutex(jobs->lock);
+	while (1)
+	{
+		uint8_t pending = 0;
+		for (uint32_t i = 0; i < jobCount; i++)
+		{
+			if (jobList[i] == NULL)
+			{
+				continue;
+			}
+			if (JobSystem_IsDone(jobList[i]))
+			{
+				result = (int32_t) i;
+				break;
+			}
+			pending = 1;
+		}
+
+		if (result >= 0 || !pending)
+		{
+			break;
+		}
+		SDL_CondWait(jobs->jobFinished, jobs->lock);
+	}
+	SDL_UnlockMutex(jobs->lock);
+
+	return result;
+}
@@ -0,0 +1,54 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+/* Small fixed pool of worker threads running caller-owned jobs.
+ *
+ * Jobs are embedded in whatever struct owns their inputs and outputs, so
+ * submitting never allocates. A job must stay alive until it has been
+ * waited on.
+ */
+
+#include <stdint.h>
+
+#include <SDL.h>
+
+typedef void (*JobFunc)(void *userdata);
+
+typedef struct Job
+{
+	JobFunc func;
+	void *userdata;
+
+	struct Job *next;
+	SDL_atomic_t done;
+} Job;
+
+typedef struct JobSystem
+{
+	SDL_Thread **threads;
+	uint32_t threadCount;
+
+	SDL_mutex *lock;
+	SDL_cond *jobQueued;
+	SDL_cond *jobFinished;
+
+	Job *head;
+	Job *tail;
+	uint8_t quit;
+} JobSystem;
+
+/* A thread count of 0 uses one worker per CPU core */
+JobSystem* JobSystem_Create(uint32_t threadCount);
+void JobSystem_Destroy(JobSystem *jobs);
+
+void JobSystem_Submit(JobSystem *jobs, Job *job, JobFunc func, void *userdata);
+uint8_t JobSystem_IsDone(Job *job);
+void JobSystem_Wait(JobSystem *jobs, Job *job);
+
+/* Blocks until one of the jobs is done and returns its index. Entries may
+ * be NULL, which lets the caller strike out jobs it has already consumed;
+ * returns -1 if every entry is NULL.
+ */
+int32_t JobSystem_WaitAny(JobSystem *jobs, Job **jobList, uint32_t jobCount);
+
+#endif /* JOBS_H */
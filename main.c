@@ -6,6 +6,8 @@
 #define SDL_MAIN_HANDLED
 #include <SDL.h>
 
+#include "vulkan_interop.h"
+
 #include <Refresh.h>
 #include <Refresh_Image.h>
 #include <Refresh_SysRenderer.h>
@@ -18,27 +20,678 @@
 #include <mojoshader.h>
 #include <mojoshader_effects.h>
 
+#include "assets.h"
+#include "benchmark.h"
+#include "capture_stream.h"
+#include "checkerboard.h"
+#include "command_capture.h"
+#include "dynamic_resolution.h"
+#include "frame_pacer.h"
+#include "golden.h"
+#include "gpu_memory.h"
+#include "gpu_profiler.h"
+#include "gpu_timer.h"
+#include "interop_targets.h"
+#include "jobs.h"
+#include "mip_chain.h"
+#include "pipeline_cache.h"
+#include "raymarch_compute.h"
+#include "raymarch_scenes.h"
+#include "readback.h"
+#include "screenshot.h"
+#include "specialization.h"
+#include "sprite_batch.h"
+#include "sprite_bench.h"
+#include "state_cache.h"
+#include "tiled_pass.h"
+#include "trace.h"
+#include "uniform_bench.h"
+#include "upload_bench.h"
+
 typedef struct Vertex
 {
 	float x, y, z;
 	float u, v;
 } Vertex;
 
-typedef struct RaymarchUniforms
+typedef enum StartupAsset
 {
-	float time, padding;
-	float resolutionX, resolutionY;
-} RaymarchUniforms;
+	STARTUP_ASSET_PASSTHROUGH_VERT,
+	STARTUP_ASSET_RAYMARCH_FRAG,
+	STARTUP_ASSET_WOODGRAIN,
+	STARTUP_ASSET_NOISE,
+	STARTUP_ASSET_SPRITE_EFFECT,
+	STARTUP_ASSET_COUNT
+} StartupAsset;
+
+/* Profiled separately, so tiers and paths can be compared from one run */
+static const char *raymarchPassNames[SHADER_QUALITY_COUNT] =
+{
+	"raymarch (low)", "raymarch (medium)", "raymarch (high)"
+};
 
-typedef struct FNAVertex
+static const char *computePassNames[SHADER_QUALITY_COUNT] =
 {
-	float x, y;
-	float u, v;
-	uint32_t color;
-} FNAVertex;
+	"raymarch compute (low)", "raymarch compute (medium)", "raymarch compute (high)"
+};
+
+static const char *raymarchScenePaths[RAYMARCH_SCENE_COUNT] =
+{
+	"hexagon_grid.spv", "seascape.spv", "color_phase.spv"
+};
+
+#define GPU_PROFILE_REPORT_FRAMES 600
+
+/* --golden renders its first frames at these times instead of the clock's */
+static const double goldenTimes[] =
+{
+	0.5, 3.0, 9.25
+};
+
+static Refresh_ShaderModule* CreateShaderModule(Refresh_Device *device, Asset *asset)
+{
+	Refresh_ShaderModuleCreateInfo shaderModuleCreateInfo;
+	shaderModuleCreateInfo.byteCode = (uint32_t*) asset->data;
+	shaderModuleCreateInfo.codeSize = asset->size;
+
+	return CommandCapture_CreateShaderModule(device, &shaderModuleCreateInfo);
+}
+
+static Refresh_Texture* CreateTexture(Refresh_Device *device, Asset *asset, bool mipmapped)
+{
+	if (asset->type == ASSET_TYPE_TEXTURE)
+	{
+		Refresh_Texture *texture = TextureFile_CreateTexture(
+			device,
+			&asset->textureFile,
+			CommandCapture_CreateTexture2D,
+			CommandCapture_SetTextureData
+		);
+		GpuMemory_AddTexture(
+			texture,
+			TextureFile_ColorFormat(asset->textureFile.format),
+			asset->textureFile.width,
+			asset->textureFile.height,
+			asset->textureFile.levelCount,
+			REFRESH_TEXTUREUSAGE_SAMPLER_BIT
+		);
+		return texture;
+	}
+
+	/* Decoded images only have level 0, the GPU fills in the rest */
+	uint32_t levelCount = mipmapped ? MipChain_LevelCount(asset->width, asset->height) : 1;
+
+	Refresh_Texture *texture = CommandCapture_CreateTexture2D(
+		device,
+		REFRESH_COLORFORMAT_R8G8B8A8,
+		asset->width,
+		asset->height,
+		levelCount,
+		REFRESH_TEXTUREUSAGE_SAMPLER_BIT
+	);
+	GpuMemory_AddTexture(texture, REFRESH_COLORFORMAT_R8G8B8A8, asset->width, asset->height, levelCount, REFRESH_TEXTUREUSAGE_SAMPLER_BIT);
+
+	Refresh_TextureSlice setTextureDataSlice;
+	setTextureDataSlice.texture = texture;
+	setTextureDataSlice.rectangle.x = 0;
+	setTextureDataSlice.rectangle.y = 0;
+	setTextureDataSlice.rectangle.w = asset->width;
+	setTextureDataSlice.rectangle.h = asset->height;
+	setTextureDataSlice.depth = 0;
+	setTextureDataSlice.layer = 0;
+	setTextureDataSlice.level = 0;
+
+	CommandCapture_SetTextureData(
+		device,
+		&setTextureDataSlice,
+		asset->data,
+		asset->size
+	);
+
+	if (levelCount > 1)
+	{
+		MipChain *mipChain = MipChain_Create(
+			device,
+			texture,
+			REFRESH_COLORFORMAT_R8G8B8A8,
+			asset->width,
+			asset->height,
+			levelCount
+		);
+
+		Refresh_CommandBuffer *commandBuffer = CommandCapture_AcquireCommandBuffer(device, 0);
+		MipChain_Generate(device, commandBuffer, mipChain);
+		CommandCapture_Submit(device, 1, &commandBuffer);
+
+		MipChain_Destroy(device, mipChain);
+	}
+
+	return texture;
+}
+
+static void PrintUsage(const char *program)
+{
+	printf("usage: %s [--headless] [--frames N] [--capture-stream PATH] [--capture-format raw|y4m] [--capture-fps N]\n", program);
+	printf("       [--pipeline-cache PATH] [--no-pipeline-cache] [--target-mips]\n");
+	printf("       [--upload-bench] [--interop-targets N] [--dynamic-resolution] [--gpu-budget MS]\n");
+	printf("       [--quality low|medium|high] [--sprites N] [--sprite-sort deferred|texture]\n");
+	printf("       [--gpu-profile] [--trace PATH] [--record-threads N] [--tile-size PX] [--checkerboard]\n");
+	printf("       [--scene hexagon_grid|seascape|color_phase] [--compute] [--compare-paths] [--capture-commands PATH]\n");
+	printf("       [--golden DIR] [--golden-update] [--golden-budget MS|scene] [--screenshot-format png|qoi|tga]\n");
+	printf("       [--screenshot-flip] [--present-mode fifo|mailbox|immediate] [--frames-in-flight N]\n");
+	printf("       [--fps-limit N] [--low-latency] [--uniform-bench N]\n");
+	printf("  --headless              render offscreen without presenting, then print frame time statistics\n");
+	printf("  --frames N              number of frames to render in headless mode (default 500)\n");
+	printf("  --capture-stream PATH   write every frame to PATH, or to stdout if PATH is -\n");
+	printf("  --capture-format FMT    raw (RGBA) or y4m (default raw)\n");
+	printf("  --capture-fps N         time step and Y4M frame rate while capturing (default 60)\n");
+	printf("  --pipeline-cache PATH   pipeline cache file (default RefreshTest_PipelineCache.blob)\n");
+	printf("  --no-pipeline-cache     neither load nor save the pipeline cache, for cold start timings\n");
+	printf("  --target-mips           rebuild the color target's mips every frame before FNA3D samples it\n");
+	printf("  --interop-targets N     color targets Refresh and FNA3D rotate through, 1 to %d (default 2)\n", INTEROP_TARGETS_MAX);
+	printf("  --dynamic-resolution    scale the raymarch pass between 50%% and 100%% of the drawable to fit the GPU budget\n");
+	printf("  --gpu-budget MS         GPU time per frame for the raymarch pass with --dynamic-resolution (default 12)\n");
+	printf("  --quality TIER          raymarch shader quality to start at, 1 2 3 switch at runtime (default high)\n");
+	printf("  --sprites N             draw N moving sprites over the raymarch output every frame\n");
+	printf("  --sprite-sort MODE      deferred (submission order) or texture (default texture)\n");
+	printf("  --gpu-profile           time the raymarch pass, the copies after it and the FNA3D pass on the GPU\n");
+	printf("                          and print a rolling table every %d frames and at exit\n", GPU_PROFILE_REPORT_FRAMES);
+	printf("  --trace PATH            record CPU zones on every thread, plus GPU passes with --gpu-profile,\n");
+	printf("                          and write them to PATH as a Chrome trace at exit\n");
+	printf("  --record-threads N      draw the raymarch pass as tiles, recorded into N command buffers\n");
+	printf("                          on as many threads, 1 to %d\n", TILED_PASS_BANDS_MAX);
+	printf("  --tile-size PX          tile size in pixels with --record-threads (default 64)\n");
+	printf("  --checkerboard          shade half the raymarch pixels each frame and rebuild the rest from the\n");
+	printf("                          previous frame, C toggles full rate at runtime to compare\n");
+	printf("  --scene NAME            raymarch shader, hexagon_grid, seascape or color_phase (default\n");
+	printf("                          hexagon_grid)\n");
+	printf("  --compute               run the seascape as a compute shader, P switches back to the fragment\n");
+	printf("                          shader at runtime\n");
+	printf("  --compare-paths         in headless mode, render half the frames with each seascape path and\n");
+	printf("                          print their frame times side by side\n");
+	printf("  --capture-commands PATH write every Refresh call to PATH for RefreshReplay to run again\n");
+	printf("  --golden DIR            render headless, compare the first %d frames with the images in DIR and\n", (int) SDL_arraysize(goldenTimes));
+	printf("                          exit with -1 if any differ or are missing\n");
+	printf("  --golden-update         write the images in DIR with --golden instead of comparing them\n");
+	printf("  --golden-budget MS      with --golden, also fail if the median frame time is over MS, or over\n");
+	printf("                          the scene and quality's budget from golden.h for \"scene\"\n");
+	printf("  --screenshot-format FMT format S saves screenshots in: png, qoi or tga (default png)\n");
+	printf("  --screenshot-flip       save screenshots bottom row first, the way the flip rect presents them\n");
+	printf("  --present-mode MODE     fifo, mailbox or immediate (default fifo)\n");
+	printf("  --frames-in-flight N    frames the CPU may get ahead of the GPU, 1 to %d, or 0 to leave it to\n", FRAME_PACER_FRAMES_IN_FLIGHT_MAX);
+	printf("                          FNA3D (default 0, 1 with --low-latency)\n");
+	printf("  --fps-limit N           pace frames to N per second, sleeping before input is sampled\n");
+	printf("  --low-latency           sample input just in time for the next vblank, with one frame in flight\n");
+	printf("  --upload-bench          time 4096 small texture and buffer uploads, individually and batched, then exit\n");
+	printf("  --uniform-bench N       add N empty draws to every frame of the plain raymarch pass, with pushed\n");
+	printf("                          uniforms and frame allocator vertices on alternate frames, and compare their cost\n");
+	printf("\n");
+	printf("Headless mode still needs a Vulkan ICD; on GPU-less hosts point\n");
+	printf("VK_ICD_FILENAMES at a software driver such as lavapipe. A hidden window is\n");
+	printf("still created for FNA3D, so an X server such as Xvfb must be available.\n");
+}
 
 int main(int argc, char *argv[])
 {
+	bool headless = false;
+	uint32_t benchmarkFrameCount = 500;
+	const char *captureStreamPath = NULL;
+	CaptureStreamFormat captureStreamFormat = CAPTURE_STREAM_FORMAT_RAW;
+	uint32_t captureFramesPerSecond = 60;
+	const char *pipelineCachePath = "RefreshTest_PipelineCache.blob";
+	bool targetMips = false;
+	bool uploadBench = false;
+	uint32_t uniformBenchBlockCount = 0;
+	uint32_t interopTargetCount = 2;
+	bool dynamicResolution = false;
+	double gpuBudgetMilliseconds = 12.0;
+	ShaderQuality shaderQuality = SHADER_QUALITY_HIGH;
+	uint32_t spriteCount = 0;
+	SpriteSortMode spriteSortMode = SPRITE_SORT_TEXTURE;
+	bool gpuProfile = false;
+	const char *tracePath = NULL;
+	const char *commandCapturePath = NULL;
+	uint32_t recordThreadCount = 0;
+	uint32_t tileSize = 64;
+	bool checkerboard = false;
+	RaymarchScene scene = RAYMARCH_SCENE_HEXAGON_GRID;
+	bool compute = false;
+	bool comparePaths = false;
+	const char *goldenDirectory = NULL;
+	bool goldenUpdate = false;
+	double goldenBudgetMilliseconds = 0.0;
+	bool goldenBudgetSet = false;
+	bool goldenBudgetScene = false;
+	ScreenshotFormat screenshotFormat = SCREENSHOT_FORMAT_PNG;
+	bool screenshotFlip = false;
+	FramePacerPresentMode presentMode = FRAME_PACER_PRESENT_FIFO;
+	int32_t framesInFlight = -1; /* 1 with --low-latency, otherwise 0 */
+	uint32_t fpsLimit = 0;
+	bool lowLatency = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (SDL_strcmp(argv[i], "--headless") == 0)
+		{
+			headless = true;
+		}
+		else if (SDL_strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+		{
+			benchmarkFrameCount = SDL_atoi(argv[++i]);
+		}
+		else if (SDL_strcmp(argv[i], "--capture-stream") == 0 && i + 1 < argc)
+		{
+			captureStreamPath = argv[++i];
+		}
+		else if (SDL_strcmp(argv[i], "--capture-format") == 0 && i + 1 < argc)
+		{
+			i += 1;
+			if (SDL_strcmp(argv[i], "raw") == 0)
+			{
+				captureStreamFormat = CAPTURE_STREAM_FORMAT_RAW;
+			}
+			else if (SDL_strcmp(argv[i], "y4m") == 0)
+			{
+				captureStreamFormat = CAPTURE_STREAM_FORMAT_Y4M;
+			}
+			else
+			{
+				fprintf(stderr, "Unknown capture format %s\n", argv[i]);
+				return -1;
+			}
+		}
+		else if (SDL_strcmp(argv[i], "--capture-fps") == 0 && i + 1 < argc)
+		{
+			captureFramesPerSecond = SDL_atoi(argv[++i]);
+		}
+		else if (SDL_strcmp(argv[i], "--pipeline-cache") == 0 && i + 1 < argc)
+		{
+			pipelineCachePath = argv[++i];
+		}
+		else if (SDL_strcmp(argv[i], "--no-pipeline-cache") == 0)
+		{
+			pipelineCachePath = NULL;
+		}
+		else if (SDL_strcmp(argv[i], "--target-mips") == 0)
+		{
+			targetMips = true;
+		}
+		else if (SDL_strcmp(argv[i], "--upload-bench") == 0)
+		{
+			uploadBench = true;
+		}
+		else if (SDL_strcmp(argv[i], "--uniform-bench") == 0 && i + 1 < argc)
+		{
+			uniformBenchBlockCount = SDL_atoi(argv[++i]);
+		}
+		else if (SDL_strcmp(argv[i], "--interop-targets") == 0 && i + 1 < argc)
+		{
+			interopTargetCount = SDL_atoi(argv[++i]);
+		}
+		else if (SDL_strcmp(argv[i], "--dynamic-resolution") == 0)
+		{
+			dynamicResolution = true;
+		}
+		else if (SDL_strcmp(argv[i], "--gpu-budget") == 0 && i + 1 < argc)
+		{
+			gpuBudgetMilliseconds = SDL_atof(argv[++i]);
+		}
+		else if (SDL_strcmp(argv[i], "--quality") == 0 && i + 1 < argc)
+		{
+			i += 1;
+			shaderQuality = SHADER_QUALITY_COUNT;
+			for (int j = 0; j < SHADER_QUALITY_COUNT; j++)
+			{
+				if (SDL_strcmp(argv[i], shaderQualityNames[j]) == 0)
+				{
+					shaderQuality = (ShaderQuality) j;
+				}
+			}
+
+			if (shaderQuality == SHADER_QUALITY_COUNT)
+			{
+				fprintf(stderr, "Unknown quality %s\n", argv[i]);
+				return -1;
+			}
+		}
+		else if (SDL_strcmp(argv[i], "--sprites") == 0 && i + 1 < argc)
+		{
+			spriteCount = SDL_atoi(argv[++i]);
+		}
+		else if (SDL_strcmp(argv[i], "--sprite-sort") == 0 && i + 1 < argc)
+		{
+			i += 1;
+			if (SDL_strcmp(argv[i], "deferred") == 0)
+			{
+				spriteSortMode = SPRITE_SORT_DEFERRED;
+			}
+			else if (SDL_strcmp(argv[i], "texture") == 0)
+			{
+				spriteSortMode = SPRITE_SORT_TEXTURE;
+			}
+			else
+			{
+				fprintf(stderr, "Unknown sprite sort mode %s\n", argv[i]);
+				return -1;
+			}
+		}
+		else if (SDL_strcmp(argv[i], "--gpu-profile") == 0)
+		{
+			gpuProfile = true;
+		}
+		else if (SDL_strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+		{
+			tracePath = argv[++i];
+		}
+		else if (SDL_strcmp(argv[i], "--capture-commands") == 0 && i + 1 < argc)
+		{
+			commandCapturePath = argv[++i];
+		}
+		else if (SDL_strcmp(argv[i], "--record-threads") == 0 && i + 1 < argc)
+		{
+			recordThreadCount = SDL_atoi(argv[++i]);
+			if (recordThreadCount < 1 || recordThreadCount > TILED_PASS_BANDS_MAX)
+			{
+				fprintf(stderr, "--record-threads must be between 1 and %d\n", TILED_PASS_BANDS_MAX);
+				return -1;
+			}
+		}
+		else if (SDL_strcmp(argv[i], "--tile-size") == 0 && i + 1 < argc)
+		{
+			tileSize = SDL_atoi(argv[++i]);
+		}
+		else if (SDL_strcmp(argv[i], "--checkerboard") == 0)
+		{
+			checkerboard = true;
+		}
+		else if (SDL_strcmp(argv[i], "--scene") == 0 && i + 1 < argc)
+		{
+			i += 1;
+			scene = RAYMARCH_SCENE_COUNT;
+			for (int j = 0; j < RAYMARCH_SCENE_COUNT; j++)
+			{
+				if (SDL_strcmp(argv[i], raymarchSceneNames[j]) == 0)
+				{
+					scene = (RaymarchScene) j;
+				}
+			}
+
+			if (scene == RAYMARCH_SCENE_COUNT)
+			{
+				fprintf(stderr, "Unknown scene %s\n", argv[i]);
+				return -1;
+			}
+		}
+		else if (SDL_strcmp(argv[i], "--compute") == 0)
+		{
+			compute = true;
+		}
+		else if (SDL_strcmp(argv[i], "--compare-paths") == 0)
+		{
+			comparePaths = true;
+		}
+		else if (SDL_strcmp(argv[i], "--golden") == 0 && i + 1 < argc)
+		{
+			goldenDirectory = argv[++i];
+			headless = true;
+		}
+		else if (SDL_strcmp(argv[i], "--golden-update") == 0)
+		{
+			goldenUpdate = true;
+		}
+		else if (SDL_strcmp(argv[i], "--golden-budget") == 0 && i + 1 < argc)
+		{
+			i += 1;
+			if (SDL_strcmp(argv[i], "scene") == 0)
+			{
+				goldenBudgetScene = true;
+			}
+			else
+			{
+				goldenBudgetMilliseconds = SDL_atof(argv[i]);
+			}
+			goldenBudgetSet = true;
+		}
+		else if (SDL_strcmp(argv[i], "--screenshot-format") == 0 && i + 1 < argc)
+		{
+			i += 1;
+			screenshotFormat = SCREENSHOT_FORMAT_COUNT;
+			for (int j = 0; j < SCREENSHOT_FORMAT_COUNT; j++)
+			{
+				if (SDL_strcmp(argv[i], screenshotFormatNames[j]) == 0)
+				{
+					screenshotFormat = (ScreenshotFormat) j;
+				}
+			}
+
+			if (screenshotFormat == SCREENSHOT_FORMAT_COUNT)
+			{
+				fprintf(stderr, "Unknown screenshot format %s\n", argv[i]);
+				return -1;
+			}
+		}
+		else if (SDL_strcmp(argv[i], "--screenshot-flip") == 0)
+		{
+			screenshotFlip = true;
+		}
+		else if (SDL_strcmp(argv[i], "--present-mode") == 0 && i + 1 < argc)
+		{
+			i += 1;
+			presentMode = FRAME_PACER_PRESENT_COUNT;
+			for (int j = 0; j < FRAME_PACER_PRESENT_COUNT; j++)
+			{
+				if (SDL_strcmp(argv[i], framePacerPresentModeNames[j]) == 0)
+				{
+					presentMode = (FramePacerPresentMode) j;
+				}
+			}
+
+			if (presentMode == FRAME_PACER_PRESENT_COUNT)
+			{
+				fprintf(stderr, "Unknown present mode %s\n", argv[i]);
+				return -1;
+			}
+		}
+		else if (SDL_strcmp(argv[i], "--frames-in-flight") == 0 && i + 1 < argc)
+		{
+			framesInFlight = SDL_atoi(argv[++i]);
+		}
+		else if (SDL_strcmp(argv[i], "--fps-limit") == 0 && i + 1 < argc)
+		{
+			fpsLimit = SDL_atoi(argv[++i]);
+		}
+		else if (SDL_strcmp(argv[i], "--low-latency") == 0)
+		{
+			lowLatency = true;
+		}
+		else
+		{
+			PrintUsage(argv[0]);
+			return SDL_strcmp(argv[i], "--help") == 0 ? 0 : -1;
+		}
+	}
+
+	if (headless && benchmarkFrameCount == 0)
+	{
+		fprintf(stderr, "--frames must be greater than zero\n");
+		return -1;
+	}
+
+	if (interopTargetCount < 1 || interopTargetCount > INTEROP_TARGETS_MAX)
+	{
+		fprintf(stderr, "--interop-targets must be between 1 and %d\n", INTEROP_TARGETS_MAX);
+		return -1;
+	}
+
+	if (captureStreamPath != NULL && captureFramesPerSecond == 0)
+	{
+		fprintf(stderr, "--capture-fps must be greater than zero\n");
+		return -1;
+	}
+
+	if (tileSize == 0)
+	{
+		fprintf(stderr, "--tile-size must be greater than zero\n");
+		return -1;
+	}
+
+	if (gpuBudgetMilliseconds <= 0.0)
+	{
+		fprintf(stderr, "--gpu-budget must be greater than zero\n");
+		return -1;
+	}
+
+	/* Refresh's compute pipelines can't bind samplers, which hexagon_grid reads */
+	if ((compute || comparePaths) && scene != RAYMARCH_SCENE_SEASCAPE)
+	{
+		fprintf(stderr, "--compute and --compare-paths need --scene seascape\n");
+		return -1;
+	}
+
+	if (comparePaths && !headless)
+	{
+		fprintf(stderr, "--compare-paths is ignored without --headless\n");
+		comparePaths = false;
+	}
+
+	/* The compute path writes every pixel of the interop target itself */
+	if (checkerboard && (compute || comparePaths))
+	{
+		fprintf(stderr, "--checkerboard is ignored with --compute and --compare-paths\n");
+		checkerboard = false;
+	}
+
+	/* The half-width target is drawn in a single pass */
+	if (checkerboard && recordThreadCount > 0)
+	{
+		fprintf(stderr, "--record-threads is ignored with --checkerboard\n");
+		recordThreadCount = 0;
+	}
+
+	/* Every frame of a stream has to be the same size */
+	if (captureStreamPath != NULL && dynamicResolution)
+	{
+		fprintf(stderr, "--dynamic-resolution is ignored while capturing a stream\n");
+		dynamicResolution = false;
+	}
+
+	if (goldenDirectory != NULL && benchmarkFrameCount < SDL_arraysize(goldenTimes))
+	{
+		fprintf(stderr, "--frames must be at least %d with --golden\n", (int) SDL_arraysize(goldenTimes));
+		return -1;
+	}
+
+	if (goldenBudgetMilliseconds < 0.0)
+	{
+		fprintf(stderr, "--golden-budget must not be negative\n");
+		return -1;
+	}
+
+	if (goldenDirectory == NULL && (goldenUpdate || goldenBudgetSet))
+	{
+		fprintf(stderr, "--golden-update and --golden-budget are ignored without --golden\n");
+		goldenUpdate = false;
+		goldenBudgetSet = false;
+	}
+
+	/* Recording is for a new driver or a changed image, neither of which the budget knows about */
+	if (goldenUpdate && goldenBudgetSet)
+	{
+		fprintf(stderr, "--golden-budget is ignored with --golden-update\n");
+		goldenBudgetSet = false;
+	}
+
+	if (!goldenBudgetSet)
+	{
+		goldenBudgetMilliseconds = 0.0;
+	}
+	else if (goldenBudgetScene)
+	{
+		/* Like the golden images, the budget is the starting tier's */
+		goldenBudgetMilliseconds = goldenBudgets[scene][shaderQuality];
+	}
+
+	/* A golden image is only comparable at the size it was rendered at */
+	if (goldenDirectory != NULL && dynamicResolution)
+	{
+		fprintf(stderr, "--dynamic-resolution is ignored with --golden\n");
+		dynamicResolution = false;
+	}
+
+	/* S is only read with a window */
+	if (headless && (screenshotFormat != SCREENSHOT_FORMAT_PNG || screenshotFlip))
+	{
+		fprintf(stderr, "--screenshot-format and --screenshot-flip are ignored with --headless\n");
+		screenshotFormat = SCREENSHOT_FORMAT_PNG;
+		screenshotFlip = false;
+	}
+
+	if (framesInFlight > FRAME_PACER_FRAMES_IN_FLIGHT_MAX)
+	{
+		fprintf(stderr, "--frames-in-flight must be between 0 and %d\n", FRAME_PACER_FRAMES_IN_FLIGHT_MAX);
+		return -1;
+	}
+	if (framesInFlight < 0)
+	{
+		framesInFlight = lowLatency ? 1 : 0;
+	}
+
+	/* Headless frames already wait for the GPU one at a time and never present */
+	if (	headless &&
+		(presentMode != FRAME_PACER_PRESENT_FIFO || framesInFlight > 0 || fpsLimit > 0 || lowLatency)	)
+	{
+		fprintf(stderr, "--present-mode, --frames-in-flight, --fps-limit and --low-latency are ignored with --headless\n");
+		presentMode = FRAME_PACER_PRESENT_FIFO;
+		framesInFlight = 0;
+		fpsLimit = 0;
+		lowLatency = false;
+	}
+
+	/* Reports go to stderr when stdout carries the capture stream */
+	FILE *reportOutput = stdout;
+	if (captureStreamPath != NULL && SDL_strcmp(captureStreamPath, "-") == 0)
+	{
+		reportOutput = stderr;
+	}
+
+	/* Asset files are read and decoded on workers while SDL, the window and
+	 * both devices come up; uploads happen below as each one finishes.
+	 */
+	uint64_t startupTicks = SDL_GetPerformanceCounter();
+
+	/* Before any thread that records zones exists */
+	Trace_Init(tracePath != NULL);
+	Trace_SetThreadName("main");
+
+	/* Refresh's device is made from FNA3D's, so the capture starts at the first object */
+	if (commandCapturePath != NULL && !CommandCapture_Open(commandCapturePath))
+	{
+		fprintf(stderr, "Failed to create command capture %s\n", commandCapturePath);
+		return -1;
+	}
+
+	JobSystem *jobs = JobSystem_Create(0);
+
+	Asset assets[STARTUP_ASSET_COUNT];
+	Asset_Load(jobs, &assets[STARTUP_ASSET_PASSTHROUGH_VERT], "passthrough_vert.spv", ASSET_TYPE_FILE);
+	Asset_Load(jobs, &assets[STARTUP_ASSET_RAYMARCH_FRAG], raymarchScenePaths[scene], ASSET_TYPE_FILE);
+	Asset_LoadTexture(jobs, &assets[STARTUP_ASSET_WOODGRAIN], "woodgrain.dds", "woodgrain.png");
+	Asset_LoadTexture(jobs, &assets[STARTUP_ASSET_NOISE], "noise.dds", "noise.png");
+	Asset_Load(jobs, &assets[STARTUP_ASSET_SPRITE_EFFECT], "SpriteEffect.fxb", ASSET_TYPE_FILE);
+
+	Asset checkerboardAsset;
+	if (checkerboard)
+	{
+		Asset_Load(jobs, &checkerboardAsset, "checkerboard_resolve.spv", ASSET_TYPE_FILE);
+	}
+
+	/* The comparison starts on the fragment path and switches halfway */
+	Asset computeAsset;
+	if (compute || comparePaths)
+	{
+		Asset_Load(jobs, &computeAsset, "seascape_comp.spv", ASSET_TYPE_FILE);
+	}
+
 	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER | SDL_INIT_GAMECONTROLLER) < 0)
 	{
 		fprintf(stderr, "Failed to initialize SDL\n\t%s\n", SDL_GetError());
@@ -52,6 +705,12 @@ int main(int argc, char *argv[])
 
 	uint32_t windowFlags = FNA3D_PrepareWindowAttributes();
 
+	/* FNA3D still needs a window to create its device, but headless runs never present to it */
+	if (headless)
+	{
+		windowFlags |= SDL_WINDOW_HIDDEN;
+	}
+
 	SDL_Window *window = SDL_CreateWindow(
 		"Refresh Test",
 		SDL_WINDOWPOS_UNDEFINED,
@@ -61,6 +720,12 @@ int main(int argc, char *argv[])
 		windowFlags
 	);
 
+	if (window == NULL)
+	{
+		fprintf(stderr, "Failed to create window\n\t%s\n", SDL_GetError());
+		return -1;
+	}
+
 	int width, height;
 	FNA3D_GetDrawableSize(window, &width, &height);
 
@@ -69,6 +734,11 @@ int main(int argc, char *argv[])
 	presentationParameters.backBufferWidth = width;
 	presentationParameters.backBufferHeight = height;
 	presentationParameters.deviceWindowHandle = window;
+	FramePacer_PreparePresentation(presentMode, &presentationParameters);
+
+	/* FNA3D loads the cache blob while creating its device */
+	PipelineCache pipelineCache;
+	PipelineCache_Prepare(&pipelineCache, pipelineCachePath);
 
 	FNA3D_Device* fnaDevice = FNA3D_CreateDevice(&presentationParameters, 0);
 
@@ -84,114 +754,150 @@ int main(int argc, char *argv[])
 		1
 	);
 
-	bool quit = false;
-
-	double t = 0.0;
-	double dt = 0.01;
-
-	uint64_t currentTime = SDL_GetPerformanceCounter();
-	double accumulator = 0.0;
-
-	Refresh_Rect renderArea;
-	renderArea.x = 0;
-	renderArea.y = 0;
-	renderArea.w = windowWidth;
-	renderArea.h = windowHeight;
-
-	/* Compile shaders */
-
-	SDL_RWops* file = SDL_RWFromFile("passthrough_vert.spv", "rb");
-	Sint64 shaderCodeSize = SDL_RWsize(file);
-	uint32_t* byteCode = SDL_malloc(sizeof(uint32_t) * shaderCodeSize);
-	SDL_RWread(file, byteCode, sizeof(uint32_t), shaderCodeSize);
-	SDL_RWclose(file);
-
-	Refresh_ShaderModuleCreateInfo passthroughVertexShaderModuleCreateInfo;
-	passthroughVertexShaderModuleCreateInfo.byteCode = byteCode;
-	passthroughVertexShaderModuleCreateInfo.codeSize = shaderCodeSize;
+	VulkanInterop vulkanInterop;
+	if (!VulkanInterop_Init(
+		&vulkanInterop,
+		vulkanRenderingContext.renderer.vulkan.instance,
+		vulkanRenderingContext.renderer.vulkan.physicalDevice,
+		vulkanRenderingContext.renderer.vulkan.logicalDevice,
+		vulkanRenderingContext.renderer.vulkan.queueFamilyIndex
+	)) {
+		fprintf(stderr, "Failed to initialize Vulkan interop\n");
+		return -1;
+	}
 
-	Refresh_ShaderModule* passthroughVertexShaderModule = Refresh_CreateShaderModule(device, &passthroughVertexShaderModuleCreateInfo);
+	PipelineCache_BindDevice(&pipelineCache, &vulkanInterop);
 
-	file = SDL_RWFromFile("hexagon_grid.spv", "rb");
-	shaderCodeSize = SDL_RWsize(file);
-	byteCode = SDL_realloc(byteCode, sizeof(uint32_t) * shaderCodeSize);
-	SDL_RWread(file, byteCode, sizeof(uint32_t), shaderCodeSize);
-	SDL_RWclose(file);
+	if (uploadBench)
+	{
+		UploadBench_Run(device, &vulkanInterop, 4096, reportOutput);
 
-	Refresh_ShaderModuleCreateInfo raymarchFragmentShaderModuleCreateInfo;
-	raymarchFragmentShaderModuleCreateInfo.byteCode = byteCode;
-	raymarchFragmentShaderModuleCreateInfo.codeSize = shaderCodeSize;
+		for (int i = 0; i < STARTUP_ASSET_COUNT; i++)
+		{
+			Asset_Wait(jobs, &assets[i]);
+			Asset_Free(&assets[i]);
+		}
+		if (checkerboard)
+		{
+			Asset_Wait(jobs, &checkerboardAsset);
+			Asset_Free(&checkerboardAsset);
+		}
+		if (compute || comparePaths)
+		{
+			Asset_Wait(jobs, &computeAsset);
+			Asset_Free(&computeAsset);
+		}
+		JobSystem_Destroy(jobs);
+
+		CommandCapture_Close();
+		Refresh_DestroyDevice(device);
+		GpuMemory_Quit();
+		FNA3D_DestroyDevice(fnaDevice);
+		VulkanInterop_Quit(&vulkanInterop);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 0;
+	}
 
-	Refresh_ShaderModule* raymarchFragmentShaderModule = Refresh_CreateShaderModule(device, &raymarchFragmentShaderModuleCreateInfo);
+	PipelineCacheTimings pipelineCacheTimings;
+	SDL_memset(&pipelineCacheTimings, 0, sizeof(pipelineCacheTimings));
+	bool startupReported = false;
+	uint64_t timingStart;
 
-	SDL_free(byteCode);
+	bool quit = false;
 
-	/* Load textures */
+	double t = 0.0;
+	double dt = 0.01;
 
-	int32_t textureWidth, textureHeight, numChannels;
-	uint8_t *woodTexturePixels = Refresh_Image_Load(
-		"woodgrain.png",
-		&textureWidth,
-		&textureHeight,
-		&numChannels
-	);
+	/* Headless and captured runs take exactly one update per rendered frame,
+	 * so every run renders the same sequence of t. Captures advance at the
+	 * stream's frame rate so the output plays back in real time.
+	 */
+	bool fixedStepPerFrame = headless || captureStreamPath != NULL;
+	if (captureStreamPath != NULL)
+	{
+		dt = 1.0 / captureFramesPerSecond;
+	}
 
-	Refresh_Texture *woodTexture = Refresh_CreateTexture2D(
-		device,
-		REFRESH_COLORFORMAT_R8G8B8A8,
-		textureWidth,
-		textureHeight,
-		1,
-		REFRESH_TEXTUREUSAGE_SAMPLER_BIT
-	);
+	uint64_t currentTime = SDL_GetPerformanceCounter();
+	double accumulator = 0.0;
 
-	Refresh_TextureSlice setTextureDataSlice;
-	setTextureDataSlice.texture = woodTexture;
-	setTextureDataSlice.rectangle.x = 0;
-	setTextureDataSlice.rectangle.y = 0;
-	setTextureDataSlice.rectangle.w = textureWidth;
-	setTextureDataSlice.rectangle.h = textureHeight;
-	setTextureDataSlice.depth = 0;
-	setTextureDataSlice.layer = 0;
-	setTextureDataSlice.level = 0;
+	/* Create shaders and textures in whatever order the workers finish them.
+	 * The effect is left out, it waits until FNA3D's state is set up.
+	 */
 
-	Refresh_SetTextureData(
-		device,
-		&setTextureDataSlice,
-		woodTexturePixels,
-		textureWidth * textureHeight * 4
-	);
+	Refresh_ShaderModule *passthroughVertexShaderModule = NULL;
+	Refresh_ShaderModule *raymarchFragmentShaderModules[SHADER_QUALITY_COUNT];
+	Refresh_ShaderModule *checkerboardFragmentShaderModules[SHADER_QUALITY_COUNT];
+	Refresh_Texture *woodTexture = NULL;
+	Refresh_Texture *noiseTexture = NULL;
 
-	Refresh_Image_Free(woodTexturePixels);
+	Job *pendingUploads[STARTUP_ASSET_SPRITE_EFFECT];
+	for (int i = 0; i < STARTUP_ASSET_SPRITE_EFFECT; i++)
+	{
+		pendingUploads[i] = &assets[i].job;
+	}
 
-	uint8_t *noiseTexturePixels = Refresh_Image_Load(
-		"noise.png",
-		&textureWidth,
-		&textureHeight,
-		&numChannels
-	);
+	int32_t readyAsset;
+	while ((readyAsset = JobSystem_WaitAny(jobs, pendingUploads, STARTUP_ASSET_SPRITE_EFFECT)) >= 0)
+	{
+		pendingUploads[readyAsset] = NULL;
 
-	Refresh_Texture *noiseTexture = Refresh_CreateTexture2D(
-		device,
-		REFRESH_COLORFORMAT_R8G8B8A8,
-		textureWidth,
-		textureHeight,
-		1,
-		REFRESH_TEXTUREUSAGE_SAMPLER_BIT
-	);
+		Asset *asset = &assets[readyAsset];
+		if (!Asset_Wait(jobs, asset))
+		{
+			return -1;
+		}
 
-	setTextureDataSlice.texture = noiseTexture;
-	setTextureDataSlice.rectangle.w = textureWidth;
-	setTextureDataSlice.rectangle.h = textureHeight;
+		uint64_t uploadStart = SDL_GetPerformanceCounter();
 
-	Refresh_SetTextureData(
-		device,
-		&setTextureDataSlice,
-		noiseTexturePixels,
-		textureWidth * textureHeight * 4
-	);
+		switch (readyAsset)
+		{
+		case STARTUP_ASSET_PASSTHROUGH_VERT:
+			passthroughVertexShaderModule = CreateShaderModule(device, asset);
+			break;
+		case STARTUP_ASSET_RAYMARCH_FRAG:
+			/* One module per tier, each with its own constant defaults */
+			for (int i = 0; i < SHADER_QUALITY_COUNT; i++)
+			{
+				raymarchFragmentShaderModules[i] = Specialization_CreateShaderModule(
+					device,
+					(uint32_t*) asset->data,
+					asset->size,
+					raymarchQualityConstants[scene][i],
+					raymarchQualityConstantCounts[scene]
+				);
+
+				if (checkerboard)
+				{
+					uint32_t constantCount = raymarchQualityConstantCounts[scene];
+					SpecializationConstant checkerboardConstants[RAYMARCH_QUALITY_CONSTANT_COUNT + 1];
+					SDL_memcpy(checkerboardConstants, raymarchQualityConstants[scene][i], constantCount * sizeof(SpecializationConstant));
+					checkerboardConstants[constantCount].id = raymarchCheckerboardConstantIds[scene];
+					checkerboardConstants[constantCount].value = 1;
+
+					checkerboardFragmentShaderModules[i] = Specialization_CreateShaderModule(
+						device,
+						(uint32_t*) asset->data,
+						asset->size,
+						checkerboardConstants,
+						constantCount + 1
+					);
+				}
+			}
+			break;
+		case STARTUP_ASSET_WOODGRAIN:
+			woodTexture = CreateTexture(device, asset, true);
+			break;
+		case STARTUP_ASSET_NOISE:
+			/* Only ever read with texelFetch at level 0 */
+			noiseTexture = CreateTexture(device, asset, false);
+			break;
+		}
 
-	Refresh_Image_Free(noiseTexturePixels);
+		asset->uploadTicks = SDL_GetPerformanceCounter() - uploadStart;
+		Asset_Free(asset);
+	}
 
 	/* Define vertex buffer */
 
@@ -214,8 +920,9 @@ int main(int argc, char *argv[])
 	vertices[2].u = 0;
 	vertices[2].v = 0;
 
-	Refresh_Buffer* vertexBuffer = Refresh_CreateBuffer(device, REFRESH_BUFFERUSAGE_VERTEX_BIT, sizeof(Vertex) * 3);
-	Refresh_SetBufferData(device, vertexBuffer, 0, vertices, sizeof(Vertex) * 3);
+	Refresh_Buffer* vertexBuffer = CommandCapture_CreateBuffer(device, REFRESH_BUFFERUSAGE_VERTEX_BIT, sizeof(Vertex) * 3);
+	GpuMemory_AddBuffer(vertexBuffer, REFRESH_BUFFERUSAGE_VERTEX_BIT, sizeof(Vertex) * 3);
+	CommandCapture_SetBufferData(device, vertexBuffer, 0, vertices, sizeof(Vertex) * 3);
 
 	uint64_t* offsets = SDL_malloc(sizeof(uint64_t));
 	offsets[0] = 0;
@@ -224,9 +931,9 @@ int main(int argc, char *argv[])
 
 	RaymarchUniforms raymarchUniforms;
 	raymarchUniforms.time = 0;
-	raymarchUniforms.padding = 0;
-	raymarchUniforms.resolutionX = (float)windowWidth;
-	raymarchUniforms.resolutionY = (float)windowHeight;
+	raymarchUniforms.checkerboardPhase = 0;
+	raymarchUniforms.resolutionX = 0;
+	raymarchUniforms.resolutionY = 0;
 
 	/* Define RenderPass */
 
@@ -236,65 +943,69 @@ int main(int argc, char *argv[])
 	mainColorTargetDescription.storeOp = REFRESH_STOREOP_STORE;
 	mainColorTargetDescription.multisampleCount = REFRESH_SAMPLECOUNT_1;
 
-	Refresh_DepthStencilTargetDescription mainDepthStencilTargetDescription;
-	mainDepthStencilTargetDescription.depthFormat = REFRESH_DEPTHFORMAT_D32_SFLOAT_S8_UINT;
-	mainDepthStencilTargetDescription.loadOp = REFRESH_LOADOP_CLEAR;
-	mainDepthStencilTargetDescription.storeOp = REFRESH_STOREOP_DONT_CARE;
-	mainDepthStencilTargetDescription.stencilLoadOp = REFRESH_LOADOP_DONT_CARE;
-	mainDepthStencilTargetDescription.stencilStoreOp = REFRESH_STOREOP_DONT_CARE;
-
+	/* Nothing tests or writes depth, so the pass has no depth attachment at all;
+	 * a full-size D32S8 target would cost 5 bytes a pixel or more for nothing.
+	 */
 	Refresh_RenderPassCreateInfo mainRenderPassCreateInfo;
 	mainRenderPassCreateInfo.colorTargetCount = 1;
 	mainRenderPassCreateInfo.colorTargetDescriptions = &mainColorTargetDescription;
-	mainRenderPassCreateInfo.depthTargetDescription = &mainDepthStencilTargetDescription;
+	mainRenderPassCreateInfo.depthTargetDescription = NULL;
 
-	Refresh_RenderPass *mainRenderPass = Refresh_CreateRenderPass(device, &mainRenderPassCreateInfo);
+	Refresh_RenderPass *mainRenderPass = CommandCapture_CreateRenderPass(device, &mainRenderPassCreateInfo);
 
-	/* Define ColorTarget */
+	/* Define ColorTargets and Framebuffers, one per shared target and resolution level.
+	 * The raymarch pass renders at the drawable's size, or a fraction of it,
+	 * and FNA3D stretches the result over the drawable.
+	 */
 
-	Refresh_Texture *mainColorTargetTexture = Refresh_CreateTexture2D(
+	DynamicResolution *resolution = DynamicResolution_Create(
 		device,
-		REFRESH_COLORFORMAT_R8G8B8A8,
-		windowWidth,
-		windowHeight,
-		1,
-		REFRESH_TEXTUREUSAGE_COLOR_TARGET_BIT | REFRESH_TEXTUREUSAGE_SAMPLER_BIT
-	);
-
-	Refresh_TextureSlice mainColorTargetTextureSlice;
-	mainColorTargetTextureSlice.texture = mainColorTargetTexture;
-	mainColorTargetTextureSlice.rectangle.x = 0;
-	mainColorTargetTextureSlice.rectangle.y = 0;
-	mainColorTargetTextureSlice.rectangle.w = windowWidth;
-	mainColorTargetTextureSlice.rectangle.h = windowHeight;
-	mainColorTargetTextureSlice.depth = 0;
-	mainColorTargetTextureSlice.layer = 0;
-	mainColorTargetTextureSlice.level = 0;
-
-	Refresh_ColorTarget *mainColorTarget = Refresh_CreateColorTarget(
-		device,
-		REFRESH_SAMPLECOUNT_1,
-		&mainColorTargetTextureSlice
+		fnaDevice,
+		&vulkanInterop,
+		interopTargetCount,
+		width,
+		height,
+		dynamicResolution ? DYNAMIC_RESOLUTION_LEVELS_MAX : 1,
+		targetMips,
+		compute || comparePaths,
+		mainRenderPass,
+		gpuBudgetMilliseconds
 	);
 
-	Refresh_DepthStencilTarget *mainDepthStencilTarget = Refresh_CreateDepthStencilTarget(
-		device,
-		windowWidth,
-		windowHeight,
-		REFRESH_DEPTHFORMAT_D32_SFLOAT_S8_UINT
-	);
+	/* Only dynamic resolution and profiling need GPU timings */
+	GpuTimer *gpuTimer = NULL;
+	if (dynamicResolution || gpuProfile)
+	{
+		gpuTimer = GpuTimer_Create(&vulkanInterop);
+		if (gpuTimer == NULL)
+		{
+			SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "no GPU timestamps, dynamic resolution stays at 100%% and nothing is profiled");
+		}
+	}
 
-	/* Define Framebuffer */
+	GpuProfiler *gpuProfiler = NULL;
+	uint32_t raymarchPasses[SHADER_QUALITY_COUNT];
+	uint32_t computePasses[SHADER_QUALITY_COUNT];
+	uint32_t copiesPass = 0;
+	uint32_t fnaPass = 0;
+	if (gpuProfile && gpuTimer != NULL)
+	{
+		gpuProfiler = GpuProfiler_Create();
 
-	Refresh_FramebufferCreateInfo framebufferCreateInfo;
-	framebufferCreateInfo.width = 1280;
-	framebufferCreateInfo.height = 720;
-	framebufferCreateInfo.colorTargetCount = 1;
-	framebufferCreateInfo.pColorTargets = &mainColorTarget;
-	framebufferCreateInfo.pDepthStencilTarget = mainDepthStencilTarget;
-	framebufferCreateInfo.renderPass = mainRenderPass;
+		for (int i = 0; i < SHADER_QUALITY_COUNT; i++)
+		{
+			raymarchPasses[i] = GpuProfiler_AddPass(gpuProfiler, raymarchPassNames[i]);
+			computePasses[i] = raymarchPasses[i];
+			if (compute || comparePaths)
+			{
+				computePasses[i] = GpuProfiler_AddPass(gpuProfiler, computePassNames[i]);
+			}
+		}
+		copiesPass = GpuProfiler_AddPass(gpuProfiler, "mips and readback");
 
-	Refresh_Framebuffer *mainFramebuffer = Refresh_CreateFramebuffer(device, &framebufferCreateInfo);
+		/* In a window this includes waiting for a swapchain image */
+		fnaPass = GpuProfiler_AddPass(gpuProfiler, "fna3d composite");
+	}
 
 	/* Define pipeline */
 	Refresh_ColorTargetBlendState renderTargetBlendState;
@@ -350,7 +1061,7 @@ int main(int argc, char *argv[])
 	vertexShaderStageState.uniformBufferSize = 0;
 
 	Refresh_ShaderStageState fragmentShaderStageState;
-	fragmentShaderStageState.shaderModule = raymarchFragmentShaderModule;
+	fragmentShaderStageState.shaderModule = NULL;
 	fragmentShaderStageState.entryPointName = "main";
 	fragmentShaderStageState.uniformBufferSize = sizeof(RaymarchUniforms);
 
@@ -398,19 +1109,15 @@ int main(int argc, char *argv[])
 	vertexInputState.vertexAttributes = vertexAttributes;
 	vertexInputState.vertexAttributeCount = 2;
 
-	Refresh_Viewport viewport;
-	viewport.x = 0;
-	viewport.y = 0;
-	viewport.w = (float)windowWidth;
-	viewport.h = (float)windowHeight;
-	viewport.minDepth = 0;
-	viewport.maxDepth = 1;
-
+	/* Every resolution level fills in its own viewport and scissor */
 	Refresh_ViewportState viewportState;
-	viewportState.viewports = &viewport;
-	viewportState.viewportCount = 1;
-	viewportState.scissors = &renderArea;
-	viewportState.scissorCount = 1;
+	viewportState.viewports = NULL;
+	viewportState.viewportCount = 0;
+	viewportState.scissors = NULL;
+	viewportState.scissorCount = 0;
+
+	/* Every tier is built up front, switching at runtime just binds another pipeline */
+	Refresh_GraphicsPipelineCreateInfo raymarchPipelineCreateInfos[SHADER_QUALITY_COUNT];
 
 	Refresh_GraphicsPipelineCreateInfo raymarchPipelineCreateInfo;
 	raymarchPipelineCreateInfo.colorBlendState = colorBlendState;
@@ -425,7 +1132,15 @@ int main(int argc, char *argv[])
 	raymarchPipelineCreateInfo.viewportState = viewportState;
 	raymarchPipelineCreateInfo.renderPass = mainRenderPass;
 
-	Refresh_GraphicsPipeline* raymarchPipeline = Refresh_CreateGraphicsPipeline(device, &raymarchPipelineCreateInfo);
+	timingStart = SDL_GetPerformanceCounter();
+	for (int i = 0; i < SHADER_QUALITY_COUNT; i++)
+	{
+		raymarchPipelineCreateInfos[i] = raymarchPipelineCreateInfo;
+		raymarchPipelineCreateInfos[i].fragmentShaderState.shaderModule = raymarchFragmentShaderModules[i];
+	}
+	DynamicResolution_CreatePipelines(resolution, raymarchPipelineCreateInfos, SHADER_QUALITY_COUNT);
+	pipelineCacheTimings.refreshPipelineMilliseconds =
+		(SDL_GetPerformanceCounter() - timingStart) * 1000.0 / SDL_GetPerformanceFrequency();
 
 	Refresh_Color clearColor;
 	clearColor.r = 100;
@@ -433,10 +1148,6 @@ int main(int argc, char *argv[])
 	clearColor.b = 237;
 	clearColor.a = 255;
 
-	Refresh_DepthStencilValue depthStencilClear;
-	depthStencilClear.depth = 1.0f;
-	depthStencilClear.stencil = 0;
-
 	/* Sampling */
 
 	Refresh_SamplerStateCreateInfo samplerStateCreateInfo;
@@ -449,47 +1160,204 @@ int main(int argc, char *argv[])
 	samplerStateCreateInfo.compareOp = REFRESH_COMPAREOP_NEVER;
 	samplerStateCreateInfo.magFilter = REFRESH_FILTER_LINEAR;
 	samplerStateCreateInfo.maxAnisotropy = 0;
-	samplerStateCreateInfo.maxLod = 1;
+	samplerStateCreateInfo.maxLod = 1000.0f; /* VK_LOD_CLAMP_NONE, textures may carry a mip chain */
 	samplerStateCreateInfo.minFilter = REFRESH_FILTER_LINEAR;
-	samplerStateCreateInfo.minLod = 1;
-	samplerStateCreateInfo.mipLodBias = 1;
+	samplerStateCreateInfo.minLod = 0;
+	samplerStateCreateInfo.mipLodBias = 0;
 	samplerStateCreateInfo.mipmapMode = REFRESH_SAMPLERMIPMAPMODE_LINEAR;
 
-	Refresh_Sampler *sampler = Refresh_CreateSampler(
+	Refresh_Sampler *sampler = CommandCapture_CreateSampler(
+		device,
+		&samplerStateCreateInfo
+	);
+
+	Refresh_Texture* sampleTextures[2];
+	sampleTextures[0] = woodTexture;
+	sampleTextures[1] = noiseTexture;
+
+	Refresh_Sampler* sampleSamplers[2];
+	sampleSamplers[0] = sampler;
+	sampleSamplers[1] = sampler;
+
+	/* The resolve pipeline is a raymarch pipeline with its own shader and uniforms */
+	Checkerboard *checkerboardPass = NULL;
+	Refresh_ShaderModule *checkerboardResolveShaderModule = NULL;
+	if (checkerboard)
+	{
+		if (Asset_Wait(jobs, &checkerboardAsset))
+		{
+			checkerboardResolveShaderModule = CreateShaderModule(device, &checkerboardAsset);
+			checkerboardPass = Checkerboard_Create(device, resolution, mainRenderPass, sampler);
+
+			for (int i = 0; i < SHADER_QUALITY_COUNT; i++)
+			{
+				raymarchPipelineCreateInfos[i].fragmentShaderState.shaderModule = checkerboardFragmentShaderModules[i];
+			}
+
+			Refresh_GraphicsPipelineCreateInfo resolvePipelineCreateInfo = raymarchPipelineCreateInfo;
+			resolvePipelineCreateInfo.fragmentShaderState.shaderModule = checkerboardResolveShaderModule;
+			resolvePipelineCreateInfo.fragmentShaderState.uniformBufferSize = sizeof(CheckerboardUniforms);
+
+			Checkerboard_CreatePipelines(checkerboardPass, raymarchPipelineCreateInfos, SHADER_QUALITY_COUNT, &resolvePipelineCreateInfo);
+		}
+		else
+		{
+			SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "no checkerboard resolve shader, rendering at full rate");
+		}
+		Asset_Free(&checkerboardAsset);
+	}
+	bool checkerboardActive = checkerboardPass != NULL;
+
+	RaymarchCompute *raymarchCompute = NULL;
+	if (compute || comparePaths)
+	{
+		if (Asset_Wait(jobs, &computeAsset))
+		{
+			raymarchCompute = RaymarchCompute_Create(
+				device,
+				(uint32_t*) computeAsset.data,
+				computeAsset.size,
+				&raymarchQualityConstants[scene][0][0],
+				SDL_arraysize(raymarchQualityConstants[scene][0]),
+				SHADER_QUALITY_COUNT,
+				sizeof(RaymarchUniforms)
+			);
+		}
+		else
+		{
+			/* Asking for the compute path and timing the fragment one would be misleading */
+			fprintf(stderr, "--compute and --compare-paths need seascape_comp.spv\n");
+			return -1;
+		}
+		Asset_Free(&computeAsset);
+	}
+	bool computeActive = raymarchCompute != NULL && !comparePaths;
+
+	/* Without --record-threads the pass is one fullscreen triangle */
+	TiledPass *tiledPass = NULL;
+	if (recordThreadCount > 0)
+	{
+		tiledPass = TiledPass_Create(device, jobs, resolution, tileSize, recordThreadCount);
+	}
+
+	Refresh_Rect flip;
+	flip.x = 0;
+	flip.y = height;
+	flip.w = width;
+	flip.h = -height;
+
+	uint8_t screenshotKey = 0;
+	bool checkerboardKeyHeld = false;
+	bool computeKeyHeld = false;
+	ScreenshotEncoder *screenshotEncoder = ScreenshotEncoder_Create(
+		screenshotFormat,
+		screenshotFlip,
+		width,
+		height,
+		0
+	);
+	ReadbackRing *screenshotRing = ReadbackRing_Create(
 		device,
-		&samplerStateCreateInfo
+		&vulkanInterop,
+		width,
+		height,
+		3,
+		READBACK_DROP_WHEN_FULL,
+		1,
+		ScreenshotEncoder_Consume,
+		screenshotEncoder
 	);
 
-	Refresh_Texture* sampleTextures[2];
-	sampleTextures[0] = woodTexture;
-	sampleTextures[1] = noiseTexture;
+	CaptureStream *captureStream = NULL;
+	ReadbackRing *captureStreamRing = NULL;
 
-	Refresh_Sampler* sampleSamplers[2];
-	sampleSamplers[0] = sampler;
-	sampleSamplers[1] = sampler;
+	if (captureStreamPath != NULL)
+	{
+		captureStream = CaptureStream_Open(
+			captureStreamPath,
+			captureStreamFormat,
+			width,
+			height,
+			captureFramesPerSecond
+		);
+
+		if (captureStream == NULL)
+		{
+			return -1;
+		}
 
-	Refresh_Rect flip;
-	flip.x = 0;
-	flip.y = windowHeight;
-	flip.w = windowWidth;
-	flip.h = -windowHeight;
+		/* Four frames in flight hides readback latency, and blocking when
+		 * full means a slow reader throttles rendering instead of losing frames
+		 */
+		captureStreamRing = ReadbackRing_Create(
+			device,
+			&vulkanInterop,
+			width,
+			height,
+			4,
+			READBACK_BLOCK_WHEN_FULL,
+			0,
+			CaptureStream_Consume,
+			captureStream
+		);
+	}
 
-	uint8_t screenshotKey = 0;
-	uint8_t *screenshotPixels = SDL_malloc(sizeof(uint8_t) * windowWidth * windowHeight * 4);
-	Refresh_Buffer *screenshotBuffer = Refresh_CreateBuffer(device, 0, windowWidth * windowHeight * 4);
+	Golden *golden = NULL;
+	ReadbackRing *goldenRing = NULL;
+
+	if (goldenDirectory != NULL)
+	{
+		/* The tiled pass and the compute path draw the fragment pass's image, so they share its goldens */
+		char goldenName[64];
+		SDL_snprintf(
+			goldenName,
+			sizeof(goldenName),
+			"%s_%s%s",
+			raymarchSceneNames[scene],
+			shaderQualityNames[shaderQuality],
+			checkerboardActive ? "_checkerboard" : ""
+		);
+
+		golden = Golden_Create(
+			goldenDirectory,
+			goldenName,
+			SDL_arraysize(goldenTimes),
+			width,
+			height,
+			goldenUpdate
+		);
+
+		/* Every golden frame has to arrive, so the ring blocks rather than drops */
+		goldenRing = ReadbackRing_Create(
+			device,
+			&vulkanInterop,
+			width,
+			height,
+			SDL_arraysize(goldenTimes),
+			READBACK_BLOCK_WHEN_FULL,
+			0,
+			Golden_Consume,
+			golden
+		);
+	}
+
+	/* FNA3D states, zeroed first so the state cache hashes them consistently */
 
-	/* FNA3D states */
+	StateCache stateCache;
+	StateCache_Init(&stateCache, fnaDevice);
 
 	FNA3D_Viewport fnaViewport;
+	SDL_memset(&fnaViewport, 0, sizeof(fnaViewport));
 	fnaViewport.x = 0;
 	fnaViewport.y = 0;
 	fnaViewport.w = width;
 	fnaViewport.h = height;
 	fnaViewport.minDepth = 0;
 	fnaViewport.maxDepth = 1;
-	FNA3D_SetViewport(fnaDevice, &fnaViewport);
+	StateCache_SetViewport(&stateCache, &fnaViewport);
 
 	FNA3D_BlendState fnaBlendState;
+	SDL_memset(&fnaBlendState, 0, sizeof(fnaBlendState));
 	fnaBlendState.alphaBlendFunction = FNA3D_BLENDFUNCTION_ADD;
 	fnaBlendState.alphaDestinationBlend = FNA3D_BLEND_INVERSESOURCEALPHA;
 	fnaBlendState.alphaSourceBlend = FNA3D_BLEND_ONE;
@@ -503,9 +1371,10 @@ int main(int argc, char *argv[])
 	fnaBlendState.colorWriteEnable2 = FNA3D_COLORWRITECHANNELS_ALL;
 	fnaBlendState.colorWriteEnable3 = FNA3D_COLORWRITECHANNELS_ALL;
 	fnaBlendState.multiSampleMask = -1;
-	FNA3D_SetBlendState(fnaDevice, &fnaBlendState);
+	StateCache_SetBlendState(&stateCache, &fnaBlendState);
 
 	FNA3D_DepthStencilState fnaDepthStencilState;
+	SDL_memset(&fnaDepthStencilState, 0, sizeof(fnaDepthStencilState));
 	fnaDepthStencilState.ccwStencilDepthBufferFail = 0;
 	fnaDepthStencilState.ccwStencilFail = 0;
 	fnaDepthStencilState.ccwStencilFunction = 0;
@@ -522,90 +1391,123 @@ int main(int argc, char *argv[])
 	fnaDepthStencilState.stencilPass = 0;
 	fnaDepthStencilState.stencilWriteMask = 0;
 	fnaDepthStencilState.twoSidedStencilMode = 0;
-	FNA3D_SetDepthStencilState(fnaDevice, &fnaDepthStencilState);
+	StateCache_SetDepthStencilState(&stateCache, &fnaDepthStencilState);
 
 	FNA3D_RasterizerState fnaRasterizerState;
+	SDL_memset(&fnaRasterizerState, 0, sizeof(fnaRasterizerState));
 	fnaRasterizerState.cullMode = FNA3D_CULLMODE_NONE;
 	fnaRasterizerState.fillMode = FNA3D_FILLMODE_SOLID;
 	fnaRasterizerState.depthBias = 0;
 	fnaRasterizerState.multiSampleAntiAlias = 1;
 	fnaRasterizerState.scissorTestEnable = 0;
 	fnaRasterizerState.slopeScaleDepthBias = 0;
-	FNA3D_ApplyRasterizerState(fnaDevice, &fnaRasterizerState);
+	StateCache_ApplyRasterizerState(&stateCache, &fnaRasterizerState);
 
 	/* load effect */
 	FNA3D_Effect* effect = NULL;
 	MOJOSHADER_effect* effectData = NULL;
 
-	/* FIXME: use SDL */
-	FILE* effectFile = fopen("SpriteEffect.fxb", "rb");
-	fseek(effectFile, 0, SEEK_END);
-	uint32_t effectCodeLength = ftell(effectFile);
-	fseek(effectFile, 0, SEEK_SET);
-	uint8_t* effectCode = malloc(effectCodeLength);
-	fread(effectCode, 1, effectCodeLength, effectFile);
-	fclose(effectFile);
-	FNA3D_CreateEffect(fnaDevice, effectCode, effectCodeLength, &effect, &effectData);
-	free(effectCode);
-
-	/* create external texture*/
-
-	Refresh_TextureHandlesEXT textureHandles;
-	Refresh_GetTextureHandlesEXT(device, mainColorTargetTexture, &textureHandles);
-
-	FNA3D_SysTextureEXT externalTextureCreateInfo;
-	externalTextureCreateInfo.rendererType = FNA3D_RENDERER_TYPE_VULKAN_EXT;
-	externalTextureCreateInfo.texture.vulkan.image = textureHandles.texture.vulkan.image;
-	externalTextureCreateInfo.texture.vulkan.view = textureHandles.texture.vulkan.view;
-	externalTextureCreateInfo.version = 0;
-
-	FNA3D_Texture* externalTexture = FNA3D_CreateSysTextureEXT(fnaDevice, &externalTextureCreateInfo);
-
-	/* create FNA vertices */
-
-	FNA3D_VertexElement vertexElements[3];
-	vertexElements[0].offset = 0;
-	vertexElements[0].usageIndex = 0;
-	vertexElements[0].vertexElementFormat = FNA3D_VERTEXELEMENTFORMAT_VECTOR2;
-	vertexElements[0].vertexElementUsage = FNA3D_VERTEXELEMENTUSAGE_POSITION;
-
-	vertexElements[1].offset = sizeof(float) * 2;
-	vertexElements[1].usageIndex = 0;
-	vertexElements[1].vertexElementFormat = FNA3D_VERTEXELEMENTFORMAT_VECTOR2;
-	vertexElements[1].vertexElementUsage = FNA3D_VERTEXELEMENTUSAGE_TEXTURECOORDINATE;
-
-	vertexElements[2].offset = sizeof(float) * 4;
-	vertexElements[2].usageIndex = 0;
-	vertexElements[2].vertexElementFormat = FNA3D_VERTEXELEMENTFORMAT_COLOR;
-	vertexElements[2].vertexElementUsage = FNA3D_VERTEXELEMENTUSAGE_COLOR;
-
-	FNA3D_VertexDeclaration vertexDeclaration;
-	vertexDeclaration.elementCount = 3;
-	vertexDeclaration.vertexStride = sizeof(Vertex);
-	vertexDeclaration.elements = vertexElements;
-
-	FNAVertex fnaVertices[6] =
-	{
-		{ 50, 50, 0, 0, 0xffff0000 },
-		{ 150, 50, 1, 0, 0xff0000ff },
-		{ 150, 150, 1, 1, 0xff00ffff },
-		{ 150, 150, 1, 1, 0xff00ffff },
-		{ 50, 150, 0, 1, 0xff00ff00 },
-		{ 50, 50, 0, 0, 0xffff0000 },
-	};
-
-	// vertex buffer
-	FNA3D_Buffer* fnaVertexBuffer = FNA3D_GenVertexBuffer(fnaDevice, 0, FNA3D_BUFFERUSAGE_WRITEONLY, sizeof(FNAVertex) * 6);
-	FNA3D_SetVertexBufferData(fnaDevice, fnaVertexBuffer, 0, fnaVertices, sizeof(FNAVertex) * 6, 1, 1, FNA3D_SETDATAOPTIONS_NONE);
-
-	FNA3D_VertexBufferBinding vertexBufferBinding;
-	vertexBufferBinding.instanceFrequency = 0;
-	vertexBufferBinding.vertexBuffer = fnaVertexBuffer;
-	vertexBufferBinding.vertexDeclaration = vertexDeclaration;
-	vertexBufferBinding.vertexOffset = 0;
+	Asset *effectAsset = &assets[STARTUP_ASSET_SPRITE_EFFECT];
+	if (!Asset_Wait(jobs, effectAsset))
+	{
+		return -1;
+	}
+
+	timingStart = SDL_GetPerformanceCounter();
+	CommandCapture_FNA3D_CreateEffect(fnaDevice, effectAsset->data, effectAsset->size, &effect, &effectData);
+	effectAsset->uploadTicks = SDL_GetPerformanceCounter() - timingStart;
+	pipelineCacheTimings.fnaEffectMilliseconds = effectAsset->uploadTicks * 1000.0 / SDL_GetPerformanceFrequency();
+	Asset_Free(effectAsset);
+
+	/* The composite and any --sprites workload share one batcher */
+	SpriteBatch *spriteBatch = SpriteBatch_Create(fnaDevice, &stateCache, effect, effectData);
+
+	SpriteBench *spriteBench = NULL;
+	if (spriteCount > 0)
+	{
+		spriteBench = SpriteBench_Create(fnaDevice, spriteCount, spriteSortMode, width, height);
+	}
+
+	UniformBench *uniformBench = NULL;
+	if (uniformBenchBlockCount > 0)
+	{
+		uniformBench = UniformBench_Create(device, &vulkanInterop, uniformBenchBlockCount, sizeof(Vertex));
+	}
+
+	/* Headless offscreen target */
+
+	FNA3D_Texture *offscreenTarget = NULL;
+	FNA3D_RenderTargetBinding offscreenTargetBinding;
+	FNA3D_Vec4 offscreenClearColor = { 0.0f, 0.0f, 0.0f, 1.0f };
+	uint32_t syncPixel;
+
+	Benchmark benchmark;
+
+	if (headless)
+	{
+		offscreenTarget = CommandCapture_FNA3D_CreateTexture2D(
+			fnaDevice,
+			FNA3D_SURFACEFORMAT_COLOR,
+			width,
+			height,
+			1,
+			1
+		);
+
+		SDL_memset(&offscreenTargetBinding, 0, sizeof(offscreenTargetBinding));
+		offscreenTargetBinding.type = FNA3D_RENDERTARGET_TYPE_2D;
+		offscreenTargetBinding.twod.width = width;
+		offscreenTargetBinding.twod.height = height;
+		offscreenTargetBinding.levelCount = 1;
+		offscreenTargetBinding.multiSampleCount = 0;
+		offscreenTargetBinding.texture = offscreenTarget;
+		offscreenTargetBinding.colorBuffer = NULL;
+
+		Benchmark_Init(&benchmark, benchmarkFrameCount);
+	}
+
+	FramePacer *framePacer = NULL;
+	if (!headless)
+	{
+		/* --low-latency is just in time for the display's vblanks unless
+		 * --fps-limit says otherwise; immediate presents have no vblank to wait for
+		 */
+		double periodSeconds = 0.0;
+		if (fpsLimit > 0)
+		{
+			periodSeconds = 1.0 / fpsLimit;
+		}
+		else if (lowLatency && presentMode != FRAME_PACER_PRESENT_IMMEDIATE)
+		{
+			SDL_DisplayMode displayMode;
+			if (	SDL_GetCurrentDisplayMode(SDL_GetWindowDisplayIndex(window), &displayMode) == 0 &&
+				displayMode.refresh_rate > 0	)
+			{
+				periodSeconds = 1.0 / displayMode.refresh_rate;
+			}
+			else
+			{
+				fprintf(stderr, "The display's refresh rate is unknown, --low-latency only limits frames in flight\n");
+			}
+		}
+
+		framePacer = FramePacer_Create(&vulkanInterop, presentMode, framesInFlight, periodSeconds);
+	}
 
 	while (!quit)
 	{
+		uint64_t frameZone = TRACE_BEGIN();
+
+		/* Input is polled right after the pacer wakes, as late as it can be */
+		if (framePacer != NULL)
+		{
+			uint64_t pacingZone = TRACE_BEGIN();
+			FramePacer_BeginFrame(framePacer);
+			TRACE_END("frame pacing", pacingZone);
+		}
+
+		uint64_t pollZone = TRACE_BEGIN();
+
 		SDL_Event event;
 		while (SDL_PollEvent(&event))
 		{
@@ -617,6 +1519,8 @@ int main(int argc, char *argv[])
 			}
 		}
 
+		TRACE_END("event poll", pollZone);
+
 		uint64_t newTime = SDL_GetPerformanceCounter();
 		double frameTime = (newTime - currentTime) / (double)SDL_GetPerformanceFrequency();
 
@@ -624,10 +1528,23 @@ int main(int argc, char *argv[])
 			frameTime = 0.25;
 		currentTime = newTime;
 
+		if (headless)
+		{
+			Benchmark_BeginFrame(&benchmark);
+		}
+
+		if (fixedStepPerFrame)
+		{
+			frameTime = dt;
+			accumulator = 0.0;
+		}
+
 		accumulator += frameTime;
 
 		bool updateThisLoop = (accumulator >= dt);
 
+		uint64_t updateZone = TRACE_BEGIN();
+
 		while (accumulator >= dt && !quit)
 		{
 			// Update here!
@@ -637,7 +1554,7 @@ int main(int argc, char *argv[])
 
 			const uint8_t *keyboardState = SDL_GetKeyboardState(NULL);
 
-			if (keyboardState[SDL_SCANCODE_S])
+			if (keyboardState[SDL_SCANCODE_S] && !headless)
 			{
 				if (screenshotKey == 1)
 				{
@@ -652,131 +1569,586 @@ int main(int argc, char *argv[])
 			{
 				screenshotKey = 0;
 			}
+
+			for (int i = 0; i < SHADER_QUALITY_COUNT; i++)
+			{
+				if (	keyboardState[SDL_SCANCODE_1 + i] &&
+					shaderQuality != (ShaderQuality) i	)
+				{
+					shaderQuality = (ShaderQuality) i;
+					SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "raymarch quality: %s", shaderQualityNames[i]);
+				}
+			}
+
+			/* C toggles checkerboarding; the history is stale after either switch */
+			if (checkerboardPass != NULL)
+			{
+				if (keyboardState[SDL_SCANCODE_C] && !checkerboardKeyHeld)
+				{
+					checkerboardActive = !checkerboardActive;
+					Checkerboard_Invalidate(checkerboardPass);
+					SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "checkerboard: %s", checkerboardActive ? "on" : "off");
+				}
+				checkerboardKeyHeld = keyboardState[SDL_SCANCODE_C];
+			}
+
+			/* P switches between the compute and fragment paths */
+			if (raymarchCompute != NULL)
+			{
+				if (keyboardState[SDL_SCANCODE_P] && !computeKeyHeld)
+				{
+					computeActive = !computeActive;
+					SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "raymarch path: %s", computeActive ? "compute" : "fragment");
+				}
+				computeKeyHeld = keyboardState[SDL_SCANCODE_P];
+			}
 		}
 
-		if (updateThisLoop && !quit)
+		TRACE_END("fixed-step update", updateZone);
+
+		/* t only moves in whole steps, so frames are drawn at the remainder
+		 * past it. Everything drawn is a function of time, which makes this
+		 * exact rather than a step behind like blending two updates would be,
+		 * and lets a frame be drawn between updates. Runs with one update per
+		 * frame have no remainder.
+		 */
+		double interpolation = accumulator / dt;
+		double renderTime = t + interpolation * dt;
+
+		if (!quit)
 		{
 			// Draw here!
 
-			Refresh_CommandBuffer *commandBuffer = Refresh_AcquireCommandBuffer(device, 0);
+			ReadbackRing_Poll(screenshotRing);
 
-			Refresh_BeginRenderPass(
-				device,
-				commandBuffer,
-				mainRenderPass,
-				mainFramebuffer,
-				renderArea,
-				&clearColor,
-				1,
-				&depthStencilClear
-			);
+			if (captureStreamRing != NULL)
+			{
+				ReadbackRing_Poll(captureStreamRing);
+			}
 
-			Refresh_BindGraphicsPipeline(
-				device,
-				commandBuffer,
-				raymarchPipeline
-			);
+			if (goldenRing != NULL)
+			{
+				ReadbackRing_Poll(goldenRing);
+			}
+
+			if (gpuTimer != NULL)
+			{
+				/* The first interval is the raymarch pass, alone when profiling */
+				GpuTimerFrame gpuFrame;
+				while (GpuTimer_Poll(gpuTimer, &gpuFrame))
+				{
+					if (dynamicResolution)
+					{
+						DynamicResolution_Update(resolution, gpuFrame.milliseconds[0], gpuFrame.tag);
+					}
+
+					if (gpuProfiler != NULL)
+					{
+						GpuProfiler_AddFrame(gpuProfiler, &gpuFrame);
+
+						if (gpuProfiler->frameCount % GPU_PROFILE_REPORT_FRAMES == 0)
+						{
+							GpuProfiler_Report(gpuProfiler, reportOutput);
+						}
+					}
+				}
+			}
+
+			DynamicResolutionLevel *resolutionLevel = DynamicResolution_BeginFrame(resolution);
 
-			raymarchUniforms.time = (float)t;
+			/* FNA3D may still be sampling the previous target */
+			uint64_t acquireZone = TRACE_BEGIN();
+			InteropTarget *interopTarget = InteropTargets_Acquire(resolutionLevel->targets);
+			TRACE_END("interop target wait", acquireZone);
 
-			uint32_t fragmentParamOffset = Refresh_PushFragmentShaderParams(device, commandBuffer, &raymarchUniforms, 1);
-			Refresh_BindVertexBuffers(device, commandBuffer, 0, 1, &vertexBuffer, offsets);
-			Refresh_BindFragmentSamplers(device, commandBuffer, sampleTextures, sampleSamplers);
-			Refresh_DrawPrimitives(device, commandBuffer, 0, 1, 0, fragmentParamOffset);
+			uint64_t recordZone = TRACE_BEGIN();
 
-			Refresh_Clear(device, commandBuffer, &renderArea, REFRESH_CLEAROPTIONS_DEPTH | REFRESH_CLEAROPTIONS_STENCIL, NULL, 0, 0.5f, 10);
-			Refresh_EndRenderPass(device, commandBuffer);
+			/* Headless frames are only counted at their end, so frameCount is this frame's index */
+			bool goldenFrame = goldenRing != NULL && benchmark.frameCount < SDL_arraysize(goldenTimes);
 
-			if (screenshotKey == 1)
+			raymarchUniforms.time = goldenFrame ? (float) goldenTimes[benchmark.frameCount] : (float)renderTime;
+			raymarchUniforms.resolutionX = (float)resolutionLevel->width;
+			raymarchUniforms.resolutionY = (float)resolutionLevel->height;
+
+			/* The raymarch pass, then whatever runs after it on the main thread */
+			Refresh_CommandBuffer *commandBuffers[TILED_PASS_BANDS_MAX + 1];
+			uint32_t commandBufferCount;
+
+			if (computeActive)
+			{
+				commandBuffers[0] = CommandCapture_AcquireCommandBuffer(device, 0);
+				RaymarchCompute_Record(
+					raymarchCompute,
+					commandBuffers[0],
+					shaderQuality,
+					interopTarget->texture,
+					resolutionLevel->width,
+					resolutionLevel->height,
+					&raymarchUniforms
+				);
+				commandBufferCount = 1;
+			}
+			else if (checkerboardActive)
+			{
+				raymarchUniforms.checkerboardPhase = (float) checkerboardPass->phase;
+
+				CheckerboardFrame checkerboardFrame;
+				checkerboardFrame.level = resolution->current;
+				checkerboardFrame.pipeline = shaderQuality;
+				checkerboardFrame.framebuffer = interopTarget->framebuffer;
+				checkerboardFrame.slice = &interopTarget->slice;
+				checkerboardFrame.vertexBuffer = vertexBuffer;
+				checkerboardFrame.clearColor = &clearColor;
+				checkerboardFrame.textures = sampleTextures;
+				checkerboardFrame.samplers = sampleSamplers;
+				checkerboardFrame.fragmentUniforms = &raymarchUniforms;
+
+				commandBuffers[0] = CommandCapture_AcquireCommandBuffer(device, 0);
+				Checkerboard_Record(checkerboardPass, commandBuffers[0], &checkerboardFrame);
+				commandBufferCount = 1;
+			}
+			else if (tiledPass != NULL)
+			{
+				TiledPassFrame tiledFrame;
+				tiledFrame.level = resolution->current;
+				tiledFrame.renderPass = mainRenderPass;
+				tiledFrame.framebuffer = interopTarget->framebuffer;
+				tiledFrame.pipeline = resolutionLevel->pipelines[shaderQuality];
+				tiledFrame.clearColor = &clearColor;
+				tiledFrame.textures = sampleTextures;
+				tiledFrame.samplers = sampleSamplers;
+				tiledFrame.fragmentUniforms = &raymarchUniforms;
+
+				commandBufferCount = TiledPass_Record(tiledPass, &tiledFrame, commandBuffers);
+			}
+			else
 			{
-				SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "screenshot!");
-				Refresh_CopyTextureToBuffer(device, commandBuffer, &mainColorTargetTextureSlice, screenshotBuffer);
+				Refresh_CommandBuffer *commandBuffer = CommandCapture_AcquireCommandBuffer(device, 0);
+
+				CommandCapture_BeginRenderPass(
+					device,
+					commandBuffer,
+					mainRenderPass,
+					interopTarget->framebuffer,
+					resolutionLevel->renderArea,
+					&clearColor,
+					1,
+					NULL
+				);
+
+				CommandCapture_BindGraphicsPipeline(
+					device,
+					commandBuffer,
+					resolutionLevel->pipelines[shaderQuality]
+				);
+
+				CommandCapture_BindFragmentSamplers(device, commandBuffer, sampleTextures, sampleSamplers);
+
+				if (uniformBench != NULL)
+				{
+					UniformBench_Record(uniformBench, commandBuffer, &raymarchUniforms);
+				}
+
+				uint32_t fragmentParamOffset = CommandCapture_PushFragmentShaderParams(device, commandBuffer, &raymarchUniforms, 1);
+				CommandCapture_BindVertexBuffers(device, commandBuffer, 0, 1, &vertexBuffer, offsets);
+				CommandCapture_DrawPrimitives(device, commandBuffer, 0, 1, 0, fragmentParamOffset);
+
+				CommandCapture_EndRenderPass(device, commandBuffer);
+
+				commandBuffers[0] = commandBuffer;
+				commandBufferCount = 1;
 			}
 
-			Refresh_Submit(device, 1, &commandBuffer);
+			if (gpuTimer != NULL)
+			{
+				GpuTimer_Begin(gpuTimer, resolution->current);
+			}
 
-			if (screenshotKey == 1)
+			/* Profiling times the render pass on its own, at the cost of a second submission */
+			if (gpuProfiler != NULL)
 			{
-				Refresh_Image_SavePNG("screenshot.png", windowWidth, windowHeight, screenshotPixels);
+				uint64_t passSubmitZone = TRACE_BEGIN();
+				CommandCapture_Submit(device, commandBufferCount, commandBuffers);
+				TRACE_END("Refresh_Submit", passSubmitZone);
+
+				GpuTimer_Mark(gpuTimer, computeActive ? computePasses[shaderQuality] : raymarchPasses[shaderQuality]);
+				commandBufferCount = 0;
 			}
 
-			MOJOSHADER_effectStateChanges stateChanges;
-			memset(&stateChanges, 0, sizeof(stateChanges));
-			FNA3D_ApplyEffect(fnaDevice, effect, 0, &stateChanges);
+			/* The tiled pass's last band belongs to a worker, so the copies get their own */
+			Refresh_CommandBuffer *commandBuffer;
+			if (commandBufferCount == 0 || tiledPass != NULL)
+			{
+				commandBuffer = CommandCapture_AcquireCommandBuffer(device, 0);
+				commandBuffers[commandBufferCount++] = commandBuffer;
+			}
+			else
+			{
+				commandBuffer = commandBuffers[commandBufferCount - 1];
+			}
 
-			FNA3D_SamplerState samplerState;
-			memset(&samplerState, 0, sizeof(samplerState));
-			samplerState.addressU = FNA3D_TEXTUREADDRESSMODE_CLAMP;
-			samplerState.addressV = FNA3D_TEXTUREADDRESSMODE_CLAMP;
-			samplerState.addressW = FNA3D_TEXTUREADDRESSMODE_WRAP;
-			samplerState.filter = FNA3D_TEXTUREFILTER_LINEAR;
-			samplerState.maxAnisotropy = 4;
-			samplerState.maxMipLevel = 0;
-			samplerState.mipMapLevelOfDetailBias = 0;
-			FNA3D_VerifySampler(fnaDevice, 0, externalTexture, &samplerState);
+			/* No-op unless the target was created with mips */
+			MipChain_Generate(device, commandBuffer, interopTarget->mipChain);
 
-			for (int i = 0; i < effectData->param_count; i++)
+			/* Frames drawn between updates would take the same screenshot again */
+			if (screenshotKey == 1 && updateThisLoop)
 			{
-				if (SDL_strcmp("MatrixTransform", effectData->params[i].value.name) == 0)
+				int32_t captureIndex = ReadbackRing_Capture(screenshotRing, commandBuffer, &interopTarget->slice);
+				if (captureIndex >= 0)
 				{
-					// OrthographicOffCenter Matrix - value copied from XNA project
-					// todo: Do I need to worry about row-major/column-major?
-					float projectionMatrix[16] =
-					{
-						0.0015625f,
-						0,
-						0,
-						-1,
-						0,
-						-0.00277777785f,
-						0,
-						1,
-						0,
-						0,
-						1,
-						0,
-						0,
-						0,
-						0,
-						1
-					};
-					SDL_memcpy(effectData->params[i].value.values, projectionMatrix, sizeof(float) * 16);
-					break;
+					SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "screenshot %d!", captureIndex);
+				}
+			}
+
+			if (captureStreamRing != NULL)
+			{
+				ReadbackRing_Capture(captureStreamRing, commandBuffer, &interopTarget->slice);
+			}
+
+			if (goldenFrame)
+			{
+				ReadbackRing_Capture(goldenRing, commandBuffer, &interopTarget->slice);
+			}
+
+			TRACE_END("command recording", recordZone);
+
+			uint64_t submitZone = TRACE_BEGIN();
+			CommandCapture_Submit(device, commandBufferCount, commandBuffers);
+			TRACE_END("Refresh_Submit", submitZone);
+
+			CommandCapture_EndFrame();
+
+			if (gpuProfiler != NULL)
+			{
+				GpuTimer_Mark(gpuTimer, copiesPass);
+			}
+			else if (gpuTimer != NULL)
+			{
+				GpuTimer_End(gpuTimer, 0);
+			}
+
+			ReadbackRing_Submitted(screenshotRing);
+
+			if (uniformBench != NULL)
+			{
+				UniformBench_Submitted(uniformBench);
+			}
+
+			if (captureStreamRing != NULL)
+			{
+				ReadbackRing_Submitted(captureStreamRing);
+			}
+
+			if (goldenFrame)
+			{
+				ReadbackRing_Submitted(goldenRing);
+			}
+
+			if (headless)
+			{
+				StateCache_SetRenderTargets(&stateCache, &offscreenTargetBinding, 1, NULL, FNA3D_DEPTHFORMAT_NONE, 0);
+				StateCache_SetViewport(&stateCache, &fnaViewport);
+				CommandCapture_FNA3D_Clear(fnaDevice, FNA3D_CLEAROPTIONS_TARGET, &offscreenClearColor, 0, 0);
+			}
+
+			/* FNA3D builds its VkPipeline on the first draw, which is where a warm cache pays off */
+			timingStart = SDL_GetPerformanceCounter();
+			uint64_t compositeZone = TRACE_BEGIN();
+
+			/* Stretches the rendered level over the whole drawable */
+			SpriteBatch_Begin(spriteBatch, SPRITE_SORT_DEFERRED, width, height);
+			SpriteBatch_Draw(
+				spriteBatch,
+				interopTarget->fnaTexture,
+				0.0f,
+				0.0f,
+				(float)width,
+				(float)height,
+				0.0f,
+				0.0f,
+				1.0f,
+				1.0f,
+				0xffffffff
+			);
+			SpriteBatch_End(spriteBatch);
+
+			TRACE_END("FNA3D composite", compositeZone);
+
+			if (!startupReported)
+			{
+				pipelineCacheTimings.fnaFirstDrawMilliseconds =
+					(SDL_GetPerformanceCounter() - timingStart) * 1000.0 / SDL_GetPerformanceFrequency();
+			}
+
+			if (spriteBench != NULL)
+			{
+				uint64_t spritesZone = TRACE_BEGIN();
+				SpriteBench_Draw(spriteBench, spriteBatch, renderTime);
+				TRACE_END("FNA3D sprites", spritesZone);
+			}
+
+			if (headless)
+			{
+				StateCache_SetRenderTargets(&stateCache, NULL, 0, NULL, FNA3D_DEPTHFORMAT_NONE, 0);
+
+				/* Reading a texel back waits on FNA3D's submission, which follows
+				 * Refresh's on the same queue, so the frame time covers the GPU
+				 * work of both passes instead of just the recording.
+				 */
+				uint64_t syncZone = TRACE_BEGIN();
+				CommandCapture_FNA3D_GetTextureData2D(fnaDevice, offscreenTarget, 0, 0, 1, 1, 0, &syncPixel, sizeof(syncPixel));
+				TRACE_END("FNA3D_GetTextureData2D", syncZone);
+
+				Benchmark_EndFrame(&benchmark);
+
+				if (benchmark.frameCount >= benchmarkFrameCount)
+				{
+					quit = true;
+				}
+
+				if (	comparePaths &&
+					raymarchCompute != NULL &&
+					benchmark.frameCount == benchmarkFrameCount / 2	)
+				{
+					computeActive = true;
 				}
 			}
+			else
+			{
+				FramePacer_BeginPresent(framePacer);
+
+				uint64_t swapZone = TRACE_BEGIN();
+				CommandCapture_FNA3D_SwapBuffers(fnaDevice, NULL, NULL, window);
+				TRACE_END("FNA3D_SwapBuffers", swapZone);
+
+				FramePacer_EndFrame(framePacer);
+			}
+
+			/* FNA3D submits its pass in SwapBuffers, or in GetTextureData2D when headless */
+			if (gpuProfiler != NULL)
+			{
+				GpuTimer_End(gpuTimer, fnaPass);
+			}
+
+			StateCache_EndFrame(&stateCache);
+
+			/* FNA3D has submitted its sampling of the target by now */
+			InteropTargets_Release(resolutionLevel->targets);
+
+			if (!startupReported)
+			{
+				Asset_Report(assets, STARTUP_ASSET_COUNT, startupTicks, reportOutput);
+				PipelineCache_Report(&pipelineCache, &pipelineCacheTimings, reportOutput);
+				GpuMemory_Report(&vulkanInterop, "startup", reportOutput);
+				fprintf(
+					reportOutput,
+					"raymarch pass: %dx%d for a %dx%d window\n",
+					width,
+					height,
+					windowWidth,
+					windowHeight
+				);
+				fprintf(
+					reportOutput,
+					"first frame submitted %.2f ms after startup\n",
+					(SDL_GetPerformanceCounter() - startupTicks) * 1000.0 / SDL_GetPerformanceFrequency()
+				);
+				startupReported = true;
+			}
+		}
+
+		TRACE_END("frame", frameZone);
+	}
+
+	/* Only headless runs time exactly the frames that were drawn */
+	double benchmarkSeconds = 0.0;
+	bool goldenPassed = true;
+
+	if (headless)
+	{
+		Benchmark_Report(&benchmark, "headless", reportOutput);
+		if (comparePaths && raymarchCompute != NULL)
+		{
+			Benchmark_ReportSplit(&benchmark, "seascape fragment", "seascape compute", benchmarkFrameCount / 2, reportOutput);
+		}
+
+		if (goldenBudgetMilliseconds > 0.0 && benchmark.frameCount > 0)
+		{
+			BenchmarkSummary summary;
+			Benchmark_Summarize(benchmark.frameTimes, benchmark.frameCount, &summary);
+			if (summary.median > goldenBudgetMilliseconds)
+			{
+				fprintf(
+					reportOutput,
+					"golden: median frame time %.2f ms is over the %.2f ms budget\n",
+					summary.median,
+					goldenBudgetMilliseconds
+				);
+				goldenPassed = false;
+			}
+		}
+		benchmarkSeconds = (benchmark.lastFrameEnd - benchmark.firstFrameStart) / (double) SDL_GetPerformanceFrequency();
+		Benchmark_Quit(&benchmark);
+
+		CommandCapture_FNA3D_AddDisposeTexture(fnaDevice, offscreenTarget);
+	}
+
+	if (spriteBench != NULL)
+	{
+		SpriteBench_Report(spriteBench, benchmarkSeconds, reportOutput);
+	}
+
+	if (uniformBench != NULL)
+	{
+		UniformBench_Report(uniformBench, reportOutput);
+	}
 
-			FNA3D_ApplyVertexBufferBindings(fnaDevice, &vertexBufferBinding, 1, 0, 0);
-			FNA3D_DrawPrimitives(fnaDevice, FNA3D_PRIMITIVETYPE_TRIANGLELIST, 0, 2);
+	StateCache_Report(&stateCache, reportOutput);
+	GpuMemory_Report(&vulkanInterop, "shutdown", reportOutput);
 
-			FNA3D_SwapBuffers(fnaDevice, NULL, NULL, window);
+	/* Waits for screenshots still being encoded */
+	ReadbackRing_Destroy(screenshotRing);
+	ScreenshotEncoder_Report(screenshotEncoder, reportOutput);
+	ScreenshotEncoder_Destroy(screenshotEncoder);
+
+	if (captureStreamRing != NULL)
+	{
+		if (captureStreamRing->stallCount > 0)
+		{
+			SDL_LogInfo(
+				SDL_LOG_CATEGORY_APPLICATION,
+				"capture stream: rendering waited on the writer %u times, %.1f ms total",
+				captureStreamRing->stallCount,
+				captureStreamRing->stallTicks * 1000.0 / SDL_GetPerformanceFrequency()
+			);
+		}
+
+		/* Drains every outstanding frame into the stream before it is closed */
+		ReadbackRing_Destroy(captureStreamRing);
+		CaptureStream_Close(captureStream);
+	}
+
+	if (goldenRing != NULL)
+	{
+		/* Waits for the last comparisons, the results are complete after this */
+		ReadbackRing_Destroy(goldenRing);
+		if (!Golden_Report(golden, reportOutput))
+		{
+			goldenPassed = false;
 		}
+		Golden_Destroy(golden);
+	}
+
+	uint32_t interopStallCount = 0;
+	uint64_t interopStallTicks = 0;
+	for (uint32_t i = 0; i < resolution->levelCount; i++)
+	{
+		interopStallCount += resolution->levels[i].targets->stallCount;
+		interopStallTicks += resolution->levels[i].targets->stallTicks;
+	}
+
+	if (interopStallCount > 0)
+	{
+		SDL_LogInfo(
+			SDL_LOG_CATEGORY_APPLICATION,
+			"interop targets: Refresh waited on FNA3D %u times, %.1f ms total",
+			interopStallCount,
+			interopStallTicks * 1000.0 / SDL_GetPerformanceFrequency()
+		);
 	}
 
-	SDL_free(screenshotPixels);
+	if (framePacer != NULL)
+	{
+		FramePacer_Report(framePacer, reportOutput);
+		FramePacer_Destroy(framePacer);
+	}
+
+	if (tiledPass != NULL)
+	{
+		TiledPass_Report(tiledPass, reportOutput);
+		TiledPass_Destroy(tiledPass);
+	}
+
+	if (raymarchCompute != NULL)
+	{
+		RaymarchCompute_Destroy(raymarchCompute);
+	}
 
-	Refresh_QueueDestroyColorTarget(device, mainColorTarget);
-	Refresh_QueueDestroyDepthStencilTarget(device, mainDepthStencilTarget);
+	if (checkerboardPass != NULL)
+	{
+		Checkerboard_Report(checkerboardPass, reportOutput);
+		Checkerboard_Destroy(checkerboardPass);
+		CommandCapture_QueueDestroyShaderModule(device, checkerboardResolveShaderModule);
+	}
+
+	if (gpuProfiler != NULL)
+	{
+		GpuProfiler_Report(gpuProfiler, reportOutput);
+		GpuProfiler_Destroy(gpuProfiler);
+	}
+
+	if (gpuTimer != NULL)
+	{
+		if (dynamicResolution)
+		{
+			DynamicResolution_Report(resolution, reportOutput);
+		}
+		GpuTimer_Destroy(gpuTimer);
+	}
+	DynamicResolution_Destroy(resolution);
 
-	Refresh_QueueDestroyTexture(device, woodTexture);
-	Refresh_QueueDestroyTexture(device, noiseTexture);
-	Refresh_QueueDestroyTexture(device, mainColorTargetTexture);
-	Refresh_QueueDestroySampler(device, sampler);
+	if (spriteBench != NULL)
+	{
+		SpriteBench_Destroy(spriteBench);
+	}
+	if (uniformBench != NULL)
+	{
+		UniformBench_Destroy(uniformBench);
+	}
+	SpriteBatch_Destroy(spriteBatch);
+	CommandCapture_FNA3D_AddDisposeEffect(fnaDevice, effect);
 
-	Refresh_QueueDestroyBuffer(device, vertexBuffer);
-	Refresh_QueueDestroyBuffer(device, screenshotBuffer);
+	GpuMemory_Remove(woodTexture);
+	CommandCapture_QueueDestroyTexture(device, woodTexture);
+	GpuMemory_Remove(noiseTexture);
+	CommandCapture_QueueDestroyTexture(device, noiseTexture);
+	CommandCapture_QueueDestroySampler(device, sampler);
 
-	Refresh_QueueDestroyGraphicsPipeline(device, raymarchPipeline);
+	GpuMemory_Remove(vertexBuffer);
+	CommandCapture_QueueDestroyBuffer(device, vertexBuffer);
 
-	Refresh_QueueDestroyShaderModule(device, passthroughVertexShaderModule);
-	Refresh_QueueDestroyShaderModule(device, raymarchFragmentShaderModule);
+	CommandCapture_QueueDestroyShaderModule(device, passthroughVertexShaderModule);
+	for (int i = 0; i < SHADER_QUALITY_COUNT; i++)
+	{
+		CommandCapture_QueueDestroyShaderModule(device, raymarchFragmentShaderModules[i]);
+		if (checkerboard)
+		{
+			CommandCapture_QueueDestroyShaderModule(device, checkerboardFragmentShaderModules[i]);
+		}
+	}
 
-	Refresh_QueueDestroyFramebuffer(device, mainFramebuffer);
-	Refresh_QueueDestroyRenderPass(device, mainRenderPass);
+	CommandCapture_QueueDestroyRenderPass(device, mainRenderPass);
 
+	CommandCapture_Close();
 	Refresh_DestroyDevice(device);
+	GpuMemory_Quit();
+
+	/* Writes the pipeline cache blob, then the device is gone */
+	FNA3D_DestroyDevice(fnaDevice);
+	PipelineCache_Commit(&pipelineCache);
+
+	VulkanInterop_Quit(&vulkanInterop);
+
+	JobSystem_Destroy(jobs);
+
+	if (tracePath != NULL)
+	{
+		Trace_Write(tracePath);
+	}
+	Trace_Quit();
 
 	SDL_DestroyWindow(window);
 	SDL_Quit();
 
-	return 0;
+	return goldenPassed ? 0 : -1;
 }
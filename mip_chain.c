@@ -0,0 +1,154 @@
+#include "mip_chain.h"
+
+#include <SDL.h>
+
+#include "command_capture.h"
+#include "gpu_memory.h"
+
+uint32_t MipChain_LevelCount(uint32_t width, uint32_t height)
+{
+	uint32_t levelCount = 1;
+
+	while ((width >> levelCount) > 0 || (height >> levelCount) > 0)
+	{
+		levelCount += 1;
+	}
+	return levelCount;
+}
+
+MipChain* MipChain_Create(
+	Refresh_Device *device,
+	Refresh_Texture *texture,
+	Refresh_ColorFormat format,
+	uint32_t width,
+	uint32_t height,
+	uint32_t levelCount
+) {
+	MipChain *mipChain = (MipChain*) SDL_malloc(sizeof(MipChain));
+
+	mipChain->texture = texture;
+	mipChain->width = width;
+	mipChain->height = height;
+	mipChain->levelCount = levelCount;
+	mipChain->scratch = NULL;
+
+	if (levelCount > 1)
+	{
+		mipChain->scratch = CommandCapture_CreateTexture2D(
+			device,
+			format,
+			SDL_max(1, width / 2),
+			SDL_max(1, height / 2),
+			levelCount - 1,
+			REFRESH_TEXTUREUSAGE_SAMPLER_BIT
+		);
+		GpuMemory_AddTexture(
+			mipChain->scratch,
+			format,
+			SDL_max(1, width / 2),
+			SDL_max(1, height / 2),
+			levelCount - 1,
+			REFRESH_TEXTUREUSAGE_SAMPLER_BIT
+		);
+	}
+
+	return mipChain;
+}
+
+static void MipChain_Slice(
+	Refresh_TextureSlice *slice,
+	Refresh_Texture *texture,
+	uint32_t level,
+	uint32_t width,
+	uint32_t height
+) {
+	slice->texture = texture;
+	slice->rectangle.x = 0;
+	slice->rectangle.y = 0;
+	slice->rectangle.w = width;
+	slice->rectangle.h = height;
+	slice->depth = 0;
+	slice->layer = 0;
+	slice->level = level;
+}
+
+void MipChain_Generate(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	MipChain *mipChain
+) {
+	if (mipChain->scratch == NULL)
+	{
+		return;
+	}
+
+	Refresh_TextureSlice source, destination;
+	uint32_t width = mipChain->width;
+	uint32_t height = mipChain->height;
+
+	/* Level n is filtered from level n - 1, which lives in the other texture */
+	for (uint32_t level = 1; level < mipChain->levelCount; level++)
+	{
+		if (level % 2 == 1)
+		{
+			MipChain_Slice(&source, mipChain->texture, level - 1, width, height);
+		}
+		else
+		{
+			MipChain_Slice(&source, mipChain->scratch, level - 2, width, height);
+		}
+
+		width = SDL_max(1, width / 2);
+		height = SDL_max(1, height / 2);
+
+		if (level % 2 == 1)
+		{
+			MipChain_Slice(&destination, mipChain->scratch, level - 1, width, height);
+		}
+		else
+		{
+			MipChain_Slice(&destination, mipChain->texture, level, width, height);
+		}
+
+		CommandCapture_CopyTextureToTexture(
+			device,
+			commandBuffer,
+			&source,
+			&destination,
+			REFRESH_FILTER_LINEAR
+		);
+	}
+
+	/* Odd levels are a quarter of the texels or less, copying them back is cheap */
+	width = mipChain->width;
+	height = mipChain->height;
+	for (uint32_t level = 1; level < mipChain->levelCount; level++)
+	{
+		width = SDL_max(1, width / 2);
+		height = SDL_max(1, height / 2);
+
+		if (level % 2 == 1)
+		{
+			MipChain_Slice(&source, mipChain->scratch, level - 1, width, height);
+			MipChain_Slice(&destination, mipChain->texture, level, width, height);
+
+			CommandCapture_CopyTextureToTexture(
+				device,
+				commandBuffer,
+				&source,
+				&destination,
+				REFRESH_FILTER_NEAREST
+			);
+		}
+	}
+}
+
+void MipChain_Destroy(Refresh_Device *device, MipChain *mipChain)
+{
+	if (mipChain->scratch != NULL)
+	{
+		GpuMemory_Remove(mipChain->scratch);
+		CommandCapture_QueueDestroyTexture(device, mipChain->scratch);
+	}
+	SDL_free(mipChain);
+}
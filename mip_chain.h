@@ -0,0 +1,52 @@
+#ifndef MIP_CHAIN_H
+#define MIP_CHAIN_H
+
+/* GPU mip generation with linear-filtered blits.
+ *
+ * Refresh tracks one layout per texture, so a blit between two levels of
+ * the same texture would read from an image in TRANSFER_DST layout. Each
+ * chain instead owns a half-size scratch texture and alternates between
+ * the two: even levels are written into the texture, odd levels into the
+ * scratch and copied across at the end. No blit ever has the same texture
+ * as its source and destination.
+ *
+ * Only uncompressed formats can be blit destinations; BCn textures carry
+ * their mips from TextureConverter.
+ */
+
+#include <stdint.h>
+
+#include <Refresh.h>
+
+typedef struct MipChain
+{
+	Refresh_Texture *texture;
+	Refresh_Texture *scratch;	/* scratch level i mirrors texture level i + 1 */
+	uint32_t width;
+	uint32_t height;
+	uint32_t levelCount;
+} MipChain;
+
+/* Levels in a full chain down to 1x1 */
+uint32_t MipChain_LevelCount(uint32_t width, uint32_t height);
+
+/* texture must have been created with levelCount levels */
+MipChain* MipChain_Create(
+	Refresh_Device *device,
+	Refresh_Texture *texture,
+	Refresh_ColorFormat format,
+	uint32_t width,
+	uint32_t height,
+	uint32_t levelCount
+);
+
+/* Rebuilds levels 1 and up from level 0. Record outside of a render pass. */
+void MipChain_Generate(
+	Refresh_Device *device,
+	Refresh_CommandBuffer *commandBuffer,
+	MipChain *mipChain
+);
+
+void MipChain_Destroy(Refresh_Device *device, MipChain *mipChain);
+
+#endif /* MIP_CHAIN_H */
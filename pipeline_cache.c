@@ -0,0 +1,235 @@
+#include "pipeline_cache.h"
+
+#include <SDL.h>
+
+#define PIPELINE_CACHE_HINT "FNA3D_VULKAN_PIPELINE_CACHE_FILE_NAME"
+#define PIPELINE_CACHE_MAGIC 0x48435052 /* "RPCH" */
+#define PIPELINE_CACHE_VERSION 1
+
+/* Fixed layout written next to the blob. Host endianness is fine here, the
+ * blob itself is only valid on the machine that produced it anyway.
+ */
+typedef struct PipelineCacheHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	PipelineCacheKey key;
+	uint64_t blobSize;
+	uint32_t blobCRC;
+} PipelineCacheHeader;
+
+/* Start of the blob as defined by VK_PIPELINE_CACHE_HEADER_VERSION_ONE */
+typedef struct VulkanPipelineCacheHeader
+{
+	uint32_t headerSize;
+	uint32_t headerVersion;
+	uint32_t vendorID;
+	uint32_t deviceID;
+	uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+} VulkanPipelineCacheHeader;
+
+static uint32_t PipelineCache_CRC32(const uint8_t *data, size_t size)
+{
+	static uint32_t table[256];
+	static uint8_t tableReady = 0;
+
+	if (!tableReady)
+	{
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			uint32_t c = i;
+			for (uint32_t j = 0; j < 8; j++)
+			{
+				c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+			}
+			table[i] = c;
+		}
+		tableReady = 1;
+	}
+
+	uint32_t crc = 0xFFFFFFFF;
+	for (size_t i = 0; i < size; i++)
+	{
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return crc ^ 0xFFFFFFFF;
+}
+
+static const char* PipelineCache_StateString(PipelineCacheState state)
+{
+	switch (state)
+	{
+	case PIPELINE_CACHE_DISABLED: return "disabled";
+	case PIPELINE_CACHE_MISSING: return "cold (no cache file)";
+	case PIPELINE_CACHE_CORRUPT: return "cold (cache file corrupt, deleted)";
+	case PIPELINE_CACHE_STALE: return "cold (cache file from another device or driver)";
+	case PIPELINE_CACHE_WARM: return "warm";
+	default: return "unknown";
+	}
+}
+
+void PipelineCache_Prepare(PipelineCache *cache, const char *blobPath)
+{
+	SDL_memset(cache, 0, sizeof(PipelineCache));
+
+	if (blobPath == NULL)
+	{
+		/* An empty name stops FNA3D from both loading and saving */
+		SDL_SetHint(PIPELINE_CACHE_HINT, "");
+		cache->state = PIPELINE_CACHE_DISABLED;
+		return;
+	}
+
+	SDL_snprintf(cache->blobPath, sizeof(cache->blobPath), "%s", blobPath);
+	SDL_snprintf(cache->headerPath, sizeof(cache->headerPath), "%s.header", blobPath);
+	SDL_SetHint(PIPELINE_CACHE_HINT, cache->blobPath);
+
+	size_t blobSize;
+	uint8_t *blob = (uint8_t*) SDL_LoadFile(cache->blobPath, &blobSize);
+	if (blob == NULL)
+	{
+		cache->state = PIPELINE_CACHE_MISSING;
+		return;
+	}
+
+	cache->state = PIPELINE_CACHE_CORRUPT;
+
+	size_t headerSize;
+	void *headerData = SDL_LoadFile(cache->headerPath, &headerSize);
+	if (headerData != NULL && headerSize == sizeof(PipelineCacheHeader))
+	{
+		PipelineCacheHeader header;
+		SDL_memcpy(&header, headerData, sizeof(PipelineCacheHeader));
+		if (	header.magic == PIPELINE_CACHE_MAGIC &&
+			header.version == PIPELINE_CACHE_VERSION &&
+			header.blobSize == blobSize &&
+			blobSize >= sizeof(VulkanPipelineCacheHeader)	)
+		{
+			VulkanPipelineCacheHeader vulkanHeader;
+			SDL_memcpy(&vulkanHeader, blob, sizeof(VulkanPipelineCacheHeader));
+			if (	vulkanHeader.headerSize >= sizeof(VulkanPipelineCacheHeader) &&
+				vulkanHeader.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+				vulkanHeader.vendorID == header.key.vendorID &&
+				vulkanHeader.deviceID == header.key.deviceID &&
+				SDL_memcmp(vulkanHeader.pipelineCacheUUID, header.key.pipelineCacheUUID, VK_UUID_SIZE) == 0 &&
+				PipelineCache_CRC32(blob, blobSize) == header.blobCRC	)
+			{
+				cache->state = PIPELINE_CACHE_WARM;
+				cache->blobSize = blobSize;
+				cache->storedKey = header.key;
+			}
+		}
+	}
+	SDL_free(headerData);
+	SDL_free(blob);
+
+	if (cache->state == PIPELINE_CACHE_CORRUPT)
+	{
+		/* Never hand the driver a blob we can't vouch for */
+		remove(cache->blobPath);
+		remove(cache->headerPath);
+		SDL_LogWarn(
+			SDL_LOG_CATEGORY_APPLICATION,
+			"Discarded corrupt pipeline cache %s",
+			cache->blobPath
+		);
+	}
+}
+
+void PipelineCache_BindDevice(PipelineCache *cache, VulkanInterop *interop)
+{
+	VkPhysicalDeviceProperties properties;
+
+	interop->vkGetPhysicalDeviceProperties(interop->physicalDevice, &properties);
+
+	cache->deviceKey.vendorID = properties.vendorID;
+	cache->deviceKey.deviceID = properties.deviceID;
+	cache->deviceKey.driverVersion = properties.driverVersion;
+	SDL_memcpy(cache->deviceKey.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+	/* The driver ignores a mismatched blob on its own, this just reports it.
+	 * FNA3D overwrites it with one for this device on shutdown.
+	 */
+	if (	cache->state == PIPELINE_CACHE_WARM &&
+		SDL_memcmp(&cache->storedKey, &cache->deviceKey, sizeof(PipelineCacheKey)) != 0	)
+	{
+		cache->state = PIPELINE_CACHE_STALE;
+	}
+}
+
+void PipelineCache_Commit(PipelineCache *cache)
+{
+	if (cache->state == PIPELINE_CACHE_DISABLED)
+	{
+		return;
+	}
+
+	size_t blobSize;
+	uint8_t *blob = (uint8_t*) SDL_LoadFile(cache->blobPath, &blobSize);
+	if (blob == NULL)
+	{
+		SDL_LogWarn(
+			SDL_LOG_CATEGORY_APPLICATION,
+			"Pipeline cache %s was not written",
+			cache->blobPath
+		);
+		return;
+	}
+
+	PipelineCacheHeader header;
+	SDL_memset(&header, 0, sizeof(PipelineCacheHeader));
+	header.magic = PIPELINE_CACHE_MAGIC;
+	header.version = PIPELINE_CACHE_VERSION;
+	header.key = cache->deviceKey;
+	header.blobSize = blobSize;
+	header.blobCRC = PipelineCache_CRC32(blob, blobSize);
+	SDL_free(blob);
+
+	/* Write then rename, so a crash here leaves no header rather than a bad one */
+	char temporaryPath[sizeof(cache->headerPath) + 4];
+	SDL_snprintf(temporaryPath, sizeof(temporaryPath), "%s.tmp", cache->headerPath);
+	FILE *file = fopen(temporaryPath, "wb");
+	if (file == NULL)
+	{
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Could not write %s", temporaryPath);
+		return;
+	}
+	if (fwrite(&header, sizeof(PipelineCacheHeader), 1, file) != 1)
+	{
+		fclose(file);
+		remove(temporaryPath);
+		return;
+	}
+	fclose(file);
+
+	remove(cache->headerPath);
+	if (rename(temporaryPath, cache->headerPath) != 0)
+	{
+		remove(temporaryPath);
+	}
+}
+
+void PipelineCache_Report(
+	PipelineCache *cache,
+	PipelineCacheTimings *timings,
+	FILE *output
+) {
+	fprintf(
+		output,
+		"pipeline cache: %s",
+		PipelineCache_StateString(cache->state)
+	);
+	if (cache->state == PIPELINE_CACHE_WARM)
+	{
+		fprintf(output, ", %llu KB", (unsigned long long) (cache->blobSize / 1024));
+	}
+	fprintf(output, "\n");
+
+	fprintf(
+		output,
+		"  Refresh_CreateGraphicsPipeline %.2f ms, FNA3D_CreateEffect %.2f ms, first FNA3D draw %.2f ms\n",
+		timings->refreshPipelineMilliseconds,
+		timings->fnaEffectMilliseconds,
+		timings->fnaFirstDrawMilliseconds
+	);
+}
@@ -0,0 +1,73 @@
+#ifndef PIPELINE_CACHE_H
+#define PIPELINE_CACHE_H
+
+/* Persistent pipeline cache for the shared Vulkan device.
+ *
+ * FNA3D already loads a VkPipelineCache blob at device creation and writes
+ * it back in FNA3D_DestroyDevice, using the file named by the
+ * FNA3D_VULKAN_PIPELINE_CACHE_FILE_NAME hint. This wraps that blob with a
+ * header file recording the device it came from and a CRC of its contents,
+ * so a truncated or corrupted blob is deleted before the driver ever sees
+ * it, and a blob from another GPU or driver version is reported as stale.
+ *
+ * Refresh has no pipeline cache hook, so Refresh_CreateGraphicsPipeline only
+ * benefits from whatever implicit cache the driver keeps.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "vulkan_interop.h"
+
+typedef enum PipelineCacheState
+{
+	PIPELINE_CACHE_DISABLED,
+	PIPELINE_CACHE_MISSING,
+	PIPELINE_CACHE_CORRUPT,		/* header or CRC check failed, blob deleted */
+	PIPELINE_CACHE_STALE,		/* valid, but written by another device or driver */
+	PIPELINE_CACHE_WARM
+} PipelineCacheState;
+
+typedef struct PipelineCacheKey
+{
+	uint32_t vendorID;
+	uint32_t deviceID;
+	uint32_t driverVersion;
+	uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+} PipelineCacheKey;
+
+typedef struct PipelineCache
+{
+	char blobPath[256];
+	char headerPath[256];
+
+	PipelineCacheState state;
+	uint64_t blobSize;
+
+	PipelineCacheKey storedKey;
+	PipelineCacheKey deviceKey;
+} PipelineCache;
+
+typedef struct PipelineCacheTimings
+{
+	double refreshPipelineMilliseconds;
+	double fnaEffectMilliseconds;
+	double fnaFirstDrawMilliseconds;	/* FNA3D builds its pipelines lazily at draw time */
+} PipelineCacheTimings;
+
+/* Call before FNA3D_CreateDevice. A NULL path disables the cache. */
+void PipelineCache_Prepare(PipelineCache *cache, const char *blobPath);
+
+/* Call once the device exists, to check the blob against it */
+void PipelineCache_BindDevice(PipelineCache *cache, VulkanInterop *interop);
+
+/* Call after FNA3D_DestroyDevice has written the blob back */
+void PipelineCache_Commit(PipelineCache *cache);
+
+void PipelineCache_Report(
+	PipelineCache *cache,
+	PipelineCacheTimings *timings,
+	FILE *output
+);
+
+#endif /* PIPELINE_CACHE_H */
@@ -0,0 +1,80 @@
+#include "raymarch_compute.h"
+
+#include <SDL.h>
+
+#include "command_capture.h"
+
+RaymarchCompute* RaymarchCompute_Create(
+	Refresh_Device *device,
+	const uint32_t *code,
+	size_t codeSize,
+	const SpecializationConstant *constants,
+	uint32_t constantCount,
+	uint32_t pipelineCount,
+	uint32_t uniformBufferSize
+) {
+	RaymarchCompute *compute = SDL_malloc(sizeof(RaymarchCompute));
+	SDL_memset(compute, 0, sizeof(RaymarchCompute));
+
+	compute->device = device;
+	compute->pipelineCount = SDL_min(pipelineCount, RAYMARCH_COMPUTE_PIPELINES_MAX);
+
+	for (uint32_t i = 0; i < compute->pipelineCount; i++)
+	{
+		compute->shaderModules[i] = Specialization_CreateShaderModule(
+			device,
+			code,
+			codeSize,
+			&constants[i * constantCount],
+			constantCount
+		);
+
+		/* set 1 holds the one storage image, set 2 the uniforms */
+		Refresh_ComputePipelineCreateInfo pipelineCreateInfo;
+		pipelineCreateInfo.computeShaderState.shaderModule = compute->shaderModules[i];
+		pipelineCreateInfo.computeShaderState.entryPointName = "main";
+		pipelineCreateInfo.computeShaderState.uniformBufferSize = uniformBufferSize;
+		pipelineCreateInfo.pipelineLayoutCreateInfo.bufferBindingCount = 0;
+		pipelineCreateInfo.pipelineLayoutCreateInfo.imageBindingCount = 1;
+
+		compute->pipelines[i] = CommandCapture_CreateComputePipeline(device, &pipelineCreateInfo);
+	}
+
+	return compute;
+}
+
+void RaymarchCompute_Destroy(RaymarchCompute *compute)
+{
+	for (uint32_t i = 0; i < compute->pipelineCount; i++)
+	{
+		CommandCapture_QueueDestroyComputePipeline(compute->device, compute->pipelines[i]);
+		CommandCapture_QueueDestroyShaderModule(compute->device, compute->shaderModules[i]);
+	}
+
+	SDL_free(compute);
+}
+
+void RaymarchCompute_Record(
+	RaymarchCompute *compute,
+	Refresh_CommandBuffer *commandBuffer,
+	uint32_t pipeline,
+	Refresh_Texture *target,
+	uint32_t width,
+	uint32_t height,
+	void *uniforms
+) {
+	Refresh_Device *device = compute->device;
+
+	CommandCapture_BindComputePipeline(device, commandBuffer, compute->pipelines[pipeline]);
+	CommandCapture_BindComputeTextures(device, commandBuffer, &target);
+
+	uint32_t computeParamOffset = CommandCapture_PushComputeShaderParams(device, commandBuffer, uniforms, 1);
+	CommandCapture_DispatchCompute(
+		device,
+		commandBuffer,
+		(width + RAYMARCH_COMPUTE_TILE - 1) / RAYMARCH_COMPUTE_TILE,
+		(height + RAYMARCH_COMPUTE_TILE - 1) / RAYMARCH_COMPUTE_TILE,
+		1,
+		computeParamOffset
+	);
+}
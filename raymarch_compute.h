@@ -0,0 +1,58 @@
+#ifndef RAYMARCH_COMPUTE_H
+#define RAYMARCH_COMPUTE_H
+
+/* --compute: the seascape raymarch as a compute shader, dispatched over
+ * 8x8 tiles straight into the interop target, which FNA3D samples as
+ * before. Tiles whose rays all point above the horizon are sky and skip the
+ * tracing as a whole, decided through group-shared memory.
+ *
+ * Refresh's compute pipelines bind storage images and buffers but no
+ * samplers, so only the seascape, which reads no textures, has a compute
+ * path. There is no viewport either: each level is covered by dispatching
+ * enough tiles, and the shader skips pixels past the image's edge.
+ */
+
+#include <stdint.h>
+
+#include <Refresh.h>
+
+#include "specialization.h"
+
+#define RAYMARCH_COMPUTE_TILE 8
+#define RAYMARCH_COMPUTE_PIPELINES_MAX 4
+
+typedef struct RaymarchCompute
+{
+	Refresh_Device *device;
+	Refresh_ShaderModule *shaderModules[RAYMARCH_COMPUTE_PIPELINES_MAX];
+	Refresh_ComputePipeline *pipelines[RAYMARCH_COMPUTE_PIPELINES_MAX];
+	uint32_t pipelineCount;
+} RaymarchCompute;
+
+/* Pipeline i is the module specialized with constants[i], each an array of
+ * constantCount
+ */
+RaymarchCompute* RaymarchCompute_Create(
+	Refresh_Device *device,
+	const uint32_t *code,
+	size_t codeSize,
+	const SpecializationConstant *constants,
+	uint32_t constantCount,
+	uint32_t pipelineCount,
+	uint32_t uniformBufferSize
+);
+
+void RaymarchCompute_Destroy(RaymarchCompute *compute);
+
+/* Writes every pixel of a width x height target, outside of any render pass */
+void RaymarchCompute_Record(
+	RaymarchCompute *compute,
+	Refresh_CommandBuffer *commandBuffer,
+	uint32_t pipeline,
+	Refresh_Texture *target,
+	uint32_t width,
+	uint32_t height,
+	void *uniforms
+);
+
+#endif /* RAYMARCH_COMPUTE_H */
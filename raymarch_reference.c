@@ -0,0 +1,312 @@
+/* RaymarchReference: renders a raymarch scene on the CPU, see cpu_raymarch.h,
+ * for checking RefreshTest's output and timing shading where there is no
+ * Vulkan at all.
+ *
+ * usage: RaymarchReference [--scene hexagon_grid|seascape|color_phase]
+ *        [--quality low|medium|high] [--size WxH] [--time T] [--frames N] [--threads N] [--scaling]
+ *        [--kernel scalar|sse4.1|avx2] [--output PATH] [--compare PATH] [--min-psnr DB]
+ *
+ * The frame is rendered --frames times and the median time reported as
+ * Mpixels/s; --scaling repeats that with 1, 2, 4 ... workers up to one per
+ * core. --compare checks the frame against a PNG of the same size, a
+ * RefreshTest --golden image or screenshot taken at the same time, and
+ * exits with -1 if its PSNR is under --min-psnr.
+ *
+ * woodgrain.png and noise.png are read from the working directory, like
+ * RefreshTest reads its assets.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <SDL.h>
+
+#include <Refresh_Image.h>
+
+#include "benchmark.h"
+#include "cpu_raymarch.h"
+#include "image_diff.h"
+
+#define REFERENCE_TOLERANCE 8
+
+static uint8_t LoadTexture(const char *path, CpuRaymarchTexture *texture)
+{
+	int32_t width, height, channelCount;
+	uint8_t *pixels = Refresh_Image_Load(path, &width, &height, &channelCount);
+	if (pixels == NULL)
+	{
+		fprintf(stderr, "Failed to load %s\n", path);
+		return 0;
+	}
+
+	texture->pixels = pixels;
+	texture->width = width;
+	texture->height = height;
+	return 1;
+}
+
+/* Median frame time in milliseconds */
+static double TimeFrames(CpuRaymarch *cpu, const CpuRaymarchFrame *frame, uint32_t frameCount)
+{
+	Benchmark benchmark;
+	Benchmark_Init(&benchmark, frameCount);
+
+	for (uint32_t i = 0; i < frameCount; i++)
+	{
+		Benchmark_BeginFrame(&benchmark);
+		CpuRaymarch_Render(cpu, frame);
+		Benchmark_EndFrame(&benchmark);
+	}
+
+	BenchmarkSummary summary;
+	Benchmark_Summarize(benchmark.frameTimes, benchmark.frameCount, &summary);
+	Benchmark_Quit(&benchmark);
+
+	return summary.median;
+}
+
+int main(int argc, char *argv[])
+{
+	RaymarchScene scene = RAYMARCH_SCENE_HEXAGON_GRID;
+	ShaderQuality shaderQuality = SHADER_QUALITY_HIGH;
+	uint32_t width = 640;
+	uint32_t height = 360;
+	float time = 3.0f;
+	uint32_t frameCount = 3;
+	uint32_t threadCount = 0;
+	uint8_t scaling = 0;
+	CpuRaymarchKernel maxKernel = CPU_RAYMARCH_KERNEL_AVX2;
+	const char *outputPath = NULL;
+	const char *comparePath = NULL;
+	double minPsnr = 30.0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (SDL_strcmp(argv[i], "--scene") == 0 && i + 1 < argc)
+		{
+			i++;
+			uint32_t j;
+			for (j = 0; j < RAYMARCH_SCENE_COUNT; j++)
+			{
+				if (SDL_strcmp(argv[i], raymarchSceneNames[j]) == 0)
+				{
+					scene = (RaymarchScene) j;
+					break;
+				}
+			}
+			if (j == RAYMARCH_SCENE_COUNT)
+			{
+				fprintf(stderr, "Unknown scene %s\n", argv[i]);
+				return -1;
+			}
+		}
+		else if (SDL_strcmp(argv[i], "--quality") == 0 && i + 1 < argc)
+		{
+			i++;
+			uint32_t j;
+			for (j = 0; j < SHADER_QUALITY_COUNT; j++)
+			{
+				if (SDL_strcmp(argv[i], shaderQualityNames[j]) == 0)
+				{
+					shaderQuality = (ShaderQuality) j;
+					break;
+				}
+			}
+			if (j == SHADER_QUALITY_COUNT)
+			{
+				fprintf(stderr, "Unknown quality %s\n", argv[i]);
+				return -1;
+			}
+		}
+		else if (SDL_strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+		{
+			if (SDL_sscanf(argv[++i], "%ux%u", &width, &height) != 2 || width == 0 || height == 0)
+			{
+				fprintf(stderr, "--size must look like 640x360\n");
+				return -1;
+			}
+		}
+		else if (SDL_strcmp(argv[i], "--time") == 0 && i + 1 < argc)
+		{
+			time = (float) SDL_atof(argv[++i]);
+		}
+		else if (SDL_strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+		{
+			frameCount = SDL_atoi(argv[++i]);
+			if (frameCount == 0)
+			{
+				fprintf(stderr, "--frames must be greater than zero\n");
+				return -1;
+			}
+		}
+		else if (SDL_strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+		{
+			threadCount = SDL_atoi(argv[++i]);
+		}
+		else if (SDL_strcmp(argv[i], "--scaling") == 0)
+		{
+			scaling = 1;
+		}
+		else if (SDL_strcmp(argv[i], "--kernel") == 0 && i + 1 < argc)
+		{
+			i++;
+			uint32_t j;
+			for (j = 0; j < CPU_RAYMARCH_KERNEL_COUNT; j++)
+			{
+				if (SDL_strcmp(argv[i], CpuRaymarch_KernelName((CpuRaymarchKernel) j)) == 0)
+				{
+					maxKernel = (CpuRaymarchKernel) j;
+					break;
+				}
+			}
+			if (j == CPU_RAYMARCH_KERNEL_COUNT)
+			{
+				fprintf(stderr, "Unknown kernel %s\n", argv[i]);
+				return -1;
+			}
+		}
+		else if (SDL_strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+		{
+			outputPath = argv[++i];
+		}
+		else if (SDL_strcmp(argv[i], "--compare") == 0 && i + 1 < argc)
+		{
+			comparePath = argv[++i];
+		}
+		else if (SDL_strcmp(argv[i], "--min-psnr") == 0 && i + 1 < argc)
+		{
+			minPsnr = SDL_atof(argv[++i]);
+		}
+		else
+		{
+			printf("usage: %s [--scene hexagon_grid|seascape|color_phase]\n", argv[0]);
+			printf("       [--quality low|medium|high] [--size WxH] [--time T] [--frames N] [--threads N] [--scaling]\n");
+			printf("       [--kernel scalar|sse4.1|avx2] [--output PATH] [--compare PATH] [--min-psnr DB]\n");
+			return SDL_strcmp(argv[i], "--help") == 0 ? 0 : -1;
+		}
+	}
+
+	CpuRaymarchFrame frame;
+	SDL_memset(&frame, 0, sizeof(frame));
+	frame.scene = scene;
+	frame.constants = raymarchQualityConstants[scene][shaderQuality];
+	frame.uniforms.time = time;
+	frame.uniforms.resolutionX = (float) width;
+	frame.uniforms.resolutionY = (float) height;
+	frame.pixels = SDL_malloc(width * height * 4);
+
+	if (	!LoadTexture("woodgrain.png", &frame.wood) ||
+		!LoadTexture("noise.png", &frame.noise)	)
+	{
+		return -1;
+	}
+
+	uint32_t coreCount = SDL_GetCPUCount();
+	if (threadCount == 0)
+	{
+		threadCount = coreCount;
+	}
+
+	printf(
+		"%s %s, %ux%u at t = %.2f\n",
+		raymarchSceneNames[scene],
+		shaderQualityNames[shaderQuality],
+		width,
+		height,
+		time
+	);
+
+	/* One worker count, or doubling up to the core count and the core count itself */
+	double singleThreadMilliseconds = 0.0;
+	uint32_t workers = scaling ? 1 : threadCount;
+	while (1)
+	{
+		JobSystem *jobs = JobSystem_Create(workers);
+		CpuRaymarch *cpu = CpuRaymarch_Create(jobs, maxKernel);
+
+		double milliseconds = TimeFrames(cpu, &frame, frameCount);
+		if (workers == 1)
+		{
+			singleThreadMilliseconds = milliseconds;
+		}
+
+		printf(
+			"  %s, %2u threads: %9.2f ms  %7.3f Mpixels/s",
+			CpuRaymarch_KernelName(cpu->kernel),
+			workers,
+			milliseconds,
+			width * height / (milliseconds * 1000.0)
+		);
+		if (singleThreadMilliseconds > 0.0 && workers > 1)
+		{
+			printf("  %5.2fx", singleThreadMilliseconds / milliseconds);
+		}
+		printf("\n");
+
+		CpuRaymarch_Destroy(cpu);
+		JobSystem_Destroy(jobs);
+
+		if (!scaling || workers >= coreCount)
+		{
+			break;
+		}
+		workers = SDL_min(workers * 2, coreCount);
+	}
+
+	if (outputPath != NULL)
+	{
+		Refresh_Image_SavePNG(outputPath, width, height, frame.pixels);
+	}
+
+	int result = 0;
+	if (comparePath != NULL)
+	{
+		int32_t compareWidth, compareHeight, channelCount;
+		uint8_t *comparePixels = Refresh_Image_Load(comparePath, &compareWidth, &compareHeight, &channelCount);
+
+		if (comparePixels == NULL)
+		{
+			fprintf(stderr, "Failed to load %s\n", comparePath);
+			result = -1;
+		}
+		else if ((uint32_t) compareWidth != width || (uint32_t) compareHeight != height)
+		{
+			fprintf(stderr, "%s is %dx%d, not %ux%u\n", comparePath, compareWidth, compareHeight, width, height);
+			result = -1;
+		}
+		else
+		{
+			uint8_t *diffPixels = SDL_malloc(width * height * 4);
+			ImageDiffResult diff;
+			ImageDiff_Compare(frame.pixels, comparePixels, width * height, REFERENCE_TOLERANCE, diffPixels, &diff);
+
+			printf(
+				"%s: %.2f%% of pixels off by more than %d, max %u, PSNR %.2f dB\n",
+				comparePath,
+				diff.failedPixelCount * 100.0 / diff.pixelCount,
+				REFERENCE_TOLERANCE,
+				diff.maxDifference,
+				diff.psnr
+			);
+
+			if (diff.psnr < minPsnr)
+			{
+				printf("under the %.2f dB minimum\n", minPsnr);
+				result = -1;
+			}
+
+			SDL_free(diffPixels);
+		}
+
+		if (comparePixels != NULL)
+		{
+			Refresh_Image_Free(comparePixels);
+		}
+	}
+
+	Refresh_Image_Free((uint8_t*) frame.wood.pixels);
+	Refresh_Image_Free((uint8_t*) frame.noise.pixels);
+	SDL_free(frame.pixels);
+
+	return result;
+}
@@ -0,0 +1,40 @@
+#include "raymarch_scenes.h"
+
+const char *shaderQualityNames[SHADER_QUALITY_COUNT] =
+{
+	"low", "medium", "high"
+};
+
+const char *raymarchSceneNames[RAYMARCH_SCENE_COUNT] =
+{
+	"hexagon_grid", "seascape", "color_phase"
+};
+
+const SpecializationConstant raymarchQualityConstants[RAYMARCH_SCENE_COUNT][SHADER_QUALITY_COUNT][RAYMARCH_QUALITY_CONSTANT_COUNT] =
+{
+	{
+		{ { 0, 1 }, { 1, 48 } },
+		{ { 0, 1 }, { 1, 100 } },
+		{ { 0, 2 }, { 1, 100 } }
+	},
+	{
+		{ { 0, 4 }, { 1, 2 }, { 2, 3 } },
+		{ { 0, 6 }, { 1, 3 }, { 2, 4 } },
+		{ { 0, 8 }, { 1, 3 }, { 2, 5 } }
+	},
+	{
+		{ { 0 } },
+		{ { 0 } },
+		{ { 0 } }
+	}
+};
+
+const uint32_t raymarchQualityConstantCounts[RAYMARCH_SCENE_COUNT] =
+{
+	2, 3, 0
+};
+
+const uint32_t raymarchCheckerboardConstantIds[RAYMARCH_SCENE_COUNT] =
+{
+	2, 3, 0
+};
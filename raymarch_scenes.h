@@ -0,0 +1,63 @@
+#ifndef RAYMARCH_SCENES_H
+#define RAYMARCH_SCENES_H
+
+/* The raymarch scenes and their quality tiers, shared by RefreshTest's
+ * GPU passes and the CPU reference renderer (cpu_raymarch.h), so both
+ * draw the same thing from the same uniforms.
+ */
+
+#include <stdint.h>
+
+#include "specialization.h"
+
+/* Matches the shaders' UniformBlock; seascape.comp skips checkerboardPhase,
+ * std140 puts its vec2 resolution at the same offset anyway
+ */
+typedef struct RaymarchUniforms
+{
+	float time, checkerboardPhase;
+	float resolutionX, resolutionY;
+} RaymarchUniforms;
+
+typedef enum ShaderQuality
+{
+	SHADER_QUALITY_LOW,
+	SHADER_QUALITY_MEDIUM,
+	SHADER_QUALITY_HIGH,
+	SHADER_QUALITY_COUNT
+} ShaderQuality;
+
+typedef enum RaymarchScene
+{
+	RAYMARCH_SCENE_HEXAGON_GRID,
+	RAYMARCH_SCENE_SEASCAPE,
+	RAYMARCH_SCENE_COLOR_PHASE,
+	RAYMARCH_SCENE_COUNT
+} RaymarchScene;
+
+/* The most quality constants a scene has */
+#define RAYMARCH_QUALITY_CONSTANT_COUNT 3
+
+extern const char *shaderQualityNames[SHADER_QUALITY_COUNT];
+extern const char *raymarchSceneNames[RAYMARCH_SCENE_COUNT];
+
+/* hexagon_grid.frag constant_id 0 is AA, the samples per axis, and
+ * constant_id 1 is RAY_STEPS, the hexagon traversal limit.
+ *
+ * seascape.glsl constant_id 0 is NUM_STEPS, the tracing iterations, and
+ * constant_id 1 and 2 are ITER_GEOMETRY and ITER_FRAGMENT, the octaves
+ * for the height and for the normals; the high tier is the original.
+ *
+ * color_phase.frag has no knobs, its tiers are all the same shader.
+ *
+ * A scene's rows hold raymarchQualityConstantCounts[scene] constants.
+ */
+extern const SpecializationConstant raymarchQualityConstants[RAYMARCH_SCENE_COUNT][SHADER_QUALITY_COUNT][RAYMARCH_QUALITY_CONSTANT_COUNT];
+extern const uint32_t raymarchQualityConstantCounts[RAYMARCH_SCENE_COUNT];
+
+/* constant_id of each scene's CHECKERBOARD, set for --checkerboard's
+ * modules on top of the tier's constants, see checkerboard.h
+ */
+extern const uint32_t raymarchCheckerboardConstantIds[RAYMARCH_SCENE_COUNT];
+
+#endif /* RAYMARCH_SCENES_H */
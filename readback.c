@@ -0,0 +1,302 @@
+#include "readback.h"
+
+#include "command_capture.h"
+#include "gpu_memory.h"
+#include "trace.h"
+
+static int ReadbackRing_WorkerThread(void *data)
+{
+	ReadbackRing *ring = (ReadbackRing*) data;
+
+	Trace_SetThreadName("readback worker");
+
+	while (1)
+	{
+		SDL_SemWait(ring->workerSignal);
+
+		SDL_LockMutex(ring->workerLock);
+
+		if (ring->workerQueueCount == 0)
+		{
+			uint8_t quit = ring->workerQuit;
+			SDL_UnlockMutex(ring->workerLock);
+
+			if (quit)
+			{
+				break;
+			}
+			continue;
+		}
+
+		uint32_t slotIndex = ring->workerQueue[ring->workerQueueHead];
+		ring->workerQueueHead = (ring->workerQueueHead + 1) % ring->slotCount;
+		ring->workerQueueCount -= 1;
+
+		SDL_UnlockMutex(ring->workerLock);
+
+		ReadbackSlot *slot = &ring->slots[slotIndex];
+
+		uint64_t consumeZone = TRACE_BEGIN();
+		ring->consume(
+			ring->consumeUserdata,
+			slot->captureIndex,
+			slot->pixels,
+			slot->width,
+			slot->height
+		);
+		TRACE_END("readback consume", consumeZone);
+
+		SDL_LockMutex(ring->workerLock);
+		SDL_AtomicSet(&slot->state, READBACK_SLOT_FREE);
+		SDL_CondSignal(ring->slotFreed);
+		SDL_UnlockMutex(ring->workerLock);
+	}
+
+	return 0;
+}
+
+static void ReadbackRing_QueueConsume(ReadbackRing *ring, uint32_t slotIndex)
+{
+	SDL_LockMutex(ring->workerLock);
+
+	uint32_t tail = (ring->workerQueueHead + ring->workerQueueCount) % ring->slotCount;
+	ring->workerQueue[tail] = slotIndex;
+	ring->workerQueueCount += 1;
+
+	SDL_UnlockMutex(ring->workerLock);
+
+	SDL_SemPost(ring->workerSignal);
+}
+
+/* Finishes in-flight copies oldest first, so consumers see captures in order.
+ * Fences on one queue signal in submission order, so the first unsignaled
+ * fence means every later one is unsignaled too.
+ */
+static void ReadbackRing_FinishCopies(ReadbackRing *ring, uint8_t waitForOldest)
+{
+	while (ring->nextFinishIndex != ring->nextCaptureIndex)
+	{
+		uint32_t slotIndex = ring->nextFinishIndex % ring->slotCount;
+		ReadbackSlot *slot = &ring->slots[slotIndex];
+
+		if (SDL_AtomicGet(&slot->state) != READBACK_SLOT_IN_FLIGHT)
+		{
+			break;
+		}
+
+		if (waitForOldest)
+		{
+			VulkanInterop_WaitForFence(ring->interop, slot->fence);
+			waitForOldest = 0;
+		}
+		else if (!VulkanInterop_IsFenceSignaled(ring->interop, slot->fence))
+		{
+			break;
+		}
+
+		CommandCapture_GetBufferData(ring->device, slot->buffer, slot->pixels, slot->width * slot->height * 4);
+
+		SDL_AtomicSet(&slot->state, READBACK_SLOT_CONSUMING);
+		ReadbackRing_QueueConsume(ring, slotIndex);
+
+		ring->nextFinishIndex += 1;
+	}
+}
+
+static void ReadbackRing_ReleaseSlot(ReadbackRing *ring, ReadbackSlot *slot)
+{
+	if (slot->buffer != NULL)
+	{
+		GpuMemory_Remove(slot->buffer);
+		CommandCapture_QueueDestroyBuffer(ring->device, slot->buffer);
+		SDL_free(slot->pixels);
+		slot->buffer = NULL;
+		slot->pixels = NULL;
+	}
+}
+
+ReadbackRing* ReadbackRing_Create(
+	Refresh_Device *device,
+	VulkanInterop *interop,
+	uint32_t width,
+	uint32_t height,
+	uint32_t slotCount,
+	ReadbackFullPolicy fullPolicy,
+	uint8_t releaseWhenIdle,
+	ReadbackConsumeFunc consume,
+	void *consumeUserdata
+) {
+	ReadbackRing *ring = SDL_malloc(sizeof(ReadbackRing));
+	SDL_memset(ring, 0, sizeof(ReadbackRing));
+
+	ring->device = device;
+	ring->interop = interop;
+	ring->width = width;
+	ring->height = height;
+	ring->bufferSize = width * height * 4;
+
+	ring->fullPolicy = fullPolicy;
+	ring->releaseWhenIdle = releaseWhenIdle;
+	ring->consume = consume;
+	ring->consumeUserdata = consumeUserdata;
+
+	ring->slotCount = slotCount;
+	ring->slots = SDL_malloc(sizeof(ReadbackSlot) * slotCount);
+
+	for (uint32_t i = 0; i < slotCount; i++)
+	{
+		ReadbackSlot *slot = &ring->slots[i];
+		slot->buffer = NULL;
+		slot->fence = VulkanInterop_CreateFence(interop, 0);
+		slot->pixels = NULL;
+		slot->captureIndex = 0;
+		slot->width = 0;
+		slot->height = 0;
+		SDL_AtomicSet(&slot->state, READBACK_SLOT_FREE);
+	}
+
+	ring->workerLock = SDL_CreateMutex();
+	ring->slotFreed = SDL_CreateCond();
+	ring->workerSignal = SDL_CreateSemaphore(0);
+	ring->workerQueue = SDL_malloc(sizeof(uint32_t) * slotCount);
+	ring->workerThread = SDL_CreateThread(ReadbackRing_WorkerThread, "ReadbackWorker", ring);
+
+	return ring;
+}
+
+void ReadbackRing_Destroy(ReadbackRing *ring)
+{
+	/* Let pending captures finish rather than losing them on exit */
+	while (ring->nextFinishIndex != ring->nextCaptureIndex)
+	{
+		uint32_t finishIndex = ring->nextFinishIndex;
+		ReadbackRing_FinishCopies(ring, 1);
+
+		if (ring->nextFinishIndex == finishIndex)
+		{
+			/* Recorded but never submitted, nothing will ever land */
+			break;
+		}
+	}
+
+	SDL_LockMutex(ring->workerLock);
+	ring->workerQuit = 1;
+	SDL_UnlockMutex(ring->workerLock);
+	SDL_SemPost(ring->workerSignal);
+
+	SDL_WaitThread(ring->workerThread, NULL);
+
+	for (uint32_t i = 0; i < ring->slotCount; i++)
+	{
+		ReadbackRing_ReleaseSlot(ring, &ring->slots[i]);
+		VulkanInterop_DestroyFence(ring->interop, ring->slots[i].fence);
+	}
+
+	SDL_DestroySemaphore(ring->workerSignal);
+	SDL_DestroyCond(ring->slotFreed);
+	SDL_DestroyMutex(ring->workerLock);
+	SDL_free(ring->workerQueue);
+	SDL_free(ring->slots);
+	SDL_free(ring);
+}
+
+int32_t ReadbackRing_Capture(
+	ReadbackRing *ring,
+	Refresh_CommandBuffer *commandBuffer,
+	Refresh_TextureSlice *textureSlice
+) {
+	if (	textureSlice->rectangle.w > (int32_t) ring->width ||
+		textureSlice->rectangle.h > (int32_t) ring->height	)
+	{
+		SDL_LogError(
+			SDL_LOG_CATEGORY_APPLICATION,
+			"%dx%d capture does not fit the %ux%u readback ring",
+			textureSlice->rectangle.w,
+			textureSlice->rectangle.h,
+			ring->width,
+			ring->height
+		);
+		return -1;
+	}
+
+	ReadbackSlot *slot = &ring->slots[ring->nextCaptureIndex % ring->slotCount];
+	int state = SDL_AtomicGet(&slot->state);
+
+	if (state != READBACK_SLOT_FREE)
+	{
+		if (	ring->fullPolicy == READBACK_DROP_WHEN_FULL ||
+			state == READBACK_SLOT_RECORDED	)
+		{
+			ring->droppedCount += 1;
+			SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "all %u readback slots busy, capture dropped", ring->slotCount);
+			return -1;
+		}
+
+		uint64_t stallStart = SDL_GetPerformanceCounter();
+
+		/* The slot being reused always holds the oldest capture */
+		if (state == READBACK_SLOT_IN_FLIGHT)
+		{
+			ReadbackRing_FinishCopies(ring, 1);
+		}
+
+		SDL_LockMutex(ring->workerLock);
+		while (SDL_AtomicGet(&slot->state) != READBACK_SLOT_FREE)
+		{
+			SDL_CondWait(ring->slotFreed, ring->workerLock);
+		}
+		SDL_UnlockMutex(ring->workerLock);
+
+		ring->stallCount += 1;
+		ring->stallTicks += SDL_GetPerformanceCounter() - stallStart;
+	}
+
+	if (slot->buffer == NULL)
+	{
+		slot->buffer = CommandCapture_CreateBuffer(ring->device, 0, ring->bufferSize);
+		GpuMemory_AddBuffer(slot->buffer, 0, ring->bufferSize);
+		slot->pixels = SDL_malloc(ring->bufferSize);
+	}
+
+	slot->captureIndex = ring->nextCaptureIndex;
+	slot->width = textureSlice->rectangle.w;
+	slot->height = textureSlice->rectangle.h;
+	ring->nextCaptureIndex += 1;
+
+	CommandCapture_CopyTextureToBuffer(ring->device, commandBuffer, textureSlice, slot->buffer);
+	SDL_AtomicSet(&slot->state, READBACK_SLOT_RECORDED);
+
+	return (int32_t) slot->captureIndex;
+}
+
+void ReadbackRing_Submitted(ReadbackRing *ring)
+{
+	for (uint32_t i = 0; i < ring->slotCount; i++)
+	{
+		ReadbackSlot *slot = &ring->slots[i];
+
+		if (SDL_AtomicGet(&slot->state) == READBACK_SLOT_RECORDED)
+		{
+			VulkanInterop_ResetFence(ring->interop, slot->fence);
+			VulkanInterop_SignalFenceOnQueue(ring->interop, slot->fence);
+			SDL_AtomicSet(&slot->state, READBACK_SLOT_IN_FLIGHT);
+		}
+	}
+}
+
+void ReadbackRing_Poll(ReadbackRing *ring)
+{
+	ReadbackRing_FinishCopies(ring, 0);
+
+	/* Only the worker frees slots, and it never touches a free one again */
+	if (ring->releaseWhenIdle)
+	{
+		for (uint32_t i = 0; i < ring->slotCount; i++)
+		{
+			if (SDL_AtomicGet(&ring->slots[i].state) == READBACK_SLOT_FREE)
+			{
+				ReadbackRing_ReleaseSlot(ring, &ring->slots[i]);
+			}
+		}
+	}
+}
@@ -0,0 +1,133 @@
+#ifndef READBACK_H
+#define READBACK_H
+
+/* Pipelined GPU->CPU readback of color targets.
+ *
+ * Each capture is copied into the next of a ring of Refresh buffers, and the
+ * buffer's fence is polled on later frames instead of waiting on it. Once the
+ * copy has landed, the pixels are handed to a worker thread that runs the
+ * consumer callback, so neither the copy nor the consumer stalls submission.
+ *
+ * Captures reach the consumer in capture order. When the ring is full it
+ * either drops the capture (screenshots) or blocks until the oldest slot is
+ * free again (streaming, where every frame has to arrive).
+ *
+ * A slot's buffer and pixels are only allocated by its first capture, and a
+ * ring made with releaseWhenIdle frees them again once the consumer is done,
+ * so occasional captures hold no memory in between.
+ */
+
+#include <stdint.h>
+
+#include <SDL.h>
+#include <Refresh.h>
+
+#include "vulkan_interop.h"
+
+typedef enum ReadbackSlotState
+{
+	READBACK_SLOT_FREE,
+	READBACK_SLOT_RECORDED,		/* copy recorded, command buffer not yet submitted */
+	READBACK_SLOT_IN_FLIGHT,	/* submitted, waiting on the fence */
+	READBACK_SLOT_CONSUMING		/* pixels on the CPU, owned by the worker thread */
+} ReadbackSlotState;
+
+typedef enum ReadbackFullPolicy
+{
+	READBACK_DROP_WHEN_FULL,
+	READBACK_BLOCK_WHEN_FULL
+} ReadbackFullPolicy;
+
+/* Runs on the worker thread. The pixels are tightly packed R8G8B8A8 and
+ * are only valid until the callback returns.
+ */
+typedef void (*ReadbackConsumeFunc)(
+	void *userdata,
+	uint32_t captureIndex,
+	uint8_t *pixels,
+	uint32_t width,
+	uint32_t height
+);
+
+typedef struct ReadbackSlot
+{
+	Refresh_Buffer *buffer; /* NULL until the slot's first capture */
+	VkFence fence;
+	uint8_t *pixels;
+	uint32_t captureIndex;
+	uint32_t width;
+	uint32_t height;
+	SDL_atomic_t state;
+} ReadbackSlot;
+
+typedef struct ReadbackRing
+{
+	Refresh_Device *device;
+	VulkanInterop *interop;
+
+	/* Largest slice a capture can hold */
+	uint32_t width;
+	uint32_t height;
+	uint32_t bufferSize;
+
+	ReadbackFullPolicy fullPolicy;
+	uint8_t releaseWhenIdle;
+	ReadbackConsumeFunc consume;
+	void *consumeUserdata;
+
+	/* Slots are used round-robin, slot i holds capture i % slotCount */
+	ReadbackSlot *slots;
+	uint32_t slotCount;
+	uint32_t nextCaptureIndex;
+	uint32_t nextFinishIndex;
+
+	/* Worker thread queue, holds slot indices in capture order */
+	SDL_Thread *workerThread;
+	SDL_mutex *workerLock;
+	SDL_cond *slotFreed;
+	SDL_sem *workerSignal;
+	uint32_t *workerQueue;
+	uint32_t workerQueueHead;
+	uint32_t workerQueueCount;
+	uint8_t workerQuit;
+
+	/* Statistics */
+	uint32_t droppedCount;
+	uint32_t stallCount;
+	uint64_t stallTicks;
+} ReadbackRing;
+
+ReadbackRing* ReadbackRing_Create(
+	Refresh_Device *device,
+	VulkanInterop *interop,
+	uint32_t width,
+	uint32_t height,
+	uint32_t slotCount,
+	ReadbackFullPolicy fullPolicy,
+	uint8_t releaseWhenIdle,
+	ReadbackConsumeFunc consume,
+	void *consumeUserdata
+);
+
+/* Waits for outstanding copies and consumers before returning */
+void ReadbackRing_Destroy(ReadbackRing *ring);
+
+/* Records a copy of the slice into the next slot. The slice may be smaller
+ * than the ring's size. Returns the capture index, or -1 if the capture was
+ * dropped because the ring is full.
+ */
+int32_t ReadbackRing_Capture(
+	ReadbackRing *ring,
+	Refresh_CommandBuffer *commandBuffer,
+	Refresh_TextureSlice *textureSlice
+);
+
+/* Call after Refresh_Submit for the command buffer the captures were recorded into */
+void ReadbackRing_Submitted(ReadbackRing *ring);
+
+/* Hands finished copies to the worker thread, and with releaseWhenIdle
+ * frees the slots the consumer is done with. Never blocks.
+ */
+void ReadbackRing_Poll(ReadbackRing *ring);
+
+#endif /* READBACK_H */
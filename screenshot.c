@@ -0,0 +1,711 @@
+#include "screenshot.h"
+
+#include <SDL.h>
+
+#ifdef _WIN32
+#define SCREENSHOT_NO_MMAP
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#define SCREENSHOT_SSE2
+#include <emmintrin.h>
+#endif
+
+/* MSVC has no per-function target attribute, so AVX2 needs GCC or Clang */
+#if defined(SCREENSHOT_SSE2) && defined(__GNUC__)
+#define SCREENSHOT_AVX2
+#include <immintrin.h>
+#endif
+
+#define PNG_FILTER_SUB 1
+
+#define TGA_HEADER_SIZE 18
+
+const char *screenshotFormatNames[SCREENSHOT_FORMAT_COUNT] =
+{
+	"png", "qoi", "tga"
+};
+
+static const uint8_t pngSignature[8] =
+{
+	0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'
+};
+
+/* CRC-32 as PNG and zlib define it, slicing four bytes at a time */
+static void Screenshot_BuildCrcTables(uint32_t tables[4][256])
+{
+	for (uint32_t n = 0; n < 256; n++)
+	{
+		uint32_t crc = n;
+		for (uint32_t k = 0; k < 8; k++)
+		{
+			crc = (crc & 1) ? 0xEDB88320 ^ (crc >> 1) : crc >> 1;
+		}
+		tables[0][n] = crc;
+	}
+
+	for (uint32_t n = 0; n < 256; n++)
+	{
+		for (uint32_t k = 1; k < 4; k++)
+		{
+			tables[k][n] = (tables[k - 1][n] >> 8) ^ tables[0][tables[k - 1][n] & 0xFF];
+		}
+	}
+}
+
+static uint32_t Screenshot_Crc32(uint32_t tables[4][256], const uint8_t *data, size_t length)
+{
+	uint32_t crc = 0xFFFFFFFF;
+
+	for (; length >= 4; length -= 4, data += 4)
+	{
+		crc ^= (uint32_t) data[0] | ((uint32_t) data[1] << 8) | ((uint32_t) data[2] << 16) | ((uint32_t) data[3] << 24);
+		crc =	tables[3][crc & 0xFF] ^
+			tables[2][(crc >> 8) & 0xFF] ^
+			tables[1][(crc >> 16) & 0xFF] ^
+			tables[0][crc >> 24];
+	}
+	for (; length > 0; length--, data++)
+	{
+		crc = tables[0][(crc ^ *data) & 0xFF] ^ (crc >> 8);
+	}
+
+	return ~crc;
+}
+
+static void Screenshot_WriteBigEndian32(uint8_t *out, uint32_t value)
+{
+	out[0] = (uint8_t) (value >> 24);
+	out[1] = (uint8_t) (value >> 16);
+	out[2] = (uint8_t) (value >> 8);
+	out[3] = (uint8_t) value;
+}
+
+/* Fills in a PNG chunk's length, type and CRC around dataSize bytes
+ * already at chunk + 8. Returns the whole chunk's size.
+ */
+static size_t Screenshot_FinishChunk(
+	ScreenshotEncoder *encoder,
+	uint8_t *chunk,
+	const char *type,
+	size_t dataSize
+) {
+	Screenshot_WriteBigEndian32(chunk, (uint32_t) dataSize);
+	SDL_memcpy(chunk + 4, type, 4);
+	Screenshot_WriteBigEndian32(chunk + 8 + dataSize, Screenshot_Crc32(encoder->crcTables, chunk + 4, dataSize + 4));
+	return dataSize + 12;
+}
+
+/* Row y of the image as it should be saved, top first */
+static const uint8_t* Screenshot_SourceRow(ScreenshotEncoder *encoder, uint32_t y)
+{
+	uint32_t sourceY = encoder->flipVertical ? encoder->frameHeight - 1 - y : y;
+	return encoder->pixels + (size_t) sourceY * encoder->frameWidth * 4;
+}
+
+/* RGBA to BGRA */
+
+static void Screenshot_SwizzleScalar(const uint8_t *source, uint8_t *destination, uint32_t pixelCount)
+{
+	for (uint32_t i = 0; i < pixelCount; i++)
+	{
+		destination[i * 4 + 0] = source[i * 4 + 2];
+		destination[i * 4 + 1] = source[i * 4 + 1];
+		destination[i * 4 + 2] = source[i * 4 + 0];
+		destination[i * 4 + 3] = source[i * 4 + 3];
+	}
+}
+
+#ifdef SCREENSHOT_SSE2
+
+/* Returns how many pixels it did, always a multiple of 4 */
+static uint32_t Screenshot_SwizzleSSE2(const uint8_t *source, uint8_t *destination, uint32_t pixelCount)
+{
+	/* Swap bytes 0 and 2 of each pixel with 32-bit shifts, no SSSE3 shuffle needed */
+	const __m128i redBlue = _mm_set1_epi32(0x00FF00FF);
+	const __m128i greenAlpha = _mm_set1_epi32((int) 0xFF00FF00);
+	uint32_t i = 0;
+
+	for (; i + 4 <= pixelCount; i += 4)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*) (source + i * 4));
+		__m128i swapped = _mm_or_si128(_mm_slli_epi32(v, 16), _mm_srli_epi32(v, 16));
+		v = _mm_or_si128(_mm_and_si128(swapped, redBlue), _mm_and_si128(v, greenAlpha));
+		_mm_storeu_si128((__m128i*) (destination + i * 4), v);
+	}
+
+	return i;
+}
+
+#endif /* SCREENSHOT_SSE2 */
+
+#ifdef SCREENSHOT_AVX2
+
+/* Returns how many pixels it did, always a multiple of 8 */
+__attribute__((target("avx2")))
+static uint32_t Screenshot_SwizzleAVX2(const uint8_t *source, uint8_t *destination, uint32_t pixelCount)
+{
+	const __m256i shuffle = _mm256_setr_epi8(
+		2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+		2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15
+	);
+	uint32_t i = 0;
+
+	for (; i + 8 <= pixelCount; i += 8)
+	{
+		__m256i v = _mm256_loadu_si256((const __m256i*) (source + i * 4));
+		_mm256_storeu_si256((__m256i*) (destination + i * 4), _mm256_shuffle_epi8(v, shuffle));
+	}
+
+	return i;
+}
+
+#endif /* SCREENSHOT_AVX2 */
+
+static void Screenshot_Swizzle(const uint8_t *source, uint8_t *destination, uint32_t pixelCount)
+{
+	uint32_t done = 0;
+
+#ifdef SCREENSHOT_AVX2
+	if (SDL_HasAVX2())
+	{
+		done = Screenshot_SwizzleAVX2(source, destination, pixelCount);
+	}
+	else
+#endif
+	{
+#ifdef SCREENSHOT_SSE2
+		done = Screenshot_SwizzleSSE2(source, destination, pixelCount);
+#endif
+	}
+
+	Screenshot_SwizzleScalar(source + done * 4, destination + done * 4, pixelCount - done);
+}
+
+/* PNG */
+
+/* Writes the filter type byte and the filtered row to out. Sub alone
+ * compresses about as well as picking a filter per row on rendered frames
+ * and noticeably better on photographic ones, and costs one subtraction.
+ */
+static void Screenshot_FilterRow(const uint8_t *row, uint32_t stride, uint8_t *out)
+{
+	out[0] = PNG_FILTER_SUB;
+	out += 1;
+
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		out[i] = row[i];
+	}
+	for (uint32_t i = 4; i < stride; i++)
+	{
+		out[i] = (uint8_t) (row[i] - row[i - 4]);
+	}
+}
+
+static void Screenshot_PNGBandJob(void *userdata)
+{
+	ScreenshotBand *band = (ScreenshotBand*) userdata;
+	ScreenshotEncoder *encoder = band->encoder;
+	uint32_t stride = encoder->frameWidth * 4;
+
+	for (uint32_t r = 0; r < band->rowCount; r++)
+	{
+		Screenshot_FilterRow(
+			Screenshot_SourceRow(encoder, band->firstRow + r),
+			stride,
+			band->filtered + (size_t) r * (stride + 1)
+		);
+	}
+
+	band->filteredSize = (size_t) band->rowCount * (stride + 1);
+	band->adler = Deflate_Adler32(1, band->filtered, band->filteredSize);
+
+	/* The first band starts the zlib stream: deflate, 32K window, no dictionary */
+	uint8_t *data = band->chunk + 8;
+	size_t dataSize = 0;
+	if (band->firstRow == 0)
+	{
+		data[dataSize++] = 0x78;
+		data[dataSize++] = 0x01;
+	}
+
+	uint8_t last = band->firstRow + band->rowCount == encoder->frameHeight;
+	dataSize += Deflate_Compress(band->deflate, band->filtered, band->filteredSize, last, data + dataSize);
+
+	band->chunkSize = Screenshot_FinishChunk(encoder, band->chunk, "IDAT", dataSize);
+}
+
+static void Screenshot_TGABandJob(void *userdata)
+{
+	ScreenshotBand *band = (ScreenshotBand*) userdata;
+	ScreenshotEncoder *encoder = band->encoder;
+	size_t stride = (size_t) encoder->frameWidth * 4;
+
+	/* Targa rows go bottom first */
+	for (uint32_t r = 0; r < band->rowCount; r++)
+	{
+		uint32_t y = band->firstRow + r;
+		Screenshot_Swizzle(
+			Screenshot_SourceRow(encoder, y),
+			encoder->tgaPixels + (encoder->frameHeight - 1 - y) * stride,
+			encoder->frameWidth
+		);
+	}
+}
+
+/* Splits the frame's rows between the bands, runs func on each and waits
+ * for all of them. Returns how many bands the frame used.
+ */
+static uint32_t Screenshot_RunBands(ScreenshotEncoder *encoder, JobFunc func)
+{
+	uint32_t bandCount = SDL_max(1, SDL_min(encoder->bandCount, encoder->frameHeight / SCREENSHOT_BAND_ROWS_MIN));
+	uint32_t rowsPerBand = (encoder->frameHeight + bandCount - 1) / bandCount;
+	uint32_t submitted = 0;
+
+	for (uint32_t i = 0; i < bandCount; i++)
+	{
+		ScreenshotBand *band = &encoder->bands[i];
+		band->firstRow = i * rowsPerBand;
+		if (band->firstRow >= encoder->frameHeight)
+		{
+			break;
+		}
+		band->rowCount = SDL_min(rowsPerBand, encoder->frameHeight - band->firstRow);
+
+		JobSystem_Submit(encoder->jobs, &band->job, func, band);
+		submitted += 1;
+	}
+
+	for (uint32_t i = 0; i < submitted; i++)
+	{
+		JobSystem_Wait(encoder->jobs, &encoder->bands[i].job);
+	}
+
+	return submitted;
+}
+
+static size_t Screenshot_WritePNG(ScreenshotEncoder *encoder, FILE *file)
+{
+	uint8_t header[8 + 12 + 13];
+	uint8_t trailer[12 + 4 + 12];
+	size_t written = 0;
+
+	uint32_t bandCount = Screenshot_RunBands(encoder, Screenshot_PNGBandJob);
+
+	/* 8-bit RGBA, deflate, filter method 0, not interlaced */
+	SDL_memcpy(header, pngSignature, 8);
+	uint8_t *ihdr = header + 8 + 8;
+	Screenshot_WriteBigEndian32(ihdr, encoder->frameWidth);
+	Screenshot_WriteBigEndian32(ihdr + 4, encoder->frameHeight);
+	ihdr[8] = 8;
+	ihdr[9] = 6;
+	ihdr[10] = 0;
+	ihdr[11] = 0;
+	ihdr[12] = 0;
+	Screenshot_FinishChunk(encoder, header + 8, "IHDR", 13);
+	written += fwrite(header, 1, sizeof(header), file);
+
+	uint32_t adler = encoder->bands[0].adler;
+	for (uint32_t i = 0; i < bandCount; i++)
+	{
+		ScreenshotBand *band = &encoder->bands[i];
+		written += fwrite(band->chunk, 1, band->chunkSize, file);
+
+		if (i > 0)
+		{
+			adler = Deflate_Adler32Combine(adler, band->adler, band->filteredSize);
+		}
+	}
+
+	/* The zlib trailer gets an IDAT of its own, the bands' chunks are already sealed */
+	Screenshot_WriteBigEndian32(trailer + 8, adler);
+	Screenshot_FinishChunk(encoder, trailer, "IDAT", 4);
+	Screenshot_FinishChunk(encoder, trailer + 16, "IEND", 0);
+	written += fwrite(trailer, 1, sizeof(trailer), file);
+
+	return ferror(file) ? 0 : written;
+}
+
+/* QOI, https://qoiformat.org/qoi-specification.pdf */
+
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF 0x40
+#define QOI_OP_LUMA 0x80
+#define QOI_OP_RUN 0xC0
+#define QOI_OP_RGB 0xFE
+#define QOI_OP_RGBA 0xFF
+
+static size_t Screenshot_EncodeQOI(ScreenshotEncoder *encoder, uint8_t *out)
+{
+	uint32_t index[64];
+	uint8_t previousBytes[4] = { 0, 0, 0, 255 };
+	uint32_t previous = 0xFF000000;	/* the same bytes as a little endian word */
+	uint32_t run = 0;
+	size_t size;
+
+	SDL_memset(index, 0, sizeof(index));
+
+	SDL_memcpy(out, "qoif", 4);
+	Screenshot_WriteBigEndian32(out + 4, encoder->frameWidth);
+	Screenshot_WriteBigEndian32(out + 8, encoder->frameHeight);
+	out[12] = 4;	/* RGBA */
+	out[13] = 0;	/* sRGB with linear alpha */
+	size = 14;
+
+	for (uint32_t y = 0; y < encoder->frameHeight; y++)
+	{
+		const uint8_t *row = Screenshot_SourceRow(encoder, y);
+		uint8_t lastRow = y == encoder->frameHeight - 1;
+
+		for (uint32_t x = 0; x < encoder->frameWidth; x++)
+		{
+			const uint8_t *p = row + x * 4;
+			uint32_t pixel = (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+
+			if (pixel == previous)
+			{
+				run += 1;
+				if (run == 62 || (lastRow && x == encoder->frameWidth - 1))
+				{
+					out[size++] = (uint8_t) (QOI_OP_RUN | (run - 1));
+					run = 0;
+				}
+				continue;
+			}
+
+			if (run > 0)
+			{
+				out[size++] = (uint8_t) (QOI_OP_RUN | (run - 1));
+				run = 0;
+			}
+
+			uint32_t hash = (p[0] * 3 + p[1] * 5 + p[2] * 7 + p[3] * 11) % 64;
+
+			if (index[hash] == pixel)
+			{
+				out[size++] = (uint8_t) (QOI_OP_INDEX | hash);
+			}
+			else
+			{
+				index[hash] = pixel;
+
+				if (p[3] == previousBytes[3])
+				{
+					int8_t dr = (int8_t) (p[0] - previousBytes[0]);
+					int8_t dg = (int8_t) (p[1] - previousBytes[1]);
+					int8_t db = (int8_t) (p[2] - previousBytes[2]);
+					int8_t drg = (int8_t) (dr - dg);
+					int8_t dbg = (int8_t) (db - dg);
+
+					if (	dr >= -2 && dr <= 1 &&
+						dg >= -2 && dg <= 1 &&
+						db >= -2 && db <= 1	)
+					{
+						out[size++] = (uint8_t) (QOI_OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+					}
+					else if (	dg >= -32 && dg <= 31 &&
+							drg >= -8 && drg <= 7 &&
+							dbg >= -8 && dbg <= 7	)
+					{
+						out[size++] = (uint8_t) (QOI_OP_LUMA | (dg + 32));
+						out[size++] = (uint8_t) ((drg + 8) << 4 | (dbg + 8));
+					}
+					else
+					{
+						out[size++] = QOI_OP_RGB;
+						out[size++] = p[0];
+						out[size++] = p[1];
+						out[size++] = p[2];
+					}
+				}
+				else
+				{
+					out[size++] = QOI_OP_RGBA;
+					out[size++] = p[0];
+					out[size++] = p[1];
+					out[size++] = p[2];
+					out[size++] = p[3];
+				}
+			}
+
+			previous = pixel;
+			previousBytes[0] = p[0];
+			previousBytes[1] = p[1];
+			previousBytes[2] = p[2];
+			previousBytes[3] = p[3];
+		}
+	}
+
+	/* End marker, seven zeros and a one */
+	SDL_memset(out + size, 0, 7);
+	out[size + 7] = 1;
+	return size + 8;
+}
+
+static size_t Screenshot_SaveTGA(ScreenshotEncoder *encoder, const char *path)
+{
+	size_t size = TGA_HEADER_SIZE + (size_t) encoder->frameWidth * encoder->frameHeight * 4;
+	uint8_t *file;
+
+#ifdef SCREENSHOT_NO_MMAP
+	file = encoder->tgaBuffer;
+#else
+	int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+	{
+		return 0;
+	}
+
+	if (ftruncate(fd, (off_t) size) != 0)
+	{
+		close(fd);
+		return 0;
+	}
+
+	file = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (file == MAP_FAILED)
+	{
+		close(fd);
+		return 0;
+	}
+#endif
+
+	/* Uncompressed true color, 32 bits with 8 of alpha, bottom left origin */
+	SDL_memset(file, 0, TGA_HEADER_SIZE);
+	file[2] = 2;
+	file[12] = (uint8_t) encoder->frameWidth;
+	file[13] = (uint8_t) (encoder->frameWidth >> 8);
+	file[14] = (uint8_t) encoder->frameHeight;
+	file[15] = (uint8_t) (encoder->frameHeight >> 8);
+	file[16] = 32;
+	file[17] = 8;
+
+	encoder->tgaPixels = file + TGA_HEADER_SIZE;
+	Screenshot_RunBands(encoder, Screenshot_TGABandJob);
+	encoder->tgaPixels = NULL;
+
+#ifdef SCREENSHOT_NO_MMAP
+	FILE *output = fopen(path, "wb");
+	if (output == NULL)
+	{
+		return 0;
+	}
+	size_t written = fwrite(file, 1, size, output);
+	fclose(output);
+	return written == size ? size : 0;
+#else
+	munmap(file, size);
+	close(fd);
+	return size;
+#endif
+}
+
+ScreenshotEncoder* ScreenshotEncoder_Create(
+	ScreenshotFormat format,
+	uint8_t flipVertical,
+	uint32_t width,
+	uint32_t height,
+	uint32_t threadCount
+) {
+	ScreenshotEncoder *encoder = SDL_malloc(sizeof(ScreenshotEncoder));
+	SDL_memset(encoder, 0, sizeof(ScreenshotEncoder));
+
+	encoder->format = format;
+	encoder->flipVertical = flipVertical;
+	encoder->width = width;
+	encoder->height = height;
+
+	/* Its own workers, so a screenshot never queues ahead of the frame's tile jobs */
+	encoder->jobs = JobSystem_Create(threadCount);
+	encoder->bandCount = SDL_min(encoder->jobs->threadCount * 2, SCREENSHOT_BANDS_MAX);
+
+	for (uint32_t i = 0; i < encoder->bandCount; i++)
+	{
+		encoder->bands[i].encoder = encoder;
+	}
+
+	if (format == SCREENSHOT_FORMAT_PNG)
+	{
+		Screenshot_BuildCrcTables(encoder->crcTables);
+
+		/* Short frames get fewer bands of at most twice the minimum, see Screenshot_RunBands */
+		uint32_t stride = width * 4;
+		uint32_t maxRows = SDL_max((height + encoder->bandCount - 1) / encoder->bandCount, SCREENSHOT_BAND_ROWS_MIN * 2);
+		size_t filteredCapacity = (size_t) maxRows * (stride + 1);
+
+		for (uint32_t i = 0; i < encoder->bandCount; i++)
+		{
+			ScreenshotBand *band = &encoder->bands[i];
+			band->deflate = Deflate_Create();
+			band->filtered = SDL_malloc(filteredCapacity);
+			band->chunk = SDL_malloc(12 + 2 + Deflate_Bound(filteredCapacity));
+		}
+	}
+	else if (format == SCREENSHOT_FORMAT_QOI)
+	{
+		/* Worst case is QOI_OP_RGBA for every pixel */
+		encoder->qoiBuffer = SDL_malloc((size_t) width * height * 5 + 14 + 8);
+	}
+#ifdef SCREENSHOT_NO_MMAP
+	else if (format == SCREENSHOT_FORMAT_TGA)
+	{
+		encoder->tgaBuffer = SDL_malloc(TGA_HEADER_SIZE + (size_t) width * height * 4);
+	}
+#endif
+
+	return encoder;
+}
+
+void ScreenshotEncoder_Destroy(ScreenshotEncoder *encoder)
+{
+	for (uint32_t i = 0; i < encoder->bandCount; i++)
+	{
+		ScreenshotBand *band = &encoder->bands[i];
+		if (band->deflate != NULL)
+		{
+			Deflate_Destroy(band->deflate);
+		}
+		SDL_free(band->filtered);
+		SDL_free(band->chunk);
+	}
+
+	JobSystem_Destroy(encoder->jobs);
+	SDL_free(encoder->qoiBuffer);
+#ifdef SCREENSHOT_NO_MMAP
+	SDL_free(encoder->tgaBuffer);
+#endif
+	SDL_free(encoder);
+}
+
+uint8_t ScreenshotEncoder_Save(
+	ScreenshotEncoder *encoder,
+	const char *path,
+	const uint8_t *pixels,
+	uint32_t width,
+	uint32_t height
+) {
+	if (width > encoder->width || height > encoder->height || width == 0 || height == 0)
+	{
+		SDL_LogError(
+			SDL_LOG_CATEGORY_APPLICATION,
+			"%ux%u screenshot does not fit the %ux%u encoder",
+			width,
+			height,
+			encoder->width,
+			encoder->height
+		);
+		return 0;
+	}
+
+	uint64_t encodeStart = SDL_GetPerformanceCounter();
+	size_t size = 0;
+
+	encoder->pixels = pixels;
+	encoder->frameWidth = width;
+	encoder->frameHeight = height;
+
+	if (encoder->format == SCREENSHOT_FORMAT_TGA)
+	{
+		size = Screenshot_SaveTGA(encoder, path);
+	}
+	else
+	{
+		FILE *file = fopen(path, "wb");
+		if (file != NULL)
+		{
+			if (encoder->format == SCREENSHOT_FORMAT_PNG)
+			{
+				size = Screenshot_WritePNG(encoder, file);
+			}
+			else
+			{
+				size = Screenshot_EncodeQOI(encoder, encoder->qoiBuffer);
+				size = fwrite(encoder->qoiBuffer, 1, size, file) == size ? size : 0;
+			}
+
+			if (fclose(file) != 0)
+			{
+				size = 0;
+			}
+		}
+	}
+
+	encoder->pixels = NULL;
+
+	if (size == 0)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write screenshot %s", path);
+		return 0;
+	}
+
+	uint64_t encodeTicks = SDL_GetPerformanceCounter() - encodeStart;
+	double encodeMilliseconds = encodeTicks * 1000.0 / SDL_GetPerformanceFrequency();
+
+	encoder->savedCount += 1;
+	encoder->bytesWritten += size;
+	encoder->encodeTicks += encodeTicks;
+	encoder->maxEncodeMilliseconds = SDL_max(encoder->maxEncodeMilliseconds, encodeMilliseconds);
+
+	SDL_LogInfo(
+		SDL_LOG_CATEGORY_APPLICATION,
+		"saved %s (%.1f ms, %.0f KB)",
+		path,
+		encodeMilliseconds,
+		size / 1024.0
+	);
+
+	return 1;
+}
+
+void ScreenshotEncoder_Consume(
+	void *userdata,
+	uint32_t captureIndex,
+	uint8_t *pixels,
+	uint32_t width,
+	uint32_t height
+) {
+	ScreenshotEncoder *encoder = (ScreenshotEncoder*) userdata;
+	char fileName[64];
+
+	SDL_snprintf(fileName, sizeof(fileName), "screenshot_%04u.%s", captureIndex, screenshotFormatNames[encoder->format]);
+	ScreenshotEncoder_Save(encoder, fileName, pixels, width, height);
+}
+
+void ScreenshotEncoder_Report(ScreenshotEncoder *encoder, FILE *output)
+{
+	if (encoder->savedCount == 0)
+	{
+		return;
+	}
+
+	fprintf(
+		output,
+		"screenshots: %u %s, %.1f ms mean and %.1f ms max to encode on %u threads, %.1f MB\n",
+		encoder->savedCount,
+		screenshotFormatNames[encoder->format],
+		encoder->encodeTicks * 1000.0 / SDL_GetPerformanceFrequency() / encoder->savedCount,
+		encoder->maxEncodeMilliseconds,
+		encoder->jobs->threadCount,
+		encoder->bytesWritten / (1024.0 * 1024.0)
+	);
+}
+
+const char* ScreenshotEncoder_KernelName(void)
+{
+#ifdef SCREENSHOT_AVX2
+	if (SDL_HasAVX2())
+	{
+		return "avx2";
+	}
+#endif
+#ifdef SCREENSHOT_SSE2
+	return "sse2";
+#else
+	return "scalar";
+#endif
+}
@@ -0,0 +1,131 @@
+#ifndef SCREENSHOT_H
+#define SCREENSHOT_H
+
+/* Screenshot encoder, the consumer behind the S key's ReadbackRing.
+ *
+ * Three formats:
+ *
+ *	png	the frame is cut into bands of rows, and each band is filtered,
+ *		deflated and checksummed on the encoder's own job system into
+ *		an IDAT chunk of its own (see deflate.h). The chunks follow
+ *		each other into one zlib stream, which any decoder reads.
+ *	qoi	the Quite OK Image format, lossless and single pass; several
+ *		times faster than PNG for a somewhat bigger file.
+ *	tga	uncompressed 32-bit Targa, swizzled to BGRA by the bands straight
+ *		into a memory mapped file.
+ *
+ * flipVertical is for sources stored bottom row first, the way the flip
+ * rect presents them; it only changes the order rows are read in. The TGA
+ * swizzle runs SSE2 or AVX2 like image_diff.c.
+ *
+ * Every save logs its encode time, and ScreenshotEncoder_Report sums them.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "deflate.h"
+#include "jobs.h"
+
+#define SCREENSHOT_BANDS_MAX 32
+#define SCREENSHOT_BAND_ROWS_MIN 16
+
+typedef enum ScreenshotFormat
+{
+	SCREENSHOT_FORMAT_PNG,
+	SCREENSHOT_FORMAT_QOI,
+	SCREENSHOT_FORMAT_TGA,
+	SCREENSHOT_FORMAT_COUNT
+} ScreenshotFormat;
+
+/* Also the file extensions */
+extern const char *screenshotFormatNames[SCREENSHOT_FORMAT_COUNT];
+
+typedef struct ScreenshotBand
+{
+	Job job;
+	struct ScreenshotEncoder *encoder;
+	uint32_t firstRow;
+	uint32_t rowCount;
+
+	/* PNG only */
+	Deflate *deflate;
+	uint8_t *filtered;	/* each row with its filter type byte, always Sub, first */
+	size_t filteredSize;
+	uint32_t adler;
+	uint8_t *chunk;		/* a whole IDAT chunk, length through CRC */
+	size_t chunkSize;
+} ScreenshotBand;
+
+typedef struct ScreenshotEncoder
+{
+	ScreenshotFormat format;
+	uint8_t flipVertical;
+	JobSystem *jobs;
+
+	/* Largest frame the buffers hold */
+	uint32_t width;
+	uint32_t height;
+
+	ScreenshotBand bands[SCREENSHOT_BANDS_MAX];
+	uint32_t bandCount;
+
+	/* The frame being saved, for the band jobs */
+	const uint8_t *pixels;
+	uint32_t frameWidth;
+	uint32_t frameHeight;
+	uint8_t *tgaPixels;	/* where the bands write BGRA rows */
+
+	uint32_t crcTables[4][256];	/* PNG only */
+
+	uint8_t *qoiBuffer;
+#ifdef _WIN32
+	uint8_t *tgaBuffer;	/* the whole file, written out in one go with no mmap */
+#endif
+
+	/* Statistics */
+	uint32_t savedCount;
+	uint64_t bytesWritten;
+	uint64_t encodeTicks;
+	double maxEncodeMilliseconds;
+} ScreenshotEncoder;
+
+/* A thread count of 0 uses one per CPU core */
+ScreenshotEncoder* ScreenshotEncoder_Create(
+	ScreenshotFormat format,
+	uint8_t flipVertical,
+	uint32_t width,
+	uint32_t height,
+	uint32_t threadCount
+);
+
+void ScreenshotEncoder_Destroy(ScreenshotEncoder *encoder);
+
+/* Writes R8G8B8A8 pixels, at most the encoder's size, to path. Returns 0
+ * and logs why if the file could not be written.
+ */
+uint8_t ScreenshotEncoder_Save(
+	ScreenshotEncoder *encoder,
+	const char *path,
+	const uint8_t *pixels,
+	uint32_t width,
+	uint32_t height
+);
+
+/* ReadbackConsumeFunc, userdata is the ScreenshotEncoder. Saves
+ * screenshot_NNNN with the format's extension.
+ */
+void ScreenshotEncoder_Consume(
+	void *userdata,
+	uint32_t captureIndex,
+	uint8_t *pixels,
+	uint32_t width,
+	uint32_t height
+);
+
+void ScreenshotEncoder_Report(ScreenshotEncoder *encoder, FILE *output);
+
+/* "avx2", "sse2" or "scalar", whichever the TGA swizzle runs */
+const char* ScreenshotEncoder_KernelName(void);
+
+#endif /* SCREENSHOT_H */
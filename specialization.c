@@ -0,0 +1,138 @@
+#include "specialization.h"
+
+#include <SDL.h>
+
+#include "command_capture.h"
+
+#define SPIRV_MAGIC 0x07230203
+#define SPIRV_HEADER_WORDS 5
+
+#define SPIRV_OP_SPEC_CONSTANT_TRUE 48
+#define SPIRV_OP_SPEC_CONSTANT_FALSE 49
+#define SPIRV_OP_SPEC_CONSTANT 50
+#define SPIRV_OP_DECORATE 71
+
+#define SPIRV_DECORATION_SPEC_ID 1
+
+uint32_t Specialization_Patch(
+	uint32_t *code,
+	size_t codeSize,
+	const SpecializationConstant *constants,
+	uint32_t constantCount
+) {
+	size_t wordCount = codeSize / sizeof(uint32_t);
+
+	if (wordCount < SPIRV_HEADER_WORDS || code[0] != SPIRV_MAGIC)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "not a SPIR-V module");
+		return 0;
+	}
+
+	/* Result ids of the constants we were asked for, filled in from the
+	 * SpecId decorations, which always come before the constants themselves
+	 */
+	uint32_t *resultIds = SDL_stack_alloc(uint32_t, constantCount);
+	for (uint32_t i = 0; i < constantCount; i++)
+	{
+		resultIds[i] = 0;
+	}
+
+	uint32_t patchedCount = 0;
+	size_t word = SPIRV_HEADER_WORDS;
+
+	while (word < wordCount)
+	{
+		uint32_t opcode = code[word] & 0xFFFF;
+		uint32_t length = code[word] >> 16;
+
+		if (length == 0 || word + length > wordCount)
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "malformed SPIR-V instruction at word %u", (uint32_t) word);
+			break;
+		}
+
+		if (	opcode == SPIRV_OP_DECORATE &&
+			length == 4 &&
+			code[word + 2] == SPIRV_DECORATION_SPEC_ID	)
+		{
+			for (uint32_t i = 0; i < constantCount; i++)
+			{
+				if (constants[i].id == code[word + 3])
+				{
+					resultIds[i] = code[word + 1];
+				}
+			}
+		}
+		else if (	opcode == SPIRV_OP_SPEC_CONSTANT ||
+				opcode == SPIRV_OP_SPEC_CONSTANT_TRUE ||
+				opcode == SPIRV_OP_SPEC_CONSTANT_FALSE	)
+		{
+			uint32_t resultId = code[word + 2];
+
+			for (uint32_t i = 0; i < constantCount; i++)
+			{
+				if (resultIds[i] != resultId)
+				{
+					continue;
+				}
+
+				if (opcode == SPIRV_OP_SPEC_CONSTANT)
+				{
+					/* Type, result id and a single literal word */
+					if (length != 4)
+					{
+						SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "specialization constant %u is 64-bit, left unchanged", constants[i].id);
+						break;
+					}
+					code[word + 3] = constants[i].value;
+				}
+				else
+				{
+					/* Booleans carry their value in the opcode */
+					code[word] = (length << 16) | (constants[i].value ?
+						SPIRV_OP_SPEC_CONSTANT_TRUE :
+						SPIRV_OP_SPEC_CONSTANT_FALSE);
+				}
+
+				patchedCount += 1;
+				break;
+			}
+		}
+
+		word += length;
+	}
+
+	SDL_stack_free(resultIds);
+	return patchedCount;
+}
+
+Refresh_ShaderModule* Specialization_CreateShaderModule(
+	Refresh_Device *device,
+	const uint32_t *code,
+	size_t codeSize,
+	const SpecializationConstant *constants,
+	uint32_t constantCount
+) {
+	uint32_t *patchedCode = SDL_malloc(codeSize);
+	SDL_memcpy(patchedCode, code, codeSize);
+
+	uint32_t patchedCount = Specialization_Patch(patchedCode, codeSize, constants, constantCount);
+	if (patchedCount < constantCount)
+	{
+		SDL_LogWarn(
+			SDL_LOG_CATEGORY_APPLICATION,
+			"shader declares %u of %u specialization constants, the rest keep their defaults",
+			patchedCount,
+			constantCount
+		);
+	}
+
+	Refresh_ShaderModuleCreateInfo shaderModuleCreateInfo;
+	shaderModuleCreateInfo.byteCode = patchedCode;
+	shaderModuleCreateInfo.codeSize = codeSize;
+
+	Refresh_ShaderModule *shaderModule = CommandCapture_CreateShaderModule(device, &shaderModuleCreateInfo);
+
+	SDL_free(patchedCode);
+	return shaderModule;
+}
@@ -0,0 +1,44 @@
+#ifndef SPECIALIZATION_H
+#define SPECIALIZATION_H
+
+/* Specialization constants for Refresh shader modules.
+ *
+ * Refresh_ShaderStageState has no way to pass VkSpecializationInfo, so the
+ * values are written into the SPIR-V instead: every constant declared with
+ * layout(constant_id = N) is an OpSpecConstant whose default sits right in
+ * the module. Replacing that default before the module is created gives the
+ * driver the same information specialization info would, and it still folds
+ * the constant into loop bounds and branches when building the pipeline.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <Refresh.h>
+
+typedef struct SpecializationConstant
+{
+	uint32_t id;	/* constant_id in GLSL */
+	uint32_t value;	/* 32-bit int, uint or float bits; nonzero for bool */
+} SpecializationConstant;
+
+/* Overwrites the default of each listed constant in place. Returns how many
+ * of them the module declares; 64-bit constants are left alone.
+ */
+uint32_t Specialization_Patch(
+	uint32_t *code,
+	size_t codeSize,
+	const SpecializationConstant *constants,
+	uint32_t constantCount
+);
+
+/* Creates a module from a patched copy of the code, the code itself is unchanged */
+Refresh_ShaderModule* Specialization_CreateShaderModule(
+	Refresh_Device *device,
+	const uint32_t *code,
+	size_t codeSize,
+	const SpecializationConstant *constants,
+	uint32_t constantCount
+);
+
+#endif /* SPECIALIZATION_H */
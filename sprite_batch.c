@@ -0,0 +1,317 @@
+#include "sprite_batch.h"
+
+#include <SDL.h>
+
+#include "command_capture.h"
+
+#define SPRITE_BATCH_INITIAL_CAPACITY 1024
+
+static int SpriteBatch_CompareKeys(const void *a, const void *b)
+{
+	const SpriteBatchSortKey *keyA = (const SpriteBatchSortKey*) a;
+	const SpriteBatchSortKey *keyB = (const SpriteBatchSortKey*) b;
+
+	if (keyA->texture != keyB->texture)
+	{
+		return keyA->texture < keyB->texture ? -1 : 1;
+	}
+
+	/* Keeps submission order within a texture, SDL_qsort isn't stable */
+	return keyA->index < keyB->index ? -1 : (keyA->index > keyB->index);
+}
+
+static void SpriteBatch_Reserve(SpriteBatch *batch, uint32_t capacity)
+{
+	if (capacity <= batch->itemCapacity)
+	{
+		return;
+	}
+
+	uint32_t newCapacity = SDL_max(batch->itemCapacity * 2, capacity);
+
+	batch->items = SDL_realloc(batch->items, sizeof(SpriteBatchItem) * newCapacity);
+	batch->sortKeys = SDL_realloc(batch->sortKeys, sizeof(SpriteBatchSortKey) * newCapacity);
+	batch->vertices = SDL_realloc(batch->vertices, sizeof(SpriteBatchVertex) * 4 * newCapacity);
+	batch->itemCapacity = newCapacity;
+}
+
+SpriteBatch* SpriteBatch_Create(
+	FNA3D_Device *device,
+	StateCache *stateCache,
+	FNA3D_Effect *effect,
+	MOJOSHADER_effect *effectData
+) {
+	SpriteBatch *batch = SDL_malloc(sizeof(SpriteBatch));
+	SDL_memset(batch, 0, sizeof(SpriteBatch));
+
+	batch->device = device;
+	batch->stateCache = stateCache;
+	batch->effect = effect;
+	batch->effectData = effectData;
+	batch->matrixTransformParam = StateCache_FindEffectParam(effectData, "MatrixTransform");
+
+	batch->vertexBuffer = CommandCapture_FNA3D_GenVertexBuffer(
+		device,
+		1,
+		FNA3D_BUFFERUSAGE_WRITEONLY,
+		sizeof(SpriteBatchVertex) * 4 * SPRITE_BATCH_MAX_SPRITES
+	);
+
+	/* Two triangles per sprite, the same six indices offset by four each time */
+	uint16_t *indices = SDL_malloc(sizeof(uint16_t) * 6 * SPRITE_BATCH_MAX_SPRITES);
+	for (uint32_t i = 0; i < SPRITE_BATCH_MAX_SPRITES; i++)
+	{
+		indices[i * 6 + 0] = (uint16_t) (i * 4 + 0);
+		indices[i * 6 + 1] = (uint16_t) (i * 4 + 1);
+		indices[i * 6 + 2] = (uint16_t) (i * 4 + 2);
+		indices[i * 6 + 3] = (uint16_t) (i * 4 + 2);
+		indices[i * 6 + 4] = (uint16_t) (i * 4 + 3);
+		indices[i * 6 + 5] = (uint16_t) (i * 4 + 0);
+	}
+
+	batch->indexBuffer = CommandCapture_FNA3D_GenIndexBuffer(
+		device,
+		0,
+		FNA3D_BUFFERUSAGE_WRITEONLY,
+		sizeof(uint16_t) * 6 * SPRITE_BATCH_MAX_SPRITES
+	);
+	CommandCapture_FNA3D_SetIndexBufferData(
+		device,
+		batch->indexBuffer,
+		0,
+		indices,
+		sizeof(uint16_t) * 6 * SPRITE_BATCH_MAX_SPRITES,
+		FNA3D_SETDATAOPTIONS_NONE
+	);
+	SDL_free(indices);
+
+	batch->vertexElements[0].offset = 0;
+	batch->vertexElements[0].usageIndex = 0;
+	batch->vertexElements[0].vertexElementFormat = FNA3D_VERTEXELEMENTFORMAT_VECTOR2;
+	batch->vertexElements[0].vertexElementUsage = FNA3D_VERTEXELEMENTUSAGE_POSITION;
+
+	batch->vertexElements[1].offset = sizeof(float) * 2;
+	batch->vertexElements[1].usageIndex = 0;
+	batch->vertexElements[1].vertexElementFormat = FNA3D_VERTEXELEMENTFORMAT_VECTOR2;
+	batch->vertexElements[1].vertexElementUsage = FNA3D_VERTEXELEMENTUSAGE_TEXTURECOORDINATE;
+
+	batch->vertexElements[2].offset = sizeof(float) * 4;
+	batch->vertexElements[2].usageIndex = 0;
+	batch->vertexElements[2].vertexElementFormat = FNA3D_VERTEXELEMENTFORMAT_COLOR;
+	batch->vertexElements[2].vertexElementUsage = FNA3D_VERTEXELEMENTUSAGE_COLOR;
+
+	batch->vertexBufferBinding.instanceFrequency = 0;
+	batch->vertexBufferBinding.vertexBuffer = batch->vertexBuffer;
+	batch->vertexBufferBinding.vertexDeclaration.elementCount = 3;
+	batch->vertexBufferBinding.vertexDeclaration.vertexStride = sizeof(SpriteBatchVertex);
+	batch->vertexBufferBinding.vertexDeclaration.elements = batch->vertexElements;
+	batch->vertexBufferBinding.vertexOffset = 0;
+
+	SDL_memset(&batch->samplerState, 0, sizeof(batch->samplerState));
+	batch->samplerState.addressU = FNA3D_TEXTUREADDRESSMODE_CLAMP;
+	batch->samplerState.addressV = FNA3D_TEXTUREADDRESSMODE_CLAMP;
+	batch->samplerState.addressW = FNA3D_TEXTUREADDRESSMODE_WRAP;
+	batch->samplerState.filter = FNA3D_TEXTUREFILTER_LINEAR;
+	batch->samplerState.maxAnisotropy = 4;
+	batch->samplerState.maxMipLevel = 0;
+	batch->samplerState.mipMapLevelOfDetailBias = 0;
+
+	SpriteBatch_Reserve(batch, SPRITE_BATCH_INITIAL_CAPACITY);
+
+	return batch;
+}
+
+void SpriteBatch_Destroy(SpriteBatch *batch)
+{
+	CommandCapture_FNA3D_AddDisposeVertexBuffer(batch->device, batch->vertexBuffer);
+	CommandCapture_FNA3D_AddDisposeIndexBuffer(batch->device, batch->indexBuffer);
+
+	SDL_free(batch->items);
+	SDL_free(batch->sortKeys);
+	SDL_free(batch->vertices);
+	SDL_free(batch);
+}
+
+void SpriteBatch_Begin(
+	SpriteBatch *batch,
+	SpriteSortMode sortMode,
+	uint32_t width,
+	uint32_t height
+) {
+	batch->sortMode = sortMode;
+	batch->itemCount = 0;
+
+	/* OrthographicOffCenter over the target, laid out as the XNA project had it */
+	SDL_memset(batch->projection, 0, sizeof(batch->projection));
+	batch->projection[0] = 2.0f / width;
+	batch->projection[3] = -1.0f;
+	batch->projection[5] = -2.0f / height;
+	batch->projection[7] = 1.0f;
+	batch->projection[10] = 1.0f;
+	batch->projection[15] = 1.0f;
+}
+
+void SpriteBatch_Draw(
+	SpriteBatch *batch,
+	FNA3D_Texture *texture,
+	float x,
+	float y,
+	float w,
+	float h,
+	float u0,
+	float v0,
+	float u1,
+	float v1,
+	uint32_t color
+) {
+	SpriteBatch_Reserve(batch, batch->itemCount + 1);
+
+	SpriteBatchItem *item = &batch->items[batch->itemCount];
+	item->texture = texture;
+	item->x = x;
+	item->y = y;
+	item->w = w;
+	item->h = h;
+	item->u0 = u0;
+	item->v0 = v0;
+	item->u1 = u1;
+	item->v1 = v1;
+	item->color = color;
+
+	batch->itemCount += 1;
+}
+
+static void SpriteBatch_DrawRun(
+	SpriteBatch *batch,
+	FNA3D_Texture *texture,
+	uint32_t firstSprite,
+	uint32_t spriteCount
+) {
+	int32_t baseVertex = firstSprite * 4;
+
+	StateCache_VerifySampler(batch->stateCache, 0, texture, &batch->samplerState);
+	StateCache_ApplyVertexBufferBindings(batch->stateCache, &batch->vertexBufferBinding, 1, baseVertex);
+	CommandCapture_FNA3D_DrawIndexedPrimitives(
+		batch->device,
+		FNA3D_PRIMITIVETYPE_TRIANGLELIST,
+		baseVertex,
+		0,
+		spriteCount * 4,
+		0,
+		spriteCount * 2,
+		batch->indexBuffer,
+		FNA3D_INDEXELEMENTSIZE_16BIT
+	);
+
+	batch->drawCallCount += 1;
+}
+
+void SpriteBatch_End(SpriteBatch *batch)
+{
+	uint32_t count = batch->itemCount;
+
+	batch->drawCallCount = 0;
+
+	if (count == 0)
+	{
+		return;
+	}
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		batch->sortKeys[i].texture = (uintptr_t) batch->items[i].texture;
+		batch->sortKeys[i].index = i;
+	}
+
+	if (batch->sortMode == SPRITE_SORT_TEXTURE)
+	{
+		SDL_qsort(batch->sortKeys, count, sizeof(SpriteBatchSortKey), SpriteBatch_CompareKeys);
+	}
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		SpriteBatchItem *item = &batch->items[batch->sortKeys[i].index];
+		SpriteBatchVertex *vertex = &batch->vertices[i * 4];
+
+		vertex[0].x = item->x;
+		vertex[0].y = item->y;
+		vertex[0].u = item->u0;
+		vertex[0].v = item->v0;
+		vertex[0].color = item->color;
+
+		vertex[1].x = item->x + item->w;
+		vertex[1].y = item->y;
+		vertex[1].u = item->u1;
+		vertex[1].v = item->v0;
+		vertex[1].color = item->color;
+
+		vertex[2].x = item->x + item->w;
+		vertex[2].y = item->y + item->h;
+		vertex[2].u = item->u1;
+		vertex[2].v = item->v1;
+		vertex[2].color = item->color;
+
+		vertex[3].x = item->x;
+		vertex[3].y = item->y + item->h;
+		vertex[3].u = item->u0;
+		vertex[3].v = item->v1;
+		vertex[3].color = item->color;
+	}
+
+	StateCache_SetEffectParam(
+		batch->stateCache,
+		batch->effectData,
+		batch->matrixTransformParam,
+		batch->projection,
+		sizeof(batch->projection)
+	);
+	StateCache_ApplyEffect(batch->stateCache, batch->effect, 0);
+
+	uint32_t first = 0;
+
+	while (first < count)
+	{
+		uint32_t segmentCount = SDL_min(count - first, SPRITE_BATCH_MAX_SPRITES);
+		FNA3D_SetDataOptions options = FNA3D_SETDATAOPTIONS_NOOVERWRITE;
+
+		/* Start over in a fresh buffer instead of writing over sprites the GPU may still read */
+		if (batch->vertexBufferOffset + segmentCount > SPRITE_BATCH_MAX_SPRITES)
+		{
+			batch->vertexBufferOffset = 0;
+			options = FNA3D_SETDATAOPTIONS_DISCARD;
+		}
+
+		CommandCapture_FNA3D_SetVertexBufferData(
+			batch->device,
+			batch->vertexBuffer,
+			batch->vertexBufferOffset * 4 * sizeof(SpriteBatchVertex),
+			&batch->vertices[first * 4],
+			segmentCount * 4,
+			sizeof(SpriteBatchVertex),
+			sizeof(SpriteBatchVertex),
+			options
+		);
+
+		/* One draw per run of sprites sharing a texture */
+		uint32_t runStart = first;
+		for (uint32_t i = first + 1; i <= first + segmentCount; i++)
+		{
+			if (	i == first + segmentCount ||
+				batch->sortKeys[i].texture != batch->sortKeys[runStart].texture	)
+			{
+				SpriteBatch_DrawRun(
+					batch,
+					batch->items[batch->sortKeys[runStart].index].texture,
+					batch->vertexBufferOffset + (runStart - first),
+					i - runStart
+				);
+				runStart = i;
+			}
+		}
+
+		batch->vertexBufferOffset += segmentCount;
+		first += segmentCount;
+	}
+
+	batch->itemCount = 0;
+}
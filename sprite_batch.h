@@ -0,0 +1,126 @@
+#ifndef SPRITE_BATCH_H
+#define SPRITE_BATCH_H
+
+/* SpriteBatch-style quad batching for the FNA3D pass, drawn with
+ * SpriteEffect.fxb.
+ *
+ * Draw only records the sprite; End sorts, builds the vertices and issues
+ * the draws. Vertices stream into one large dynamic vertex buffer, appended
+ * with NOOVERWRITE until it is full and then restarted with DISCARD, so
+ * FNA3D never has to wait on or copy a buffer the GPU is still reading.
+ * The index buffer is static: every sprite is the same two triangles, and
+ * each draw picks its sprites with baseVertex.
+ *
+ * Effect, sampler and vertex binding calls go through the StateCache, so a
+ * run of draws only pays for the state that actually changes between them.
+ */
+
+#include <stdint.h>
+
+#include <FNA3D.h>
+
+#define MOJOSHADER_NO_VERSION_INCLUDE
+#define MOJOSHADER_EFFECT_SUPPORT
+#include <mojoshader.h>
+#include <mojoshader_effects.h>
+
+#include "state_cache.h"
+
+/* Sprites per draw call and per pass through the vertex buffer, the most
+ * 16-bit indices can address
+ */
+#define SPRITE_BATCH_MAX_SPRITES 16384
+
+typedef enum SpriteSortMode
+{
+	SPRITE_SORT_DEFERRED,	/* submission order */
+	SPRITE_SORT_TEXTURE	/* grouped by texture, fewest draw calls */
+} SpriteSortMode;
+
+typedef struct SpriteBatchVertex
+{
+	float x, y;
+	float u, v;
+	uint32_t color;
+} SpriteBatchVertex;
+
+typedef struct SpriteBatchItem
+{
+	FNA3D_Texture *texture;
+	float x, y, w, h;
+	float u0, v0, u1, v1;
+	uint32_t color;
+} SpriteBatchItem;
+
+typedef struct SpriteBatchSortKey
+{
+	uintptr_t texture;
+	uint32_t index;
+} SpriteBatchSortKey;
+
+typedef struct SpriteBatch
+{
+	FNA3D_Device *device;
+	StateCache *stateCache;
+	FNA3D_Effect *effect;
+	MOJOSHADER_effect *effectData;
+	int32_t matrixTransformParam;
+
+	FNA3D_Buffer *vertexBuffer;
+	FNA3D_Buffer *indexBuffer;
+	FNA3D_VertexElement vertexElements[3];
+	FNA3D_VertexBufferBinding vertexBufferBinding;
+	FNA3D_SamplerState samplerState;
+
+	/* Sprites already in the vertex buffer since the last DISCARD */
+	uint32_t vertexBufferOffset;
+
+	SpriteSortMode sortMode;
+	float projection[16];
+
+	SpriteBatchItem *items;
+	SpriteBatchSortKey *sortKeys;
+	SpriteBatchVertex *vertices;
+	uint32_t itemCount;
+	uint32_t itemCapacity;
+
+	/* Statistics for the last End */
+	uint32_t drawCallCount;
+} SpriteBatch;
+
+/* The state cache and effect stay owned by the caller */
+SpriteBatch* SpriteBatch_Create(
+	FNA3D_Device *device,
+	StateCache *stateCache,
+	FNA3D_Effect *effect,
+	MOJOSHADER_effect *effectData
+);
+
+void SpriteBatch_Destroy(SpriteBatch *batch);
+
+/* Sprite coordinates are pixels in a width x height target */
+void SpriteBatch_Begin(
+	SpriteBatch *batch,
+	SpriteSortMode sortMode,
+	uint32_t width,
+	uint32_t height
+);
+
+void SpriteBatch_Draw(
+	SpriteBatch *batch,
+	FNA3D_Texture *texture,
+	float x,
+	float y,
+	float w,
+	float h,
+	float u0,
+	float v0,
+	float u1,
+	float v1,
+	uint32_t color
+);
+
+/* Applies the effect and draws everything since Begin */
+void SpriteBatch_End(SpriteBatch *batch);
+
+#endif /* SPRITE_BATCH_H */
@@ -0,0 +1,175 @@
+#include "sprite_bench.h"
+
+#include <SDL.h>
+
+#include "command_capture.h"
+
+#define SPRITE_BENCH_TEXTURE_SIZE 16
+#define SPRITE_BENCH_SPRITE_SIZE 12.0f
+
+static const uint32_t textureColors[SPRITE_BENCH_TEXTURE_COUNT] =
+{
+	0xff3030e0, 0xff30e030, 0xffe03030, 0xff30e0e0
+};
+
+/* Per-sprite constants derived from the index, so nothing is stored per sprite */
+static uint32_t SpriteBench_Hash(uint32_t n)
+{
+	n = (n ^ 61) ^ (n >> 16);
+	n = n + (n << 3);
+	n = n ^ (n >> 4);
+	n = n * 0x27d4eb2d;
+	n = n ^ (n >> 15);
+	return n;
+}
+
+SpriteBench* SpriteBench_Create(
+	FNA3D_Device *device,
+	uint32_t spriteCount,
+	SpriteSortMode sortMode,
+	uint32_t width,
+	uint32_t height
+) {
+	SpriteBench *bench = SDL_malloc(sizeof(SpriteBench));
+	SDL_memset(bench, 0, sizeof(SpriteBench));
+
+	bench->device = device;
+	bench->spriteCount = spriteCount;
+	bench->sortMode = sortMode;
+	bench->width = width;
+	bench->height = height;
+
+	uint32_t pixels[SPRITE_BENCH_TEXTURE_SIZE * SPRITE_BENCH_TEXTURE_SIZE];
+
+	for (uint32_t i = 0; i < SPRITE_BENCH_TEXTURE_COUNT; i++)
+	{
+		/* A solid square with a one texel dark border, so overlapping sprites stay distinguishable */
+		for (uint32_t y = 0; y < SPRITE_BENCH_TEXTURE_SIZE; y++)
+		{
+			for (uint32_t x = 0; x < SPRITE_BENCH_TEXTURE_SIZE; x++)
+			{
+				uint8_t border =
+					x == 0 || y == 0 ||
+					x == SPRITE_BENCH_TEXTURE_SIZE - 1 ||
+					y == SPRITE_BENCH_TEXTURE_SIZE - 1;
+				pixels[y * SPRITE_BENCH_TEXTURE_SIZE + x] = border ? 0xff000000 : textureColors[i];
+			}
+		}
+
+		bench->textures[i] = CommandCapture_FNA3D_CreateTexture2D(
+			device,
+			FNA3D_SURFACEFORMAT_COLOR,
+			SPRITE_BENCH_TEXTURE_SIZE,
+			SPRITE_BENCH_TEXTURE_SIZE,
+			1,
+			0
+		);
+
+		CommandCapture_FNA3D_SetTextureData2D(
+			device,
+			bench->textures[i],
+			0,
+			0,
+			SPRITE_BENCH_TEXTURE_SIZE,
+			SPRITE_BENCH_TEXTURE_SIZE,
+			0,
+			pixels,
+			sizeof(pixels)
+		);
+	}
+
+	return bench;
+}
+
+void SpriteBench_Destroy(SpriteBench *bench)
+{
+	for (uint32_t i = 0; i < SPRITE_BENCH_TEXTURE_COUNT; i++)
+	{
+		CommandCapture_FNA3D_AddDisposeTexture(bench->device, bench->textures[i]);
+	}
+
+	SDL_free(bench);
+}
+
+void SpriteBench_Draw(SpriteBench *bench, SpriteBatch *batch, double t)
+{
+	uint64_t batchStart = SDL_GetPerformanceCounter();
+
+	float rangeX = bench->width - SPRITE_BENCH_SPRITE_SIZE;
+	float rangeY = bench->height - SPRITE_BENCH_SPRITE_SIZE;
+
+	SpriteBatch_Begin(batch, bench->sortMode, bench->width, bench->height);
+
+	for (uint32_t i = 0; i < bench->spriteCount; i++)
+	{
+		uint32_t hash = SpriteBench_Hash(i);
+
+		/* Start anywhere, drift at up to 64 pixels a second on each axis, wrap at the edges */
+		float startX = (hash & 0xFFFF) / 65535.0f;
+		float startY = (hash >> 16) / 65535.0f;
+		float speedX = ((int32_t) (hash & 0xFF) - 128) * 0.5f;
+		float speedY = ((int32_t) ((hash >> 8) & 0xFF) - 128) * 0.5f;
+
+		float x = SDL_fmodf(startX * rangeX + speedX * (float) t, rangeX);
+		float y = SDL_fmodf(startY * rangeY + speedY * (float) t, rangeY);
+		if (x < 0.0f)
+		{
+			x += rangeX;
+		}
+		if (y < 0.0f)
+		{
+			y += rangeY;
+		}
+
+		SpriteBatch_Draw(
+			batch,
+			bench->textures[i % SPRITE_BENCH_TEXTURE_COUNT],
+			x,
+			y,
+			SPRITE_BENCH_SPRITE_SIZE,
+			SPRITE_BENCH_SPRITE_SIZE,
+			0.0f,
+			0.0f,
+			1.0f,
+			1.0f,
+			0xffffffff
+		);
+	}
+
+	SpriteBatch_End(batch);
+
+	bench->frameCount += 1;
+	bench->drawCallCount += batch->drawCallCount;
+	bench->batchTicks += SDL_GetPerformanceCounter() - batchStart;
+}
+
+void SpriteBench_Report(SpriteBench *bench, double seconds, FILE *output)
+{
+	if (bench->frameCount == 0)
+	{
+		fprintf(output, "sprites: no frames drawn\n");
+		return;
+	}
+
+	double batchSeconds = bench->batchTicks / (double) SDL_GetPerformanceFrequency();
+	double totalSprites = (double) bench->spriteCount * bench->frameCount;
+
+	fprintf(
+		output,
+		"sprites: %u per frame, %s sort, %.1f draw calls per frame\n",
+		bench->spriteCount,
+		bench->sortMode == SPRITE_SORT_TEXTURE ? "texture" : "deferred",
+		bench->drawCallCount / (double) bench->frameCount
+	);
+	fprintf(
+		output,
+		"  batching cpu time    %.3f ms per frame, %.2f M sprites/s\n",
+		batchSeconds * 1000.0 / bench->frameCount,
+		totalSprites / batchSeconds / 1000000.0
+	);
+
+	if (seconds > 0.0)
+	{
+		fprintf(output, "  end to end           %.2f M sprites/s\n", totalSprites / seconds / 1000000.0);
+	}
+}
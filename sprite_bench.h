@@ -0,0 +1,50 @@
+#ifndef SPRITE_BENCH_H
+#define SPRITE_BENCH_H
+
+/* --sprites N: N small moving sprites drawn through the SpriteBatch on top
+ * of the Refresh output every frame, spread over a few textures in
+ * interleaved order so texture sorting has something to do.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <FNA3D.h>
+
+#include "sprite_batch.h"
+
+#define SPRITE_BENCH_TEXTURE_COUNT 4
+
+typedef struct SpriteBench
+{
+	FNA3D_Device *device;
+	FNA3D_Texture *textures[SPRITE_BENCH_TEXTURE_COUNT];
+
+	uint32_t spriteCount;
+	uint32_t width;
+	uint32_t height;
+	SpriteSortMode sortMode;
+
+	/* Statistics */
+	uint32_t frameCount;
+	uint64_t drawCallCount;
+	uint64_t batchTicks;
+} SpriteBench;
+
+SpriteBench* SpriteBench_Create(
+	FNA3D_Device *device,
+	uint32_t spriteCount,
+	SpriteSortMode sortMode,
+	uint32_t width,
+	uint32_t height
+);
+
+void SpriteBench_Destroy(SpriteBench *bench);
+
+/* Batches and draws every sprite at time t */
+void SpriteBench_Draw(SpriteBench *bench, SpriteBatch *batch, double t);
+
+/* seconds is the wall time of the frames drawn, or 0 if unknown */
+void SpriteBench_Report(SpriteBench *bench, double seconds, FILE *output);
+
+#endif /* SPRITE_BENCH_H */
@@ -0,0 +1,267 @@
+#include "state_cache.h"
+
+#include <SDL.h>
+
+#include "command_capture.h"
+
+static const char *callNames[STATE_CACHE_CALL_COUNT] =
+{
+	"blend state",
+	"depth stencil state",
+	"rasterizer state",
+	"viewport",
+	"sampler",
+	"vertex bindings",
+	"effect"
+};
+
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+static uint64_t StateCache_Hash(uint64_t hash, const void *data, size_t size)
+{
+	const uint8_t *bytes = (const uint8_t*) data;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= FNV_PRIME;
+	}
+
+	return hash;
+}
+
+/* Returns 1 if the call has to go through, and records it either way */
+static uint8_t StateCache_Check(StateCache *cache, StateCacheCall call, uint64_t hash)
+{
+	if (cache->valid[call] && cache->hashes[call] == hash)
+	{
+		cache->elidedCounts[call] += 1;
+		return 0;
+	}
+
+	cache->hashes[call] = hash;
+	cache->valid[call] = 1;
+	cache->issuedCounts[call] += 1;
+	return 1;
+}
+
+void StateCache_Init(StateCache *cache, FNA3D_Device *device)
+{
+	SDL_memset(cache, 0, sizeof(StateCache));
+	cache->device = device;
+}
+
+void StateCache_Invalidate(StateCache *cache)
+{
+	SDL_memset(cache->valid, 0, sizeof(cache->valid));
+	SDL_memset(cache->samplerValid, 0, sizeof(cache->samplerValid));
+	cache->effect = NULL;
+	cache->effectDirty = 0;
+}
+
+void StateCache_EndFrame(StateCache *cache)
+{
+	cache->effect = NULL;
+}
+
+void StateCache_SetBlendState(StateCache *cache, FNA3D_BlendState *blendState)
+{
+	uint64_t hash = StateCache_Hash(FNV_OFFSET_BASIS, blendState, sizeof(FNA3D_BlendState));
+
+	if (StateCache_Check(cache, STATE_CACHE_CALL_BLEND, hash))
+	{
+		CommandCapture_FNA3D_SetBlendState(cache->device, blendState);
+	}
+}
+
+void StateCache_SetDepthStencilState(StateCache *cache, FNA3D_DepthStencilState *depthStencilState)
+{
+	uint64_t hash = StateCache_Hash(FNV_OFFSET_BASIS, depthStencilState, sizeof(FNA3D_DepthStencilState));
+
+	if (StateCache_Check(cache, STATE_CACHE_CALL_DEPTH_STENCIL, hash))
+	{
+		CommandCapture_FNA3D_SetDepthStencilState(cache->device, depthStencilState);
+	}
+}
+
+void StateCache_ApplyRasterizerState(StateCache *cache, FNA3D_RasterizerState *rasterizerState)
+{
+	uint64_t hash = StateCache_Hash(FNV_OFFSET_BASIS, rasterizerState, sizeof(FNA3D_RasterizerState));
+
+	if (StateCache_Check(cache, STATE_CACHE_CALL_RASTERIZER, hash))
+	{
+		CommandCapture_FNA3D_ApplyRasterizerState(cache->device, rasterizerState);
+	}
+}
+
+void StateCache_SetViewport(StateCache *cache, FNA3D_Viewport *viewport)
+{
+	uint64_t hash = StateCache_Hash(FNV_OFFSET_BASIS, viewport, sizeof(FNA3D_Viewport));
+
+	if (StateCache_Check(cache, STATE_CACHE_CALL_VIEWPORT, hash))
+	{
+		CommandCapture_FNA3D_SetViewport(cache->device, viewport);
+	}
+}
+
+void StateCache_VerifySampler(
+	StateCache *cache,
+	int32_t index,
+	FNA3D_Texture *texture,
+	FNA3D_SamplerState *samplerState
+) {
+	uint64_t hash = StateCache_Hash(FNV_OFFSET_BASIS, &texture, sizeof(texture));
+	hash = StateCache_Hash(hash, samplerState, sizeof(FNA3D_SamplerState));
+
+	/* Slots past the tracked ones always go through */
+	if (index < 0 || index >= STATE_CACHE_SAMPLER_SLOTS)
+	{
+		cache->issuedCounts[STATE_CACHE_CALL_SAMPLER] += 1;
+		CommandCapture_FNA3D_VerifySampler(cache->device, index, texture, samplerState);
+		return;
+	}
+
+	if (cache->samplerValid[index] && cache->samplerHashes[index] == hash)
+	{
+		cache->elidedCounts[STATE_CACHE_CALL_SAMPLER] += 1;
+		return;
+	}
+
+	cache->samplerHashes[index] = hash;
+	cache->samplerValid[index] = 1;
+	cache->issuedCounts[STATE_CACHE_CALL_SAMPLER] += 1;
+	CommandCapture_FNA3D_VerifySampler(cache->device, index, texture, samplerState);
+}
+
+void StateCache_ApplyVertexBufferBindings(
+	StateCache *cache,
+	FNA3D_VertexBufferBinding *bindings,
+	int32_t bindingCount,
+	int32_t baseVertex
+) {
+	/* The call itself always goes through, since it also binds the pipeline
+	 * for the current state. What the cache saves is FNA3D rehashing the
+	 * vertex declarations, so the hash covers the elements they point to.
+	 */
+	uint64_t hash = StateCache_Hash(FNV_OFFSET_BASIS, &bindingCount, sizeof(bindingCount));
+	for (int32_t i = 0; i < bindingCount; i++)
+	{
+		hash = StateCache_Hash(hash, &bindings[i], sizeof(FNA3D_VertexBufferBinding));
+		hash = StateCache_Hash(
+			hash,
+			bindings[i].vertexDeclaration.elements,
+			sizeof(FNA3D_VertexElement) * bindings[i].vertexDeclaration.elementCount
+		);
+	}
+
+	uint8_t bindingsUpdated = StateCache_Check(cache, STATE_CACHE_CALL_VERTEX_BUFFERS, hash);
+
+	CommandCapture_FNA3D_ApplyVertexBufferBindings(cache->device, bindings, bindingCount, bindingsUpdated, baseVertex);
+}
+
+void StateCache_SetRenderTargets(
+	StateCache *cache,
+	FNA3D_RenderTargetBinding *renderTargets,
+	int32_t renderTargetCount,
+	FNA3D_Renderbuffer *depthStencilBuffer,
+	FNA3D_DepthFormat depthFormat,
+	uint8_t preserveTargetContents
+) {
+	CommandCapture_FNA3D_SetRenderTargets(
+		cache->device,
+		renderTargets,
+		renderTargetCount,
+		depthStencilBuffer,
+		depthFormat,
+		preserveTargetContents
+	);
+
+	cache->valid[STATE_CACHE_CALL_VIEWPORT] = 0;
+}
+
+int32_t StateCache_FindEffectParam(MOJOSHADER_effect *effectData, const char *name)
+{
+	for (int32_t i = 0; i < effectData->param_count; i++)
+	{
+		if (SDL_strcmp(name, effectData->params[i].value.name) == 0)
+		{
+			return i;
+		}
+	}
+
+	SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Effect parameter %s not found", name);
+	return -1;
+}
+
+void StateCache_SetEffectParam(
+	StateCache *cache,
+	MOJOSHADER_effect *effectData,
+	int32_t param,
+	const void *value,
+	size_t size
+) {
+	if (param < 0)
+	{
+		return;
+	}
+
+	void *values = effectData->params[param].value.values;
+
+	if (SDL_memcmp(values, value, size) != 0)
+	{
+		SDL_memcpy(values, value, size);
+		cache->effectDirty = 1;
+	}
+}
+
+void StateCache_ApplyEffect(StateCache *cache, FNA3D_Effect *effect, uint32_t pass)
+{
+	if (	cache->effect == effect &&
+		cache->effectPass == pass &&
+		!cache->effectDirty	)
+	{
+		cache->elidedCounts[STATE_CACHE_CALL_EFFECT] += 1;
+		return;
+	}
+
+	MOJOSHADER_effectStateChanges stateChanges;
+	SDL_memset(&stateChanges, 0, sizeof(stateChanges));
+	CommandCapture_FNA3D_ApplyEffect(cache->device, effect, pass, &stateChanges);
+
+	cache->effect = effect;
+	cache->effectPass = pass;
+	cache->effectDirty = 0;
+	cache->issuedCounts[STATE_CACHE_CALL_EFFECT] += 1;
+}
+
+void StateCache_Report(StateCache *cache, FILE *output)
+{
+	uint64_t issued = 0;
+	uint64_t elided = 0;
+
+	fprintf(output, "fna3d state calls:    issued     elided\n");
+
+	for (int i = 0; i < STATE_CACHE_CALL_COUNT; i++)
+	{
+		fprintf(
+			output,
+			"  %-20s %10llu %10llu\n",
+			callNames[i],
+			(unsigned long long) cache->issuedCounts[i],
+			(unsigned long long) cache->elidedCounts[i]
+		);
+
+		issued += cache->issuedCounts[i];
+		elided += cache->elidedCounts[i];
+	}
+
+	fprintf(
+		output,
+		"  %-20s %10llu %10llu (%.1f%% elided)\n",
+		"total",
+		(unsigned long long) issued,
+		(unsigned long long) elided,
+		issued + elided > 0 ? elided * 100.0 / (issued + elided) : 0.0
+	);
+}
@@ -0,0 +1,122 @@
+#ifndef STATE_CACHE_H
+#define STATE_CACHE_H
+
+/* Redundant state filtering in front of FNA3D.
+ *
+ * Each state struct is hashed (64-bit FNV-1a over its bytes) and compared
+ * with the hash of what was last sent, and the backend call is skipped when
+ * they match. Callers must build state structs the same way every time,
+ * zeroing them first, so padding doesn't make equal states hash apart.
+ *
+ * Effect parameters are looked up by name once and set through their
+ * index; a changed value marks the effect dirty, which is the only thing
+ * besides a different effect or pass that makes ApplyEffect go through.
+ *
+ * Vertex buffer bindings always reach FNA3D, since that call also binds
+ * the pipeline; the cache only works out bindingsUpdated, and "elided"
+ * counts the calls where FNA3D could skip rehashing the declarations.
+ *
+ * Anything that changes FNA3D state behind the cache's back, including
+ * disposing a texture that may still be bound, must be followed by
+ * StateCache_Invalidate.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <FNA3D.h>
+
+#define MOJOSHADER_NO_VERSION_INCLUDE
+#define MOJOSHADER_EFFECT_SUPPORT
+#include <mojoshader.h>
+#include <mojoshader_effects.h>
+
+#define STATE_CACHE_SAMPLER_SLOTS 16
+
+typedef enum StateCacheCall
+{
+	STATE_CACHE_CALL_BLEND,
+	STATE_CACHE_CALL_DEPTH_STENCIL,
+	STATE_CACHE_CALL_RASTERIZER,
+	STATE_CACHE_CALL_VIEWPORT,
+	STATE_CACHE_CALL_SAMPLER,
+	STATE_CACHE_CALL_VERTEX_BUFFERS,
+	STATE_CACHE_CALL_EFFECT,
+	STATE_CACHE_CALL_COUNT
+} StateCacheCall;
+
+typedef struct StateCache
+{
+	FNA3D_Device *device;
+
+	uint64_t hashes[STATE_CACHE_CALL_COUNT];
+	uint8_t valid[STATE_CACHE_CALL_COUNT];
+
+	uint64_t samplerHashes[STATE_CACHE_SAMPLER_SLOTS];
+	uint8_t samplerValid[STATE_CACHE_SAMPLER_SLOTS];
+
+	FNA3D_Effect *effect;
+	uint32_t effectPass;
+	uint8_t effectDirty;
+
+	/* Statistics */
+	uint64_t issuedCounts[STATE_CACHE_CALL_COUNT];
+	uint64_t elidedCounts[STATE_CACHE_CALL_COUNT];
+} StateCache;
+
+void StateCache_Init(StateCache *cache, FNA3D_Device *device);
+
+/* Forgets everything, the next call of each kind always goes through */
+void StateCache_Invalidate(StateCache *cache);
+
+/* Forgets the applied effect, since the uniform memory it was pushed into
+ * is recycled per frame; fixed-function state survives
+ */
+void StateCache_EndFrame(StateCache *cache);
+
+void StateCache_SetBlendState(StateCache *cache, FNA3D_BlendState *blendState);
+void StateCache_SetDepthStencilState(StateCache *cache, FNA3D_DepthStencilState *depthStencilState);
+void StateCache_ApplyRasterizerState(StateCache *cache, FNA3D_RasterizerState *rasterizerState);
+void StateCache_SetViewport(StateCache *cache, FNA3D_Viewport *viewport);
+
+void StateCache_VerifySampler(
+	StateCache *cache,
+	int32_t index,
+	FNA3D_Texture *texture,
+	FNA3D_SamplerState *samplerState
+);
+
+void StateCache_ApplyVertexBufferBindings(
+	StateCache *cache,
+	FNA3D_VertexBufferBinding *bindings,
+	int32_t bindingCount,
+	int32_t baseVertex
+);
+
+/* Passes through, and forgets the viewport since a new target needs a new one */
+void StateCache_SetRenderTargets(
+	StateCache *cache,
+	FNA3D_RenderTargetBinding *renderTargets,
+	int32_t renderTargetCount,
+	FNA3D_Renderbuffer *depthStencilBuffer,
+	FNA3D_DepthFormat depthFormat,
+	uint8_t preserveTargetContents
+);
+
+/* Returns the parameter's index for StateCache_SetEffectParam, or -1 */
+int32_t StateCache_FindEffectParam(MOJOSHADER_effect *effectData, const char *name);
+
+void StateCache_SetEffectParam(
+	StateCache *cache,
+	MOJOSHADER_effect *effectData,
+	int32_t param,
+	const void *value,
+	size_t size
+);
+
+void StateCache_ApplyEffect(StateCache *cache, FNA3D_Effect *effect, uint32_t pass);
+
+void StateCache_Report(StateCache *cache, FILE *output);
+
+#endif /* STATE_CACHE_H */
@@ -0,0 +1,273 @@
+#include "texture_compress.h"
+
+#include <SDL.h>
+
+void TextureCompress_Downsample(
+	const uint8_t *src,
+	uint32_t width,
+	uint32_t height,
+	uint8_t *dst
+) {
+	uint32_t dstWidth = SDL_max(1, width / 2);
+	uint32_t dstHeight = SDL_max(1, height / 2);
+
+	for (uint32_t y = 0; y < dstHeight; y++)
+	{
+		uint32_t y0 = y * 2;
+		uint32_t y1 = SDL_min(y0 + 1, height - 1);
+		for (uint32_t x = 0; x < dstWidth; x++)
+		{
+			uint32_t x0 = x * 2;
+			uint32_t x1 = SDL_min(x0 + 1, width - 1);
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				dst[(y * dstWidth + x) * 4 + c] = (uint8_t) ((
+					src[(y0 * width + x0) * 4 + c] +
+					src[(y0 * width + x1) * 4 + c] +
+					src[(y1 * width + x0) * 4 + c] +
+					src[(y1 * width + x1) * 4 + c] +
+					2
+				) / 4);
+			}
+		}
+	}
+}
+
+/* Edge blocks of small or odd-sized levels repeat the last row/column */
+static void TextureCompress_FetchBlock(
+	const uint8_t *rgba,
+	uint32_t width,
+	uint32_t height,
+	uint32_t blockX,
+	uint32_t blockY,
+	uint8_t block[16][4]
+) {
+	for (uint32_t y = 0; y < 4; y++)
+	{
+		uint32_t sy = SDL_min(blockY * 4 + y, height - 1);
+		for (uint32_t x = 0; x < 4; x++)
+		{
+			uint32_t sx = SDL_min(blockX * 4 + x, width - 1);
+			SDL_memcpy(block[y * 4 + x], &rgba[(sy * width + sx) * 4], 4);
+		}
+	}
+}
+
+static uint16_t TextureCompress_Pack565(const uint8_t *color)
+{
+	uint32_t r = (color[0] * 31 + 127) / 255;
+	uint32_t g = (color[1] * 63 + 127) / 255;
+	uint32_t b = (color[2] * 31 + 127) / 255;
+
+	return (uint16_t) ((r << 11) | (g << 5) | b);
+}
+
+static void TextureCompress_Unpack565(uint16_t packed, int32_t *color)
+{
+	int32_t r = (packed >> 11) & 0x1F;
+	int32_t g = (packed >> 5) & 0x3F;
+	int32_t b = packed & 0x1F;
+
+	color[0] = (r << 3) | (r >> 2);
+	color[1] = (g << 2) | (g >> 4);
+	color[2] = (b << 3) | (b >> 2);
+}
+
+static void TextureCompress_ColorBlock(uint8_t block[16][4], uint8_t *dst)
+{
+	float mean[3] = { 0.0f, 0.0f, 0.0f };
+	float covariance[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+
+	/* Endpoints are the extreme pixels along the principal axis, which
+	 * unlike the bounding box diagonal also handles anticorrelated channels
+	 */
+	for (uint32_t i = 0; i < 16; i++)
+	{
+		for (uint32_t j = 0; j < 3; j++)
+		{
+			mean[j] += block[i][j] / 16.0f;
+		}
+	}
+	for (uint32_t i = 0; i < 16; i++)
+	{
+		float d[3];
+		d[0] = block[i][0] - mean[0];
+		d[1] = block[i][1] - mean[1];
+		d[2] = block[i][2] - mean[2];
+		covariance[0] += d[0] * d[0];
+		covariance[1] += d[0] * d[1];
+		covariance[2] += d[0] * d[2];
+		covariance[3] += d[1] * d[1];
+		covariance[4] += d[1] * d[2];
+		covariance[5] += d[2] * d[2];
+	}
+
+	float axis[3] = { 1.0f, 1.0f, 1.0f };
+	for (uint32_t i = 0; i < 8; i++)
+	{
+		float next[3];
+		next[0] = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+		next[1] = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+		next[2] = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+		float length = SDL_sqrtf(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+		if (length < 1e-6f)
+		{
+			break;
+		}
+		axis[0] = next[0] / length;
+		axis[1] = next[1] / length;
+		axis[2] = next[2] / length;
+	}
+
+	float minT = block[0][0] * axis[0] + block[0][1] * axis[1] + block[0][2] * axis[2];
+	float maxT = minT;
+	uint32_t minIndex = 0, maxIndex = 0;
+	for (uint32_t i = 1; i < 16; i++)
+	{
+		float t = block[i][0] * axis[0] + block[i][1] * axis[1] + block[i][2] * axis[2];
+		if (t < minT)
+		{
+			minT = t;
+			minIndex = i;
+		}
+		if (t > maxT)
+		{
+			maxT = t;
+			maxIndex = i;
+		}
+	}
+
+	uint16_t color0 = TextureCompress_Pack565(block[maxIndex]);
+	uint16_t color1 = TextureCompress_Pack565(block[minIndex]);
+
+	/* color0 > color1 selects the four color mode */
+	if (color0 < color1)
+	{
+		uint16_t swap = color0;
+		color0 = color1;
+		color1 = swap;
+	}
+
+	uint32_t indices = 0;
+	if (color0 != color1)
+	{
+		int32_t palette[4][3];
+		TextureCompress_Unpack565(color0, palette[0]);
+		TextureCompress_Unpack565(color1, palette[1]);
+		for (uint32_t j = 0; j < 3; j++)
+		{
+			palette[2][j] = (2 * palette[0][j] + palette[1][j]) / 3;
+			palette[3][j] = (palette[0][j] + 2 * palette[1][j]) / 3;
+		}
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			uint32_t best = 0;
+			int32_t bestDistance = 0x7FFFFFFF;
+			for (uint32_t j = 0; j < 4; j++)
+			{
+				int32_t distance =
+					(block[i][0] - palette[j][0]) * (block[i][0] - palette[j][0]) +
+					(block[i][1] - palette[j][1]) * (block[i][1] - palette[j][1]) +
+					(block[i][2] - palette[j][2]) * (block[i][2] - palette[j][2]);
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					best = j;
+				}
+			}
+			indices |= best << (i * 2);
+		}
+	}
+
+	dst[0] = color0 & 0xFF;
+	dst[1] = color0 >> 8;
+	dst[2] = color1 & 0xFF;
+	dst[3] = color1 >> 8;
+	dst[4] = indices & 0xFF;
+	dst[5] = (indices >> 8) & 0xFF;
+	dst[6] = (indices >> 16) & 0xFF;
+	dst[7] = indices >> 24;
+}
+
+static void TextureCompress_AlphaBlock(uint8_t block[16][4], uint8_t *dst)
+{
+	uint8_t alpha0 = 0, alpha1 = 255;
+
+	for (uint32_t i = 0; i < 16; i++)
+	{
+		alpha0 = SDL_max(alpha0, block[i][3]);
+		alpha1 = SDL_min(alpha1, block[i][3]);
+	}
+
+	/* alpha0 > alpha1 selects the eight value mode */
+	uint64_t indices = 0;
+	if (alpha0 != alpha1)
+	{
+		int32_t palette[8];
+		palette[0] = alpha0;
+		palette[1] = alpha1;
+		for (uint32_t j = 1; j < 7; j++)
+		{
+			palette[j + 1] = ((7 - j) * alpha0 + j * alpha1) / 7;
+		}
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			uint32_t best = 0;
+			int32_t bestDistance = 0x7FFFFFFF;
+			for (uint32_t j = 0; j < 8; j++)
+			{
+				int32_t distance = SDL_abs(block[i][3] - palette[j]);
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					best = j;
+				}
+			}
+			indices |= (uint64_t) best << (i * 3);
+		}
+	}
+
+	dst[0] = alpha0;
+	dst[1] = alpha1;
+	for (uint32_t i = 0; i < 6; i++)
+	{
+		dst[2 + i] = (indices >> (i * 8)) & 0xFF;
+	}
+}
+
+void TextureCompress_BC1(const uint8_t *rgba, uint32_t width, uint32_t height, uint8_t *dst)
+{
+	uint8_t block[16][4];
+	uint32_t blocksWide = (width + 3) / 4;
+	uint32_t blocksHigh = (height + 3) / 4;
+
+	for (uint32_t y = 0; y < blocksHigh; y++)
+	{
+		for (uint32_t x = 0; x < blocksWide; x++)
+		{
+			TextureCompress_FetchBlock(rgba, width, height, x, y, block);
+			TextureCompress_ColorBlock(block, dst);
+			dst += 8;
+		}
+	}
+}
+
+void TextureCompress_BC3(const uint8_t *rgba, uint32_t width, uint32_t height, uint8_t *dst)
+{
+	uint8_t block[16][4];
+	uint32_t blocksWide = (width + 3) / 4;
+	uint32_t blocksHigh = (height + 3) / 4;
+
+	for (uint32_t y = 0; y < blocksHigh; y++)
+	{
+		for (uint32_t x = 0; x < blocksWide; x++)
+		{
+			TextureCompress_FetchBlock(rgba, width, height, x, y, block);
+			TextureCompress_AlphaBlock(block, dst);
+			TextureCompress_ColorBlock(block, dst + 8);
+			dst += 16;
+		}
+	}
+}
@@ -0,0 +1,22 @@
+#ifndef TEXTURE_COMPRESS_H
+#define TEXTURE_COMPRESS_H
+
+/* Offline helpers for TextureConverter: mip downsampling and BC1/BC3 block
+ * encoding. Quality over speed, none of this runs at startup.
+ */
+
+#include <stdint.h>
+
+/* Box filters RGBA8 src into a max(1, w/2) x max(1, h/2) dst */
+void TextureCompress_Downsample(
+	const uint8_t *src,
+	uint32_t width,
+	uint32_t height,
+	uint8_t *dst
+);
+
+/* dst must hold TextureFile_LevelSize() bytes for the format */
+void TextureCompress_BC1(const uint8_t *rgba, uint32_t width, uint32_t height, uint8_t *dst);
+void TextureCompress_BC3(const uint8_t *rgba, uint32_t width, uint32_t height, uint8_t *dst);
+
+#endif /* TEXTURE_COMPRESS_H */
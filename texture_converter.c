@@ -0,0 +1,157 @@
+/* TextureConverter: PNG to mip-mapped DDS for RefreshTest.
+ *
+ * usage: TextureConverter input.png output.dds [bc1|bc3|rgba8] [--no-mips]
+ *
+ * Without a format, opaque images become BC1 and anything with alpha BC3.
+ * Data textures read with texelFetch, like the noise texture, should stay
+ * rgba8 with --no-mips: block compression correlates the channels.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <SDL.h>
+
+#include <Refresh_Image.h>
+
+#include "texture_compress.h"
+#include "texture_file.h"
+
+int main(int argc, char *argv[])
+{
+	if (argc < 3)
+	{
+		printf("usage: %s input.png output.dds [bc1|bc3|rgba8] [--no-mips]\n", argv[0]);
+		return -1;
+	}
+
+	int32_t width, height, numChannels;
+	uint8_t *pixels = Refresh_Image_Load(argv[1], &width, &height, &numChannels);
+	if (pixels == NULL)
+	{
+		fprintf(stderr, "Failed to load %s\n", argv[1]);
+		return -1;
+	}
+
+	uint64_t startTicks = SDL_GetPerformanceCounter();
+
+	/* Refresh_Image_Load always returns RGBA, check the alpha itself */
+	bool opaque = true;
+	for (int32_t i = 0; i < width * height; i++)
+	{
+		if (pixels[i * 4 + 3] != 255)
+		{
+			opaque = false;
+			break;
+		}
+	}
+
+	TextureFileFormat format = opaque ? TEXTURE_FILE_FORMAT_BC1 : TEXTURE_FILE_FORMAT_BC3;
+	bool mips = true;
+	for (int i = 3; i < argc; i++)
+	{
+		if (SDL_strcmp(argv[i], "bc1") == 0)
+		{
+			format = TEXTURE_FILE_FORMAT_BC1;
+		}
+		else if (SDL_strcmp(argv[i], "bc3") == 0)
+		{
+			format = TEXTURE_FILE_FORMAT_BC3;
+		}
+		else if (SDL_strcmp(argv[i], "rgba8") == 0)
+		{
+			format = TEXTURE_FILE_FORMAT_RGBA8;
+		}
+		else if (SDL_strcmp(argv[i], "--no-mips") == 0)
+		{
+			mips = false;
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return -1;
+		}
+	}
+
+	/* Full chain down to 1x1 */
+	uint32_t levelCount = 1;
+	while (mips && (((uint32_t) width >> levelCount) > 0 || ((uint32_t) height >> levelCount) > 0))
+	{
+		levelCount += 1;
+	}
+	levelCount = SDL_min(levelCount, TEXTURE_FILE_MAX_LEVELS);
+
+	uint8_t *levelData[TEXTURE_FILE_MAX_LEVELS];
+	uint8_t *levelPixels = pixels;
+	uint32_t levelWidth = width;
+	uint32_t levelHeight = height;
+	uint32_t totalSize = 0;
+
+	for (uint32_t level = 0; level < levelCount; level++)
+	{
+		uint32_t levelSize = TextureFile_LevelSize(format, levelWidth, levelHeight);
+		levelData[level] = SDL_malloc(levelSize);
+		totalSize += levelSize;
+
+		switch (format)
+		{
+		case TEXTURE_FILE_FORMAT_BC1:
+			TextureCompress_BC1(levelPixels, levelWidth, levelHeight, levelData[level]);
+			break;
+		case TEXTURE_FILE_FORMAT_BC3:
+			TextureCompress_BC3(levelPixels, levelWidth, levelHeight, levelData[level]);
+			break;
+		default:
+			SDL_memcpy(levelData[level], levelPixels, levelSize);
+			break;
+		}
+
+		if (level + 1 < levelCount)
+		{
+			/* Each level is filtered from the previous uncompressed one */
+			uint8_t *nextPixels = SDL_malloc(SDL_max(1, levelWidth / 2) * SDL_max(1, levelHeight / 2) * 4);
+			TextureCompress_Downsample(levelPixels, levelWidth, levelHeight, nextPixels);
+			if (levelPixels != pixels)
+			{
+				SDL_free(levelPixels);
+			}
+			levelPixels = nextPixels;
+			levelWidth = SDL_max(1, levelWidth / 2);
+			levelHeight = SDL_max(1, levelHeight / 2);
+		}
+	}
+
+	if (levelPixels != pixels)
+	{
+		SDL_free(levelPixels);
+	}
+	Refresh_Image_Free(pixels);
+
+	bool written = TextureFile_Write(argv[2], format, width, height, levelCount, levelData);
+
+	for (uint32_t level = 0; level < levelCount; level++)
+	{
+		SDL_free(levelData[level]);
+	}
+
+	if (!written)
+	{
+		fprintf(stderr, "Failed to write %s\n", argv[2]);
+		return -1;
+	}
+
+	printf(
+		"%s: %dx%d, %u levels, %s, %u KB (%u KB as RGBA8), %.1f ms\n",
+		argv[2],
+		width,
+		height,
+		levelCount,
+		format == TEXTURE_FILE_FORMAT_BC1 ? "BC1" : format == TEXTURE_FILE_FORMAT_BC3 ? "BC3" : "RGBA8",
+		totalSize / 1024,
+		width * height * 4 / 1024,
+		(SDL_GetPerformanceCounter() - startTicks) * 1000.0 / SDL_GetPerformanceFrequency()
+	);
+
+	return 0;
+}
@@ -0,0 +1,377 @@
+#include "texture_file.h"
+
+#include <stdio.h>
+
+#include <SDL.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* DDS layout, see "Programming Guide for DDS" */
+
+#define DDS_MAGIC 0x20534444 /* "DDS " */
+#define DDS_HEADER_SIZE 124
+#define DDS_PIXELFORMAT_SIZE 32
+
+#define DDSD_CAPS 0x1
+#define DDSD_HEIGHT 0x2
+#define DDSD_WIDTH 0x4
+#define DDSD_PITCH 0x8
+#define DDSD_PIXELFORMAT 0x1000
+#define DDSD_MIPMAPCOUNT 0x20000
+#define DDSD_LINEARSIZE 0x80000
+
+#define DDPF_ALPHAPIXELS 0x1
+#define DDPF_FOURCC 0x4
+#define DDPF_RGB 0x40
+
+#define DDSCAPS_COMPLEX 0x8
+#define DDSCAPS_TEXTURE 0x1000
+#define DDSCAPS_MIPMAP 0x400000
+
+#define DDS_FOURCC(a, b, c, d) \
+	((uint32_t) (a) | ((uint32_t) (b) << 8) | ((uint32_t) (c) << 16) | ((uint32_t) (d) << 24))
+
+typedef struct DDSPixelFormat
+{
+	uint32_t size;
+	uint32_t flags;
+	uint32_t fourCC;
+	uint32_t rgbBitCount;
+	uint32_t rBitMask;
+	uint32_t gBitMask;
+	uint32_t bBitMask;
+	uint32_t aBitMask;
+} DDSPixelFormat;
+
+typedef struct DDSHeader
+{
+	uint32_t magic;
+	uint32_t size;
+	uint32_t flags;
+	uint32_t height;
+	uint32_t width;
+	uint32_t pitchOrLinearSize;
+	uint32_t depth;
+	uint32_t mipMapCount;
+	uint32_t reserved1[11];
+	DDSPixelFormat pixelFormat;
+	uint32_t caps;
+	uint32_t caps2;
+	uint32_t caps3;
+	uint32_t caps4;
+	uint32_t reserved2;
+} DDSHeader;
+
+uint32_t TextureFile_LevelSize(TextureFileFormat format, uint32_t width, uint32_t height)
+{
+	uint32_t blocksWide = SDL_max(1, (width + 3) / 4);
+	uint32_t blocksHigh = SDL_max(1, (height + 3) / 4);
+
+	switch (format)
+	{
+	case TEXTURE_FILE_FORMAT_BC1: return blocksWide * blocksHigh * 8;
+	case TEXTURE_FILE_FORMAT_BC3: return blocksWide * blocksHigh * 16;
+	default: return width * height * 4;
+	}
+}
+
+Refresh_ColorFormat TextureFile_ColorFormat(TextureFileFormat format)
+{
+	switch (format)
+	{
+	case TEXTURE_FILE_FORMAT_BC1: return REFRESH_COLORFORMAT_BC1;
+	case TEXTURE_FILE_FORMAT_BC3: return REFRESH_COLORFORMAT_BC3;
+	default: return REFRESH_COLORFORMAT_R8G8B8A8;
+	}
+}
+
+static uint8_t TextureFile_Map(TextureFile *textureFile, const char *path)
+{
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return 0;
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return 0;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (mapping == NULL)
+	{
+		return 0;
+	}
+
+	textureFile->mapping = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (textureFile->mapping == NULL)
+	{
+		CloseHandle(mapping);
+		return 0;
+	}
+	textureFile->mappingHandle = mapping;
+	textureFile->mappingSize = (size_t) fileSize.QuadPart;
+#else
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		return 0;
+	}
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+	{
+		close(fd);
+		return 0;
+	}
+
+	void *mapping = mmap(NULL, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED)
+	{
+		return 0;
+	}
+
+	/* Start paging in now, the upload reads the whole file front to back */
+	madvise(mapping, fileStat.st_size, MADV_WILLNEED);
+
+	textureFile->mapping = mapping;
+	textureFile->mappingSize = (size_t) fileStat.st_size;
+#endif
+	return 1;
+}
+
+static void TextureFile_Unmap(TextureFile *textureFile)
+{
+	if (textureFile->mapping == NULL)
+	{
+		return;
+	}
+#ifdef _WIN32
+	UnmapViewOfFile(textureFile->mapping);
+	CloseHandle((HANDLE) textureFile->mappingHandle);
+#else
+	munmap(textureFile->mapping, textureFile->mappingSize);
+#endif
+	textureFile->mapping = NULL;
+}
+
+uint8_t TextureFile_Open(TextureFile *textureFile, const char *path)
+{
+	SDL_memset(textureFile, 0, sizeof(TextureFile));
+
+	if (!TextureFile_Map(textureFile, path))
+	{
+		return 0;
+	}
+
+	if (textureFile->mappingSize < sizeof(DDSHeader))
+	{
+		goto invalid;
+	}
+	DDSHeader header;
+	SDL_memcpy(&header, textureFile->mapping, sizeof(DDSHeader));
+
+	if (	header.magic != DDS_MAGIC ||
+		header.size != DDS_HEADER_SIZE ||
+		header.pixelFormat.size != DDS_PIXELFORMAT_SIZE ||
+		header.width == 0 ||
+		header.height == 0	)
+	{
+		goto invalid;
+	}
+
+	if (header.pixelFormat.flags & DDPF_FOURCC)
+	{
+		if (header.pixelFormat.fourCC == DDS_FOURCC('D', 'X', 'T', '1'))
+		{
+			textureFile->format = TEXTURE_FILE_FORMAT_BC1;
+		}
+		else if (header.pixelFormat.fourCC == DDS_FOURCC('D', 'X', 'T', '5'))
+		{
+			textureFile->format = TEXTURE_FILE_FORMAT_BC3;
+		}
+		else
+		{
+			goto invalid;
+		}
+	}
+	else if (	(header.pixelFormat.flags & DDPF_RGB) &&
+			header.pixelFormat.rgbBitCount == 32 &&
+			header.pixelFormat.rBitMask == 0x000000FF &&
+			header.pixelFormat.gBitMask == 0x0000FF00 &&
+			header.pixelFormat.bBitMask == 0x00FF0000	)
+	{
+		textureFile->format = TEXTURE_FILE_FORMAT_RGBA8;
+	}
+	else
+	{
+		goto invalid;
+	}
+
+	textureFile->width = header.width;
+	textureFile->height = header.height;
+	textureFile->levelCount = (header.flags & DDSD_MIPMAPCOUNT) ? header.mipMapCount : 1;
+	textureFile->levelCount = SDL_max(1, SDL_min(textureFile->levelCount, TEXTURE_FILE_MAX_LEVELS));
+
+	const uint8_t *data = (const uint8_t*) textureFile->mapping;
+	size_t offset = sizeof(DDSHeader);
+	uint32_t width = header.width;
+	uint32_t height = header.height;
+
+	for (uint32_t i = 0; i < textureFile->levelCount; i++)
+	{
+		textureFile->levels[i].width = width;
+		textureFile->levels[i].height = height;
+		textureFile->levels[i].size = TextureFile_LevelSize(textureFile->format, width, height);
+		textureFile->levels[i].data = data + offset;
+
+		offset += textureFile->levels[i].size;
+		if (offset > textureFile->mappingSize)
+		{
+			goto invalid;
+		}
+
+		width = SDL_max(1, width / 2);
+		height = SDL_max(1, height / 2);
+	}
+
+	return 1;
+
+invalid:
+	SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "%s is not a supported DDS file", path);
+	TextureFile_Unmap(textureFile);
+	return 0;
+}
+
+void TextureFile_Close(TextureFile *textureFile)
+{
+	TextureFile_Unmap(textureFile);
+	SDL_memset(textureFile, 0, sizeof(TextureFile));
+}
+
+Refresh_Texture* TextureFile_CreateTexture(
+	Refresh_Device *device,
+	TextureFile *textureFile,
+	TextureFileCreateFunc create,
+	TextureFileUploadFunc upload
+) {
+	Refresh_Texture *texture = create(
+		device,
+		TextureFile_ColorFormat(textureFile->format),
+		textureFile->width,
+		textureFile->height,
+		textureFile->levelCount,
+		REFRESH_TEXTUREUSAGE_SAMPLER_BIT
+	);
+
+	Refresh_TextureSlice slice;
+	slice.texture = texture;
+	slice.rectangle.x = 0;
+	slice.rectangle.y = 0;
+	slice.depth = 0;
+	slice.layer = 0;
+
+	/* Straight from the mapping to Refresh's staging buffer, no decode */
+	for (uint32_t i = 0; i < textureFile->levelCount; i++)
+	{
+		slice.rectangle.w = textureFile->levels[i].width;
+		slice.rectangle.h = textureFile->levels[i].height;
+		slice.level = i;
+
+		upload(
+			device,
+			&slice,
+			(void*) textureFile->levels[i].data,
+			textureFile->levels[i].size
+		);
+	}
+
+	return texture;
+}
+
+uint8_t TextureFile_Write(
+	const char *path,
+	TextureFileFormat format,
+	uint32_t width,
+	uint32_t height,
+	uint32_t levelCount,
+	uint8_t **levelData
+) {
+	DDSHeader header;
+	SDL_memset(&header, 0, sizeof(DDSHeader));
+	header.magic = DDS_MAGIC;
+	header.size = DDS_HEADER_SIZE;
+	header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT;
+	header.height = height;
+	header.width = width;
+	header.mipMapCount = levelCount;
+	header.pixelFormat.size = DDS_PIXELFORMAT_SIZE;
+	header.caps = DDSCAPS_TEXTURE;
+
+	if (levelCount > 1)
+	{
+		header.caps |= DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+	}
+
+	if (format == TEXTURE_FILE_FORMAT_RGBA8)
+	{
+		header.flags |= DDSD_PITCH;
+		header.pitchOrLinearSize = width * 4;
+		header.pixelFormat.flags = DDPF_RGB | DDPF_ALPHAPIXELS;
+		header.pixelFormat.rgbBitCount = 32;
+		header.pixelFormat.rBitMask = 0x000000FF;
+		header.pixelFormat.gBitMask = 0x0000FF00;
+		header.pixelFormat.bBitMask = 0x00FF0000;
+		header.pixelFormat.aBitMask = 0xFF000000;
+	}
+	else
+	{
+		header.flags |= DDSD_LINEARSIZE;
+		header.pitchOrLinearSize = TextureFile_LevelSize(format, width, height);
+		header.pixelFormat.flags = DDPF_FOURCC;
+		header.pixelFormat.fourCC = (format == TEXTURE_FILE_FORMAT_BC1) ?
+			DDS_FOURCC('D', 'X', 'T', '1') :
+			DDS_FOURCC('D', 'X', 'T', '5');
+	}
+
+	FILE *file = fopen(path, "wb");
+	if (file == NULL)
+	{
+		return 0;
+	}
+
+	if (fwrite(&header, sizeof(DDSHeader), 1, file) != 1)
+	{
+		fclose(file);
+		return 0;
+	}
+
+	uint32_t levelWidth = width;
+	uint32_t levelHeight = height;
+	for (uint32_t i = 0; i < levelCount; i++)
+	{
+		uint32_t levelSize = TextureFile_LevelSize(format, levelWidth, levelHeight);
+		if (fwrite(levelData[i], 1, levelSize, file) != levelSize)
+		{
+			fclose(file);
+			return 0;
+		}
+
+		levelWidth = SDL_max(1, levelWidth / 2);
+		levelHeight = SDL_max(1, levelHeight / 2);
+	}
+
+	return fclose(file) == 0;
+}
@@ -0,0 +1,89 @@
+#ifndef TEXTURE_FILE_H
+#define TEXTURE_FILE_H
+
+/* GPU-ready texture container.
+ *
+ * Files are plain DDS: BC1 (DXT1), BC3 (DXT5) or uncompressed RGBA8, with
+ * every mip level stored back to back. Opening one maps it into memory and
+ * points each level at its bytes, so creating the texture is nothing but
+ * uploads. TextureConverter writes these from PNGs offline.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <Refresh.h>
+
+#define TEXTURE_FILE_MAX_LEVELS 16
+
+typedef enum TextureFileFormat
+{
+	TEXTURE_FILE_FORMAT_RGBA8,
+	TEXTURE_FILE_FORMAT_BC1,
+	TEXTURE_FILE_FORMAT_BC3
+} TextureFileFormat;
+
+typedef struct TextureFileLevel
+{
+	uint32_t width;
+	uint32_t height;
+	const uint8_t *data;
+	uint32_t size;
+} TextureFileLevel;
+
+typedef struct TextureFile
+{
+	TextureFileFormat format;
+	uint32_t width;
+	uint32_t height;
+	uint32_t levelCount;
+	TextureFileLevel levels[TEXTURE_FILE_MAX_LEVELS];
+
+	void *mapping;
+	size_t mappingSize;
+	void *mappingHandle;	/* Windows only */
+} TextureFile;
+
+/* Refresh_CreateTexture2D's and Refresh_SetTextureData's signatures, so the
+ * app can pass the CommandCapture_ wrappers and have its loads captured
+ */
+typedef Refresh_Texture* (*TextureFileCreateFunc)(
+	Refresh_Device *device,
+	Refresh_ColorFormat format,
+	uint32_t width,
+	uint32_t height,
+	uint32_t levelCount,
+	Refresh_TextureUsageFlags usageFlags
+);
+
+typedef void (*TextureFileUploadFunc)(
+	Refresh_Device *device,
+	Refresh_TextureSlice *textureSlice,
+	void *data,
+	uint32_t dataLengthInBytes
+);
+
+uint32_t TextureFile_LevelSize(TextureFileFormat format, uint32_t width, uint32_t height);
+Refresh_ColorFormat TextureFile_ColorFormat(TextureFileFormat format);
+
+/* Returns 0 if the file is missing or not a DDS this loader understands */
+uint8_t TextureFile_Open(TextureFile *textureFile, const char *path);
+void TextureFile_Close(TextureFile *textureFile);
+
+Refresh_Texture* TextureFile_CreateTexture(
+	Refresh_Device *device,
+	TextureFile *textureFile,
+	TextureFileCreateFunc create,
+	TextureFileUploadFunc upload
+);
+
+uint8_t TextureFile_Write(
+	const char *path,
+	TextureFileFormat format,
+	uint32_t width,
+	uint32_t height,
+	uint32_t levelCount,
+	uint8_t **levelData
+);
+
+#endif /* TEXTURE_FILE_H */
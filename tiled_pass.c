@@ -0,0 +1,261 @@
+#include "tiled_pass.h"
+
+#include <SDL.h>
+
+#include "command_capture.h"
+#include "gpu_memory.h"
+#include "trace.h"
+
+/* Band rows are whole tile rows, split as evenly as the level allows. The
+ * level's bandCount is at most tileRows, so every band gets at least one.
+ */
+static void TiledPass_BandRows(
+	TiledPassLevel *level,
+	uint32_t band,
+	uint32_t *firstRow,
+	uint32_t *rowCount
+) {
+	uint32_t first = band * level->tileRows / level->bandCount;
+	uint32_t last = (band + 1) * level->tileRows / level->bandCount;
+
+	*firstRow = first;
+	*rowCount = last - first;
+}
+
+static void TiledPass_BeginBand(TiledPass *pass, TiledPassBand *band)
+{
+	TiledPassFrame *frame = &pass->frame;
+	TiledPassLevel *level = &pass->levels[frame->level];
+	uint32_t firstRow, rowCount;
+
+	TiledPass_BandRows(level, band->index, &firstRow, &rowCount);
+
+	Refresh_Rect renderArea;
+	renderArea.x = 0;
+	renderArea.y = firstRow * pass->tileSize;
+	renderArea.w = level->width;
+	renderArea.h = SDL_min((firstRow + rowCount) * pass->tileSize, level->height) - renderArea.y;
+
+	band->commandBuffer = CommandCapture_AcquireCommandBuffer(pass->device, 0);
+
+	SDL_LockMutex(pass->renderPassLock);
+	CommandCapture_BeginRenderPass(
+		pass->device,
+		band->commandBuffer,
+		frame->renderPass,
+		frame->framebuffer,
+		renderArea,
+		frame->clearColor,
+		1,
+		NULL
+	);
+	SDL_UnlockMutex(pass->renderPassLock);
+}
+
+static void TiledPass_FinishBand(TiledPass *pass, TiledPassBand *band)
+{
+	TiledPassFrame *frame = &pass->frame;
+	TiledPassLevel *level = &pass->levels[frame->level];
+	Refresh_CommandBuffer *commandBuffer = band->commandBuffer;
+	uint32_t firstRow, rowCount;
+	uint64_t offset = 0;
+
+	TiledPass_BandRows(level, band->index, &firstRow, &rowCount);
+
+	CommandCapture_BindGraphicsPipeline(pass->device, commandBuffer, frame->pipeline);
+
+	uint32_t fragmentParamOffset = CommandCapture_PushFragmentShaderParams(pass->device, commandBuffer, frame->fragmentUniforms, 1);
+	CommandCapture_BindVertexBuffers(pass->device, commandBuffer, 0, 1, &level->vertexBuffer, &offset);
+	CommandCapture_BindFragmentSamplers(pass->device, commandBuffer, frame->textures, frame->samplers);
+
+	uint32_t firstTile = firstRow * level->tileColumns;
+	uint32_t tileCount = rowCount * level->tileColumns;
+
+	for (uint32_t i = firstTile; i < firstTile + tileCount; i++)
+	{
+		CommandCapture_DrawPrimitives(pass->device, commandBuffer, i * 6, 2, 0, fragmentParamOffset);
+	}
+
+	SDL_LockMutex(pass->renderPassLock);
+	CommandCapture_EndRenderPass(pass->device, commandBuffer);
+	SDL_UnlockMutex(pass->renderPassLock);
+}
+
+static void TiledPass_RecordBandJob(void *userdata)
+{
+	TiledPassBand *band = (TiledPassBand*) userdata;
+	uint64_t bandZone = TRACE_BEGIN();
+	uint64_t start = SDL_GetPerformanceCounter();
+
+	TiledPass_BeginBand(band->pass, band);
+	TiledPass_FinishBand(band->pass, band);
+
+	band->recordTicks = SDL_GetPerformanceCounter() - start;
+	TRACE_END("record band", bandZone);
+}
+
+static void TiledPass_CreateLevel(
+	TiledPass *pass,
+	TiledPassLevel *level,
+	uint32_t width,
+	uint32_t height
+) {
+	level->width = width;
+	level->height = height;
+	level->tileColumns = (width + pass->tileSize - 1) / pass->tileSize;
+	level->tileRows = (height + pass->tileSize - 1) / pass->tileSize;
+	level->bandCount = SDL_min(pass->bandCount, level->tileRows);
+
+	uint32_t tileCount = level->tileColumns * level->tileRows;
+	TiledPassVertex *vertices = SDL_malloc(sizeof(TiledPassVertex) * 6 * tileCount);
+
+	/* Row-major, so a band's tiles are contiguous */
+	for (uint32_t row = 0; row < level->tileRows; row++)
+	{
+		for (uint32_t column = 0; column < level->tileColumns; column++)
+		{
+			/* The last row and column stop at the edge of the level */
+			float x0 = (float) (column * pass->tileSize);
+			float y0 = (float) (row * pass->tileSize);
+			float x1 = (float) SDL_min((column + 1) * pass->tileSize, width);
+			float y1 = (float) SDL_min((row + 1) * pass->tileSize, height);
+
+			float left = x0 / width * 2.0f - 1.0f;
+			float right = x1 / width * 2.0f - 1.0f;
+			float top = y0 / height * 2.0f - 1.0f;
+			float bottom = y1 / height * 2.0f - 1.0f;
+
+			TiledPassVertex *tile = &vertices[(row * level->tileColumns + column) * 6];
+
+			tile[0].x = left;	tile[0].y = top;
+			tile[1].x = right;	tile[1].y = top;
+			tile[2].x = right;	tile[2].y = bottom;
+			tile[3].x = right;	tile[3].y = bottom;
+			tile[4].x = left;	tile[4].y = bottom;
+			tile[5].x = left;	tile[5].y = top;
+
+			for (uint32_t i = 0; i < 6; i++)
+			{
+				tile[i].z = 0.0f;
+				tile[i].u = (tile[i].x + 1.0f) * 0.5f;
+				tile[i].v = (tile[i].y + 1.0f) * 0.5f;
+			}
+		}
+	}
+
+	uint32_t size = sizeof(TiledPassVertex) * 6 * tileCount;
+	level->vertexBuffer = CommandCapture_CreateBuffer(pass->device, REFRESH_BUFFERUSAGE_VERTEX_BIT, size);
+	GpuMemory_AddBuffer(level->vertexBuffer, REFRESH_BUFFERUSAGE_VERTEX_BIT, size);
+	CommandCapture_SetBufferData(pass->device, level->vertexBuffer, 0, vertices, size);
+
+	SDL_free(vertices);
+}
+
+TiledPass* TiledPass_Create(
+	Refresh_Device *device,
+	JobSystem *jobs,
+	DynamicResolution *resolution,
+	uint32_t tileSize,
+	uint32_t bandCount
+) {
+	TiledPass *pass = SDL_malloc(sizeof(TiledPass));
+	SDL_memset(pass, 0, sizeof(TiledPass));
+
+	pass->device = device;
+	pass->jobs = jobs;
+	pass->tileSize = tileSize;
+	pass->bandCount = SDL_max(SDL_min(bandCount, TILED_PASS_BANDS_MAX), 1);
+	pass->renderPassLock = SDL_CreateMutex();
+
+	for (uint32_t i = 0; i < pass->bandCount; i++)
+	{
+		pass->bands[i].pass = pass;
+		pass->bands[i].index = i;
+	}
+
+	pass->levelCount = resolution->levelCount;
+	for (uint32_t i = 0; i < resolution->levelCount; i++)
+	{
+		TiledPass_CreateLevel(pass, &pass->levels[i], resolution->levels[i].width, resolution->levels[i].height);
+	}
+
+	return pass;
+}
+
+void TiledPass_Destroy(TiledPass *pass)
+{
+	for (uint32_t i = 0; i < pass->levelCount; i++)
+	{
+		GpuMemory_Remove(pass->levels[i].vertexBuffer);
+		CommandCapture_QueueDestroyBuffer(pass->device, pass->levels[i].vertexBuffer);
+	}
+
+	SDL_DestroyMutex(pass->renderPassLock);
+	SDL_free(pass);
+}
+
+uint32_t TiledPass_Record(
+	TiledPass *pass,
+	TiledPassFrame *frame,
+	Refresh_CommandBuffer **commandBuffers
+) {
+	uint64_t start = SDL_GetPerformanceCounter();
+	TiledPassLevel *level = &pass->levels[frame->level];
+	TiledPassBand *first = &pass->bands[0];
+
+	pass->frame = *frame;
+
+	/* Band 0's render pass has to begin first, see the header */
+	TiledPass_BeginBand(pass, first);
+
+	for (uint32_t i = 1; i < level->bandCount; i++)
+	{
+		JobSystem_Submit(pass->jobs, &pass->bands[i].job, TiledPass_RecordBandJob, &pass->bands[i]);
+	}
+
+	TiledPass_FinishBand(pass, first);
+	first->recordTicks = SDL_GetPerformanceCounter() - start;
+
+	for (uint32_t i = 1; i < level->bandCount; i++)
+	{
+		JobSystem_Wait(pass->jobs, &pass->bands[i].job);
+	}
+
+	for (uint32_t i = 0; i < level->bandCount; i++)
+	{
+		commandBuffers[i] = pass->bands[i].commandBuffer;
+		pass->bandTicks += pass->bands[i].recordTicks;
+	}
+
+	pass->drawCount += level->tileColumns * level->tileRows;
+	pass->wallTicks += SDL_GetPerformanceCounter() - start;
+	pass->frameCount += 1;
+
+	return level->bandCount;
+}
+
+void TiledPass_Report(TiledPass *pass, FILE *output)
+{
+	if (pass->frameCount == 0)
+	{
+		return;
+	}
+
+	double millisecondsPerTick = 1000.0 / SDL_GetPerformanceFrequency();
+
+	fprintf(
+		output,
+		"tiled pass: %ux%u tiles, %.0f draws per frame, %u command buffers recorded in parallel\n",
+		pass->tileSize,
+		pass->tileSize,
+		pass->drawCount / (double) pass->frameCount,
+		pass->bandCount
+	);
+	fprintf(
+		output,
+		"  recording            %.3f ms per frame, %.3f ms of thread time (%.2fx)\n",
+		pass->wallTicks * millisecondsPerTick / pass->frameCount,
+		pass->bandTicks * millisecondsPerTick / pass->frameCount,
+		pass->wallTicks > 0 ? pass->bandTicks / (double) pass->wallTicks : 0.0
+	);
+}
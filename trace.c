@@ -0,0 +1,205 @@
+#include "trace.h"
+
+#include <stdio.h>
+
+uint8_t traceEnabled = 0;
+
+static TraceTrack tracks[TRACE_TRACKS_MAX];
+static SDL_atomic_t trackCount;
+static SDL_TLSID trackKey;
+
+/* Claiming a slot is the only step shared between threads */
+static TraceTrack* Trace_AllocateTrack(const char *name)
+{
+	int index = SDL_AtomicAdd(&trackCount, 1);
+
+	if (index >= TRACE_TRACKS_MAX)
+	{
+		SDL_AtomicAdd(&trackCount, -1);
+		return NULL;
+	}
+
+	TraceTrack *track = &tracks[index];
+	SDL_strlcpy(track->name, name, sizeof(track->name));
+	track->events = SDL_malloc(sizeof(TraceEvent) * TRACE_RING_EVENTS);
+	SDL_AtomicSet(&track->head, 0);
+	SDL_AtomicSet(&track->ready, 1);
+
+	return track;
+}
+
+/* The name is only used when the thread has no track yet */
+static TraceTrack* Trace_GetThreadTrack(const char *name)
+{
+	TraceTrack *track = (TraceTrack*) SDL_TLSGet(trackKey);
+
+	if (track == NULL)
+	{
+		char defaultName[32];
+		if (name == NULL)
+		{
+			SDL_snprintf(defaultName, sizeof(defaultName), "thread %lu", SDL_ThreadID());
+			name = defaultName;
+		}
+
+		track = Trace_AllocateTrack(name);
+		if (track != NULL)
+		{
+			SDL_TLSSet(trackKey, track, NULL);
+		}
+	}
+
+	return track;
+}
+
+void Trace_Init(uint8_t enabled)
+{
+	SDL_memset(tracks, 0, sizeof(tracks));
+	SDL_AtomicSet(&trackCount, 0);
+
+	if (enabled)
+	{
+		trackKey = SDL_TLSCreate();
+	}
+
+	traceEnabled = enabled;
+}
+
+void Trace_Quit(void)
+{
+	traceEnabled = 0;
+
+	int count = SDL_min(SDL_AtomicGet(&trackCount), TRACE_TRACKS_MAX);
+	for (int i = 0; i < count; i++)
+	{
+		SDL_free(tracks[i].events);
+	}
+
+	SDL_memset(tracks, 0, sizeof(tracks));
+	SDL_AtomicSet(&trackCount, 0);
+}
+
+void Trace_SetThreadName(const char *name)
+{
+	if (!traceEnabled)
+	{
+		return;
+	}
+
+	/* Naming a thread that already recorded is ignored, its name may be in use */
+	Trace_GetThreadTrack(name);
+}
+
+TraceTrack* Trace_CreateTrack(const char *name)
+{
+	if (!traceEnabled)
+	{
+		return NULL;
+	}
+
+	return Trace_AllocateTrack(name);
+}
+
+void Trace_TrackZone(TraceTrack *track, const char *name, uint64_t start, uint64_t end)
+{
+	/* Only the owning thread writes, so the head needs no read-modify-write */
+	uint32_t head = (uint32_t) SDL_AtomicGet(&track->head);
+
+	TraceEvent *event = &track->events[head % TRACE_RING_EVENTS];
+	event->name = name;
+	event->start = start;
+	event->end = end;
+
+	/* Publishes the event; SDL's atomics are full barriers */
+	SDL_AtomicSet(&track->head, (int) (head + 1));
+}
+
+void Trace_Zone(const char *name, uint64_t start, uint64_t end)
+{
+	TraceTrack *track = Trace_GetThreadTrack(NULL);
+
+	if (track != NULL)
+	{
+		Trace_TrackZone(track, name, start, end);
+	}
+}
+
+uint8_t Trace_Write(const char *path)
+{
+	FILE *file = fopen(path, "w");
+	if (file == NULL)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "could not open %s for the trace", path);
+		return 0;
+	}
+
+	double microsecondsPerTick = 1000000.0 / SDL_GetPerformanceFrequency();
+	TraceEvent *events = SDL_malloc(sizeof(TraceEvent) * TRACE_RING_EVENTS);
+	uint32_t eventCount = 0;
+	uint32_t droppedCount = 0;
+
+	fprintf(file, "{\"traceEvents\":[\n");
+	fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"RefreshTest\"}}");
+
+	int count = SDL_min(SDL_AtomicGet(&trackCount), TRACE_TRACKS_MAX);
+	for (int i = 0; i < count; i++)
+	{
+		TraceTrack *track = &tracks[i];
+
+		if (!SDL_AtomicGet(&track->ready))
+		{
+			continue;
+		}
+
+		fprintf(
+			file,
+			",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+			i,
+			track->name
+		);
+
+		uint32_t head = (uint32_t) SDL_AtomicGet(&track->head);
+		uint32_t first = head > TRACE_RING_EVENTS ? head - TRACE_RING_EVENTS : 0;
+
+		for (uint32_t j = first; j < head; j++)
+		{
+			events[j - first] = track->events[j % TRACE_RING_EVENTS];
+		}
+
+		/* Anything the owner wrapped around onto during the copy is torn */
+		uint32_t newHead = (uint32_t) SDL_AtomicGet(&track->head);
+		uint32_t valid = newHead > TRACE_RING_EVENTS ? newHead - TRACE_RING_EVENTS : 0;
+		uint32_t skip = valid > first ? SDL_min(valid - first, head - first) : 0;
+		droppedCount += skip + first;
+
+		for (uint32_t j = skip; j < head - first; j++)
+		{
+			TraceEvent *event = &events[j];
+
+			fprintf(
+				file,
+				",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+				event->name,
+				i,
+				event->start * microsecondsPerTick,
+				(event->end - event->start) * microsecondsPerTick
+			);
+			eventCount += 1;
+		}
+	}
+
+	fprintf(file, "\n]}\n");
+	fclose(file);
+	SDL_free(events);
+
+	SDL_LogInfo(
+		SDL_LOG_CATEGORY_APPLICATION,
+		"trace: wrote %u zones from %d tracks to %s, %u older zones overwritten",
+		eventCount,
+		count,
+		path,
+		droppedCount
+	);
+
+	return 1;
+}
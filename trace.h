@@ -0,0 +1,87 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+/* --trace PATH: CPU zones from every thread, written as a Chrome trace
+ * (chrome://tracing or Perfetto) at exit.
+ *
+ * Each thread records into its own ring, found through thread-local
+ * storage, so recording takes no lock: the thread writes the event and
+ * then publishes it by bumping the ring's atomic head. Rings keep the most
+ * recent TRACE_RING_EVENTS zones and overwrite older ones. Writing the
+ * trace may run while threads still record; events overwritten during
+ * the copy are dropped.
+ *
+ * Timestamps are performance counter ticks, converted to microseconds with
+ * nanosecond digits when written. When tracing is off TRACE_BEGIN is a
+ * load and a branch, and TRACE_END a branch.
+ *
+ * Zones nest by time, so a zone must end on the thread that began it and
+ * inner zones must end first:
+ *
+ *	uint64_t submitZone = TRACE_BEGIN();
+ *	Refresh_Submit(...);
+ *	TRACE_END("Refresh_Submit", submitZone);
+ */
+
+#include <stdint.h>
+
+#include <SDL.h>
+
+#define TRACE_RING_EVENTS 65536
+#define TRACE_TRACKS_MAX 64
+
+typedef struct TraceEvent
+{
+	const char *name;
+	uint64_t start;
+	uint64_t end;
+} TraceEvent;
+
+/* One per recording thread, or per timeline added with Trace_CreateTrack */
+typedef struct TraceTrack
+{
+	char name[32];
+	TraceEvent *events;
+	SDL_atomic_t head;
+
+	/* Set once the fields above are, so Trace_Write never sees half a track */
+	SDL_atomic_t ready;
+} TraceTrack;
+
+/* Set once by Trace_Init, before any thread records */
+extern uint8_t traceEnabled;
+
+#define TRACE_BEGIN() (traceEnabled ? SDL_GetPerformanceCounter() : 0)
+
+/* The name must be a string literal or otherwise outlive the trace */
+#define TRACE_END(name, start) \
+	do \
+	{ \
+		if ((start) != 0) \
+		{ \
+			Trace_Zone((name), (start), SDL_GetPerformanceCounter()); \
+		} \
+	} while (0)
+
+/* Call before creating any thread that records */
+void Trace_Init(uint8_t enabled);
+
+/* Frees every ring; nothing may record after this */
+void Trace_Quit(void);
+
+/* Names the calling thread's track, before it records anything */
+void Trace_SetThreadName(const char *name);
+
+/* A timeline that isn't a thread, such as a GPU queue. Zones are added
+ * with Trace_TrackZone, only ever from one thread at a time. Returns NULL
+ * when tracing is off or out of tracks.
+ */
+TraceTrack* Trace_CreateTrack(const char *name);
+
+void Trace_Zone(const char *name, uint64_t start, uint64_t end);
+void Trace_TrackZone(TraceTrack *track, const char *name, uint64_t start, uint64_t end);
+
+/* Returns 0 if the file can't be written */
+uint8_t Trace_Write(const char *path);
+
+#endif /* TRACE_H */
@@ -0,0 +1,151 @@
+#include "uniform_bench.h"
+
+#include <SDL.h>
+
+#include "command_capture.h"
+#include "gpu_memory.h"
+
+/* Vertex attributes are floats */
+#define UNIFORM_BENCH_ALIGNMENT 4
+
+/* Frames FNA3D keeps in flight plus the one being recorded */
+#define UNIFORM_BENCH_REGION_COUNT 3
+
+static double UniformBench_Milliseconds(uint64_t ticks, uint32_t frameCount)
+{
+	return frameCount > 0 ? ticks * 1000.0 / SDL_GetPerformanceFrequency() / frameCount : 0.0;
+}
+
+UniformBench* UniformBench_Create(
+	Refresh_Device *device,
+	VulkanInterop *interop,
+	uint32_t blockCount,
+	uint32_t vertexSize
+) {
+	UniformBench *bench = SDL_malloc(sizeof(UniformBench));
+	SDL_memset(bench, 0, sizeof(UniformBench));
+
+	bench->device = device;
+	bench->blockCount = blockCount;
+	bench->vertexSize = (vertexSize + UNIFORM_BENCH_ALIGNMENT - 1) & ~(UNIFORM_BENCH_ALIGNMENT - 1);
+
+	bench->allocator = FrameAllocator_Create(
+		device,
+		interop,
+		REFRESH_BUFFERUSAGE_VERTEX_BIT,
+		blockCount * bench->vertexSize * 3,
+		UNIFORM_BENCH_REGION_COUNT
+	);
+
+	/* Three vertices at the same point cover no pixels */
+	uint8_t *zeroes = SDL_malloc(bench->vertexSize * 3);
+	SDL_memset(zeroes, 0, bench->vertexSize * 3);
+	bench->vertexBuffer = CommandCapture_CreateBuffer(device, REFRESH_BUFFERUSAGE_VERTEX_BIT, bench->vertexSize * 3);
+	GpuMemory_AddBuffer(bench->vertexBuffer, REFRESH_BUFFERUSAGE_VERTEX_BIT, bench->vertexSize * 3);
+	CommandCapture_SetBufferData(device, bench->vertexBuffer, 0, zeroes, bench->vertexSize * 3);
+	SDL_free(zeroes);
+
+	return bench;
+}
+
+void UniformBench_Destroy(UniformBench *bench)
+{
+	FrameAllocator_Destroy(bench->allocator);
+	GpuMemory_Remove(bench->vertexBuffer);
+	CommandCapture_QueueDestroyBuffer(bench->device, bench->vertexBuffer);
+	SDL_free(bench);
+}
+
+void UniformBench_Record(
+	UniformBench *bench,
+	Refresh_CommandBuffer *commandBuffer,
+	const RaymarchUniforms *uniforms
+) {
+	bench->allocatorFrame = (bench->pushFrameCount + bench->allocatorFrameCount) & 1;
+
+	uint64_t offsets[1] = { 0 };
+
+	if (!bench->allocatorFrame)
+	{
+		uint64_t start = SDL_GetPerformanceCounter();
+		CommandCapture_BindVertexBuffers(bench->device, commandBuffer, 0, 1, &bench->vertexBuffer, offsets);
+		for (uint32_t i = 0; i < bench->blockCount; i++)
+		{
+			uint32_t fragmentParamOffset = CommandCapture_PushFragmentShaderParams(bench->device, commandBuffer, (void*) uniforms, 1);
+			CommandCapture_DrawPrimitives(bench->device, commandBuffer, 0, 1, 0, fragmentParamOffset);
+		}
+		bench->pushTicks += SDL_GetPerformanceCounter() - start;
+		bench->pushFrameCount += 1;
+		return;
+	}
+
+	/* Waiting on the region's last frame is pacing, not allocation overhead */
+	FrameAllocator_BeginFrame(bench->allocator);
+
+	/* The pipeline's fragment shader still reads one block */
+	uint64_t start = SDL_GetPerformanceCounter();
+	uint32_t fragmentParamOffset = CommandCapture_PushFragmentShaderParams(bench->device, commandBuffer, (void*) uniforms, 1);
+
+	/* Flush only has to land before the submit, not before the draws are recorded */
+	for (uint32_t i = 0; i < bench->blockCount; i++)
+	{
+		uint32_t offset;
+		uint8_t *vertices = FrameAllocator_Allocate(
+			bench->allocator,
+			bench->vertexSize * 3,
+			UNIFORM_BENCH_ALIGNMENT,
+			&offset
+		);
+		if (vertices == NULL)
+		{
+			break;
+		}
+		SDL_memset(vertices, 0, bench->vertexSize * 3);
+
+		offsets[0] = offset;
+		CommandCapture_BindVertexBuffers(bench->device, commandBuffer, 0, 1, &bench->allocator->buffer, offsets);
+		CommandCapture_DrawPrimitives(bench->device, commandBuffer, 0, 1, 0, fragmentParamOffset);
+	}
+	FrameAllocator_Flush(bench->allocator);
+
+	bench->allocatorTicks += SDL_GetPerformanceCounter() - start;
+	bench->allocatorFrameCount += 1;
+}
+
+void UniformBench_Submitted(UniformBench *bench)
+{
+	if (bench->allocatorFrame)
+	{
+		FrameAllocator_Submitted(bench->allocator);
+		bench->allocatorFrame = 0;
+	}
+}
+
+void UniformBench_Report(UniformBench *bench, FILE *output)
+{
+	double pushMilliseconds = UniformBench_Milliseconds(bench->pushTicks, bench->pushFrameCount);
+	double allocatorMilliseconds = UniformBench_Milliseconds(bench->allocatorTicks, bench->allocatorFrameCount);
+
+	fprintf(
+		output,
+		"uniform bench: %u draws a frame, %u bytes pushed or %u bytes allocated for each\n",
+		bench->blockCount,
+		(uint32_t) sizeof(RaymarchUniforms),
+		bench->vertexSize * 3
+	);
+	fprintf(
+		output,
+		"  push:            %8.3f ms a frame over %u frames, %.1f ns a draw\n",
+		pushMilliseconds,
+		bench->pushFrameCount,
+		pushMilliseconds * 1000000.0 / bench->blockCount
+	);
+	fprintf(
+		output,
+		"  frame allocator: %8.3f ms a frame over %u frames, %.1f ns a draw\n",
+		allocatorMilliseconds,
+		bench->allocatorFrameCount,
+		allocatorMilliseconds * 1000000.0 / bench->blockCount
+	);
+	FrameAllocator_Report(bench->allocator, output);
+}
@@ -0,0 +1,65 @@
+#ifndef UNIFORM_BENCH_H
+#define UNIFORM_BENCH_H
+
+/* --uniform-bench N: N extra draws a frame, each with data of its own, on
+ * frames drawn by the plain fragment pass. Every draw is a degenerate
+ * triangle, so the GPU reads its data but shades nothing.
+ *
+ * Even frames push a RaymarchUniforms block through
+ * Refresh_PushFragmentShaderParams for each draw, over a zeroed vertex
+ * buffer of the bench's own. Odd frames bump allocate each draw's three
+ * vertices from a FrameAllocator, flush them as one upload, then bind the
+ * allocator's buffer at each draw's offset. The report compares the CPU
+ * time of the two.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <Refresh.h>
+
+#include "frame_allocator.h"
+#include "raymarch_scenes.h"
+#include "vulkan_interop.h"
+
+typedef struct UniformBench
+{
+	Refresh_Device *device;
+	FrameAllocator *allocator;
+	Refresh_Buffer *vertexBuffer;	/* the push frames' degenerate triangle */
+	uint32_t vertexSize;
+	uint32_t blockCount;
+	uint8_t allocatorFrame;	/* the frame being recorded used the allocator */
+
+	/* Statistics */
+	uint32_t pushFrameCount;
+	uint64_t pushTicks;
+	uint32_t allocatorFrameCount;
+	uint64_t allocatorTicks;
+} UniformBench;
+
+/* vertexSize is the bound pipeline's vertex stride */
+UniformBench* UniformBench_Create(
+	Refresh_Device *device,
+	VulkanInterop *interop,
+	uint32_t blockCount,
+	uint32_t vertexSize
+);
+
+void UniformBench_Destroy(UniformBench *bench);
+
+/* Needs a graphics pipeline and its fragment samplers bound to
+ * commandBuffer. Leaves vertex buffer 0 bound to something else.
+ */
+void UniformBench_Record(
+	UniformBench *bench,
+	Refresh_CommandBuffer *commandBuffer,
+	const RaymarchUniforms *uniforms
+);
+
+/* After the submit of every frame, recorded on or not */
+void UniformBench_Submitted(UniformBench *bench);
+
+void UniformBench_Report(UniformBench *bench, FILE *output);
+
+#endif /* UNIFORM_BENCH_H */
@@ -0,0 +1,405 @@
+#include "upload_batch.h"
+
+#include <SDL.h>
+
+#include "command_capture.h"
+#include "gpu_memory.h"
+
+#define UPLOAD_BUFFER_ALIGNMENT 16
+#define UPLOAD_ATLAS_PADDING 1	/* keeps linear filtering from bleeding between regions */
+
+static void UploadBatch_PushRange(
+	UploadRange **ranges,
+	uint32_t *count,
+	uint32_t *capacity,
+	uint32_t index,
+	UploadRange *range
+) {
+	if (*count == *capacity)
+	{
+		*capacity = SDL_max(16, *capacity * 2);
+		*ranges = (UploadRange*) SDL_realloc(*ranges, sizeof(UploadRange) * *capacity);
+	}
+
+	SDL_memmove(&(*ranges)[index + 1], &(*ranges)[index], sizeof(UploadRange) * (*count - index));
+	(*ranges)[index] = *range;
+	*count += 1;
+}
+
+static void UploadBatch_ReleaseRange(UploadBatch *batch, UploadRange *range)
+{
+	uint32_t index = 0;
+
+	while (index < batch->freeRangeCount && batch->freeRanges[index].offset < range->offset)
+	{
+		index += 1;
+	}
+
+	UploadBatch_PushRange(
+		&batch->freeRanges,
+		&batch->freeRangeCount,
+		&batch->freeRangeCapacity,
+		index,
+		range
+	);
+	UploadRange *ranges = batch->freeRanges;
+
+	/* Merge with the following range, then with the preceding one */
+	if (	index + 1 < batch->freeRangeCount &&
+		ranges[index].offset + ranges[index].size == ranges[index + 1].offset	)
+	{
+		ranges[index].size += ranges[index + 1].size;
+		SDL_memmove(&ranges[index + 1], &ranges[index + 2], sizeof(UploadRange) * (batch->freeRangeCount - index - 2));
+		batch->freeRangeCount -= 1;
+	}
+	if (	index > 0 &&
+		ranges[index - 1].offset + ranges[index - 1].size == ranges[index].offset	)
+	{
+		ranges[index - 1].size += ranges[index].size;
+		SDL_memmove(&ranges[index], &ranges[index + 1], sizeof(UploadRange) * (batch->freeRangeCount - index - 1));
+		batch->freeRangeCount -= 1;
+	}
+}
+
+/* Fences on one queue signal in order, so stop at the first pending one */
+static void UploadBatch_Reclaim(UploadBatch *batch)
+{
+	uint32_t i = 0;
+
+	while (	batch->completedFlushCount < batch->flushCount &&
+		VulkanInterop_IsFenceSignaled(
+			batch->interop,
+			batch->fences[batch->completedFlushCount % UPLOAD_BATCH_FENCE_COUNT]
+		)	)
+	{
+		batch->completedFlushCount += 1;
+	}
+
+	while (i < batch->retiredRangeCount)
+	{
+		if (batch->retiredRanges[i].flushIndex < batch->completedFlushCount)
+		{
+			UploadBatch_ReleaseRange(batch, &batch->retiredRanges[i]);
+			batch->retiredRanges[i] = batch->retiredRanges[batch->retiredRangeCount - 1];
+			batch->retiredRangeCount -= 1;
+		}
+		else
+		{
+			i += 1;
+		}
+	}
+}
+
+UploadBatch* UploadBatch_Create(
+	Refresh_Device *device,
+	VulkanInterop *interop,
+	Refresh_BufferUsageFlags bufferUsage,
+	uint32_t bufferCapacity
+) {
+	UploadBatch *batch = (UploadBatch*) SDL_malloc(sizeof(UploadBatch));
+	SDL_memset(batch, 0, sizeof(UploadBatch));
+
+	batch->device = device;
+	batch->interop = interop;
+
+	bufferCapacity = (bufferCapacity + UPLOAD_BUFFER_ALIGNMENT - 1) & ~(UPLOAD_BUFFER_ALIGNMENT - 1);
+	batch->buffer = CommandCapture_CreateBuffer(device, bufferUsage, bufferCapacity);
+	GpuMemory_AddBuffer(batch->buffer, bufferUsage, bufferCapacity);
+	batch->bufferShadow = (uint8_t*) SDL_malloc(bufferCapacity);
+	SDL_memset(batch->bufferShadow, 0, bufferCapacity);
+	batch->bufferCapacity = bufferCapacity;
+	batch->dirtyStart = bufferCapacity;
+	batch->dirtyEnd = 0;
+
+	UploadRange range;
+	range.offset = 0;
+	range.size = bufferCapacity;
+	range.flushIndex = 0;
+	UploadBatch_ReleaseRange(batch, &range);
+
+	for (uint32_t i = 0; i < UPLOAD_BATCH_FENCE_COUNT; i++)
+	{
+		batch->fences[i] = VulkanInterop_CreateFence(interop, 0);
+	}
+
+	return batch;
+}
+
+void UploadBatch_Destroy(UploadBatch *batch)
+{
+	UploadBatch_Wait(batch);
+
+	for (uint32_t i = 0; i < UPLOAD_BATCH_FENCE_COUNT; i++)
+	{
+		VulkanInterop_DestroyFence(batch->interop, batch->fences[i]);
+	}
+
+	for (uint32_t i = 0; i < batch->pageCount; i++)
+	{
+		GpuMemory_Remove(batch->pages[i].texture);
+		CommandCapture_QueueDestroyTexture(batch->device, batch->pages[i].texture);
+		SDL_free(batch->pages[i].shadow);
+	}
+
+	GpuMemory_Remove(batch->buffer);
+	CommandCapture_QueueDestroyBuffer(batch->device, batch->buffer);
+	SDL_free(batch->bufferShadow);
+	SDL_free(batch->freeRanges);
+	SDL_free(batch->retiredRanges);
+	SDL_free(batch);
+}
+
+uint8_t UploadBatch_AllocateBuffer(
+	UploadBatch *batch,
+	uint32_t size,
+	UploadBufferAllocation *allocation
+) {
+	size = (size + UPLOAD_BUFFER_ALIGNMENT - 1) & ~(UPLOAD_BUFFER_ALIGNMENT - 1);
+
+	UploadBatch_Reclaim(batch);
+
+	/* First fit keeps allocations packed toward the front, so dirty spans stay short */
+	for (uint32_t i = 0; i < batch->freeRangeCount; i++)
+	{
+		UploadRange *range = &batch->freeRanges[i];
+		if (range->size < size)
+		{
+			continue;
+		}
+
+		allocation->offset = range->offset;
+		allocation->size = size;
+
+		range->offset += size;
+		range->size -= size;
+		if (range->size == 0)
+		{
+			SDL_memmove(range, range + 1, sizeof(UploadRange) * (batch->freeRangeCount - i - 1));
+			batch->freeRangeCount -= 1;
+		}
+		return 1;
+	}
+
+	return 0;
+}
+
+void UploadBatch_WriteBuffer(
+	UploadBatch *batch,
+	UploadBufferAllocation *allocation,
+	uint32_t offset,
+	void *data,
+	uint32_t dataLength
+) {
+	uint32_t start = allocation->offset + offset;
+
+	SDL_memcpy(batch->bufferShadow + start, data, dataLength);
+
+	batch->dirtyStart = SDL_min(batch->dirtyStart, start);
+	batch->dirtyEnd = SDL_max(batch->dirtyEnd, start + dataLength);
+}
+
+void UploadBatch_FreeBuffer(UploadBatch *batch, UploadBufferAllocation *allocation)
+{
+	UploadRange range;
+	range.offset = allocation->offset;
+	range.size = allocation->size;
+	range.flushIndex = batch->flushCount;
+
+	UploadBatch_PushRange(
+		&batch->retiredRanges,
+		&batch->retiredRangeCount,
+		&batch->retiredRangeCapacity,
+		batch->retiredRangeCount,
+		&range
+	);
+}
+
+static uint8_t UploadBatch_PackPage(
+	UploadAtlasPage *page,
+	uint32_t width,
+	uint32_t height,
+	Refresh_Rect *rectangle
+) {
+	uint32_t paddedWidth = width + UPLOAD_ATLAS_PADDING;
+	uint32_t paddedHeight = height + UPLOAD_ATLAS_PADDING;
+
+	if (page->cursorX + paddedWidth > UPLOAD_ATLAS_PAGE_SIZE)
+	{
+		page->shelfY += page->shelfHeight;
+		page->shelfHeight = 0;
+		page->cursorX = 0;
+	}
+	if (page->shelfY + paddedHeight > UPLOAD_ATLAS_PAGE_SIZE)
+	{
+		return 0;
+	}
+
+	rectangle->x = page->cursorX;
+	rectangle->y = page->shelfY;
+	rectangle->w = width;
+	rectangle->h = height;
+
+	page->cursorX += paddedWidth;
+	page->shelfHeight = SDL_max(page->shelfHeight, paddedHeight);
+	return 1;
+}
+
+uint8_t UploadBatch_AllocateTexture(
+	UploadBatch *batch,
+	uint32_t width,
+	uint32_t height,
+	UploadTextureRegion *region
+) {
+	if (	width + UPLOAD_ATLAS_PADDING > UPLOAD_ATLAS_PAGE_SIZE ||
+		height + UPLOAD_ATLAS_PADDING > UPLOAD_ATLAS_PAGE_SIZE	)
+	{
+		return 0;
+	}
+
+	/* Only the newest page has an open shelf worth trying */
+	for (uint32_t i = (batch->pageCount > 0) ? batch->pageCount - 1 : 0; i <= batch->pageCount; i++)
+	{
+		if (i == batch->pageCount)
+		{
+			if (batch->pageCount == UPLOAD_ATLAS_MAX_PAGES)
+			{
+				return 0;
+			}
+
+			UploadAtlasPage *page = &batch->pages[batch->pageCount];
+			SDL_memset(page, 0, sizeof(UploadAtlasPage));
+			page->texture = CommandCapture_CreateTexture2D(
+				batch->device,
+				REFRESH_COLORFORMAT_R8G8B8A8,
+				UPLOAD_ATLAS_PAGE_SIZE,
+				UPLOAD_ATLAS_PAGE_SIZE,
+				1,
+				REFRESH_TEXTUREUSAGE_SAMPLER_BIT
+			);
+			GpuMemory_AddTexture(
+				page->texture,
+				REFRESH_COLORFORMAT_R8G8B8A8,
+				UPLOAD_ATLAS_PAGE_SIZE,
+				UPLOAD_ATLAS_PAGE_SIZE,
+				1,
+				REFRESH_TEXTUREUSAGE_SAMPLER_BIT
+			);
+			page->shadow = (uint8_t*) SDL_malloc(UPLOAD_ATLAS_PAGE_SIZE * UPLOAD_ATLAS_PAGE_SIZE * 4);
+			SDL_memset(page->shadow, 0, UPLOAD_ATLAS_PAGE_SIZE * UPLOAD_ATLAS_PAGE_SIZE * 4);
+			page->dirtyTop = UPLOAD_ATLAS_PAGE_SIZE;
+			batch->pageCount += 1;
+		}
+
+		if (UploadBatch_PackPage(&batch->pages[i], width, height, &region->rectangle))
+		{
+			region->page = batch->pages[i].texture;
+			region->pageIndex = i;
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+void UploadBatch_WriteTexture(
+	UploadBatch *batch,
+	UploadTextureRegion *region,
+	uint8_t *pixels
+) {
+	UploadAtlasPage *page = &batch->pages[region->pageIndex];
+	uint32_t rowSize = region->rectangle.w * 4;
+
+	for (uint32_t y = 0; y < (uint32_t) region->rectangle.h; y++)
+	{
+		SDL_memcpy(
+			page->shadow + ((region->rectangle.y + y) * UPLOAD_ATLAS_PAGE_SIZE + region->rectangle.x) * 4,
+			pixels + y * rowSize,
+			rowSize
+		);
+	}
+
+	page->dirtyTop = SDL_min(page->dirtyTop, (uint32_t) region->rectangle.y);
+	page->dirtyBottom = SDL_max(page->dirtyBottom, (uint32_t) (region->rectangle.y + region->rectangle.h));
+}
+
+void UploadBatch_Flush(UploadBatch *batch)
+{
+	/* Bytes between allocations go out too, unchanged; one upload beats many */
+	if (batch->dirtyStart < batch->dirtyEnd)
+	{
+		CommandCapture_SetBufferData(
+			batch->device,
+			batch->buffer,
+			batch->dirtyStart,
+			batch->bufferShadow + batch->dirtyStart,
+			batch->dirtyEnd - batch->dirtyStart
+		);
+		batch->uploadCallCount += 1;
+		batch->uploadedBytes += batch->dirtyEnd - batch->dirtyStart;
+
+		batch->dirtyStart = batch->bufferCapacity;
+		batch->dirtyEnd = 0;
+	}
+
+	/* Whole rows keep the source contiguous in the shadow */
+	for (uint32_t i = 0; i < batch->pageCount; i++)
+	{
+		UploadAtlasPage *page = &batch->pages[i];
+		if (page->dirtyTop >= page->dirtyBottom)
+		{
+			continue;
+		}
+
+		Refresh_TextureSlice slice;
+		slice.texture = page->texture;
+		slice.rectangle.x = 0;
+		slice.rectangle.y = page->dirtyTop;
+		slice.rectangle.w = UPLOAD_ATLAS_PAGE_SIZE;
+		slice.rectangle.h = page->dirtyBottom - page->dirtyTop;
+		slice.depth = 0;
+		slice.layer = 0;
+		slice.level = 0;
+
+		CommandCapture_SetTextureData(
+			batch->device,
+			&slice,
+			page->shadow + page->dirtyTop * UPLOAD_ATLAS_PAGE_SIZE * 4,
+			slice.rectangle.w * slice.rectangle.h * 4
+		);
+		batch->uploadCallCount += 1;
+		batch->uploadedBytes += slice.rectangle.w * slice.rectangle.h * 4;
+
+		page->dirtyTop = UPLOAD_ATLAS_PAGE_SIZE;
+		page->dirtyBottom = 0;
+	}
+
+	/* The fence slot is free once the flush that last used it is done */
+	UploadBatch_Reclaim(batch);
+	if (batch->flushCount - batch->completedFlushCount == UPLOAD_BATCH_FENCE_COUNT)
+	{
+		VulkanInterop_WaitForFence(
+			batch->interop,
+			batch->fences[batch->completedFlushCount % UPLOAD_BATCH_FENCE_COUNT]
+		);
+		batch->stallCount += 1;
+		UploadBatch_Reclaim(batch);
+	}
+
+	VkFence fence = batch->fences[batch->flushCount % UPLOAD_BATCH_FENCE_COUNT];
+	VulkanInterop_ResetFence(batch->interop, fence);
+	VulkanInterop_SignalFenceOnQueue(batch->interop, fence);
+	batch->flushCount += 1;
+}
+
+void UploadBatch_Wait(UploadBatch *batch)
+{
+	while (batch->completedFlushCount < batch->flushCount)
+	{
+		VulkanInterop_WaitForFence(
+			batch->interop,
+			batch->fences[batch->completedFlushCount % UPLOAD_BATCH_FENCE_COUNT]
+		);
+		batch->completedFlushCount += 1;
+	}
+	UploadBatch_Reclaim(batch);
+}
@@ -0,0 +1,140 @@
+#ifndef UPLOAD_BATCH_H
+#define UPLOAD_BATCH_H
+
+/* Coalesced uploads for many small buffers and textures.
+ *
+ * Every Refresh_SetBufferData and Refresh_SetTextureData call stages and
+ * copies on its own, so thousands of small uploads pay that cost thousands
+ * of times. Here small buffers are sub-allocated from one large
+ * Refresh_Buffer and small RGBA8 textures are packed into atlas pages.
+ * Both keep a persistent CPU shadow that writes go into; Flush then sends
+ * the dirty span of the buffer and the dirty rows of each page as one
+ * upload apiece.
+ *
+ * Freed buffer ranges are only reused once a fence signaled after the
+ * freeing flush has passed, so in-flight frames never see them change.
+ * Free a range only after the last submit that reads it.
+ */
+
+#include <stdint.h>
+
+#include "vulkan_interop.h"
+
+#include <Refresh.h>
+
+#define UPLOAD_BATCH_FENCE_COUNT 4
+#define UPLOAD_ATLAS_PAGE_SIZE 1024
+#define UPLOAD_ATLAS_MAX_PAGES 16
+
+typedef struct UploadBufferAllocation
+{
+	uint32_t offset;
+	uint32_t size;
+} UploadBufferAllocation;
+
+typedef struct UploadTextureRegion
+{
+	Refresh_Texture *page;
+	uint32_t pageIndex;
+	Refresh_Rect rectangle;
+} UploadTextureRegion;
+
+typedef struct UploadRange
+{
+	uint32_t offset;
+	uint32_t size;
+	uint64_t flushIndex;	/* retired ranges: reusable once this flush completes */
+} UploadRange;
+
+typedef struct UploadAtlasPage
+{
+	Refresh_Texture *texture;
+	uint8_t *shadow;
+
+	/* Shelf packer */
+	uint32_t shelfY;
+	uint32_t shelfHeight;
+	uint32_t cursorX;
+
+	/* Rows [dirtyTop, dirtyBottom) go out on the next flush */
+	uint32_t dirtyTop;
+	uint32_t dirtyBottom;
+} UploadAtlasPage;
+
+typedef struct UploadBatch
+{
+	Refresh_Device *device;
+	VulkanInterop *interop;
+
+	Refresh_Buffer *buffer;
+	uint8_t *bufferShadow;
+	uint32_t bufferCapacity;
+	uint32_t dirtyStart;
+	uint32_t dirtyEnd;
+
+	UploadRange *freeRanges;	/* sorted by offset, adjacent ranges merged */
+	uint32_t freeRangeCount;
+	uint32_t freeRangeCapacity;
+
+	UploadRange *retiredRanges;
+	uint32_t retiredRangeCount;
+	uint32_t retiredRangeCapacity;
+
+	UploadAtlasPage pages[UPLOAD_ATLAS_MAX_PAGES];
+	uint32_t pageCount;
+
+	VkFence fences[UPLOAD_BATCH_FENCE_COUNT];
+	uint64_t flushCount;
+	uint64_t completedFlushCount;
+
+	/* Statistics */
+	uint32_t uploadCallCount;
+	uint64_t uploadedBytes;
+	uint32_t stallCount;
+} UploadBatch;
+
+UploadBatch* UploadBatch_Create(
+	Refresh_Device *device,
+	VulkanInterop *interop,
+	Refresh_BufferUsageFlags bufferUsage,
+	uint32_t bufferCapacity
+);
+
+/* Waits for every flush, then destroys the buffer and atlas pages */
+void UploadBatch_Destroy(UploadBatch *batch);
+
+/* Returns 0 when the buffer has no free range large enough */
+uint8_t UploadBatch_AllocateBuffer(
+	UploadBatch *batch,
+	uint32_t size,
+	UploadBufferAllocation *allocation
+);
+void UploadBatch_WriteBuffer(
+	UploadBatch *batch,
+	UploadBufferAllocation *allocation,
+	uint32_t offset,
+	void *data,
+	uint32_t dataLength
+);
+void UploadBatch_FreeBuffer(UploadBatch *batch, UploadBufferAllocation *allocation);
+
+/* Regions live as long as the batch. Returns 0 when every page is full. */
+uint8_t UploadBatch_AllocateTexture(
+	UploadBatch *batch,
+	uint32_t width,
+	uint32_t height,
+	UploadTextureRegion *region
+);
+void UploadBatch_WriteTexture(
+	UploadBatch *batch,
+	UploadTextureRegion *region,
+	uint8_t *pixels
+);
+
+/* Sends everything written since the last flush, then fences it */
+void UploadBatch_Flush(UploadBatch *batch);
+
+/* Blocks until every flush so far has completed on the GPU */
+void UploadBatch_Wait(UploadBatch *batch);
+
+#endif /* UPLOAD_BATCH_H */
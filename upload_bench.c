@@ -0,0 +1,135 @@
+#include "upload_bench.h"
+
+#include <SDL.h>
+
+#include "command_capture.h"
+#include "gpu_memory.h"
+#include "upload_batch.h"
+
+#define UPLOAD_BENCH_TEXTURE_SIZE 32
+#define UPLOAD_BENCH_BUFFER_SIZE 256
+
+static double UploadBench_Milliseconds(uint64_t start)
+{
+	return (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+void UploadBench_Run(
+	Refresh_Device *device,
+	VulkanInterop *interop,
+	uint32_t count,
+	FILE *output
+) {
+	uint8_t pixels[UPLOAD_BENCH_TEXTURE_SIZE * UPLOAD_BENCH_TEXTURE_SIZE * 4];
+	for (uint32_t i = 0; i < sizeof(pixels); i++)
+	{
+		pixels[i] = (uint8_t) i;
+	}
+	uint8_t bytes[UPLOAD_BENCH_BUFFER_SIZE];
+	for (uint32_t i = 0; i < sizeof(bytes); i++)
+	{
+		bytes[i] = (uint8_t) (i * 7);
+	}
+
+	/* One call per texture and per buffer, as main.c uploads today */
+
+	Refresh_Texture **textures = (Refresh_Texture**) SDL_malloc(sizeof(Refresh_Texture*) * count);
+	Refresh_Buffer **buffers = (Refresh_Buffer**) SDL_malloc(sizeof(Refresh_Buffer*) * count);
+
+	Refresh_TextureSlice slice;
+	slice.rectangle.x = 0;
+	slice.rectangle.y = 0;
+	slice.rectangle.w = UPLOAD_BENCH_TEXTURE_SIZE;
+	slice.rectangle.h = UPLOAD_BENCH_TEXTURE_SIZE;
+	slice.depth = 0;
+	slice.layer = 0;
+	slice.level = 0;
+
+	uint64_t start = SDL_GetPerformanceCounter();
+	for (uint32_t i = 0; i < count; i++)
+	{
+		textures[i] = CommandCapture_CreateTexture2D(
+			device,
+			REFRESH_COLORFORMAT_R8G8B8A8,
+			UPLOAD_BENCH_TEXTURE_SIZE,
+			UPLOAD_BENCH_TEXTURE_SIZE,
+			1,
+			REFRESH_TEXTUREUSAGE_SAMPLER_BIT
+		);
+		GpuMemory_AddTexture(
+			textures[i],
+			REFRESH_COLORFORMAT_R8G8B8A8,
+			UPLOAD_BENCH_TEXTURE_SIZE,
+			UPLOAD_BENCH_TEXTURE_SIZE,
+			1,
+			REFRESH_TEXTUREUSAGE_SAMPLER_BIT
+		);
+		slice.texture = textures[i];
+		CommandCapture_SetTextureData(device, &slice, pixels, sizeof(pixels));
+
+		buffers[i] = CommandCapture_CreateBuffer(device, REFRESH_BUFFERUSAGE_VERTEX_BIT, UPLOAD_BENCH_BUFFER_SIZE);
+		GpuMemory_AddBuffer(buffers[i], REFRESH_BUFFERUSAGE_VERTEX_BIT, UPLOAD_BENCH_BUFFER_SIZE);
+		CommandCapture_SetBufferData(device, buffers[i], 0, bytes, sizeof(bytes));
+	}
+	CommandCapture_Wait(device);
+	double individualTime = UploadBench_Milliseconds(start);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		GpuMemory_Remove(textures[i]);
+		CommandCapture_QueueDestroyTexture(device, textures[i]);
+		GpuMemory_Remove(buffers[i]);
+		CommandCapture_QueueDestroyBuffer(device, buffers[i]);
+	}
+	SDL_free(textures);
+	SDL_free(buffers);
+
+	/* The same data through atlas pages and one shared buffer */
+
+	start = SDL_GetPerformanceCounter();
+	UploadBatch *batch = UploadBatch_Create(device, interop, REFRESH_BUFFERUSAGE_VERTEX_BIT, count * UPLOAD_BENCH_BUFFER_SIZE);
+	uint32_t uploaded = 0;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		UploadTextureRegion region;
+		if (!UploadBatch_AllocateTexture(batch, UPLOAD_BENCH_TEXTURE_SIZE, UPLOAD_BENCH_TEXTURE_SIZE, &region))
+		{
+			break;
+		}
+		UploadBatch_WriteTexture(batch, &region, pixels);
+
+		UploadBufferAllocation allocation;
+		UploadBatch_AllocateBuffer(batch, UPLOAD_BENCH_BUFFER_SIZE, &allocation);
+		UploadBatch_WriteBuffer(batch, &allocation, 0, bytes, sizeof(bytes));
+
+		uploaded += 1;
+	}
+	UploadBatch_Flush(batch);
+	UploadBatch_Wait(batch);
+	double batchedTime = UploadBench_Milliseconds(start);
+
+	fprintf(
+		output,
+		"upload bench: %u textures %ux%u and %u buffers of %u bytes\n",
+		count,
+		UPLOAD_BENCH_TEXTURE_SIZE,
+		UPLOAD_BENCH_TEXTURE_SIZE,
+		count,
+		UPLOAD_BENCH_BUFFER_SIZE
+	);
+	fprintf(output, "  individual: %.2f ms, %u upload calls\n", individualTime, count * 2);
+	fprintf(
+		output,
+		"  batched:    %.2f ms, %u upload calls, %u atlas pages, %.1f MB\n",
+		batchedTime,
+		batch->uploadCallCount,
+		batch->pageCount,
+		batch->uploadedBytes / (1024.0 * 1024.0)
+	);
+	if (uploaded < count)
+	{
+		fprintf(output, "  atlas full after %u textures\n", uploaded);
+	}
+
+	UploadBatch_Destroy(batch);
+}
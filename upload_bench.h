@@ -0,0 +1,22 @@
+#ifndef UPLOAD_BENCH_H
+#define UPLOAD_BENCH_H
+
+/* --upload-bench: many small textures and buffers uploaded one call at a
+ * time, then again through an UploadBatch.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "vulkan_interop.h"
+
+#include <Refresh.h>
+
+void UploadBench_Run(
+	Refresh_Device *device,
+	VulkanInterop *interop,
+	uint32_t count,
+	FILE *output
+);
+
+#endif /* UPLOAD_BENCH_H */
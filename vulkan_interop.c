@@ -0,0 +1,191 @@
+#include "vulkan_interop.h"
+
+#include <SDL.h>
+#include <SDL_vulkan.h>
+
+static const char* VulkanInterop_ResultString(VkResult result)
+{
+	switch (result)
+	{
+	case VK_SUCCESS: return "VK_SUCCESS";
+	case VK_NOT_READY: return "VK_NOT_READY";
+	case VK_TIMEOUT: return "VK_TIMEOUT";
+	case VK_ERROR_OUT_OF_HOST_MEMORY: return "VK_ERROR_OUT_OF_HOST_MEMORY";
+	case VK_ERROR_DEVICE_LOST: return "VK_ERROR_DEVICE_LOST";
+	default: return "VK_ERROR";
+	}
+}
+
+#define VULKAN_ERROR_CHECK(res, fn) \
+	if (res != VK_SUCCESS) \
+	{ \
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s %s", #fn, VulkanInterop_ResultString(res)); \
+	}
+
+uint8_t VulkanInterop_Init(
+	VulkanInterop *interop,
+	VkInstance instance,
+	VkPhysicalDevice physicalDevice,
+	VkDevice device,
+	uint32_t queueFamilyIndex
+) {
+	SDL_memset(interop, 0, sizeof(VulkanInterop));
+
+	interop->instance = instance;
+	interop->physicalDevice = physicalDevice;
+	interop->device = device;
+	interop->queueFamilyIndex = queueFamilyIndex;
+
+	/* FNA3D created its window with SDL_WINDOW_VULKAN, so SDL already has the loader open */
+	interop->vkGetInstanceProcAddr = (PFN_vkGetInstanceProcAddr) SDL_Vulkan_GetVkGetInstanceProcAddr();
+	if (interop->vkGetInstanceProcAddr == NULL)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Vulkan loader is not available: %s", SDL_GetError());
+		return 0;
+	}
+
+	interop->vkGetDeviceProcAddr = (PFN_vkGetDeviceProcAddr) interop->vkGetInstanceProcAddr(
+		instance,
+		"vkGetDeviceProcAddr"
+	);
+
+	#define VULKAN_INSTANCE_FUNCTION(name) \
+		interop->name = (PFN_##name) interop->vkGetInstanceProcAddr(instance, #name); \
+		if (interop->name == NULL) \
+		{ \
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Missing Vulkan entry point %s", #name); \
+			return 0; \
+		}
+	#define VULKAN_DEVICE_FUNCTION(name) \
+		interop->name = (PFN_##name) interop->vkGetDeviceProcAddr(device, #name); \
+		if (interop->name == NULL) \
+		{ \
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Missing Vulkan entry point %s", #name); \
+			return 0; \
+		}
+	#include "vulkan_interop_functions.h"
+
+	/* Both FNA3D and Refresh submit to the first queue of the family */
+	interop->vkGetDeviceQueue(device, queueFamilyIndex, 0, &interop->queue);
+
+	/* The budget query is physical device level, so the device supporting
+	 * the extension is enough; neither library has to have enabled it
+	 */
+	uint32_t extensionCount = 0;
+	interop->vkEnumerateDeviceExtensionProperties(physicalDevice, NULL, &extensionCount, NULL);
+	VkExtensionProperties *extensions = SDL_malloc(sizeof(VkExtensionProperties) * SDL_max(extensionCount, 1));
+	interop->vkEnumerateDeviceExtensionProperties(physicalDevice, NULL, &extensionCount, extensions);
+
+	for (uint32_t i = 0; i < extensionCount; i++)
+	{
+		if (SDL_strcmp(extensions[i].extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0)
+		{
+			interop->vkGetPhysicalDeviceMemoryProperties2 = (PFN_vkGetPhysicalDeviceMemoryProperties2)
+				interop->vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceMemoryProperties2");
+			if (interop->vkGetPhysicalDeviceMemoryProperties2 == NULL)
+			{
+				interop->vkGetPhysicalDeviceMemoryProperties2 = (PFN_vkGetPhysicalDeviceMemoryProperties2)
+					interop->vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceMemoryProperties2KHR");
+			}
+			break;
+		}
+	}
+	SDL_free(extensions);
+
+	return 1;
+}
+
+void VulkanInterop_Quit(VulkanInterop *interop)
+{
+	SDL_memset(interop, 0, sizeof(VulkanInterop));
+}
+
+VkFence VulkanInterop_CreateFence(VulkanInterop *interop, uint8_t signaled)
+{
+	VkFenceCreateInfo fenceCreateInfo;
+	fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	fenceCreateInfo.pNext = NULL;
+	fenceCreateInfo.flags = signaled ? VK_FENCE_CREATE_SIGNALED_BIT : 0;
+
+	VkFence fence = VK_NULL_HANDLE;
+	VkResult result = interop->vkCreateFence(interop->device, &fenceCreateInfo, NULL, &fence);
+	VULKAN_ERROR_CHECK(result, vkCreateFence)
+
+	return fence;
+}
+
+void VulkanInterop_DestroyFence(VulkanInterop *interop, VkFence fence)
+{
+	interop->vkDestroyFence(interop->device, fence, NULL);
+}
+
+void VulkanInterop_SignalFenceOnQueue(VulkanInterop *interop, VkFence fence)
+{
+	/* A submission with no batches still signals its fence after all prior work on the queue */
+	VkResult result = interop->vkQueueSubmit(interop->queue, 0, NULL, fence);
+	VULKAN_ERROR_CHECK(result, vkQueueSubmit)
+}
+
+uint8_t VulkanInterop_IsFenceSignaled(VulkanInterop *interop, VkFence fence)
+{
+	return interop->vkGetFenceStatus(interop->device, fence) == VK_SUCCESS;
+}
+
+void VulkanInterop_WaitForFence(VulkanInterop *interop, VkFence fence)
+{
+	VkResult result = interop->vkWaitForFences(interop->device, 1, &fence, VK_TRUE, UINT64_MAX);
+	VULKAN_ERROR_CHECK(result, vkWaitForFences)
+}
+
+void VulkanInterop_ResetFence(VulkanInterop *interop, VkFence fence)
+{
+	VkResult result = interop->vkResetFences(interop->device, 1, &fence);
+	VULKAN_ERROR_CHECK(result, vkResetFences)
+}
+
+uint32_t VulkanInterop_GetHeaps(VulkanInterop *interop, VulkanInteropHeap *heaps)
+{
+	VkPhysicalDeviceMemoryBudgetPropertiesEXT budget;
+	SDL_memset(&budget, 0, sizeof(budget));
+	budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+	VkPhysicalDeviceMemoryProperties2 properties;
+	properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+	properties.pNext = &budget;
+
+	if (interop->vkGetPhysicalDeviceMemoryProperties2 != NULL)
+	{
+		interop->vkGetPhysicalDeviceMemoryProperties2(interop->physicalDevice, &properties);
+	}
+	else
+	{
+		interop->vkGetPhysicalDeviceMemoryProperties(interop->physicalDevice, &properties.memoryProperties);
+	}
+
+	VkPhysicalDeviceMemoryProperties *memory = &properties.memoryProperties;
+	for (uint32_t i = 0; i < memory->memoryHeapCount; i++)
+	{
+		heaps[i].size = memory->memoryHeaps[i].size;
+		heaps[i].deviceLocal = (memory->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+		heaps[i].usage = budget.heapUsage[i];
+		heaps[i].budget = budget.heapBudget[i];
+	}
+
+	return memory->memoryHeapCount;
+}
+
+uint32_t VulkanInterop_FindHeap(VulkanInterop *interop, VkMemoryPropertyFlags propertyFlags)
+{
+	VkPhysicalDeviceMemoryProperties memory;
+	interop->vkGetPhysicalDeviceMemoryProperties(interop->physicalDevice, &memory);
+
+	for (uint32_t i = 0; i < memory.memoryTypeCount; i++)
+	{
+		if ((memory.memoryTypes[i].propertyFlags & propertyFlags) == propertyFlags)
+		{
+			return memory.memoryTypes[i].heapIndex;
+		}
+	}
+
+	return 0;
+}
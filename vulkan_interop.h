@@ -0,0 +1,83 @@
+#ifndef VULKAN_INTEROP_H
+#define VULKAN_INTEROP_H
+
+/* Refresh and FNA3D share one VkDevice and submit to the same VkQueue. This
+ * is the thin layer we use for the Vulkan features neither library exposes,
+ * such as fences that tell us when previously submitted work has finished.
+ *
+ * Everything here must be called from the thread that calls Refresh_Submit
+ * and FNA3D_SwapBuffers, since that is what serializes access to the queue.
+ */
+
+#include <stdint.h>
+
+#define VK_NO_PROTOTYPES
+#include <vulkan/vulkan.h>
+
+typedef struct VulkanInterop
+{
+	VkInstance instance;
+	VkPhysicalDevice physicalDevice;
+	VkDevice device;
+	uint32_t queueFamilyIndex;
+	VkQueue queue;
+
+	PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr;
+	PFN_vkGetDeviceProcAddr vkGetDeviceProcAddr;
+
+	#define VULKAN_INSTANCE_FUNCTION(name) PFN_##name name;
+	#define VULKAN_DEVICE_FUNCTION(name) PFN_##name name;
+	#include "vulkan_interop_functions.h"
+
+	/* NULL unless the device has VK_EXT_memory_budget */
+	PFN_vkGetPhysicalDeviceMemoryProperties2 vkGetPhysicalDeviceMemoryProperties2;
+} VulkanInterop;
+
+typedef struct VulkanInteropHeap
+{
+	uint64_t size;
+	uint8_t deviceLocal;
+
+	/* Everything the process has allocated from the heap, FNA3D and Refresh
+	 * included, and how much it may. Both 0 without VK_EXT_memory_budget.
+	 */
+	uint64_t usage;
+	uint64_t budget;
+} VulkanInteropHeap;
+
+uint8_t VulkanInterop_Init(
+	VulkanInterop *interop,
+	VkInstance instance,
+	VkPhysicalDevice physicalDevice,
+	VkDevice device,
+	uint32_t queueFamilyIndex
+);
+
+void VulkanInterop_Quit(VulkanInterop *interop);
+
+/* Fences */
+
+VkFence VulkanInterop_CreateFence(VulkanInterop *interop, uint8_t signaled);
+void VulkanInterop_DestroyFence(VulkanInterop *interop, VkFence fence);
+
+/* Queues an empty submission that signals the fence once everything
+ * submitted to the queue before it, by any library, has completed.
+ * The fence must be unsignaled.
+ */
+void VulkanInterop_SignalFenceOnQueue(VulkanInterop *interop, VkFence fence);
+
+uint8_t VulkanInterop_IsFenceSignaled(VulkanInterop *interop, VkFence fence);
+void VulkanInterop_WaitForFence(VulkanInterop *interop, VkFence fence);
+void VulkanInterop_ResetFence(VulkanInterop *interop, VkFence fence);
+
+/* Memory */
+
+/* Fills up to VK_MAX_MEMORY_HEAPS heaps and returns how many there are */
+uint32_t VulkanInterop_GetHeaps(VulkanInterop *interop, VulkanInteropHeap *heaps);
+
+/* The heap of the first memory type with all of propertyFlags, the way
+ * allocators pick one
+ */
+uint32_t VulkanInterop_FindHeap(VulkanInterop *interop, VkMemoryPropertyFlags propertyFlags);
+
+#endif /* VULKAN_INTEROP_H */
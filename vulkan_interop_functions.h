@@ -0,0 +1,35 @@
+/* X-macro list of the Vulkan entry points used by vulkan_interop.c */
+
+#ifndef VULKAN_INSTANCE_FUNCTION
+#define VULKAN_INSTANCE_FUNCTION(name)
+#endif
+
+#ifndef VULKAN_DEVICE_FUNCTION
+#define VULKAN_DEVICE_FUNCTION(name)
+#endif
+
+VULKAN_INSTANCE_FUNCTION(vkGetPhysicalDeviceProperties)
+VULKAN_INSTANCE_FUNCTION(vkGetPhysicalDeviceQueueFamilyProperties)
+VULKAN_INSTANCE_FUNCTION(vkGetPhysicalDeviceMemoryProperties)
+VULKAN_INSTANCE_FUNCTION(vkEnumerateDeviceExtensionProperties)
+
+VULKAN_DEVICE_FUNCTION(vkGetDeviceQueue)
+VULKAN_DEVICE_FUNCTION(vkQueueSubmit)
+VULKAN_DEVICE_FUNCTION(vkCreateFence)
+VULKAN_DEVICE_FUNCTION(vkDestroyFence)
+VULKAN_DEVICE_FUNCTION(vkResetFences)
+VULKAN_DEVICE_FUNCTION(vkGetFenceStatus)
+VULKAN_DEVICE_FUNCTION(vkWaitForFences)
+VULKAN_DEVICE_FUNCTION(vkCreateCommandPool)
+VULKAN_DEVICE_FUNCTION(vkDestroyCommandPool)
+VULKAN_DEVICE_FUNCTION(vkAllocateCommandBuffers)
+VULKAN_DEVICE_FUNCTION(vkBeginCommandBuffer)
+VULKAN_DEVICE_FUNCTION(vkEndCommandBuffer)
+VULKAN_DEVICE_FUNCTION(vkCreateQueryPool)
+VULKAN_DEVICE_FUNCTION(vkDestroyQueryPool)
+VULKAN_DEVICE_FUNCTION(vkGetQueryPoolResults)
+VULKAN_DEVICE_FUNCTION(vkCmdResetQueryPool)
+VULKAN_DEVICE_FUNCTION(vkCmdWriteTimestamp)
+
+#undef VULKAN_INSTANCE_FUNCTION
+#undef VULKAN_DEVICE_FUNCTION